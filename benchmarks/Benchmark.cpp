@@ -0,0 +1,189 @@
+#include "Engine.hpp"
+
+// Renders a fixed number of frames and reports CPU / GPU frame time statistics.
+// Usage : LunarBenchmark [--frames N] [--warmup N] [--width W] [--height H] [--windowed] [--lod-threshold PIXELS] [--no-meshlet-culling] [--gpu-driven] [--linear-culling] [--no-instancing] [--serial-recording] [--dump-render-graph] [--profile N] [--profile-output profile.json] [--telemetry telemetry.csv] [--telemetry-binary] [--memory-report memory.json] [--assert-no-allocations] [--objects N] [--output results.json]
+int main(int argc, char** argv)
+{
+    lunar::EngineConfig config{
+        .headless = true,
+        .benchmarkFrameCount = 1000u,
+    };
+
+    std::string outputPath{};
+    std::string memoryReportPath{};
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+
+            const auto nextValue = [&]() -> std::string_view
+            {
+                if (i + 1 >= argc)
+                {
+                    fatalError(std::string("Missing value for argument : ") + std::string(argument));
+                }
+
+                return argv[++i];
+            };
+
+            if (argument == "--frames")
+            {
+                config.benchmarkFrameCount = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--warmup")
+            {
+                config.benchmarkWarmupFrameCount = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--width")
+            {
+                config.headlessExtent.width = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--height")
+            {
+                config.headlessExtent.height = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--windowed")
+            {
+                config.headless = false;
+            }
+            else if (argument == "--lod-threshold")
+            {
+                config.lodErrorThreshold = std::stof(std::string(nextValue()));
+            }
+            else if (argument == "--no-meshlet-culling")
+            {
+                config.meshletCulling = false;
+            }
+            else if (argument == "--gpu-driven")
+            {
+                config.gpuDrivenRendering = true;
+            }
+            else if (argument == "--linear-culling")
+            {
+                config.bvhCulling = false;
+            }
+            else if (argument == "--no-instancing")
+            {
+                config.instancing = false;
+            }
+            else if (argument == "--serial-recording")
+            {
+                config.parallelCommandRecording = false;
+            }
+            else if (argument == "--dump-render-graph")
+            {
+                config.dumpRenderGraph = true;
+            }
+            else if (argument == "--profile")
+            {
+                config.profileFrameCount = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--profile-output")
+            {
+                config.profileOutputPath = nextValue();
+            }
+            else if (argument == "--telemetry")
+            {
+                config.telemetryOutputPath = nextValue();
+            }
+            else if (argument == "--telemetry-binary")
+            {
+                config.telemetryFormat = lunar::TelemetryFormat::eBinary;
+            }
+            else if (argument == "--memory-report")
+            {
+                memoryReportPath = nextValue();
+            }
+            else if (argument == "--assert-no-allocations")
+            {
+                config.assertNoFrameAllocations = true;
+            }
+            else if (argument == "--objects")
+            {
+                config.sceneObjectCount = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--output")
+            {
+                outputPath = nextValue();
+            }
+            else
+            {
+                fatalError(std::string("Unknown argument : ") + std::string(argument));
+            }
+        }
+
+        if (config.benchmarkFrameCount == 0u)
+        {
+            fatalError("Benchmark frame count must be non zero.");
+        }
+
+        if (config.profileFrameCount > 0u && !LUNAR_PROFILING)
+        {
+            std::cout << "Profiler scopes are not compiled in (see LUNAR_PROFILING in CMakeLists.txt), no trace will be written.\n";
+        }
+
+        lunar::Engine engine{config};
+        engine.run();
+
+        // The engine is still alive here, so the report has every allocation of the benchmark scene.
+        if (!memoryReportPath.empty())
+        {
+            engine.writeMemoryReport(memoryReportPath);
+        }
+
+        // Write the results in a machine readable format so they can be tracked across commits.
+        if (!outputPath.empty())
+        {
+            const lunar::BenchmarkResults& results = engine.getBenchmarkResults();
+
+            const auto statisticsToJson = [](const lunar::FrameTimeStatistics& statistics)
+            { return std::format(R"({{"min_ms": {:.4f}, "avg_ms": {:.4f}, "p99_ms": {:.4f}, "max_ms": {:.4f}}})", statistics.minMs, statistics.avgMs, statistics.p99Ms, statistics.maxMs); };
+
+            std::string jobWorkerUtilization{};
+            for (const lunar::JobWorkerStatistics& statistics : results.jobWorkerStatistics)
+            {
+                jobWorkerUtilization += std::format("{}{:.4f}", jobWorkerUtilization.empty() ? "" : ", ", statistics.utilization);
+            }
+
+            std::ofstream outputFile{outputPath};
+            if (!outputFile.is_open())
+            {
+                fatalError(std::string("Failed to open benchmark output file : ") + outputPath);
+            }
+
+            outputFile << std::format(R"({{"init_time_ms": {:.4f}, "pipeline_creation_time_ms": {:.4f}, "pipeline_cache_warm": {}, "gpu_driven": {}, "bvh_culling": {}, "instancing": {}, "parallel_recording": {}, "object_count": {}, "frame_count": {}, "cpu_frame_time": {}, "gpu_frame_time": {}, "average_visible_objects": {:.1f}, "average_culled_objects": {:.1f}, "job_worker_utilization": [{}], "transient_allocated_bytes": {}, "transient_lazily_allocated_bytes": {}, "transient_peak_saved_bytes": {}, "draw_calls": {}, "pipeline_binds": {}, "skipped_pipeline_binds": {}, "triangles": {}, "heap_allocations": {}}})",
+                                      results.initTimeMs,
+                                      results.pipelineCreationTimeMs,
+                                      results.pipelineCacheWarm,
+                                      config.gpuDrivenRendering,
+                                      config.bvhCulling,
+                                      config.instancing,
+                                      config.parallelCommandRecording,
+                                      config.sceneObjectCount,
+                                      results.frameCount,
+                                      statisticsToJson(results.cpuFrameTime),
+                                      statisticsToJson(results.gpuFrameTime),
+                                      results.averageVisibleObjectCount,
+                                      results.averageCulledObjectCount,
+                                      jobWorkerUtilization,
+                                      results.transientMemoryStatistics.allocatedBytes,
+                                      results.transientMemoryStatistics.lazilyAllocatedBytes,
+                                      results.transientMemoryStatistics.peakSavedBytes,
+                                      results.totalRenderStatistics.drawCallCount,
+                                      results.totalRenderStatistics.pipelineBindCount,
+                                      results.totalRenderStatistics.skippedPipelineBindCount,
+                                      results.totalRenderStatistics.triangleCount,
+                                      results.totalRenderStatistics.heapAllocationCount)
+                       << '\n';
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "[Exception Caught] : " << exception.what();
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "Bvh.hpp"
+
+#include <random>
+
+// Compares the scene BVH against a linear scan over the same bounds, for frustum, ray, sphere and box queries, at several object counts.
+// Objects are boxes scattered in a cube whose volume grows with the object count (so the density, and the fraction of objects each query
+// touches, stays roughly the same).
+// Usage : LunarBvhBenchmark [--queries N] [--seed N]
+namespace
+{
+    // Returns the average time (in microseconds) of a call to function, over count calls.
+    template <typename Function> double measureMicroseconds(const uint32_t count, Function&& function)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        for (const uint32_t i : std::views::iota(0u, count))
+        {
+            function(i);
+        }
+
+        const std::chrono::duration<double, std::micro> duration = std::chrono::high_resolution_clock::now() - startTime;
+        return duration.count() / static_cast<double>(count);
+    }
+
+    void runBenchmark(const uint32_t objectCount, const uint32_t queryCount, std::mt19937& randomEngine)
+    {
+        // Each object occupies on average a 4 x 4 x 4 cell.
+        const float halfSceneSize = std::cbrt(static_cast<float>(objectCount)) * 2.0f;
+
+        std::uniform_real_distribution<float> positionDistribution(-halfSceneSize, halfSceneSize);
+        std::uniform_real_distribution<float> extentDistribution(0.25f, 1.5f);
+        std::uniform_real_distribution<float> directionDistribution(-1.0f, 1.0f);
+
+        const auto randomPosition = [&]() { return math::XMFLOAT3{positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine)}; };
+
+        std::vector<lunar::Aabb> bounds(objectCount);
+        for (lunar::Aabb& aabb : bounds)
+        {
+            const math::XMFLOAT3 center = randomPosition();
+            const float extent = extentDistribution(randomEngine);
+
+            aabb = lunar::Aabb{
+                .min = {center.x - extent, center.y - extent, center.z - extent},
+                .max = {center.x + extent, center.y + extent, center.z + extent},
+            };
+        }
+
+        // Queries : cameras at random positions looking at the scene center, rays between random points, and spheres / boxes around random points.
+        std::vector<lunar::Frustum> frustums(queryCount);
+        std::vector<std::pair<math::XMFLOAT3, math::XMFLOAT3>> rays(queryCount);
+        std::vector<math::XMFLOAT3> queryCenters(queryCount);
+
+        const math::XMMATRIX projectionMatrix = math::XMMatrixPerspectiveFovLH(math::XMConvertToRadians(45.0f), 16.0f / 9.0f, 0.1f, halfSceneSize);
+
+        for (const uint32_t queryIndex : std::views::iota(0u, queryCount))
+        {
+            const math::XMFLOAT3 eyePosition = randomPosition();
+            const math::XMVECTOR eye = math::XMLoadFloat3(&eyePosition);
+            const math::XMVECTOR target = math::XMVectorSet(directionDistribution(randomEngine), directionDistribution(randomEngine), directionDistribution(randomEngine), 1.0f);
+
+            frustums[queryIndex] = lunar::Frustum::fromViewProjection(math::XMMatrixLookAtLH(eye, target, math::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * projectionMatrix);
+
+            const math::XMFLOAT3 rayTarget = randomPosition();
+            rays[queryIndex] = {eyePosition, math::XMFLOAT3{rayTarget.x - eyePosition.x, rayTarget.y - eyePosition.y, rayTarget.z - eyePosition.z}};
+
+            queryCenters[queryIndex] = randomPosition();
+        }
+
+        constexpr float queryRadius = 4.0f;
+
+        lunar::DynamicBvh bvh{};
+        std::vector<uint32_t> leaves{};
+
+        const double buildTimeUs = measureMicroseconds(1u, [&](uint32_t) { leaves = bvh.build(bounds); });
+        const lunar::BvhStatistics builtStatistics = bvh.getStatistics();
+
+        std::vector<uint32_t> results{};
+        results.reserve(objectCount);
+
+        // The result counts of both versions are accumulated, so that a mismatch can be reported (and the work cannot be optimized away).
+        uint64_t linearResultCount{};
+        uint64_t bvhResultCount{};
+
+        const auto linearFrustumUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            results.clear();
+            for (const uint32_t objectIndex : std::views::iota(0u, objectCount))
+            {
+                if (lunar::intersectsFrustum(bounds[objectIndex], frustums[queryIndex]))
+                {
+                    results.push_back(objectIndex);
+                }
+            }
+
+            linearResultCount += results.size();
+        });
+
+        const auto bvhFrustumUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            results.clear();
+            bvh.queryFrustum(frustums[queryIndex], results);
+
+            bvhResultCount += results.size();
+        });
+
+        const auto linearRayUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            float closestDistance = 1.0f;
+            uint32_t closestObject = INVALID_U32;
+
+            for (const uint32_t objectIndex : std::views::iota(0u, objectCount))
+            {
+                const std::optional<float> distance = lunar::intersectRay(bounds[objectIndex], rays[queryIndex].first, rays[queryIndex].second, closestDistance);
+                if (distance.has_value() && *distance < closestDistance)
+                {
+                    closestDistance = *distance;
+                    closestObject = objectIndex;
+                }
+            }
+
+            linearResultCount += closestObject != INVALID_U32 ? 1u : 0u;
+        });
+
+        const auto bvhRayUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            bvhResultCount += bvh.raycast(rays[queryIndex].first, rays[queryIndex].second, 1.0f).has_value() ? 1u : 0u;
+        });
+
+        const auto linearSphereUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            results.clear();
+            for (const uint32_t objectIndex : std::views::iota(0u, objectCount))
+            {
+                if (lunar::intersectsSphere(bounds[objectIndex], queryCenters[queryIndex], queryRadius))
+                {
+                    results.push_back(objectIndex);
+                }
+            }
+
+            linearResultCount += results.size();
+        });
+
+        const auto bvhSphereUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            results.clear();
+            bvh.querySphere(queryCenters[queryIndex], queryRadius, results);
+
+            bvhResultCount += results.size();
+        });
+
+        const auto getQueryBox = [&](const uint32_t queryIndex) {
+            const math::XMFLOAT3& center = queryCenters[queryIndex];
+            return lunar::Aabb{
+                .min = {center.x - queryRadius, center.y - queryRadius, center.z - queryRadius},
+                .max = {center.x + queryRadius, center.y + queryRadius, center.z + queryRadius},
+            };
+        };
+
+        const auto linearAabbUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            const lunar::Aabb queryBox = getQueryBox(queryIndex);
+
+            results.clear();
+            for (const uint32_t objectIndex : std::views::iota(0u, objectCount))
+            {
+                if (lunar::intersects(bounds[objectIndex], queryBox))
+                {
+                    results.push_back(objectIndex);
+                }
+            }
+
+            linearResultCount += results.size();
+        });
+
+        const auto bvhAabbUs = measureMicroseconds(queryCount, [&](const uint32_t queryIndex) {
+            results.clear();
+            bvh.queryAabb(getQueryBox(queryIndex), results);
+
+            bvhResultCount += results.size();
+        });
+
+        // Move a tenth of the objects a short distance every frame, and refit.
+        constexpr uint32_t refitFrameCount = 100u;
+        std::uniform_real_distribution<float> offsetDistribution(-0.5f, 0.5f);
+
+        const double refitUs = measureMicroseconds(refitFrameCount, [&](uint32_t) {
+            for (uint32_t objectIndex = 0u; objectIndex < objectCount; objectIndex += 10u)
+            {
+                const math::XMFLOAT3 offset = {offsetDistribution(randomEngine), offsetDistribution(randomEngine), offsetDistribution(randomEngine)};
+
+                lunar::Aabb& aabb = bounds[objectIndex];
+                aabb.min = {aabb.min.x + offset.x, aabb.min.y + offset.y, aabb.min.z + offset.z};
+                aabb.max = {aabb.max.x + offset.x, aabb.max.y + offset.y, aabb.max.z + offset.z};
+
+                bvh.update(leaves[objectIndex], aabb);
+            }
+
+            bvh.refit();
+        });
+
+        const lunar::BvhStatistics refitStatistics = bvh.getStatistics();
+
+        std::cout << std::format("{} objects : build {:.1f} ms (height {}, SAH cost {:.1f}), refit of {} moved objects {:.1f} us (height {}, SAH cost {:.1f})\n",
+                                 objectCount,
+                                 buildTimeUs / 1000.0,
+                                 builtStatistics.height,
+                                 builtStatistics.sahCost,
+                                 objectCount / 10u,
+                                 refitUs,
+                                 refitStatistics.height,
+                                 refitStatistics.sahCost);
+
+        const auto printQuery = [](const std::string_view name, const double linearUs, const double bvhUs) {
+            std::cout << std::format("    {:<8} : linear {:>10.2f} us, BVH {:>8.2f} us ({:.1f}x)\n", name, linearUs, bvhUs, linearUs / bvhUs);
+        };
+
+        printQuery("Frustum", linearFrustumUs, bvhFrustumUs);
+        printQuery("Ray", linearRayUs, bvhRayUs);
+        printQuery("Sphere", linearSphereUs, bvhSphereUs);
+        printQuery("Box", linearAabbUs, bvhAabbUs);
+
+        if (linearResultCount != bvhResultCount)
+        {
+            fatalError(std::format("BVH and linear queries returned a different number of results ({} vs {}).", bvhResultCount, linearResultCount));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t queryCount = 100u;
+    uint32_t seed = 42u;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+
+            const auto nextValue = [&]() -> std::string_view
+            {
+                if (i + 1 >= argc)
+                {
+                    fatalError(std::string("Missing value for argument : ") + std::string(argument));
+                }
+
+                return argv[++i];
+            };
+
+            if (argument == "--queries")
+            {
+                queryCount = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else if (argument == "--seed")
+            {
+                seed = static_cast<uint32_t>(std::stoul(std::string(nextValue())));
+            }
+            else
+            {
+                fatalError(std::string("Unknown argument : ") + std::string(argument));
+            }
+        }
+
+        if (queryCount == 0u)
+        {
+            fatalError("Query count must be non zero.");
+        }
+
+        std::mt19937 randomEngine(seed);
+
+        for (const uint32_t objectCount : {1'000u, 10'000u, 100'000u})
+        {
+            runBenchmark(objectCount, queryCount, randomEngine);
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "[Exception Caught] : " << exception.what();
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+namespace lunar
+{
+    struct AllocationCounters
+    {
+        uint64_t allocationCount{};
+        uint64_t allocatedBytes{};
+    };
+
+    // Allocations made inside the allocation scopes of a name (see LUNAR_ALLOCATION_SCOPE).
+    struct AllocationCallSite
+    {
+        std::string_view name{};
+        uint64_t allocationCount{};
+        uint64_t allocatedBytes{};
+    };
+
+    // Counts heap allocations, through a replacement of the global operator new (AllocationTracker.cpp), which every standard container,
+    // std::function, std::make_shared and new expression go through. Allocations are only counted on tracked threads (the thread that runs the
+    // engine), so that background threads (asset loading, telemetry) do not show up in the counts of the frame they overlap. Jobs of
+    // JobSystem::parallelFor are tracked if the thread that called it is.
+    // In debug builds, the allocations of tracked threads are also attributed to the innermost allocation scope (LUNAR_ALLOCATION_SCOPE) that
+    // was open on the thread when they were made. Jobs of JobSystem::parallelFor run in the scope of the thread that called it.
+    class AllocationTracker
+    {
+      public:
+        // Whether the allocations of the calling thread are counted (threads are not tracked by default).
+        [[nodiscard]] static bool isCurrentThreadTracked();
+        static void setCurrentThreadTracked(const bool tracked);
+
+        // Totals of all tracked threads since the start of the program.
+        [[nodiscard]] static AllocationCounters getCounters();
+
+        // Allocation scopes of the allocations counted since the last resetCallSites() (empty unless DEF_LUNAR_DEBUG is defined), most
+        // allocations first. Allocates, so it must not be called between counter reads that are expected not to change.
+        [[nodiscard]] static std::vector<AllocationCallSite> getCallSites();
+        static void resetCallSites();
+
+        // Innermost allocation scope of the calling thread, or null.
+        [[nodiscard]] static const char* getCurrentScope();
+        static void setCurrentScope(const char* name);
+
+      public:
+        // Name of the call site of the allocations made outside of any allocation scope.
+        static constexpr const char* UNSCOPED_CALL_SITE_NAME = "(no allocation scope)";
+    };
+
+    class AllocationScope
+    {
+      public:
+        explicit AllocationScope(const char* name) : m_previousName(AllocationTracker::getCurrentScope()) { AllocationTracker::setCurrentScope(name); }
+        ~AllocationScope() { AllocationTracker::setCurrentScope(m_previousName); }
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+      private:
+        const char* m_previousName{};
+    };
+}
+
+#ifdef DEF_LUNAR_DEBUG
+#define LUNAR_ALLOCATION_SCOPE_CONCAT_INNER(a, b) a##b
+#define LUNAR_ALLOCATION_SCOPE_CONCAT(a, b) LUNAR_ALLOCATION_SCOPE_CONCAT_INNER(a, b)
+
+// Attributes the allocations made from here to the end of the enclosing scope to name (in debug builds). name must be a string literal.
+#define LUNAR_ALLOCATION_SCOPE(name) const ::lunar::AllocationScope LUNAR_ALLOCATION_SCOPE_CONCAT(allocationScope, __LINE__){name}
+#else
+#define LUNAR_ALLOCATION_SCOPE(name)
+#endif
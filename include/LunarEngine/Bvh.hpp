@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Culling.hpp"
+#include "Types.hpp"
+
+namespace lunar
+{
+    // World space axis aligned bounding box.
+    struct Aabb
+    {
+        math::XMFLOAT3 min{};
+        math::XMFLOAT3 max{};
+
+        // Bounds of the object space box transformed by modelMatrix.
+        [[nodiscard]] static Aabb fromBoundingBox(const BoundingBox& boundingBox, const math::XMMATRIX& modelMatrix);
+
+        [[nodiscard]] static Aabb merge(const Aabb& a, const Aabb& b);
+
+        [[nodiscard]] float getSurfaceArea() const;
+        [[nodiscard]] bool contains(const Aabb& other) const;
+    };
+
+    [[nodiscard]] bool intersects(const Aabb& a, const Aabb& b);
+    [[nodiscard]] bool intersectsSphere(const Aabb& aabb, const math::XMFLOAT3& center, const float radius);
+
+    // Conservative in the same way as Frustum::intersectsSphere.
+    [[nodiscard]] bool intersectsFrustum(const Aabb& aabb, const Frustum& frustum);
+
+    // Returns the distance along the ray at which it enters the box (0 if the origin is inside it), if that is at most maxDistance.
+    [[nodiscard]] std::optional<float> intersectRay(const Aabb& aabb, const math::XMFLOAT3& origin, const math::XMFLOAT3& direction, const float maxDistance);
+
+    struct BvhRayHit
+    {
+        uint32_t userData{INVALID_U32};
+        float distance{};
+    };
+
+    struct BvhStatistics
+    {
+        uint32_t leafCount{};
+        uint32_t height{};
+
+        // Surface area of the internal nodes relative to the root's (lower is better, the expected number of nodes a random ray visits).
+        float sahCost{};
+    };
+
+    // Dynamic bounding volume hierarchy with one object per leaf, used for spatial queries over the scene (frustum culling, picking, overlap
+    // tests) in less than linear time.
+    // The tree is built top down with a binned surface area heuristic (SAH). Objects can then be inserted (at the sibling that minimizes the
+    // SAH cost increase), removed, or moved : moved leaves only mark their ancestors, and refit() updates the bounds of marked nodes in a single
+    // bottom up pass. Every refit node is also rotated (a grandchild swapped with its uncle) if that reduces the surface area of its children,
+    // so the tree quality does not degrade as objects move.
+    // Queries only test the leaf bounds, callers do any exact test themselves.
+    class DynamicBvh
+    {
+      public:
+        // Replaces the tree with one built from the bounds (the user data of object i is i). Returns the leaf node of every object.
+        [[nodiscard]] std::vector<uint32_t> build(std::span<const Aabb> bounds);
+        void clear();
+
+        // Returns the leaf node of the object.
+        [[nodiscard]] uint32_t insert(const Aabb& bounds, const uint32_t userData);
+        void remove(const uint32_t leaf);
+
+        // The bounds of the leaf's ancestors are only updated on the next refit().
+        void update(const uint32_t leaf, const Aabb& bounds);
+        void refit();
+
+        // The user data of every leaf that intersects the frustum / box / sphere is appended to results.
+        void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+        void queryAabb(const Aabb& aabb, std::vector<uint32_t>& results) const;
+        void querySphere(const math::XMFLOAT3& center, const float radius, std::vector<uint32_t>& results) const;
+
+        // Returns the closest leaf hit by the ray (direction need not be normalized, distances are in multiples of its length).
+        [[nodiscard]] std::optional<BvhRayHit> raycast(const math::XMFLOAT3& origin, const math::XMFLOAT3& direction, const float maxDistance) const;
+
+        [[nodiscard]] uint32_t getUserData(const uint32_t leaf) const { return m_nodes[leaf].userData; }
+        [[nodiscard]] const Aabb& getBounds(const uint32_t node) const { return m_nodes[node].bounds; }
+
+        [[nodiscard]] BvhStatistics getStatistics() const;
+
+      private:
+        struct Node
+        {
+            Aabb bounds{};
+
+            uint32_t parent{INVALID_U32};
+            std::array<uint32_t, 2> children{INVALID_U32, INVALID_U32};
+
+            // Only valid for leaves.
+            uint32_t userData{INVALID_U32};
+
+            // Set on the ancestors of updated leaves, cleared by refit().
+            bool needsRefit{false};
+
+            [[nodiscard]] bool isLeaf() const { return children[0] == INVALID_U32; }
+        };
+
+        [[nodiscard]] uint32_t allocateNode();
+        void freeNode(const uint32_t node);
+
+        // Builds the subtree over the items (indices into bounds) and returns its root. The items are reordered.
+        [[nodiscard]] uint32_t buildRecursive(std::span<const Aabb> bounds, std::span<uint32_t> items, std::span<uint32_t> leaves, const uint32_t parent);
+
+        // Returns the node that, as the sibling of a new leaf with the given bounds, increases the SAH cost of the tree the least.
+        [[nodiscard]] uint32_t findBestSibling(const Aabb& bounds) const;
+
+        // Recomputes the bounds of the node (whose children are up to date) and of its ancestors, rotating each of them.
+        void refitAncestors(uint32_t node);
+        void refitMarked(const uint32_t node);
+
+        // Marks the node and its ancestors (a marked node always has a marked parent, so this stops at the first marked one).
+        void markForRefit(uint32_t node);
+
+        // Swaps a grandchild of the internal node with its uncle if that reduces the surface area of the grandchild's parent.
+        void rotate(const uint32_t node);
+
+        void appendLeaves(const uint32_t node, std::vector<uint32_t>& results) const;
+
+      private:
+        std::vector<Node> m_nodes{};
+        std::vector<uint32_t> m_freeNodes{};
+
+        uint32_t m_root{INVALID_U32};
+        uint32_t m_leafCount{};
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    // View frustum as 6 normalized planes (xyz is the normal pointing inside the frustum, w the distance), extracted from a view projection
+    // matrix (row vector convention, Direct3D clip space with depth in [0, 1]).
+    struct Frustum
+    {
+        std::array<math::XMFLOAT4, 6> planes{};
+
+        [[nodiscard]] static Frustum fromViewProjection(const math::XMMATRIX& viewProjectionMatrix);
+
+        // Conservative : spheres that intersect the frustum's corner regions may be reported as visible.
+        [[nodiscard]] bool intersectsSphere(const math::XMVECTOR center, const float radius) const;
+    };
+
+    struct CullingStatistics
+    {
+        uint32_t visibleCount{};
+        uint32_t culledCount{};
+    };
+
+    // Frustum culls a set of objects, CULLING_BATCH_SIZE at a time. The world space bounds of the objects are stored in a structure of arrays
+    // layout (padded to a multiple of the batch size), so that each plane test is a few SIMD operations for the whole batch.
+    // An object is visible if both its bounding sphere and its bounding box intersect every plane.
+    class FrustumCuller
+    {
+      public:
+        // Number of objects tested at once (the number of lanes of an XMVECTOR).
+        static constexpr size_t CULLING_BATCH_SIZE = 4u;
+
+        void resize(const size_t objectCount);
+
+        // Transforms the object space bounds of the object to world space.
+        void setBounds(const size_t objectIndex, const math::XMMATRIX& modelMatrix, const BoundingBox& boundingBox, const math::XMFLOAT4& boundingSphere);
+
+        CullingStatistics cull(const Frustum& frustum) { return cull(frustum, 0u, m_objectCount); }
+
+        // Culls the objects in [firstObject, firstObject + objectCount) only. firstObject must be a multiple of CULLING_BATCH_SIZE, so that
+        // disjoint ranges can be culled (and their bounds set) concurrently.
+        CullingStatistics cull(const Frustum& frustum, const size_t firstObject, const size_t objectCount);
+
+        // Valid after cull().
+        [[nodiscard]] bool isVisible(const size_t objectIndex) const { return m_visibility[objectIndex] != 0u; }
+
+        [[nodiscard]] size_t getObjectCount() const { return m_objectCount; }
+
+      private:
+        size_t m_objectCount{};
+
+        // World space bounds, one element per object.
+        std::vector<float> m_centerX{};
+        std::vector<float> m_centerY{};
+        std::vector<float> m_centerZ{};
+        std::vector<float> m_radius{};
+        std::vector<float> m_extentX{};
+        std::vector<float> m_extentY{};
+        std::vector<float> m_extentZ{};
+
+        std::vector<uint8_t> m_visibility{};
+    };
+
+    // Largest scale of the axes of a model matrix (used to scale bounding spheres / errors from object space to world space).
+    [[nodiscard]] float getMaxScale(const math::XMMATRIX& modelMatrix);
+
+    // World space data used to cull the meshlets of a render object.
+    struct MeshletCullingContext
+    {
+        Frustum frustum{};
+        math::XMFLOAT3 cameraPosition{};
+    };
+
+    // Returns true if the meshlet (transformed by modelMatrix, whose largest axis scale is maxScale) is outside the frustum or entirely
+    // backfacing. The cone test assumes a uniform scale.
+    [[nodiscard]] bool isMeshletCulled(const Meshlet& meshlet, const math::XMMATRIX& modelMatrix, const float maxScale, const MeshletCullingContext& context);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MemoryTracker.hpp"
+#include "Resources.hpp"
+
+namespace lunar
+{
+    // Destroys GPU objects once the GPU no longer uses them, so that objects can be replaced mid session (ex when the scene changes) without
+    // waiting for the device to be idle.
+    // An object is retired with the number of the last frame that may use it (the frame being recorded), and is destroyed by collect() once
+    // that frame has completed (i.e its render fence has signaled). Objects that live as long as the engine are destroyed by flush(), at shutdown.
+    // Every object type has its own arrays, so objects are destroyed with one loop per type (no type erasure), and once the arrays have
+    // reached their peak size, retiring an object does not allocate. Types are destroyed in the order of ObjectArrayTuple, objects before the
+    // objects they are created from or with (ex pipelines before their layouts, image views before images, and everything before the swapchain).
+    class DeferredDestructionQueue
+    {
+      public:
+        void init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker);
+
+        // Frame numbers must not decrease from one call to the next. Buffers and images are untracked from the memory tracker when destroyed.
+        template <typename T> void retire(const T& object, const uint64_t frameNumber)
+        {
+            std::get<ObjectArrays<T>>(m_objectArrays).retiredObjects.emplace_back(frameNumber, object);
+        }
+
+        template <typename T> void destroyAtShutdown(const T& object) { std::get<ObjectArrays<T>>(m_objectArrays).shutdownObjects.push_back(object); }
+
+        // Destroys the objects retired by frames up to completedFrameNumber.
+        void collect(const uint64_t completedFrameNumber);
+
+        // Destroys every object, retired or not. The device must be idle.
+        void flush();
+
+      private:
+        template <typename T> struct ObjectArrays
+        {
+            // In the order they were retired, so frame numbers never decrease.
+            std::vector<std::pair<uint64_t, T>> retiredObjects{};
+            std::vector<T> shutdownObjects{};
+        };
+
+        using ObjectArrayTuple = std::tuple<ObjectArrays<vk::Pipeline>,
+                                            ObjectArrays<vk::PipelineLayout>,
+                                            ObjectArrays<vk::ShaderModule>,
+                                            ObjectArrays<vk::DescriptorPool>,
+                                            ObjectArrays<vk::DescriptorSetLayout>,
+                                            ObjectArrays<vk::PipelineCache>,
+                                            ObjectArrays<vk::ImageView>,
+                                            ObjectArrays<Image>,
+                                            ObjectArrays<Buffer>,
+                                            ObjectArrays<vk::QueryPool>,
+                                            ObjectArrays<vk::CommandPool>,
+                                            ObjectArrays<vk::Semaphore>,
+                                            ObjectArrays<vk::Fence>,
+                                            ObjectArrays<vk::SwapchainKHR>>;
+
+        template <typename T> void collect(ObjectArrays<T>& objectArrays, const uint64_t completedFrameNumber);
+        template <typename T> void flush(ObjectArrays<T>& objectArrays);
+
+        template <typename T> void destroy(const T& object);
+        void destroy(const Buffer& buffer);
+        void destroy(const Image& image);
+
+      private:
+        vk::Device m_device{};
+        VmaAllocator m_allocator{};
+        MemoryTracker* m_memoryTracker{};
+
+        ObjectArrayTuple m_objectArrays{};
+    };
+}
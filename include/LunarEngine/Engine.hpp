@@ -1,69 +1,298 @@
 #pragma once
 
+#include "Bvh.hpp"
+#include "Culling.hpp"
+#include "DeferredDestructionQueue.hpp"
+#include "GeometryPool.hpp"
+#include "MeshCache.hpp"
+#include "Profiler.hpp"
 #include "Resources.hpp"
+#include "JobSystem.hpp"
+#include "RenderGraph.hpp"
+#include "ThreadPool.hpp"
 #include "Types.hpp"
+#include "UploadManager.hpp"
 
 struct SDL_Window;
 
-namespace tinygltf
-{
-    struct Model;
-}
-
 namespace lunar
 {
+    struct EngineConfig
+    {
+        // In headless mode no window, surface or swapchain is created, and frames are rendered into offscreen targets.
+        bool headless{false};
+        vk::Extent2D headlessExtent{1920u, 1080u};
+
+        // If non zero, the engine renders this many frames (after the warmup frames), and then reports frame time statistics and exits.
+        uint32_t benchmarkFrameCount{0u};
+        uint32_t benchmarkWarmupFrameCount{16u};
+
+        // The coarsest LOD whose projected geometric error is below this threshold (in pixels) is drawn.
+        float lodErrorThreshold{1.0f};
+
+        // If true, meshlets of objects drawn at full detail are culled individually.
+        bool meshletCulling{true};
+
+        // Size (in bytes) of the vertex and index buffers every mesh is suballocated from.
+        uint64_t geometryPoolVertexCapacity{128ull * 1024ull * 1024ull};
+        uint64_t geometryPoolIndexCapacity{64ull * 1024ull * 1024ull};
+
+        // Size (in bytes) of the per frame upload arena, which holds the scene constants and the object / instance transforms of a frame.
+        uint32_t frameArenaSize{32u * 1024u * 1024u};
+
+        // Size (in bytes) of the staging ring that uploads to GPU only buffers go through.
+        uint32_t stagingRingSize{64u * 1024u * 1024u};
+
+        // If true, render objects are culled and their LOD selected by a compute shader, which writes the draw commands that are then drawn
+        // with one drawIndexedIndirectCount per material. Else, the CPU records one draw per render object submesh.
+        bool gpuDrivenRendering{false};
+
+        // If true, the CPU path draws visible render objects that share a material, mesh and LOD with one instanced draw per submesh. Submeshes
+        // and meshlets of instanced render objects are not culled individually.
+        bool instancing{true};
+
+        // If true, the CPU path frustum culls render objects by traversing the scene BVH, else every render object is tested.
+        bool bvhCulling{true};
+
+        // If true, the draws of the CPU path are recorded into secondary command buffers by several jobs (when there are enough of them).
+        bool parallelCommandRecording{true};
+
+        // If true, the compiled render graph (passes, barriers and transient images) is printed for the first frame, and for the first frame
+        // after the draw path is switched.
+        bool dumpRenderGraph{false};
+
+        // If non zero, CPU and GPU profiler scopes of this many frames (from startup) are written to profileOutputPath as a Chrome trace.
+        // Ignored unless the profiler scopes are compiled in (see LUNAR_PROFILING in CMakeLists.txt).
+        uint32_t profileFrameCount{0u};
+        std::string profileOutputPath{"profile.json"};
+
+        // If not empty, the render statistics of every frame are streamed to this file (by a writer thread, so the frame never waits on it).
+        std::string telemetryOutputPath{};
+        TelemetryFormat telemetryFormat{TelemetryFormat::eCsv};
+
+        // The memory budget watchdog warns when the usage of a memory heap goes above this fraction of its budget.
+        float memoryBudgetWarningThreshold{0.9f};
+
+        // If true, a benchmark fails (fatalError) as soon as a frame after the warmup frames makes a heap allocation, listing the allocation
+        // scopes they were made in (in debug builds). Profile captures allocate their events, so profileFrameCount should be zero.
+        bool assertNoFrameAllocations{false};
+
+        // Number of static render objects placed on a grid in front of the camera, in addition to the default scene (used to benchmark draw submission).
+        uint32_t sceneObjectCount{0u};
+    };
+
+    // CPU side data of a mesh : either a view into its mesh cache file (warm path), or the imported and encoded mesh (cold path).
+    struct LoadedMesh
+    {
+        std::optional<MeshCacheView> meshCache{};
+        PackedMeshData packedMeshData{};
+    };
+
+    // Result of loading a streamed mesh on an asset loader thread.
+    struct StreamedMeshLoad
+    {
+        std::string meshName{};
+        uint64_t loadRequestId{};
+        LoadedMesh loadedMesh{};
+
+        // Set if loading failed.
+        std::exception_ptr exception{};
+    };
+
     class Engine
     {
       public:
         Engine() = default;
+        explicit Engine(const EngineConfig& config) : m_config(config) {}
         ~Engine();
 
         void init();
         void run();
 
+        // Valid only after run() has returned in benchmark mode.
+        [[nodiscard]] const BenchmarkResults& getBenchmarkResults() const { return m_benchmarkResults; }
+
+        // Returns the mesh right away, and loads it on the asset loader threads. Its geometry is uploaded once it is loaded, and render objects
+        // that use it are not drawn until it is resident. If a mesh with this name exists, it is returned instead.
+        Mesh* requestMesh(const std::string_view meshName, const std::string_view modelPath, const VertexFormat vertexFormat = VertexFormat::eFull);
+
+        // Blocks until every requested mesh has been loaded and its upload has completed.
+        void waitForStreamedMeshes();
+
+        // Removes the mesh and every render object that uses it. Its geometry is released once the frames in flight have completed.
+        void destroyMesh(const std::string_view meshName);
+
+        // Packs the geometry of all meshes to the start of the geometry pool buffers. Waits for the device to be idle.
+        void defragmentGeometryPool();
+
+        // Returns the index of the closest render object whose bounds are under the pixel, as seen from the camera of the last rendered frame.
+        [[nodiscard]] std::optional<uint32_t> pickRenderObject(const math::XMFLOAT2& pixelPosition) const;
+
+        // Sets the model matrix of the render object, and moves it in the scene BVH.
+        void setRenderObjectTransform(const uint32_t objectIndex, const math::XMMATRIX& modelMatrix);
+
+        // Spatial index over the world space bounds of the render objects (for culling, picking and overlap queries).
+        [[nodiscard]] const DynamicBvh& getSceneBvh() const { return m_sceneBvh; }
+
+        // Number of render objects that passed / failed frustum culling in the last frame (CPU path only).
+        [[nodiscard]] const CullingStatistics& getCullingStatistics() const { return m_cullingStatistics; }
+
+        // Commands recorded (draws, binds, ...) and data uploaded by the last frame.
+        [[nodiscard]] const RenderStatistics& getRenderStatistics() const { return m_renderStatistics; }
+
+        // Writes a JSON report of the device memory used by the engine : budget and usage of each heap, totals of each allocation category, and
+        // VMA's stats dump. In windowed mode, M writes one to memory_report.json.
+        void writeMemoryReport(const std::string_view path) const { m_memoryTracker.writeReport(path); }
+
+        // Switches between the CPU and GPU driven draw paths (takes effect from the next frame).
+        void setGpuDrivenRendering(const bool enabled) { m_config.gpuDrivenRendering = enabled; }
+
       private:
         void initVulkan();
         void initSwapchain();
+        void initOffscreenTargets();
         void initCommandObjects();
         void initSyncPrimitives();
+        void initQueryPools();
+        void initPipelineCache();
         void initDescriptors();
         void initPipelines();
         void initMeshes();
         void initScene();
 
+        // Rebuilds the scene BVH from all render objects (required when render objects are removed, as that changes their indices).
+        void buildSceneBvh();
+
+        // Creates the buffers used by the GPU driven path from the current render objects into the pending scene, and records their uploads
+        // without waiting for them. swapGpuDrivenScene() makes it the scene that is drawn from once the uploads have completed : the previous
+        // buffers are retired to the deferred destruction queue, and the descriptor set of each frame data is rewritten before its next use
+        // (it may be in use by a frame in flight), so neither the frame nor the device has to wait.
+        void buildGpuDrivenScene();
+        void swapGpuDrivenScene();
+        [[nodiscard]] Buffer createGpuDrivenSceneBuffer(const size_t elementCount, const size_t elementSize, const vk::BufferUsageFlags usage, const std::string_view name);
+        void writeGpuDrivenDescriptorSet(FrameData& frameData);
+
+        // Called when render objects are removed or geometry moves, which the draw items refer to : nothing is drawn by the GPU driven path
+        // until the rebuilt scene is swapped in.
+        void invalidateGpuDrivenScene();
+
+        // Retires the buffers of the current and pending scenes (the pending uploads must have completed).
+        void destroyGpuDrivenScene();
+
         void render();
 
+        // Reads back the GPU timestamps written by the last submission that used this frame data. Must be called only after its render fence is signaled.
+        void readGpuFrameTime(FrameData& frameData);
+        void reportBenchmarkResults();
+
+        // Writes the pipeline cache to disk, so that the next launch can skip most pipeline compilation.
+        void savePipelineCache();
+
         void cleanup();
 
         FrameData& getCurrentFrameData() { return m_frameData[m_frameNumber % FRAME_COUNT]; }
+        const FrameData& getCurrentFrameData() const { return m_frameData[m_frameNumber % FRAME_COUNT]; }
 
       private:
         [[nodiscard]] vk::ShaderModule createShaderModule(const std::string_view shaderPath);
 
-        // Creates GPU buffer and updates the deletion queue internally.
-        // If data is a nullptr, it will create a buffer with CPU write access.
-        [[nodiscard]] Buffer createGPUBuffer(const vk::BufferCreateInfo bufferCreateInfo, const void* data = nullptr);
-
-        // Copies the data from staging buffer to the respective src buffers. Called upload rather than 'copy buffers' as it sounds close to uploading data onto GPU only buffer.
-        // Might find a more suitable name as two different names (i.e copy buffer / upload buffer) is being used in the project now.
-        void uploadBuffers();
+        // Creates GPU buffer, destroyed at shutdown by the deferred destruction queue.
+        // If data is a nullptr, it will create a buffer with CPU write access. Else, the data is uploaded through the upload manager.
+        [[nodiscard]] Buffer createGPUBuffer(const vk::BufferCreateInfo bufferCreateInfo, const std::string_view name, const void* data = nullptr);
 
         [[nodiscard]] vk::Pipeline createPipeline(const PipelineCreationDesc& pipelineCreationDesc,
                                                   const vk::PipelineLayout& pipelineLayout);
 
+        // Returns the LOD of the render object's mesh to draw, from the projected screen space error of its LODs. projectionScale converts a
+        // length at a view space depth of 1 into pixels.
+        [[nodiscard]] uint32_t selectLod(const RenderObject& renderObject, const math::XMMATRIX& viewProjectionMatrix, const float projectionScale) const;
+
+        // Records one draw per submesh of each of the render objects (that passed frustum culling and are not instanced, CPU driven path).
+        // Only reads engine state, so disjoint ranges of the visible render objects can be recorded concurrently.
+        void drawRenderObjects(const vk::CommandBuffer& cmd, std::span<const uint32_t> objectIndices, const MeshletCullingContext& meshletCullingContext,
+                               RenderStatistics& statistics) const;
+
+        // Groups the visible render objects that share a material, mesh and LOD, and writes the model matrices of each group into the
+        // instance buffer of the current frame. Render objects that are alone in their group are left in m_visibleObjectIndices.
+        void buildInstanceGroups();
+
+        // Records one instanced draw per submesh of each of the instance groups (CPU driven path).
+        void drawInstanceGroups(const vk::CommandBuffer& cmd, std::span<const InstanceGroup> instanceGroups, RenderStatistics& statistics) const;
+
+        // Records the draws of the CPU driven path, in [firstDraw, lastDraw) of the list made of the instance groups followed by the visible
+        // render objects. Binds all the state it uses, so it can record into a secondary command buffer. The recorded commands are counted into
+        // statistics (each recording job has its own).
+        void recordDraws(const vk::CommandBuffer& cmd, const size_t firstDraw, const size_t lastDraw, const MeshletCullingContext& meshletCullingContext,
+                         RenderStatistics& statistics) const;
+
+        // Splits the draws of the CPU driven path into chunks, records each into a secondary command buffer of the current frame (one job per
+        // chunk), and executes them from cmd. Must be called inside a render pass instance begun with the secondary command buffers contents flag.
+        void recordDrawsInParallel(const vk::CommandBuffer& cmd, const MeshletCullingContext& meshletCullingContext);
+
+        // Records the culling compute dispatch, which writes the draw commands of the current frame (GPU driven path). The draw counts must
+        // have been cleared before.
+        void dispatchGpuCulling(const vk::CommandBuffer& cmd, const Frustum& frustum, const math::XMMATRIX& viewProjectionMatrix, const float projectionScale);
+
+        // Records one drawIndexedIndirectCount per indirect draw batch (GPU driven path).
+        void drawIndirectBatches(const vk::CommandBuffer& cmd);
+
+        // Records the draws of the meshlets of the submesh that survive frustum and normal cone culling.
+        void drawVisibleMeshlets(const vk::CommandBuffer& cmd, const Submesh& submesh, const Mesh& mesh, const GeometryAllocation& geometryAllocation,
+                                 const math::XMMATRIX& modelMatrix, const MeshletCullingContext& meshletCullingContext, RenderStatistics& statistics) const;
+
+        // Returns the material whose pipeline matches the vertex format of the mesh.
+        [[nodiscard]] Material* getMaterialForMesh(const Mesh& mesh);
+
         // Mesh creation functions.
-        [[nodiscard]] Mesh createMesh(const std::string_view modelPath);
+        // Meshes are loaded from the binary mesh cache if it is up to date, else imported from the glTF file (and the cache is written).
+        [[nodiscard]] Mesh createMesh(const std::string_view modelPath, const VertexFormat vertexFormat = VertexFormat::eFull);
+
+        // Loads the CPU side data of a mesh. Only reads state that is constant after init (and uses the thread safe job system), so it can be
+        // called from any thread.
+        [[nodiscard]] LoadedMesh loadMesh(const std::string_view modelPath, const VertexFormat vertexFormat);
+        [[nodiscard]] Mesh uploadLoadedMesh(const LoadedMesh& loadedMesh);
+
+        // Uploads the meshes loaded by the asset loader threads since the last call.
+        void commitLoadedMeshes();
+
+        // Marks meshes whose upload has completed as resident. Uploads that have completed by now are acquired by the next recorded frame.
+        void updateMeshResidency();
+
+        // Records a copy of data (through the staging ring of the upload manager) into buffer at the given offset.
+        UploadTicket copyToGPUBuffer(const vk::Buffer buffer, const vk::DeviceSize offset, std::span<const std::byte> data);
+
+        // Suballocates the vertex and index data of a mesh (already encoded as described by encoding) from the geometry pool.
+        [[nodiscard]] Mesh uploadMesh(const MeshEncoding& encoding, std::span<const std::byte> vertexData, std::span<const std::byte> indexData,
+                                      std::span<const Submesh> submeshes);
 
       public:
         static constexpr uint32_t FRAME_COUNT = 2u;
 
+        // Mesh loading is mostly I/O and is parallelized internally (on m_jobSystem), so a few loader threads are enough.
+        static constexpr uint32_t ASSET_LOADER_THREAD_COUNT = 2u;
+
+        // Minimum number of draws recorded per secondary command buffer. Frames with fewer draws are recorded directly into the primary one.
+        static constexpr size_t DRAWS_PER_RECORDING_JOB = 256u;
+
+        // Minimum number of elements per job for the per object loops of a frame, so that small scenes run them inline on the main thread.
+        static constexpr size_t CULLING_BATCHES_PER_JOB = 256u;
+        static constexpr size_t LOD_SELECTIONS_PER_JOB = 512u;
+        static constexpr size_t TRANSFORM_COPIES_PER_JOB = 4096u;
+
       private:
+        EngineConfig m_config{};
+
         SDL_Window* m_window{};
         vk::Extent2D m_windowExtent{};
         uint64_t m_frameNumber{};
 
         std::string m_rootDirectory{};
-        DeletionQueue m_deletionQueue{};
+
+        // Destroys the objects owned by the engine at shutdown, and the objects replaced mid session once the frames that use them complete.
+        DeferredDestructionQueue m_deferredDestructionQueue{};
+
+        // Used for CPU heavy work that can be split up (ex decoding mesh primitives, culling).
+        JobSystem m_jobSystem{};
 
         // Core vulkan structures.
         vk::Instance m_instance{};
@@ -74,6 +303,8 @@ namespace lunar
 
         vk::SwapchainKHR m_swapchain{};
         uint32_t m_swapchainImageCount{};
+
+        // In headless mode, this is the format of the offscreen render targets.
         vk::Format m_swapchainImageFormat{};
         std::vector<vk::Image> m_swapchainImages{};
         std::vector<vk::ImageView> m_swapchainImageViews{};
@@ -84,30 +315,98 @@ namespace lunar
         vk::Queue m_transferQueue{};
         uint32_t m_transferQueueIndex{};
 
-        vk::CommandPool m_transferCommandPool{};
-        vk::CommandBuffer m_transferCommandBuffer{};
+        // All uploads to GPU only buffers go through the transfer queue. Completed uploads are acquired by the next frame's command buffer.
+        UploadManager m_uploadManager{};
 
         std::array<FrameData, FRAME_COUNT> m_frameData{};
 
         VmaAllocator m_vmaAllocator{};
 
-        Image m_depthImage{};
-        vk::ImageView m_depthImageView{};
+        // Every VMA allocation is tagged with a category and name, for the memory reports and budget watchdog.
+        MemoryTracker m_memoryTracker{};
+
+        // Passes of a frame, and the transient images they use (ex the depth buffer).
+        RenderGraph m_renderGraph{};
         vk::Format m_depthImageFormat{vk::Format::eD32Sfloat};
-        
-        // Holds all the staging buffers and the GPU only buffers together. All staging buffers will be destroyed at the end of the delete function.
-        // This means we can batch commands rather than submitted a buffer to the queue for the creation of each buffer. 
-        std::vector<BufferUploadData> m_bufferUploadData{};
-        DeletionQueue m_uploadBufferDeletionQueue{};
+        bool m_renderGraphDumpPending{true};
+
+        // Timestamp queries of the profiler scopes are per frame data, like the frame time ones.
+        Profiler m_profiler{};
 
         // Each frame will have a descriptor set, but the layout and pool they are allocated from remain unique.
         vk::DescriptorPool m_descriptorPool{};
         vk::DescriptorSetLayout m_globalDescriptorSetLayout{};
 
+        // Pipeline cache, persisted to disk and keyed by the device's pipeline cache UUID and driver version.
+        vk::PipelineCache m_pipelineCache{};
+        std::string m_pipelineCachePath{};
+        bool m_pipelineCacheWarm{false};
+
         // Scene management : Materials (i.e pipeline + pipeline layout) and meshes will be unordered maps, and render objects will be a material + mesh + transform buffer.
         std::unordered_map<std::string, Mesh> m_meshes{};
         std::unordered_map<std::string, Material> m_materials{};
 
         std::vector<RenderObject> m_renderObjects{};
+
+        // Vertex and index data of every mesh.
+        GeometryPool m_geometryPool{};
+
+        // CPU frustum culling of the render objects. The indices of visible render objects are in ascending order.
+        DynamicBvh m_sceneBvh{};
+        FrustumCuller m_frustumCuller{};
+        std::vector<uint32_t> m_visibleObjectIndices{};
+        CullingStatistics m_cullingStatistics{};
+
+        // Statistics of the frame being recorded (of the last frame once render() returns), and of each draw recording job.
+        RenderStatistics m_renderStatistics{};
+        std::vector<RenderStatistics> m_recordingJobStatistics{};
+        TelemetryWriter m_telemetryWriter{};
+
+        // Instancing (CPU driven path).
+        vk::DescriptorSetLayout m_instanceDescriptorSetLayout{};
+        std::vector<InstanceGroup> m_instanceGroups{};
+
+        // Camera of the last rendered frame.
+        math::XMMATRIX m_viewProjectionMatrix{};
+
+        // GPU driven rendering. The per frame buffers are in FrameData.
+        vk::DescriptorSetLayout m_gpuDrivenDescriptorSetLayout{};
+        vk::PipelineLayout m_gpuCullingPipelineLayout{};
+        vk::Pipeline m_gpuCullingPipeline{};
+
+        // The scene that is drawn from, and a rebuild of it whose uploads have not completed yet (swapped in once they have).
+        GpuDrivenScene m_gpuDrivenScene{};
+        GpuDrivenScene m_pendingGpuDrivenScene{};
+        bool m_gpuDrivenScenePending{false};
+
+        // Set when meshes become resident or render objects / geometry change, so that the GPU driven scene is rebuilt by the next frame that
+        // uses the GPU driven path.
+        bool m_gpuDrivenSceneDirty{false};
+
+        // Asset streaming : meshes loaded by the asset loader threads, waiting to be uploaded by the main thread.
+        std::vector<StreamedMeshLoad> m_loadedMeshes{};
+        std::mutex m_loadedMeshesMutex{};
+        std::condition_variable m_loadedMeshesCondition{};
+        uint32_t m_meshLoadsInFlight{};
+        uint64_t m_nextMeshLoadRequestId{};
+
+        // Startup timings.
+        double m_initTimeMs{};
+        double m_pipelineCreationTimeMs{};
+        uint32_t m_pipelineCount{};
+
+        // Benchmark related.
+        bool m_gpuTimestampsSupported{false};
+        float m_timestampPeriod{};
+        uint32_t m_timestampValidBits{};
+        std::vector<double> m_cpuFrameTimes{};
+        std::vector<double> m_gpuFrameTimes{};
+        uint64_t m_visibleObjectCountSum{};
+        uint64_t m_culledObjectCountSum{};
+        RenderStatistics m_renderStatisticsSum{};
+        BenchmarkResults m_benchmarkResults{};
+
+        // Declared last, so that its threads are joined before the members that loading tasks use are destroyed.
+        ThreadPool m_assetLoaderThreadPool{ASSET_LOADER_THREAD_COUNT};
     };
 }
\ No newline at end of file
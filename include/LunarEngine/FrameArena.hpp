@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MemoryTracker.hpp"
+
+namespace lunar
+{
+    // Location of an allocation in a frame arena : offset into the arena's buffer, and the persistently mapped CPU address of the allocation.
+    struct FrameArenaAllocation
+    {
+        uint32_t offset{};
+        std::byte* data{};
+    };
+
+    // Linear allocator over one persistently mapped, host visible buffer, used for data that the CPU writes every frame (scene constants,
+    // object / instance transforms). Allocations are bump allocated and bound by offset (dynamic offsets for uniform / storage buffer
+    // descriptors), and are all released at once by reset(), which must only be called once the GPU is done with the previous frame that used
+    // the arena (i.e after its fence has been waited on).
+    class FrameArena
+    {
+      public:
+        // Every allocation is aligned to at least minAlignment (the largest of the device's minimum dynamic offset alignments).
+        void init(const VmaAllocator allocator, MemoryTracker& memoryTracker, const uint32_t size, const vk::BufferUsageFlags usage, const uint32_t minAlignment);
+        void destroy();
+
+        void reset() { m_offset = 0u; }
+
+        // Fatal error if the arena does not have size bytes left.
+        [[nodiscard]] FrameArenaAllocation allocate(const uint32_t size, const uint32_t alignment = 1u);
+
+        // Allocates and copies the data, returning the offset of the allocation.
+        template <typename T> uint32_t push(const T& data, const uint32_t alignment = alignof(T))
+        {
+            const FrameArenaAllocation allocation = allocate(static_cast<uint32_t>(sizeof(T)), alignment);
+            std::memcpy(allocation.data, &data, sizeof(T));
+
+            return allocation.offset;
+        }
+
+        [[nodiscard]] vk::Buffer getBuffer() const { return m_buffer; }
+        [[nodiscard]] uint32_t getSize() const { return m_size; }
+        [[nodiscard]] uint32_t getUsedSize() const { return m_offset; }
+
+      private:
+        VmaAllocator m_allocator{};
+        MemoryTracker* m_memoryTracker{};
+
+        vk::Buffer m_buffer{};
+        VmaAllocation m_allocation{};
+        std::byte* m_mappedData{};
+
+        uint32_t m_size{};
+        uint32_t m_offset{};
+        uint32_t m_minAlignment{1u};
+    };
+}
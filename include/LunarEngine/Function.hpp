@@ -0,0 +1,60 @@
+#pragma once
+
+namespace lunar
+{
+    template <typename Signature> class FunctionRef;
+
+    // Non owning reference to a callable, for functions that only call it before they return (ex JobSystem::parallelFor). Unlike a
+    // std::function parameter, passing a lambda never allocates, whatever it captures. The callable must outlive the reference.
+    template <typename Return, typename... Args> class FunctionRef<Return(Args...)>
+    {
+      public:
+        template <typename Function>
+            requires(!std::is_same_v<std::remove_cvref_t<Function>, FunctionRef> && std::is_invocable_r_v<Return, Function&, Args...>)
+        FunctionRef(Function&& function)
+            : m_function(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+              m_invoke([](void* function, Args... args) -> Return { return (*static_cast<std::remove_reference_t<Function>*>(function))(std::forward<Args>(args)...); })
+        {
+        }
+
+        Return operator()(Args... args) const { return m_invoke(m_function, std::forward<Args>(args)...); }
+
+      private:
+        void* m_function{};
+        Return (*m_invoke)(void*, Args...){};
+    };
+
+    template <typename Signature, size_t Capacity> class InplaceFunction;
+
+    // Owning callable stored in a fixed size buffer, for callables kept after the call that provides them (ex the record functions of render
+    // graph passes). Never allocates : callables must fit in Capacity bytes, and be trivially copyable and destructible (lambdas that capture
+    // by reference, or capture trivially copyable values), which is checked at compile time.
+    template <typename Return, typename... Args, size_t Capacity> class InplaceFunction<Return(Args...), Capacity>
+    {
+      public:
+        InplaceFunction() = default;
+
+        template <typename Function>
+            requires(!std::is_same_v<std::remove_cvref_t<Function>, InplaceFunction> && std::is_invocable_r_v<Return, const std::remove_cvref_t<Function>&, Args...>)
+        InplaceFunction(Function&& function)
+        {
+            using StoredFunction = std::remove_cvref_t<Function>;
+
+            static_assert(sizeof(StoredFunction) <= Capacity, "Callable does not fit in the InplaceFunction (capture less, or by reference).");
+            static_assert(alignof(StoredFunction) <= alignof(std::max_align_t), "Callable is over aligned.");
+            static_assert(std::is_trivially_copyable_v<StoredFunction> && std::is_trivially_destructible_v<StoredFunction>,
+                          "Callable must be trivially copyable and destructible (capture by reference, or trivially copyable values).");
+
+            new (m_storage.data()) StoredFunction(std::forward<Function>(function));
+            m_invoke = [](const void* function, Args... args) -> Return { return (*static_cast<const StoredFunction*>(function))(std::forward<Args>(args)...); };
+        }
+
+        Return operator()(Args... args) const { return m_invoke(m_storage.data(), std::forward<Args>(args)...); }
+
+        [[nodiscard]] explicit operator bool() const { return m_invoke != nullptr; }
+
+      private:
+        alignas(std::max_align_t) std::array<std::byte, Capacity> m_storage{};
+        Return (*m_invoke)(const void*, Args...){};
+    };
+}
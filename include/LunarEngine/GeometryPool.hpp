@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    // Location of a mesh's vertex / index data in the geometry pool.
+    struct GeometryAllocation
+    {
+        VmaVirtualAllocation vertexAllocation{};
+        VmaVirtualAllocation indexAllocation{};
+
+        uint64_t vertexDataSize{};
+        uint64_t indexDataSize{};
+
+        uint32_t vertexStride{};
+        uint32_t indexStride{};
+
+        // Added to the vertex offset / first index of the mesh's draws. The vertex data starts at baseVertex * vertexStride bytes in the vertex
+        // buffer, and the index data at baseIndex * indexStride bytes in the index buffer.
+        uint32_t baseVertex{};
+        uint32_t baseIndex{};
+
+        bool isAllocated{false};
+    };
+
+    struct GeometryPoolStatistics
+    {
+        uint32_t allocationCount{};
+
+        uint64_t vertexCapacity{};
+        uint64_t vertexBytesUsed{};
+        uint64_t indexCapacity{};
+        uint64_t indexBytesUsed{};
+
+        // Free bytes not in the largest free region, relative to all free bytes (0 means no fragmentation).
+        float vertexFragmentation{};
+        float indexFragmentation{};
+    };
+
+    // Buffers that were replaced by defragmentation, to be destroyed once the copies out of them have completed.
+    struct RetiredGeometryBuffers
+    {
+        Buffer vertexBuffer{};
+        Buffer indexBuffer{};
+    };
+
+    // One large vertex buffer and one large index buffer that every mesh is suballocated from (using VMA virtual blocks, i.e a TLSF allocator),
+    // so the geometry of the whole scene can be bound once.
+    // Vertex allocations are placed at a multiple of their vertex stride, so that meshes with different vertex formats can share the vertex
+    // buffer (bound at offset 0) and be addressed with a base vertex. Index allocations are 4 byte aligned, so both 16 and 32 bit indices can
+    // be addressed with a base index (the index buffer is rebound only when the index type changes).
+    class GeometryPool
+    {
+      public:
+        void init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker, const uint64_t vertexCapacity, const uint64_t indexCapacity);
+        void destroy();
+
+        // Returns std::nullopt if either buffer does not have a large enough free region.
+        [[nodiscard]] std::optional<GeometryHandle> allocate(const uint64_t vertexDataSize, const uint32_t vertexStride, const uint64_t indexDataSize,
+                                                             const uint32_t indexStride);
+
+        // The GPU may still be reading the allocation, so it is only released once frameNumber has completed (see releaseCompletedFrees).
+        void free(const GeometryHandle handle, const uint64_t frameNumber);
+        void releaseCompletedFrees(const uint64_t completedFrameNumber);
+
+        // Records copies of every live allocation into new buffers, where they are packed from offset 0, and returns the old buffers. The base
+        // vertex / base index of allocations change, so draws must look them up again. Pending frees are released, so the GPU must be idle.
+        [[nodiscard]] RetiredGeometryBuffers defragment(const vk::CommandBuffer commandBuffer);
+
+        void destroyRetiredBuffers(const RetiredGeometryBuffers& retiredBuffers);
+
+        [[nodiscard]] const GeometryAllocation& getAllocation(const GeometryHandle handle) const { return m_allocations[handle]; }
+
+        [[nodiscard]] vk::Buffer getVertexBuffer() const { return m_vertexBuffer.buffer; }
+        [[nodiscard]] vk::Buffer getIndexBuffer() const { return m_indexBuffer.buffer; }
+
+        [[nodiscard]] GeometryPoolStatistics getStatistics() const;
+
+      private:
+        [[nodiscard]] Buffer createBuffer(const uint64_t size, const vk::BufferUsageFlags usage, const MemoryCategory category, const std::string_view name) const;
+        [[nodiscard]] VmaVirtualBlock createVirtualBlock(const uint64_t size) const;
+
+        // Allocates size bytes from the block, at an offset that is a multiple of alignment (which does not have to be a power of two).
+        [[nodiscard]] static std::optional<uint64_t> allocateAligned(const VmaVirtualBlock block, const uint64_t size, const uint64_t alignment,
+                                                                     VmaVirtualAllocation& allocation);
+
+      private:
+        vk::Device m_device{};
+        VmaAllocator m_allocator{};
+        MemoryTracker* m_memoryTracker{};
+
+        uint64_t m_vertexCapacity{};
+        uint64_t m_indexCapacity{};
+
+        Buffer m_vertexBuffer{};
+        Buffer m_indexBuffer{};
+
+        VmaVirtualBlock m_vertexBlock{};
+        VmaVirtualBlock m_indexBlock{};
+
+        std::vector<GeometryAllocation> m_allocations{};
+        std::vector<GeometryHandle> m_freeHandles{};
+
+        // (frame number, handle) of allocations waiting for the GPU to be done with them.
+        std::deque<std::pair<uint64_t, GeometryHandle>> m_pendingFrees{};
+    };
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Function.hpp"
+
+namespace lunar
+{
+    struct Job;
+    class JobPool;
+
+    // Handle to a scheduled job, used to wait for it or to make other jobs depend on it. A null handle is a job that has already completed.
+    using JobHandle = std::shared_ptr<Job>;
+
+    struct JobWorkerStatistics
+    {
+        uint64_t executedJobCount{};
+
+        // Number of jobs the worker took from the queue of another worker.
+        uint64_t stolenJobCount{};
+
+        // Time spent executing jobs, and its fraction of the time since the statistics were last reset.
+        double busyTimeMs{};
+        double utilization{};
+    };
+
+    // Work stealing job scheduler. Each worker owns a queue of jobs : jobs scheduled from a worker are pushed to (and popped from) the back of
+    // its own queue, so that the most recently scheduled (cache warm) work runs first, and idle workers steal the oldest jobs from the front of
+    // the other queues. Jobs scheduled from other threads go through a shared injection queue.
+    // A job can depend on other jobs, in which case it is only queued once all of them have completed (the last dependency to complete queues
+    // its continuations), so dependencies never block a worker. Threads that wait for a job execute other jobs in the meantime, so jobs can
+    // schedule and wait for other jobs without starving the workers. parallelFor instead only runs its own indices : while the calling thread
+    // waits for its helpers, it never picks up unrelated jobs (ex the mesh processing of the asset loader threads, which could stall a frame).
+    // Jobs are allocated from a pool and queues only grow, so that once warmed up, parallelFor does not allocate.
+    class JobSystem
+    {
+      public:
+        // By default, one worker per hardware thread (minus the main thread, which also executes jobs while it waits for them).
+        explicit JobSystem(const uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Queues the function once every dependency has completed. Can be called from any thread, including from inside a job.
+        // If the function throws, the exception is rethrown by wait() (it is lost if nobody waits for the job).
+        JobHandle schedule(std::function<void()>&& function, std::span<const JobHandle> dependencies = {});
+
+        // Blocks until the job has completed, executing other jobs meanwhile. Rethrows the exception thrown by the job, if any.
+        void wait(const JobHandle& job);
+
+        // Calls function(index) for every index in [0, count), distributed across the workers and the calling thread. Blocks until all
+        // indices are processed, without executing any other job. If any invocation throws, the first exception is rethrown on the calling thread.
+        void parallelFor(const size_t count, const FunctionRef<void(size_t)> function);
+
+        // Calls function(begin, end) over consecutive ranges that cover [0, count), each of at least minRangeSize indices (except the last).
+        // Meant for cheap per index work : when count is at most minRangeSize, the whole range is processed inline by the calling thread.
+        void parallelForRange(const size_t count, const size_t minRangeSize, const FunctionRef<void(size_t, size_t)> function);
+
+        [[nodiscard]] uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+        // Statistics of each worker since the last resetStatistics() (jobs executed by non worker threads while they wait are not counted).
+        [[nodiscard]] std::vector<JobWorkerStatistics> getStatistics() const;
+        void resetStatistics();
+
+      private:
+        // Ring buffer of jobs that only grows, so that queueing a job does not allocate once the queue has reached its peak size (unlike
+        // std::deque, which allocates and frees blocks as jobs go through it).
+        class JobQueue
+        {
+          public:
+            [[nodiscard]] bool empty() const { return m_size == 0u; }
+            [[nodiscard]] const JobHandle& back() const { return m_jobs[(m_front + m_size - 1u) % m_jobs.size()]; }
+
+            void pushBack(JobHandle&& job);
+            [[nodiscard]] JobHandle popBack();
+            [[nodiscard]] JobHandle popFront();
+
+          private:
+            std::vector<JobHandle> m_jobs{};
+            size_t m_front{};
+            size_t m_size{};
+        };
+
+        struct Worker
+        {
+            std::thread thread{};
+
+            JobQueue jobs{};
+            std::mutex mutex{};
+
+            std::atomic<uint64_t> executedJobCount{};
+            std::atomic<uint64_t> stolenJobCount{};
+            std::atomic<uint64_t> busyTimeNs{};
+        };
+
+        void workerLoop(const uint32_t workerIndex);
+
+        // Pushes a job whose dependencies have all completed to the queue of the calling worker (or to the injection queue), and wakes a worker.
+        void enqueue(JobHandle job);
+
+        // Pops a job from the queue of the calling worker, then from the injection queue, then steals from the other workers.
+        // workerIndex is INVALID_U32 when called from a non worker thread. Returns a null handle if every queue is empty.
+        [[nodiscard]] JobHandle dequeue(const uint32_t workerIndex);
+
+        // Removes the parallelFor helpers cancelled by the calling thread from the end of the queue they were pushed to (its own queue, or the
+        // injection queue), so that they do not hold on to blocks of the job pool until some thread dequeues them.
+        void removeCancelledJobs();
+
+        // Runs the job, stores its exception, marks it completed and queues the continuations whose dependencies have all completed.
+        void execute(const JobHandle& job);
+
+        // Returns the index of the calling thread in m_workers, or INVALID_U32 if it is not one of this job system's workers.
+        [[nodiscard]] uint32_t getCurrentWorkerIndex() const;
+
+      private:
+        std::vector<std::unique_ptr<Worker>> m_workers{};
+
+        // Shared with the allocator of every job, so that handles to jobs can outlive the job system.
+        std::shared_ptr<JobPool> m_jobPool{};
+
+        JobQueue m_injectedJobs{};
+        std::mutex m_injectedJobsMutex{};
+
+        // Number of jobs in all queues. Idle workers and waiting threads sleep on m_sleepCondition until it is non zero (or until the job they
+        // wait for completes).
+        std::atomic<uint64_t> m_queuedJobCount{};
+        std::mutex m_sleepMutex{};
+        std::condition_variable m_sleepCondition{};
+
+        // parallelFor sleeps on it (with m_sleepMutex) until its running helpers complete. Separate from m_sleepCondition, so that the
+        // notify_one of a queued job always wakes a thread that can run it.
+        std::condition_variable m_completionCondition{};
+        std::atomic<bool> m_stopping{false};
+
+        std::atomic<int64_t> m_statisticsResetTimeNs{};
+    };
+}
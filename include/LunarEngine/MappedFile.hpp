@@ -0,0 +1,37 @@
+#pragma once
+
+namespace lunar
+{
+    // Read only memory mapping of a file. The mapping is released when the object is destroyed.
+    class MappedFile
+    {
+      public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string_view filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        [[nodiscard]] bool isValid() const { return m_data != nullptr; }
+        [[nodiscard]] const std::byte* data() const { return m_data; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+      private:
+        void release();
+
+      private:
+        const std::byte* m_data{};
+        size_t m_size{};
+
+#ifdef _WIN32
+        void* m_fileHandle{};
+        void* m_fileMappingHandle{};
+#else
+        int m_fileDescriptor{-1};
+#endif
+    };
+}
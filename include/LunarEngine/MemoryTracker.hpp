@@ -0,0 +1,82 @@
+#pragma once
+
+#include <mutex>
+
+namespace lunar
+{
+    // What a device memory allocation is used for.
+    enum class MemoryCategory : uint8_t
+    {
+        eMeshVertex,
+        eMeshIndex,
+        eStaging,
+        ePerFrame,
+        eRenderTarget,
+        eTransientImage,
+        eGpuDrivenScene,
+        eBuffer,
+        eCount,
+    };
+
+    [[nodiscard]] std::string_view getMemoryCategoryName(const MemoryCategory category);
+
+    struct MemoryCategoryStatistics
+    {
+        uint32_t allocationCount{};
+        uint64_t bytes{};
+
+        // Most bytes the category has used at once since init().
+        uint64_t peakBytes{};
+    };
+
+    // Attributes the device memory allocations of VMA to categories and names, tracks the memory budget of each heap, and writes memory reports.
+    // Every allocation must be tracked right after it is created, and untracked before it is destroyed. Tracked allocations are also named in
+    // VMA ("<category> : <name>"), so they can be identified in VMA's JSON stats dump.
+    // Budgets come from VK_EXT_memory_budget when it is enabled (VMA then queries the usage and budget of the process from the driver), else VMA
+    // estimates them from its own allocations and the heap sizes.
+    // Thread safe.
+    class MemoryTracker
+    {
+      public:
+        // The watchdog warns when the usage of a heap goes above budgetWarningThreshold of its budget.
+        void init(const VmaAllocator allocator, const bool memoryBudgetExtensionEnabled, const float budgetWarningThreshold);
+
+        void track(const VmaAllocation allocation, const MemoryCategory category, const std::string_view name);
+        void untrack(const VmaAllocation allocation);
+
+        // Budget watchdog : prints a warning for each heap whose usage has gone above the warning threshold of its budget since the last
+        // warning (a heap is warned about again once its usage has gone back below the threshold). Does not allocate, so it can run every frame.
+        void checkBudgets();
+
+        [[nodiscard]] MemoryCategoryStatistics getCategoryStatistics(const MemoryCategory category) const;
+
+        // JSON report with the budget, usage and fragmentation of each heap, the totals of each category, every tracked allocation, and VMA's
+        // detailed stats dump.
+        [[nodiscard]] std::string buildReport() const;
+        void writeReport(const std::string_view path) const;
+
+      private:
+        struct TrackedAllocation
+        {
+            MemoryCategory category{};
+            std::string name{};
+            uint64_t size{};
+        };
+
+        // Usage goes this far below the warning threshold before a heap can be warned about again, so that usage hovering around the threshold
+        // does not warn every frame.
+        static constexpr float BUDGET_WARNING_HYSTERESIS = 0.05f;
+
+      private:
+        VmaAllocator m_allocator{};
+        bool m_memoryBudgetExtensionEnabled{false};
+        float m_budgetWarningThreshold{};
+
+        std::array<bool, VK_MAX_MEMORY_HEAPS> m_budgetWarned{};
+
+        std::unordered_map<VmaAllocation, TrackedAllocation> m_allocations{};
+        std::array<MemoryCategoryStatistics, static_cast<size_t>(MemoryCategory::eCount)> m_categoryStatistics{};
+
+        mutable std::mutex m_mutex{};
+    };
+}
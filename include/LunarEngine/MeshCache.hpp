@@ -0,0 +1,75 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Types.hpp"
+
+// Binary mesh cache : meshes are stored in a GPU ready format (i.e the vertex blob is already in the mesh's vertex format and the index blob in its
+// index type), so that warm loads require no parsing and the data can be copied straight from the mapped file into a staging buffer.
+// Layout : MeshCacheHeader | submesh table | meshlet table | vertex blob | index blob. Section offsets are 16 byte aligned.
+namespace lunar
+{
+    struct MeshCacheHeader
+    {
+        static constexpr uint32_t MAGIC = 0x48534d4cu; // 'LMSH'.
+        static constexpr uint32_t VERSION = 7u;
+
+        uint32_t magic{MAGIC};
+        uint32_t version{VERSION};
+
+        // Encoding of the vertex / index blobs.
+        VertexFormat vertexFormat{};
+        vk::IndexType indexType{};
+        math::XMFLOAT3 positionScale{};
+        math::XMFLOAT3 positionOffset{};
+
+        MeshLodChain lodChain{};
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
+
+        // Used to reject caches written by a build with a different vertex / index layout.
+        uint32_t vertexStride{};
+        uint32_t indexStride{};
+
+        uint64_t sourcePathHash{};
+        uint64_t contentHash{};
+
+        uint64_t vertexCount{};
+        uint64_t indexCount{};
+        uint64_t submeshCount{};
+        uint64_t meshletCount{};
+
+        uint64_t submeshDataOffset{};
+        uint64_t meshletDataOffset{};
+        uint64_t vertexDataOffset{};
+        uint64_t indexDataOffset{};
+    };
+
+    // View into a mapped mesh cache file. The data pointers are valid as long as the view is alive.
+    struct MeshCacheView
+    {
+        MappedFile file{};
+        MeshCacheHeader header{};
+        MeshEncoding encoding{};
+        MeshLodChain lodChain{};
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
+
+        std::span<const std::byte> vertexData{};
+        std::span<const std::byte> indexData{};
+        std::span<const Submesh> submeshes{};
+        std::span<const Meshlet> meshlets{};
+    };
+
+    // Returns the path of the cache file for the source model and vertex format (the name is derived from the hash of the source path).
+    [[nodiscard]] std::string getMeshCachePath(const std::string_view rootDirectory, const std::string_view modelPath, const VertexFormat vertexFormat);
+
+    // Hash of the source asset : the contents of the glTF file, along with the size and last write time of the binary buffers next to it (hashing
+    // the buffers in full would cost almost as much I/O as loading them).
+    [[nodiscard]] uint64_t computeMeshSourceHash(const std::string_view fullModelPath);
+
+    // Returns std::nullopt if the cache file does not exist, is stale (hash mismatch) or is corrupt.
+    [[nodiscard]] std::optional<MeshCacheView> openMeshCache(const std::string_view cachePath, const uint64_t sourcePathHash, const uint64_t contentHash);
+
+    // Returns false if the cache could not be written. Failure to write the cache is not fatal, the mesh will be imported again on the next launch.
+    bool writeMeshCache(const std::string_view cachePath, const uint64_t sourcePathHash, const uint64_t contentHash, const PackedMeshData& packedMeshData);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    // Converts imported mesh data into the GPU ready layout of the requested vertex format.
+    // The compact vertex format quantizes positions / normals / texture coordinates (see CompactVertex). Independent of the vertex format, 16
+    // bit indices are used whenever every submesh has at most 65536 vertices (submesh indices are relative to the submesh's vertex offset).
+    [[nodiscard]] PackedMeshData encodeMeshData(const MeshData& meshData, const VertexFormat vertexFormat);
+
+    // Octahedral encoding of a unit vector into two snorm 16 values. Decoded in the vertex shader.
+    [[nodiscard]] std::array<int16_t, 2> encodeOctahedralNormal(const math::XMFLOAT3& normal);
+}
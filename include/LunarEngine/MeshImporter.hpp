@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    class JobSystem;
+
+    // Imports every mesh primitive reachable from the glTF file's default scene into a single MeshData. Each (node, primitive) pair becomes a
+    // submesh, with the node's world transform baked into its vertices. Primitives are decoded in parallel on the job system.
+    [[nodiscard]] MeshData importGltfMesh(const std::string_view fullModelPath, JobSystem& jobSystem);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    class JobSystem;
+
+    // Size of the FIFO post transform vertex cache that is optimized for / simulated when computing statistics.
+    static constexpr uint32_t VERTEX_CACHE_SIZE = 16u;
+
+    struct VertexCacheStatistics
+    {
+        // Average cache miss ratio (transformed vertices per triangle, 0.5 is the best case for large regular meshes, 3 the worst).
+        double acmr{};
+        // Average transform to vertex ratio (transformed vertices per unique vertex, 1 is optimal).
+        double atvr{};
+    };
+
+    struct MeshOptimizationStatistics
+    {
+        VertexCacheStatistics before{};
+        VertexCacheStatistics after{};
+
+        uint32_t vertexCountBefore{};
+        uint32_t vertexCountAfter{};
+    };
+
+    // Optimizes each submesh of the mesh in place (submeshes are processed in parallel on the job system) :
+    //  1. Bitwise identical vertices (including the texture coordinate) are welded.
+    //  2. Triangles are reordered for post transform vertex cache locality (Tipsify, Sander et al. 2007).
+    //  3. Triangle clusters are sorted so that outward facing clusters on the outside of the mesh are drawn first, which reduces overdraw at the
+    //     cost of a small (bounded by overdrawThreshold) increase of the ACMR.
+    //  4. Vertices are reordered in the order they are first referenced by the index buffer, for vertex fetch locality.
+    // The submesh ranges are updated, as welding changes the vertex count of the submeshes.
+    MeshOptimizationStatistics optimizeMeshData(MeshData& meshData, JobSystem& jobSystem, const float overdrawThreshold = 1.05f);
+
+    // Simulates a FIFO vertex cache of VERTEX_CACHE_SIZE entries, and returns the number of cache misses.
+    [[nodiscard]] uint64_t simulateVertexCacheMisses(std::span<const uint32_t> indices, const uint32_t vertexCount);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    class JobSystem;
+
+    // Target triangle count of LOD 1, 2, ... relative to the full detail mesh.
+    static constexpr std::array<float, MAX_MESH_LOD_COUNT - 1u> DEFAULT_LOD_TRIANGLE_RATIOS = {0.5f, 0.25f, 0.125f};
+
+    // Generates the LOD chain of every submesh by quadric error metric edge collapse (Garland & Heckbert 1997), each LOD being simplified from
+    // the previous one. Vertices are collapsed onto existing vertices, so LODs reuse the submesh's vertices and only add indices : the index
+    // ranges of the LODs are appended to meshData.indices and stored in the submeshes, and meshData.lodChain is filled.
+    // Vertices on mesh borders and attribute seams are never moved, so that simplification does not open holes in the mesh.
+    // The chain stops early if simplification can no longer make progress.
+    void generateMeshLods(MeshData& meshData, JobSystem& jobSystem, std::span<const float> lodTriangleRatios = DEFAULT_LOD_TRIANGLE_RATIOS);
+}
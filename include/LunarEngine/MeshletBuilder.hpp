@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    class JobSystem;
+
+    // Splits the full detail index range of every submesh into meshlets of at most MAX_MESHLET_VERTEX_COUNT unique vertices and
+    // MAX_MESHLET_TRIANGLE_COUNT triangles, and computes their bounding sphere and normal cone. The full detail indices are reordered so that
+    // each meshlet is a contiguous index range, which lets visible meshlets be drawn with regular indexed draws (at the cost of some of
+    // the vertex cache locality from the optimizer).
+    void buildMeshlets(MeshData& meshData, JobSystem& jobSystem);
+}
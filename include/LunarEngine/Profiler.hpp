@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Resources.hpp"
+
+#include <mutex>
+#include <thread>
+
+namespace lunar
+{
+    // CPU and GPU profiler. While a capture runs, CPU scopes (LUNAR_PROFILE_SCOPE, from any thread) and GPU scopes (timestamp queries written
+    // around the passes and draw batches of a frame, LUNAR_PROFILE_GPU_SCOPE) are recorded. Once the requested number of frames has been
+    // recorded and their timestamps read back, everything is written as a Chrome trace_event JSON file (chrome://tracing, Perfetto).
+    // GPU timestamps are converted to the CPU clock with calibrated timestamps (VK_EXT_calibrated_timestamps) when the device supports them,
+    // else by aligning the start of each frame with the time its command buffer was submitted.
+    // The scope macros expand to nothing unless DEF_LUNAR_PROFILING is defined (see LUNAR_PROFILING in CMakeLists.txt), and captures are only
+    // started on request.
+    class Profiler
+    {
+      public:
+        // frameCount is the number of frames in flight : each has its own timestamp query pool, read back once its fence has been waited on.
+        // The GPU timestamps of the graphics queue must be supported, and timestampValidBits is that of its queue family.
+        void init(const vk::Instance instance, const vk::PhysicalDevice physicalDevice, const vk::Device device, const uint32_t frameCount,
+                  const uint32_t timestampValidBits);
+        void destroy();
+
+        // Starts recording CPU scopes right away, and GPU scopes from the next frame on (if init() has been called), until frameCount frames have
+        // been recorded. The trace is then written to outputPath.
+        void beginCapture(const uint32_t frameCount, const std::string_view outputPath);
+
+        // Writes the trace of a capture that has not completed yet (ex the engine exits first). The device must be idle.
+        void endCapture();
+
+        // Reads back the GPU scopes of the frame last recorded with this frame index. Must be called once its fence has been waited on.
+        void collectFrame(const uint32_t frameIndex);
+
+        // Resets the queries of the frame index, and opens the scope of the whole frame. Must be called right after the command buffer is begun.
+        void beginFrame(const vk::CommandBuffer& cmd, const uint32_t frameIndex, const uint64_t frameNumber);
+
+        // Closes the scope of the whole frame. Must be called right before the command buffer is ended (and submitted).
+        void endFrame(const vk::CommandBuffer& cmd);
+
+        // GPU scopes can be nested, and are dropped if the frame runs out of queries. Names must outlive the capture (string literals).
+        void beginGpuScope(const vk::CommandBuffer& cmd, const std::string_view name);
+        void endGpuScope(const vk::CommandBuffer& cmd);
+
+        // Can be called from any thread.
+        void recordCpuScope(const std::string_view name, const int64_t beginTimeNs, const int64_t endTimeNs);
+
+        // Returns the profiler whose capture is recording CPU scopes, if any.
+        [[nodiscard]] static Profiler* getCapturingProfiler() { return s_capturingProfiler.load(std::memory_order_relaxed); }
+
+        // Time of the CPU clock used by the trace (the steady clock, which calibrated timestamps are converted to).
+        [[nodiscard]] static int64_t getTimeNs();
+
+      private:
+        // The end timestamp of a scope is written to the query after its begin timestamp.
+        struct GpuScope
+        {
+            std::string_view name{};
+            uint32_t beginQuery{};
+        };
+
+        struct Frame
+        {
+            vk::QueryPool queryPool{};
+
+            // Set when the frame was recorded with queries that have not been read back yet.
+            bool recorded{false};
+            uint64_t frameNumber{};
+
+            uint32_t queryCount{};
+            std::vector<GpuScope> scopes{};
+
+            // Indices of the scopes that have not been closed yet (INVALID_U32 for scopes dropped as the frame ran out of queries).
+            std::vector<uint32_t> openScopes{};
+
+            // GPU timestamp and CPU time sampled at the same instant, if calibrated timestamps are supported. Else, CPU time of the submission.
+            bool calibrated{false};
+            uint64_t calibrationGpuTimestamp{};
+            int64_t calibrationTimeNs{};
+        };
+
+        struct TraceEvent
+        {
+            std::string_view name{};
+            int64_t beginTimeNs{};
+            int64_t endTimeNs{};
+
+            // Index of the CPU thread, or INVALID_U32 for the GPU timeline.
+            uint32_t threadIndex{};
+
+            // Only set for the scopes of whole GPU frames.
+            uint64_t frameNumber{INVALID_U64};
+        };
+
+        // Samples the GPU timestamp and CPU time of the same instant into the frame, returns false if calibrated timestamps are not supported.
+        [[nodiscard]] bool calibrate(Frame& frame) const;
+
+        // Writes the trace and ends the capture.
+        void writeTrace();
+
+      private:
+        // Two queries per scope (including the frame scope).
+        static constexpr uint32_t MAX_GPU_SCOPES_PER_FRAME = 512u;
+
+        static inline std::atomic<Profiler*> s_capturingProfiler{};
+
+        vk::Device m_device{};
+        float m_timestampPeriod{};
+        uint32_t m_timestampValidBits{};
+        PFN_vkGetCalibratedTimestampsEXT m_getCalibratedTimestamps{};
+
+        std::vector<Frame> m_frames{};
+        Frame* m_recordingFrame{};
+
+        std::string m_outputPath{};
+        int64_t m_captureStartTimeNs{};
+        uint32_t m_remainingFrameCount{};
+        bool m_gpuTimestampsCalibrated{false};
+
+        // Recorded CPU and GPU scopes, and the index of each thread that recorded some (the thread that began the capture is thread 0). All
+        // guarded by m_eventsMutex.
+        bool m_capturing{false};
+        std::vector<TraceEvent> m_events{};
+        std::unordered_map<std::thread::id, uint32_t> m_threadIndices{};
+        std::mutex m_eventsMutex{};
+    };
+
+    class CpuProfileScope
+    {
+      public:
+        explicit CpuProfileScope(const std::string_view name) : m_name(name), m_profiler(Profiler::getCapturingProfiler())
+        {
+            if (m_profiler)
+            {
+                m_beginTimeNs = Profiler::getTimeNs();
+            }
+        }
+
+        ~CpuProfileScope()
+        {
+            if (m_profiler)
+            {
+                m_profiler->recordCpuScope(m_name, m_beginTimeNs, Profiler::getTimeNs());
+            }
+        }
+
+        CpuProfileScope(const CpuProfileScope&) = delete;
+        CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+
+      private:
+        std::string_view m_name{};
+        Profiler* m_profiler{};
+        int64_t m_beginTimeNs{};
+    };
+
+    class GpuProfileScope
+    {
+      public:
+        GpuProfileScope(Profiler* profiler, const vk::CommandBuffer& cmd, const std::string_view name) : m_profiler(profiler), m_cmd(cmd)
+        {
+            if (m_profiler)
+            {
+                m_profiler->beginGpuScope(m_cmd, name);
+            }
+        }
+
+        ~GpuProfileScope()
+        {
+            if (m_profiler)
+            {
+                m_profiler->endGpuScope(m_cmd);
+            }
+        }
+
+        GpuProfileScope(const GpuProfileScope&) = delete;
+        GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+      private:
+        Profiler* m_profiler{};
+        vk::CommandBuffer m_cmd{};
+    };
+}
+
+#ifdef DEF_LUNAR_PROFILING
+#define LUNAR_PROFILE_CONCAT_INNER(a, b) a##b
+#define LUNAR_PROFILE_CONCAT(a, b) LUNAR_PROFILE_CONCAT_INNER(a, b)
+
+// Records the time from here to the end of the enclosing scope. name must be a string literal.
+#define LUNAR_PROFILE_SCOPE(name) const ::lunar::CpuProfileScope LUNAR_PROFILE_CONCAT(cpuProfileScope, __LINE__){name}
+
+// Writes timestamps around the commands recorded into cmd from here to the end of the enclosing scope. profiler may be null.
+#define LUNAR_PROFILE_GPU_SCOPE(profiler, cmd, name) const ::lunar::GpuProfileScope LUNAR_PROFILE_CONCAT(gpuProfileScope, __LINE__){profiler, cmd, name}
+#else
+#define LUNAR_PROFILE_SCOPE(name)
+#define LUNAR_PROFILE_GPU_SCOPE(profiler, cmd, name)
+#endif
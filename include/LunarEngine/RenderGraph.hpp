@@ -0,0 +1,233 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Profiler.hpp"
+#include "TransientAllocator.hpp"
+
+namespace lunar
+{
+    // Handle to a resource of a render graph, valid until the graph is reset.
+    using RenderGraphResource = uint32_t;
+
+    // How a pass uses a resource. Each usage maps to the pipeline stages, access flags and (for images) layout of the access, from which the
+    // graph derives the barriers between passes.
+    enum class RenderGraphUsage : uint8_t
+    {
+        eColorAttachment,
+        eDepthAttachment,
+        eDepthAttachmentRead,
+        eFragmentSampled,
+        eComputeSampled,
+        eComputeStorageRead,
+        eComputeStorageWrite,
+        eGraphicsStorageRead,
+        eIndirectArgument,
+        eTransferSrc,
+        eTransferDst,
+
+        // Only valid as the final usage of an imported image.
+        ePresent,
+    };
+
+    // Synchronization state of a resource : the stages / accesses that last used it, and the layout it is in.
+    struct RenderGraphResourceState
+    {
+        vk::PipelineStageFlags2 stages{};
+        vk::AccessFlags2 access{};
+        vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+    };
+
+    struct RenderGraphAttachment
+    {
+        RenderGraphResource resource{INVALID_U32};
+        vk::AttachmentLoadOp loadOp{vk::AttachmentLoadOp::eLoad};
+        vk::ClearValue clearValue{};
+
+        // Set by compile() : eDontCare if nothing reads the contents after the pass (ex a depth buffer only used by one pass).
+        vk::AttachmentStoreOp storeOp{vk::AttachmentStoreOp::eStore};
+    };
+
+    // Records the commands of a pass. Stored inline in the pass (passes are declared every frame, so this must not allocate) : lambdas capture
+    // by reference, or a few trivially copyable values.
+    using RenderGraphRecordFunction = InplaceFunction<void(const vk::CommandBuffer&), 64u>;
+
+    // A pass of a render graph : the resources it uses, and the function that records its commands.
+    // Passes with attachments are recorded inside a dynamic rendering instance begun (and ended) by the graph.
+    class RenderGraphPass
+    {
+        friend class RenderGraph;
+
+      public:
+        RenderGraphPass& use(const RenderGraphResource resource, const RenderGraphUsage usage);
+
+        // Attachments are used as eColorAttachment / eDepthAttachment. A load op other than eLoad discards the previous contents.
+        RenderGraphPass& colorAttachment(const RenderGraphResource resource, const vk::AttachmentLoadOp loadOp, const vk::ClearValue clearValue = {});
+        RenderGraphPass& depthAttachment(const RenderGraphResource resource, const vk::AttachmentLoadOp loadOp, const vk::ClearValue clearValue = {});
+
+        // The commands of the rendering instance are recorded into secondary command buffers, which the record function executes.
+        RenderGraphPass& secondaryCommandBuffers();
+
+        // The pass is never culled, even if nothing uses what it writes (ex it writes to memory read back by the CPU).
+        RenderGraphPass& sideEffects();
+
+      private:
+        struct Access
+        {
+            RenderGraphResource resource{};
+            RenderGraphUsage usage{};
+        };
+
+        // Returns true if the resource is an attachment of the pass that is not loaded (so its previous contents are not used).
+        [[nodiscard]] bool discardsContents(const RenderGraphResource resource) const;
+
+        // Reinitializes a pass of a previous frame, keeping the capacity of its vectors.
+        void reset(const std::string_view name, RenderGraphRecordFunction&& record);
+
+        std::string_view m_name{};
+        RenderGraphRecordFunction m_record{};
+
+        std::vector<Access> m_accesses{};
+        std::vector<RenderGraphAttachment> m_colorAttachments{};
+        std::optional<RenderGraphAttachment> m_depthAttachment{};
+        bool m_secondaryCommandBuffers{false};
+        bool m_sideEffects{false};
+
+        // Compiled state : whether the pass is culled, and the barriers recorded before it (attachment store ops are in the attachments).
+        bool m_culled{false};
+        std::vector<vk::ImageMemoryBarrier2> m_imageBarriers{};
+        std::vector<vk::BufferMemoryBarrier2> m_bufferBarriers{};
+    };
+
+    // Frame graph of the passes recorded into a command buffer. The graph is rebuilt every frame : resources and passes are declared (in
+    // execution order), then compile() :
+    //  - culls the passes whose writes are never used (the outputs are the imported images with a final usage, and passes with side effects),
+    //  - allocates the transient images with a TransientAllocator, which aliases the memory of images whose lifetimes (first to last pass that
+    //    uses them) do not overlap,
+    //  - picks the store op of each attachment (eDontCare if no later pass reads it, and it is not imported),
+    //  - computes, for each pass, a single batch of synchronization2 barriers (execution / memory dependencies and layout transitions) from the
+    //    previous uses of its resources.
+    // execute() then records the barriers and passes.
+    // Resource and pass names must outlive the graph's use of them (string literals).
+    // Passes, and the scratch state of compile(), are reused from frame to frame, so that once the graph has reached its peak size, building,
+    // compiling and executing it does not allocate.
+    class RenderGraph
+    {
+      public:
+        void init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker);
+        void destroy();
+
+        // Removes all passes and resources (transient images, and the memory of the passes, are kept for the next frame).
+        void reset();
+
+        // The image is in initialState when the graph starts (its stages are those the first barrier waits on, ex the stage a semaphore wait
+        // was done at). If finalUsage is set, the image is an output of the graph, transitioned to that usage after the last pass.
+        RenderGraphResource importImage(const std::string_view name, const vk::Image image, const vk::ImageView imageView, const vk::Format format,
+                                        const vk::Extent2D extent, const RenderGraphResourceState& initialState, const std::optional<RenderGraphUsage> finalUsage);
+
+        // Buffers are assumed to be available when the graph starts (ex written by the host, or by an earlier submission).
+        RenderGraphResource importBuffer(const std::string_view name, const vk::Buffer buffer, const vk::DeviceSize offset = 0u, const vk::DeviceSize size = VK_WHOLE_SIZE);
+
+        // Image whose contents only live during the graph. Its usage flags are those of the passes that use it.
+        RenderGraphResource createImage(const std::string_view name, const vk::Format format, const vk::Extent2D extent);
+
+        // The returned pass is only valid until the next addPass().
+        RenderGraphPass& addPass(const std::string_view name, RenderGraphRecordFunction&& record);
+
+        void compile();
+
+        // Each pass (with its barriers) is a GPU scope of profiler, if profiler scopes are compiled in and it is not null.
+        void execute(const vk::CommandBuffer& cmd, [[maybe_unused]] Profiler* profiler = nullptr);
+
+        // Passes (with their barriers and whether they were culled) and transient images (with their lifetime and memory) of the last compile().
+        [[nodiscard]] std::string getDebugDump() const;
+
+        [[nodiscard]] const TransientMemoryStatistics& getTransientMemoryStatistics() const { return m_transientAllocator.getStatistics(); }
+
+      private:
+        struct Resource
+        {
+            std::string_view name{};
+            bool isImage{};
+            bool imported{};
+
+            vk::Image image{};
+            vk::ImageView imageView{};
+            vk::Format format{};
+            vk::Extent2D extent{};
+            vk::ImageAspectFlags aspect{};
+
+            vk::Buffer buffer{};
+            vk::DeviceSize offset{};
+            vk::DeviceSize size{};
+
+            RenderGraphResourceState initialState{};
+            std::optional<RenderGraphUsage> finalUsage{};
+
+            // Compiled state : first and last live pass that use the resource, union of the image usages of those passes, and index of the
+            // transient image in the transient allocator (INVALID_U32 if the resource is imported or unused).
+            uint32_t firstPass{INVALID_U32};
+            uint32_t lastPass{};
+            vk::ImageUsageFlags imageUsage{};
+            uint32_t transientIndex{INVALID_U32};
+        };
+
+        struct UsageInfo
+        {
+            vk::PipelineStageFlags2 stages{};
+            vk::AccessFlags2 access{};
+            vk::ImageLayout layout{};
+            vk::ImageUsageFlags imageUsage{};
+            bool write{};
+        };
+
+        // Synchronization state of a resource, as computeBarriers() walks the passes in order.
+        struct SyncState
+        {
+            // Stages and (write) accesses of the last write or layout transition.
+            vk::PipelineStageFlags2 writeStages{};
+            vk::AccessFlags2 writeAccess{};
+
+            // Stages that read the resource since then (a later write must wait for them), and the reads that already wait for the last write.
+            vk::PipelineStageFlags2 readStages{};
+            vk::PipelineStageFlags2 visibleStages{};
+            vk::AccessFlags2 visibleAccess{};
+
+            vk::ImageLayout layout{};
+        };
+
+        // Uses of the same resource within a pass, merged into a single access.
+        struct MergedAccess
+        {
+            RenderGraphResource resource{};
+            UsageInfo usageInfo{};
+        };
+
+        [[nodiscard]] static UsageInfo getUsageInfo(const RenderGraphUsage usage);
+
+        void cullPasses();
+        void allocateTransientImages();
+        void computeStoreOps();
+        void computeBarriers();
+
+      private:
+        std::vector<Resource> m_resources{};
+        std::vector<RenderGraphPass> m_passes{};
+
+        // Passes of previous frames, reused by addPass().
+        std::vector<RenderGraphPass> m_freePasses{};
+
+        TransientAllocator m_transientAllocator{};
+
+        // Barriers to the final usages of the output images, recorded after the last pass.
+        std::vector<vk::ImageMemoryBarrier2> m_finalImageBarriers{};
+
+        // Scratch state of compile(), kept to reuse its memory.
+        std::vector<bool> m_neededResources{};
+        std::vector<TransientImageDesc> m_transientImageDescs{};
+        std::vector<SyncState> m_syncStates{};
+        std::vector<uint32_t> m_slotLastImages{};
+        std::vector<SyncState> m_slotPreviousFrameStates{};
+        std::vector<RenderGraphResource> m_slotLastResources{};
+        std::vector<MergedAccess> m_mergedAccesses{};
+    };
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "FrameArena.hpp"
+
 namespace lunar
 {
     struct Buffer
@@ -23,7 +25,37 @@ namespace lunar
         vk::CommandPool graphicsCommandPool{};
         vk::CommandBuffer graphicsCommandBuffer{};
 
-        Buffer sceneBuffer{};
+        // Draws are recorded in parallel into secondary command buffers. Command pools must be externally synchronized, so each recording job
+        // has its own pool (with a single command buffer), one per thread of the job system.
+        std::vector<vk::CommandPool> secondaryCommandPools{};
+        std::vector<vk::CommandBuffer> secondaryCommandBuffers{};
+
+        // Scene constants, object transforms (GPU driven path) and instance transforms (instanced path) of the frame. Reset once the frame's
+        // fence has been waited on. The offsets are those of the current frame's allocations, used as dynamic descriptor offsets.
+        FrameArena uploadArena{};
+        uint32_t sceneBufferOffset{};
+        uint32_t objectTransformOffset{};
+
         vk::DescriptorSet globalDescriptorSet{};
+
+        // GPU driven rendering : the draw commands / draw counts written by the culling compute shader.
+        Buffer drawCommandBuffer{};
+        Buffer drawCountBuffer{};
+        vk::DescriptorSet gpuDrivenDescriptorSet{};
+
+        // Set when the buffers of the GPU driven path are recreated, the descriptor set is then rewritten once the frame's fence has been waited on.
+        bool gpuDrivenDescriptorSetDirty{false};
+
+        // Instancing : points to the whole upload arena, instance transforms are addressed with the first instance of each draw.
+        vk::DescriptorSet instanceDescriptorSet{};
+
+        // Only used in headless mode, where there is no swapchain to render into.
+        Image offscreenImage{};
+        vk::ImageView offscreenImageView{};
+
+        // Two timestamps (start and end of the frame), used to measure GPU frame time.
+        // The frame number is that of the last frame that wrote the timestamps, INVALID_U64 if none has.
+        vk::QueryPool timestampQueryPool{};
+        uint64_t timestampFrameNumber{INVALID_U64};
     };
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace lunar
+{
+    // Counters of the commands recorded by a frame (draw calls include the indirect ones). Draws of the GPU driven path are indirect : their
+    // triangle count is only known on the GPU, so it is not counted, and neither are the objects culled by the GPU.
+    // Every field is an uint64_t (the binary telemetry log writes the struct as is).
+    struct RenderStatistics
+    {
+        uint64_t drawCallCount{};
+        uint64_t indirectDrawCallCount{};
+        uint64_t dispatchCount{};
+        uint64_t triangleCount{};
+
+        uint64_t pipelineBindCount{};
+        uint64_t descriptorSetBindCount{};
+        uint64_t vertexBufferBindCount{};
+        uint64_t indexBufferBindCount{};
+        uint64_t pushConstantBytes{};
+
+        // Binds that were skipped as the state they would have set was already bound (the pipeline and descriptor sets of the previous draw's
+        // material, or the index buffer of the previous draw's index type).
+        uint64_t skippedPipelineBindCount{};
+        uint64_t skippedIndexBufferBindCount{};
+
+        uint64_t visibleObjectCount{};
+        uint64_t culledObjectCount{};
+
+        // Bytes copied through the staging ring of the upload manager, and bytes written to the per frame upload arena.
+        uint64_t uploadedBytes{};
+        uint64_t frameArenaBytes{};
+
+        // Heap allocations made by render(), on the thread that runs it and the jobs it runs (see AllocationTracker). Zero once warmed up.
+        uint64_t heapAllocationCount{};
+        uint64_t heapAllocatedBytes{};
+
+        RenderStatistics& operator+=(const RenderStatistics& other)
+        {
+            drawCallCount += other.drawCallCount;
+            indirectDrawCallCount += other.indirectDrawCallCount;
+            dispatchCount += other.dispatchCount;
+            triangleCount += other.triangleCount;
+            pipelineBindCount += other.pipelineBindCount;
+            descriptorSetBindCount += other.descriptorSetBindCount;
+            vertexBufferBindCount += other.vertexBufferBindCount;
+            indexBufferBindCount += other.indexBufferBindCount;
+            pushConstantBytes += other.pushConstantBytes;
+            skippedPipelineBindCount += other.skippedPipelineBindCount;
+            skippedIndexBufferBindCount += other.skippedIndexBufferBindCount;
+            visibleObjectCount += other.visibleObjectCount;
+            culledObjectCount += other.culledObjectCount;
+            uploadedBytes += other.uploadedBytes;
+            frameArenaBytes += other.frameArenaBytes;
+            heapAllocationCount += other.heapAllocationCount;
+            heapAllocatedBytes += other.heapAllocatedBytes;
+
+            return *this;
+        }
+    };
+
+    // One record of the telemetry log per frame.
+    struct TelemetryRecord
+    {
+        uint64_t frameNumber{};
+        double cpuFrameTimeMs{};
+        RenderStatistics renderStatistics{};
+    };
+
+    enum class TelemetryFormat : uint8_t
+    {
+        // One line per record, after a header line with the names of the columns.
+        eCsv,
+
+        // TELEMETRY_BINARY_MAGIC, the version and the size of a record (uint32_t each), then the TelemetryRecord structs as they are in memory.
+        eBinary,
+    };
+
+    // Streams telemetry records to a file. Records are pushed into a fixed size ring buffer, which a writer thread drains to the file : pushing
+    // never blocks or allocates, and records pushed while the ring is full are dropped (and counted) rather than waited on.
+    // push() must only be called from one thread.
+    class TelemetryWriter
+    {
+      public:
+        TelemetryWriter() = default;
+        ~TelemetryWriter();
+
+        TelemetryWriter(const TelemetryWriter&) = delete;
+        TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+        // Opens the file (replacing it) and starts the writer thread.
+        void open(const std::string_view path, const TelemetryFormat format);
+
+        // Writes the records left in the ring, and joins the writer thread.
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return m_writerThread.joinable(); }
+
+        void push(const TelemetryRecord& record);
+
+        [[nodiscard]] uint64_t getDroppedRecordCount() const { return m_droppedRecordCount; }
+
+      private:
+        void writerLoop();
+        void writeRecord(const TelemetryRecord& record);
+
+      public:
+        static constexpr uint32_t TELEMETRY_BINARY_MAGIC = 0x4D4C544Cu;
+        static constexpr uint32_t TELEMETRY_BINARY_VERSION = 2u;
+
+        // Over ten seconds of frames at 60 FPS, so that records are only dropped if the disk stalls for that long.
+        static constexpr size_t RING_CAPACITY = 1024u;
+
+      private:
+        std::ofstream m_file{};
+        TelemetryFormat m_format{};
+
+        // Single producer / single consumer ring (allocated by open()) : positions only grow, the slot of a position is position % RING_CAPACITY.
+        // The producer only writes the head, the writer thread only the tail.
+        std::vector<TelemetryRecord> m_ring{};
+        std::atomic<uint64_t> m_head{0u};
+        std::atomic<uint64_t> m_tail{0u};
+
+        uint64_t m_droppedRecordCount{};
+
+        std::thread m_writerThread{};
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        bool m_stopping{false};
+    };
+}
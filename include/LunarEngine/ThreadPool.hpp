@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace lunar
+{
+    // Fixed size pool of worker threads that execute tasks from a shared queue.
+    class ThreadPool
+    {
+      public:
+        // By default, one worker per hardware thread (minus the main thread).
+        explicit ThreadPool(const uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()>&& task);
+
+        [[nodiscard]] uint32_t getThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+      private:
+        void workerLoop();
+
+      private:
+        std::vector<std::thread> m_threads{};
+
+        std::deque<std::function<void()>> m_tasks{};
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        bool m_stopping{false};
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Resources.hpp"
+
+namespace lunar
+{
+    struct TransientImageDesc
+    {
+        vk::Format format{};
+        vk::Extent2D extent{};
+        vk::ImageUsageFlags usage{};
+
+        // First and last pass of the frame that use the image.
+        uint32_t firstPass{};
+        uint32_t lastPass{};
+
+        // The image is only used as an attachment of a single render pass instance, and its contents are never stored. Such images get the
+        // transient attachment usage, and lazily allocated memory where the device has some (tile based GPUs then never commit memory for them).
+        bool transientAttachment{};
+    };
+
+    // Transient image, and the memory slot it is bound to (several images can share a slot).
+    struct TransientImage
+    {
+        TransientImageDesc desc{};
+
+        vk::Image image{};
+        vk::ImageView imageView{};
+        uint32_t memorySlot{};
+    };
+
+    struct TransientMemoryStatistics
+    {
+        uint32_t imageCount{};
+        uint32_t memorySlotCount{};
+
+        // Memory the transient images would use with a dedicated allocation each, and memory allocated for them. Lazily allocated memory is
+        // counted separately, as it is only committed if the implementation needs it.
+        uint64_t requiredBytes{};
+        uint64_t allocatedBytes{};
+        uint64_t lazilyAllocatedBytes{};
+
+        // requiredBytes - allocatedBytes, for the current images and at most since init().
+        uint64_t savedBytes{};
+        uint64_t peakSavedBytes{};
+    };
+
+    // Allocates the transient images of a frame. Images whose pass lifetimes do not overlap alias the same memory : images are assigned to
+    // memory slots in the order of their first pass, and reuse the first slot whose images are all dead by then (and whose memory types are
+    // compatible). Transient attachments are given their own lazily allocated slots when the device supports it.
+    // Images are kept across frames, and only recreated when the descriptions change.
+    class TransientAllocator
+    {
+      public:
+        void init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker);
+        void destroy();
+
+        // Returns true if the images were (re)created, in which case the previous images and views are destroyed. As that only happens when
+        // the frame's passes or image sizes change, the device is waited on before destroying images that frames in flight may still use.
+        bool allocate(std::span<const TransientImageDesc> imageDescs);
+
+        [[nodiscard]] const std::vector<TransientImage>& getImages() const { return m_images; }
+
+        [[nodiscard]] uint32_t getMemorySlotCount() const { return static_cast<uint32_t>(m_memorySlots.size()); }
+        [[nodiscard]] vk::DeviceSize getMemorySlotSize(const uint32_t memorySlot) const { return m_memorySlots[memorySlot].size; }
+        [[nodiscard]] bool isMemorySlotLazilyAllocated(const uint32_t memorySlot) const { return m_memorySlots[memorySlot].lazilyAllocated; }
+
+        [[nodiscard]] const TransientMemoryStatistics& getStatistics() const { return m_statistics; }
+
+      private:
+        struct MemorySlot
+        {
+            VmaAllocation allocation{};
+            vk::DeviceSize size{};
+            bool lazilyAllocated{};
+        };
+
+        void destroyImages();
+
+      private:
+        vk::Device m_device{};
+        VmaAllocator m_allocator{};
+        MemoryTracker* m_memoryTracker{};
+
+        std::vector<TransientImage> m_images{};
+        std::vector<MemorySlot> m_memorySlots{};
+
+        TransientMemoryStatistics m_statistics{};
+    };
+}
@@ -1,26 +1,12 @@
 #pragma once
 
 #include "Resources.hpp"
+#include "JobSystem.hpp"
+#include "Telemetry.hpp"
+#include "TransientAllocator.hpp"
 
 namespace lunar
 {
-    struct DeletionQueue
-    {
-        std::deque<std::function<void()>> functions{};
-
-        void pushFunction(std::function<void()>&& func) { functions.push_back(func); }
-
-        void flush()
-        {
-            for (auto it = functions.rbegin(); it != functions.rend(); ++it)
-            {
-                (*it)();
-            }
-
-            functions.clear();
-        }
-    };
-
     // Vertex / Mesh related.
     struct Vertex
     {
@@ -69,39 +55,245 @@ namespace lunar
         }
     };
 
-    struct Mesh
+    // Compressed vertex layout (16 bytes, vs 36 for Vertex).
+    // Positions are quantized to 16 bit unorm within the mesh's bounding box, and dequantized with the mesh's position scale / offset.
+    // Normals are octahedral encoded into two 16 bit snorm values, and texture coordinates are stored as half precision floats.
+    struct CompactVertex
     {
-        uint32_t indicesCount{};
-        Buffer vertexBuffer{};
-        Buffer indexBuffer{};
+        std::array<uint16_t, 4> position{};
+        std::array<int16_t, 2> normal{};
+        std::array<uint16_t, 2> textureCoord{};
+
+        // Returns the vertex input state for this specific vertex type.
+        [[nodiscard]] static vk::PipelineVertexInputStateCreateInfo getVertexInputState()
+        {
+            static const vk::VertexInputBindingDescription vertexInputBindingDescription = {
+                .binding = 0u,
+                .stride = sizeof(CompactVertex),
+                .inputRate = vk::VertexInputRate::eVertex,
+            };
+
+            // The fourth position component is padding, as 3 component 16 bit formats are not guaranteed to be supported for vertex buffers.
+            static const std::array<vk::VertexInputAttributeDescription, 3> vertexInputAttributes = {vk::VertexInputAttributeDescription{
+                                                                                                         .location = 0u,
+                                                                                                         .binding = 0u,
+                                                                                                         .format = vk::Format::eR16G16B16A16Unorm,
+                                                                                                         .offset = offsetof(CompactVertex, position),
+                                                                                                     },
+                                                                                                     vk::VertexInputAttributeDescription{
+                                                                                                         .location = 1u,
+                                                                                                         .binding = 0u,
+                                                                                                         .format = vk::Format::eR16G16Snorm,
+                                                                                                         .offset = offsetof(CompactVertex, normal),
+                                                                                                     },
+                                                                                                     vk::VertexInputAttributeDescription{
+                                                                                                         .location = 2u,
+                                                                                                         .binding = 0u,
+                                                                                                         .format = vk::Format::eR16G16Sfloat,
+                                                                                                         .offset = offsetof(CompactVertex, textureCoord),
+                                                                                                     }};
+
+            static const vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {
+                .vertexBindingDescriptionCount = 1u,
+                .pVertexBindingDescriptions = &vertexInputBindingDescription,
+                .vertexAttributeDescriptionCount = 3u,
+                .pVertexAttributeDescriptions = vertexInputAttributes.data(),
+            };
+
+            return vertexInputStateCreateInfo;
+        }
     };
 
-    struct SceneBufferData
+    static_assert(sizeof(CompactVertex) == 16u);
+
+    enum class VertexFormat : uint32_t
     {
-        math::XMMATRIX viewProjectionMatrix{};
+        eFull,
+        eCompact,
     };
 
-    struct TransformBufferData
+    // Describes how the vertex / index data of a mesh is encoded on the GPU.
+    struct MeshEncoding
     {
-        math::XMMATRIX modelMatrix{math::XMMatrixIdentity()};
+        VertexFormat vertexFormat{VertexFormat::eFull};
+        vk::IndexType indexType{vk::IndexType::eUint32};
+
+        // Only used by the compact vertex format : position = quantizedPosition * positionScale + positionOffset.
+        math::XMFLOAT3 positionScale{1.0f, 1.0f, 1.0f};
+        math::XMFLOAT3 positionOffset{};
+
+        [[nodiscard]] uint32_t getVertexStride() const { return vertexFormat == VertexFormat::eCompact ? sizeof(CompactVertex) : sizeof(Vertex); }
+        [[nodiscard]] uint32_t getIndexStride() const { return indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+        // Dequantization is folded into the model matrix (row vector convention, so it is applied first).
+        [[nodiscard]] math::XMMATRIX getPositionDequantizationMatrix() const
+        {
+            return math::XMMatrixScaling(positionScale.x, positionScale.y, positionScale.z) * math::XMMatrixTranslation(positionOffset.x, positionOffset.y, positionOffset.z);
+        }
+    };
+
+    // Maximum number of levels of detail of a mesh (including the full detail LOD 0).
+    static constexpr uint32_t MAX_MESH_LOD_COUNT = 4u;
+
+    // Axis aligned bounding box, as a center and half extents.
+    struct BoundingBox
+    {
+        math::XMFLOAT3 center{};
+        math::XMFLOAT3 extents{};
+    };
+
+    struct IndexRange
+    {
+        uint32_t firstIndex{};
+        uint32_t indexCount{};
+    };
+
+    // A range of the mesh's vertex / index buffer (one per glTF primitive). Indices are relative to the submesh's vertex offset.
+    // firstIndex / indexCount is the full detail index range, simplified LODs index into the same vertices.
+    struct Submesh
+    {
+        uint32_t vertexOffset{};
+        uint32_t vertexCount{};
+        uint32_t firstIndex{};
+        uint32_t indexCount{};
+
+        // Index ranges of LOD 1 to MAX_MESH_LOD_COUNT - 1.
+        std::array<IndexRange, MAX_MESH_LOD_COUNT - 1u> lodIndexRanges{};
+
+        // Meshlets partitioning the full detail index range (in index order).
+        uint32_t firstMeshlet{};
+        uint32_t meshletCount{};
+
+        // Object space bounds of the submesh's vertices.
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
+
+        [[nodiscard]] IndexRange getIndexRange(const uint32_t lodIndex) const
+        {
+            return lodIndex == 0u ? IndexRange{.firstIndex = firstIndex, .indexCount = indexCount} : lodIndexRanges[lodIndex - 1u];
+        }
+    };
+
+    // Meshlet limits (the usual mesh shader limits, so that the same clusters can be used if the engine ever switches to mesh shaders).
+    static constexpr uint32_t MAX_MESHLET_VERTEX_COUNT = 64u;
+    static constexpr uint32_t MAX_MESHLET_TRIANGLE_COUNT = 124u;
+
+    // A cluster of triangles that are contiguous in the submesh's full detail index range, along with the data needed to cull it.
+    // All culling data is in object space.
+    struct Meshlet
+    {
+        math::XMFLOAT4 boundingSphere{};
+
+        // Normal cone : the meshlet is entirely backfacing if dot(normalize(apex - cameraPosition), axis) >= cutoff. A cutoff of 1 means the cone
+        // is too wide for the meshlet to ever be backface culled.
+        math::XMFLOAT3 coneApex{};
+        math::XMFLOAT3 coneAxis{};
+        float coneCutoff{1.0f};
+
+        IndexRange indexRange{};
+    };
+
+    // Level of detail chain of a mesh. Every submesh has lodCount index ranges.
+    struct MeshLodChain
+    {
+        uint32_t lodCount{1u};
+
+        // Object space geometric error of each LOD (the error of LOD 0 is 0). Errors are increasing along the chain.
+        std::array<float, MAX_MESH_LOD_COUNT> lodErrors{};
+    };
+
+    // CPU side mesh data, as produced by the importer.
+    // Texture coordinates are a separate stream (one per vertex), as the full precision Vertex layout has no use for them yet.
+    struct MeshData
+    {
+        std::vector<Vertex> vertices{};
+        std::vector<math::XMFLOAT2> textureCoords{};
+        std::vector<uint32_t> indices{};
+        std::vector<Submesh> submeshes{};
+        std::vector<Meshlet> meshlets{};
+
+        MeshLodChain lodChain{};
+
+        // Object space bounds (for the sphere, xyz is the center and w the radius).
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
+    };
+
+    // GPU ready mesh data : vertices are in the encoding's vertex format and indices in its index type.
+    struct PackedMeshData
+    {
+        MeshEncoding encoding{};
+        std::vector<std::byte> vertexData{};
+        std::vector<std::byte> indexData{};
+        std::vector<Submesh> submeshes{};
+        std::vector<Meshlet> meshlets{};
+
+        MeshLodChain lodChain{};
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
+    };
+
+    // Index of a mesh's allocation in the geometry pool.
+    using GeometryHandle = uint32_t;
+
+    // Identifies the batch an upload was recorded in (see UploadManager). The upload has completed once the upload manager's timeline semaphore
+    // reaches the value.
+    struct UploadTicket
+    {
+        uint64_t timelineValue{};
+    };
+
+    // Meshes are loaded (on the asset loader threads for streamed meshes), then uploaded. Render objects are only drawn once their mesh is
+    // resident.
+    enum class MeshResidency : uint32_t
+    {
+        eLoading,
+        eUploading,
+        eResident,
+        eFailed,
+    };
+
+    struct Mesh
+    {
+        uint32_t indicesCount{};
+        GeometryHandle geometryHandle{INVALID_U32};
+
+        MeshResidency residency{MeshResidency::eLoading};
+        UploadTicket uploadTicket{};
+
+        // Id of the load request that streams the mesh in. A mesh destroyed and requested again under the same name gets a new id, so that
+        // the result of the earlier load is dropped.
+        uint64_t loadRequestId{};
+
+        MeshEncoding encoding{};
+        std::vector<Submesh> submeshes{};
+        std::vector<Meshlet> meshlets{};
+
+        MeshLodChain lodChain{};
+        BoundingBox boundingBox{};
+        math::XMFLOAT4 boundingSphere{};
     };
 
-    struct TransformBuffer
+    struct SceneBufferData
     {
-        Buffer buffer{};
-        TransformBufferData bufferData{};
+        math::XMMATRIX viewProjectionMatrix{};
     };
 
-    struct BufferUploadData
+    struct TransformBufferData
     {
-        Buffer stagingBuffer{};
-        uint64_t size{};
+        math::XMMATRIX modelMatrix{math::XMMatrixIdentity()};
     };
 
     struct Material
     {
         vk::Pipeline pipeline{};
         vk::PipelineLayout pipelineLayout{};
+
+        // Variant of this material used by the GPU driven path (transforms are read from a storage buffer rather than push constants).
+        Material* gpuDrivenVariant{};
+
+        // Variant of this material used for instanced draws (transforms are read from the instance buffer, indexed by the instance index).
+        Material* instancedVariant{};
     };
 
     // Point to the mesh / material from the mesh / material collection.
@@ -110,7 +302,93 @@ namespace lunar
         Mesh* mesh{};
         Material* material{};
 
-        TransformBuffer transformBuffer{};
+        TransformBufferData transformData{};
+
+        // Selected every frame from the projected screen space error of the mesh's LODs.
+        uint32_t lodIndex{};
+
+        // Leaf of the render object in the scene BVH (whose user data is the index of the render object).
+        uint32_t bvhLeaf{INVALID_U32};
+    };
+
+    // GPU driven rendering. The layouts of these structs match the structured buffers in shaders/GpuDriven.hlsli.
+
+    // Per mesh data read by the culling compute shader (bounds and LOD errors) and the vertex shaders (position dequantization).
+    struct GpuMeshData
+    {
+        math::XMFLOAT4 boundingSphere{};
+        math::XMFLOAT3 positionScale{1.0f, 1.0f, 1.0f};
+        uint32_t lodCount{1u};
+        math::XMFLOAT3 positionOffset{};
+        uint32_t padding{};
+        math::XMFLOAT4 lodErrors{};
+    };
+
+    static_assert(sizeof(GpuMeshData) == 64u);
+
+    // One per (render object, submesh). Index ranges are absolute (i.e include the base index of the mesh in the geometry pool), and the culling
+    // compute shader writes the draw command of the selected LOD at firstCommand + (number of draws of the batch that were already emitted).
+    struct GpuDrawItem
+    {
+        uint32_t objectIndex{};
+        uint32_t meshIndex{};
+        uint32_t batchIndex{};
+        uint32_t firstCommand{};
+        int32_t vertexOffset{};
+        uint32_t padding{};
+        std::array<IndexRange, MAX_MESH_LOD_COUNT> lodIndexRanges{};
+    };
+
+    static_assert(sizeof(GpuDrawItem) == 56u);
+
+    // Push constants of the culling compute shader.
+    struct GpuCullingConstants
+    {
+        std::array<math::XMFLOAT4, 6> frustumPlanes{};
+
+        // Fourth column of the view projection matrix (dot(float4(position, 1), depthColumn) is the view space depth).
+        math::XMFLOAT4 depthColumn{};
+
+        float projectionScale{};
+        float lodErrorThreshold{};
+        uint32_t drawItemCount{};
+        uint32_t padding{};
+    };
+
+    static_assert(sizeof(GpuCullingConstants) == 128u);
+
+    // Draw items that are drawn with a single drawIndexedIndirectCount : all use the same material and index type, and their draw commands
+    // are in [firstCommand, firstCommand + maxDrawCount) of the draw command buffer.
+    struct IndirectDrawBatch
+    {
+        Material* material{};
+        vk::IndexType indexType{};
+        uint32_t firstCommand{};
+        uint32_t maxDrawCount{};
+    };
+
+    // Buffers of the GPU driven path built from the render objects (mesh data and draw items), and the batches their draw commands are
+    // grouped into. The per frame draw command / draw count buffers are in FrameData, as they are written by the GPU every frame.
+    struct GpuDrivenScene
+    {
+        Buffer meshBuffer{};
+        Buffer drawItemBuffer{};
+        uint32_t drawItemCount{};
+        std::vector<IndirectDrawBatch> indirectDrawBatches{};
+
+        // Ticket of the upload of the mesh data and draw items.
+        UploadTicket uploadTicket{};
+    };
+
+    // Visible render objects that share a material, mesh and LOD, drawn with one instanced draw per submesh. The model matrices of the
+    // instances are in [firstInstance, firstInstance + instanceCount) of the instance buffer.
+    struct InstanceGroup
+    {
+        Material* material{};
+        Mesh* mesh{};
+        uint32_t lodIndex{};
+        uint32_t firstInstance{};
+        uint32_t instanceCount{};
     };
 
     // Pipeline related.
@@ -125,4 +403,59 @@ namespace lunar
         vk::PipelineRenderingCreateInfo pipelineRenderingInfo{};
     };
 
+    // Benchmark related.
+    struct FrameTimeStatistics
+    {
+        double minMs{};
+        double avgMs{};
+        double p99Ms{};
+        double maxMs{};
+
+        // Note that the samples are sorted in place.
+        [[nodiscard]] static FrameTimeStatistics compute(std::span<double> samples)
+        {
+            if (samples.empty())
+            {
+                return FrameTimeStatistics{};
+            }
+
+            std::sort(samples.begin(), samples.end());
+
+            // Nearest rank percentile.
+            const size_t p99Index = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(samples.size()))) - 1u;
+
+            return FrameTimeStatistics{
+                .minMs = samples.front(),
+                .avgMs = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()),
+                .p99Ms = samples[p99Index],
+                .maxMs = samples.back(),
+            };
+        }
+    };
+
+    struct BenchmarkResults
+    {
+        // Startup timings, useful to compare cold (empty pipeline cache) and warm launches.
+        double initTimeMs{};
+        double pipelineCreationTimeMs{};
+        bool pipelineCacheWarm{};
+
+        uint32_t frameCount{};
+        FrameTimeStatistics cpuFrameTime{};
+        FrameTimeStatistics gpuFrameTime{};
+
+        // Render objects per frame that passed / failed CPU frustum culling (0 in the GPU driven path, where culling is done on the GPU).
+        double averageVisibleObjectCount{};
+        double averageCulledObjectCount{};
+
+        // Sum of the render statistics of the measured frames.
+        RenderStatistics totalRenderStatistics{};
+
+        // Per worker statistics of the job system over the measured frames.
+        std::vector<JobWorkerStatistics> jobWorkerStatistics{};
+
+        // Memory of the render graph's transient images (ex the depth buffer), and how much aliasing / lazy allocation saved.
+        TransientMemoryStatistics transientMemoryStatistics{};
+    };
+
 }
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace lunar
+{
+    struct UploadStatistics
+    {
+        uint64_t uploadedBytes{};
+        uint64_t submittedBatchCount{};
+
+        // Number of times an upload had to wait for an earlier batch to complete, as the staging ring was full.
+        uint64_t stallCount{};
+    };
+
+    // Streams data from the CPU into GPU only buffers on the transfer queue, without blocking the caller.
+    // Data is copied into a persistently mapped staging ring, and its copies are recorded into a transfer command buffer. flush() submits the
+    // recorded copies as one batch that signals the next value of a timeline semaphore, and every upload returns the ticket of the batch it is
+    // recorded in. The staging space and command buffer of a batch are reused once its value has been reached, so uploads only block when the
+    // ring is full of batches that are still in flight.
+    // If the transfer queue is from another family than the graphics queue, each batch releases the buffer ranges it wrote to the graphics
+    // queue family, and acquireCompletedUploads() records the matching acquire barriers into a graphics command buffer.
+    // Must only be used from one thread.
+    class UploadManager
+    {
+      public:
+        void init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker, const vk::Queue transferQueue,
+                  const uint32_t transferQueueIndex, const uint32_t graphicsQueueIndex, const uint32_t stagingRingSize);
+        void destroy();
+
+        // Copies the data into the staging ring and records its copy into buffer at offset (buffer must have been created with the transfer dst
+        // usage). Uploads larger than a fraction of the ring are split into several copies, and several batches if the ring fills up.
+        UploadTicket uploadBuffer(const vk::Buffer buffer, const vk::DeviceSize offset, std::span<const std::byte> data);
+
+        // Submits the copies recorded since the last flush (if any). Returns the ticket of the last submitted batch.
+        UploadTicket flush();
+
+        [[nodiscard]] bool isComplete(const UploadTicket ticket) const;
+
+        // Submits the ticket's batch if it has not been yet, and blocks until it has completed.
+        void wait(const UploadTicket ticket);
+
+        // Records the acquire barriers of the batches that have completed since the last call into a graphics command buffer, after which the
+        // data of those batches can be used by it. Returns the timeline value the submission of the command buffer must wait on.
+        [[nodiscard]] uint64_t acquireCompletedUploads(const vk::CommandBuffer commandBuffer);
+
+        [[nodiscard]] vk::Semaphore getTimelineSemaphore() const { return m_timelineSemaphore; }
+        [[nodiscard]] const UploadStatistics& getStatistics() const { return m_statistics; }
+
+      private:
+        // Buffer range written by a batch, whose ownership is transferred to the graphics queue family.
+        struct OwnershipTransfer
+        {
+            vk::Buffer buffer{};
+            vk::DeviceSize offset{};
+            vk::DeviceSize size{};
+        };
+
+        struct Batch
+        {
+            vk::CommandBuffer commandBuffer{};
+            uint64_t timelineValue{};
+
+            // Position of the ring head once the batch's data was written (the ring tail moves here when the batch has completed).
+            uint64_t stagingEnd{};
+
+            std::vector<OwnershipTransfer> ownershipTransfers{};
+        };
+
+        // Returns the offset in the staging ring of size free bytes, flushing and waiting for earlier batches if the ring is full.
+        [[nodiscard]] uint64_t allocateStaging(const uint64_t size);
+
+        // Begins recording the current batch if it has no copies yet.
+        void beginBatch();
+
+        // Releases the staging space and command buffers of every submitted batch that has completed.
+        void retireCompletedBatches();
+
+        [[nodiscard]] vk::BufferMemoryBarrier2 createOwnershipBarrier(const OwnershipTransfer& ownershipTransfer, const bool release) const;
+
+      private:
+        vk::Device m_device{};
+        VmaAllocator m_allocator{};
+        MemoryTracker* m_memoryTracker{};
+
+        vk::Queue m_transferQueue{};
+        uint32_t m_transferQueueIndex{};
+        uint32_t m_graphicsQueueIndex{};
+
+        vk::CommandPool m_commandPool{};
+        std::vector<vk::CommandBuffer> m_freeCommandBuffers{};
+
+        vk::Semaphore m_timelineSemaphore{};
+
+        Buffer m_stagingBuffer{};
+        std::byte* m_stagingData{};
+        uint64_t m_stagingSize{};
+
+        // Total number of bytes allocated from / released to the ring. The ring offset of a position is position % m_stagingSize.
+        uint64_t m_stagingHead{};
+        uint64_t m_stagingTail{};
+
+        // The batch that copies are recorded into, whose timeline value is that of the next submission.
+        Batch m_recordingBatch{};
+        bool m_recording{false};
+
+        // Submitted batches, in submission order.
+        std::deque<Batch> m_submittedBatches{};
+        uint64_t m_lastSubmittedValue{};
+
+        // Buffer ranges of completed batches that have not been acquired by the graphics queue family yet, and the last completed value.
+        std::vector<OwnershipTransfer> m_pendingAcquires{};
+        uint64_t m_completedValue{};
+
+        // Scratch memory of the release / acquire barriers, reused from batch to batch.
+        std::vector<vk::BufferMemoryBarrier2> m_ownershipBarriers{};
+
+        UploadStatistics m_statistics{};
+    };
+}
@@ -24,4 +24,50 @@ inline void vkCheck(const VkResult& result)
         const auto res = vk::Result(result);
         throw std::runtime_error(vk::to_string(res));
     }
-}
\ No newline at end of file
+}
+
+// Aspects of an image of the given format (depth and / or stencil for depth formats, color otherwise).
+[[nodiscard]] inline vk::ImageAspectFlags getImageAspect(const vk::Format format)
+{
+    switch (format)
+    {
+    case vk::Format::eD16Unorm:
+    case vk::Format::eX8D24UnormPack32:
+    case vk::Format::eD32Sfloat:
+        return vk::ImageAspectFlagBits::eDepth;
+    case vk::Format::eD16UnormS8Uint:
+    case vk::Format::eD24UnormS8Uint:
+    case vk::Format::eD32SfloatS8Uint:
+        return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+    default:
+        return vk::ImageAspectFlagBits::eColor;
+    }
+}
+
+// Ticks between two timestamps written by a queue with the given number of valid timestamp bits (the other bits of the query results are
+// undefined, and the counter wraps around at 2^validBits).
+[[nodiscard]] inline uint64_t getTimestampDelta(const uint64_t beginTimestamp, const uint64_t endTimestamp, const uint32_t validBits)
+{
+    const uint64_t mask = validBits < 64u ? (1ull << validBits) - 1ull : ~0ull;
+
+    return ((endTimestamp & mask) - (beginTimestamp & mask)) & mask;
+}
+
+// 64 bit FNV-1a hash. Not cryptographically secure, but fast and good enough for detecting stale / corrupt cache files.
+static constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+[[nodiscard]] inline uint64_t fnv1aHash(const void* data, const size_t size, const uint64_t seed = FNV1A_OFFSET_BASIS)
+{
+    constexpr uint64_t fnv1aPrime = 0x100000001b3ull;
+
+    uint64_t hash = seed;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= fnv1aPrime;
+    }
+
+    return hash;
+}
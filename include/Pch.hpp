@@ -6,20 +6,36 @@ constexpr bool LUNAR_DEBUG = true;
 constexpr bool LUNAR_DEBUG = false;
 #endif
 
+#ifdef DEF_LUNAR_PROFILING
+constexpr bool LUNAR_PROFILING = true;
+#else
+constexpr bool LUNAR_PROFILING = false;
+#endif
+
 // STL includes.
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <deque>
 #include <stdexcept>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <filesystem>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <ranges>
 #include <queue>
 #include <functional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <unordered_map>
 #include <vector>
 #include <source_location>
 #include <format>
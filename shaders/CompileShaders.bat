@@ -2,4 +2,10 @@ WHERE dxc
 IF %ERRORLEVEL% NEQ 0 ECHO DirectX Shader Compiler was not found. Consider installing it for shader compilation.
 
 dxc -spirv -T vs_6_6 -E VsMain Shader.hlsl -Fo ShaderVS.cso
-dxc -spirv -T ps_6_6 -E PsMain Shader.hlsl -Fo ShaderPS.cso
\ No newline at end of file
+dxc -spirv -T ps_6_6 -E PsMain Shader.hlsl -Fo ShaderPS.cso
+dxc -spirv -T vs_6_6 -E VsMainCompact Shader.hlsl -Fo ShaderCompactVS.cso
+dxc -spirv -T vs_6_6 -E VsMainIndirect Shader.hlsl -Fo ShaderIndirectVS.cso
+dxc -spirv -T vs_6_6 -E VsMainCompactIndirect Shader.hlsl -Fo ShaderCompactIndirectVS.cso
+dxc -spirv -T cs_6_6 -E CsMain Culling.hlsl -Fo CullingCS.cso
+dxc -spirv -T vs_6_6 -E VsMainInstanced Shader.hlsl -Fo ShaderInstancedVS.cso
+dxc -spirv -T vs_6_6 -E VsMainCompactInstanced Shader.hlsl -Fo ShaderCompactInstancedVS.cso
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "GpuDriven.hlsli"
+
+// Layout matches GpuCullingConstants in include/LunarEngine/Types.hpp.
+struct CullingConstants
+{
+    float4 frustumPlanes[6];
+
+    // Fourth column of the view projection matrix (dot(float4(position, 1.0f), depthColumn) is the view space depth).
+    float4 depthColumn;
+
+    float projectionScale;
+    float lodErrorThreshold;
+    uint drawItemCount;
+    uint padding;
+};
+
+[[vk::push_constant]] ConstantBuffer<CullingConstants> cullingConstants;
+
+// One thread per draw item : the item is culled against the frustum, the LOD is selected from the projected error (as done by
+// Engine::selectLod on the CPU), and the draw command of the LOD is appended to the draw commands of the item's batch.
+[numthreads(64, 1, 1)]
+void CsMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint drawItemIndex = dispatchThreadId.x;
+    if (drawItemIndex >= cullingConstants.drawItemCount)
+    {
+        return;
+    }
+
+    const DrawItem drawItem = drawItems[drawItemIndex];
+    const MeshData mesh = meshes[drawItem.meshIndex];
+    const float4x4 modelMatrix = objectTransforms[drawItem.objectIndex].modelMatrix;
+
+    const float3 center = mul(float4(mesh.boundingSphere.xyz, 1.0f), modelMatrix).xyz;
+    const float maxScale = sqrt(max(max(dot(modelMatrix[0].xyz, modelMatrix[0].xyz), dot(modelMatrix[1].xyz, modelMatrix[1].xyz)), dot(modelMatrix[2].xyz, modelMatrix[2].xyz)));
+    const float radius = mesh.boundingSphere.w * maxScale;
+
+    for (uint planeIndex = 0; planeIndex < 6; planeIndex++)
+    {
+        const float4 plane = cullingConstants.frustumPlanes[planeIndex];
+        if (dot(plane.xyz, center) + plane.w < -radius)
+        {
+            return;
+        }
+    }
+
+    uint lodIndex = 0;
+
+    const float depth = dot(float4(center, 1.0f), cullingConstants.depthColumn) - radius;
+    if (depth > 0.0f)
+    {
+        for (uint lod = mesh.lodCount - 1; lod > 0; lod--)
+        {
+            if (mesh.lodErrors[lod] * maxScale / depth * cullingConstants.projectionScale <= cullingConstants.lodErrorThreshold)
+            {
+                lodIndex = lod;
+                break;
+            }
+        }
+    }
+
+    const uint2 indexRange = drawItem.lodIndexRanges[lodIndex];
+    if (indexRange.y == 0)
+    {
+        return;
+    }
+
+    uint commandIndex;
+    InterlockedAdd(drawCounts[drawItem.batchIndex], 1, commandIndex);
+
+    // The draw item index is passed as the first instance, so that the vertex shader can find the item's transform.
+    DrawIndexedCommand drawCommand;
+    drawCommand.indexCount = indexRange.y;
+    drawCommand.instanceCount = 1;
+    drawCommand.firstIndex = indexRange.x;
+    drawCommand.vertexOffset = drawItem.vertexOffset;
+    drawCommand.firstInstance = drawItemIndex;
+
+    drawCommands[drawItem.firstCommand + commandIndex] = drawCommand;
+}
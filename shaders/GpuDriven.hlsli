@@ -0,0 +1,45 @@
+// Buffers of the GPU driven path (descriptor set 1). The layouts match GpuMeshData / GpuDrawItem in include/LunarEngine/Types.hpp.
+
+struct ObjectTransform
+{
+    row_major matrix modelMatrix;
+};
+
+struct MeshData
+{
+    float4 boundingSphere;
+    float3 positionScale;
+    uint lodCount;
+    float3 positionOffset;
+    uint padding;
+    float4 lodErrors;
+};
+
+struct DrawItem
+{
+    uint objectIndex;
+    uint meshIndex;
+    uint batchIndex;
+    uint firstCommand;
+    int vertexOffset;
+    uint padding;
+
+    // (first index, index count) of each LOD.
+    uint2 lodIndexRanges[4];
+};
+
+// Same layout as VkDrawIndexedIndirectCommand.
+struct DrawIndexedCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+[[vk::binding(0, 1)]] StructuredBuffer<ObjectTransform> objectTransforms : register(t0, space1);
+[[vk::binding(1, 1)]] StructuredBuffer<MeshData> meshes : register(t1, space1);
+[[vk::binding(2, 1)]] StructuredBuffer<DrawItem> drawItems : register(t2, space1);
+[[vk::binding(3, 1)]] RWStructuredBuffer<DrawIndexedCommand> drawCommands : register(u3, space1);
+[[vk::binding(4, 1)]] RWStructuredBuffer<uint> drawCounts : register(u4, space1);
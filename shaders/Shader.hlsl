@@ -5,6 +5,15 @@ struct VertexInput
     [[vk::location(2)]] float3 color : COLOR;
 };
 
+// Compact vertex format : positions are unorm16 (dequantized by the model matrix), normals are octahedral encoded snorm16 and texture
+// coordinates are half floats.
+struct CompactVertexInput
+{
+    [[vk::location(0)]] float4 position : POSITION;
+    [[vk::location(1)]] float2 normal : NORMAL;
+    [[vk::location(2)]] float2 textureCoord : TEXCOORD;
+};
+
 struct VsOutput
 {
     float4 position : SV_Position;
@@ -23,7 +32,23 @@ struct TransformBuffer
 
 // [[vk::binding(x, y)]] : binding number x, set number x.
 [[vk::binding(0, 0)]] ConstantBuffer<SceneBuffer> sceneBuffer: register(b0, space0);
-[[vk::binding(0, 1)]] ConstantBuffer<TransformBuffer> transformBuffer : register(b0, space1);
+[[vk::push_constant]] ConstantBuffer<TransformBuffer> transformBuffer;
+
+// Used by the GPU driven path (VsMainIndirect / VsMainCompactIndirect), and by the instanced path (VsMainInstanced / VsMainCompactInstanced),
+// whose set 1 only has the instance transforms at the binding of objectTransforms.
+#include "GpuDriven.hlsli"
+
+// Inverse of the octahedral encoding done in MeshEncoder.cpp.
+float3 decodeOctahedral(float2 encodedNormal)
+{
+    float3 normal = float3(encodedNormal.x, encodedNormal.y, 1.0f - abs(encodedNormal.x) - abs(encodedNormal.y));
+    if (normal.z < 0.0f)
+    {
+        normal.xy = (1.0f - abs(normal.yx)) * float2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return normalize(normal);
+}
 
 VsOutput VsMain(VertexInput input)
 {
@@ -34,4 +59,63 @@ VsOutput VsMain(VertexInput input)
     return output;
 }
 
+VsOutput VsMainCompact(CompactVertexInput input)
+{
+    VsOutput output;
+    output.position = mul(mul(float4(input.position.xyz, 1.0f), transformBuffer.modelMatrix), sceneBuffer.viewProjectionMatrix);
+
+    // The full vertex format stores the normal as the vertex color, so the same is done here.
+    output.color = decodeOctahedral(input.normal);
+
+    return output;
+}
+
+// GPU driven path : the first instance of each draw command is the index of its draw item. DXC maps SV_InstanceID to InstanceIndex, which
+// includes the first instance.
+VsOutput VsMainIndirect(VertexInput input, uint instanceId : SV_InstanceID)
+{
+    const DrawItem drawItem = drawItems[instanceId];
+
+    VsOutput output;
+    output.position = mul(mul(float4(input.position, 1.0f), objectTransforms[drawItem.objectIndex].modelMatrix), sceneBuffer.viewProjectionMatrix);
+    output.color = input.color;
+
+    return output;
+}
+
+VsOutput VsMainCompactIndirect(CompactVertexInput input, uint instanceId : SV_InstanceID)
+{
+    const DrawItem drawItem = drawItems[instanceId];
+    const MeshData mesh = meshes[drawItem.meshIndex];
+
+    // Dequantization is done here rather than folded into the model matrix, so that the CPU only has to copy the model matrices.
+    const float3 position = input.position.xyz * mesh.positionScale + mesh.positionOffset;
+
+    VsOutput output;
+    output.position = mul(mul(float4(position, 1.0f), objectTransforms[drawItem.objectIndex].modelMatrix), sceneBuffer.viewProjectionMatrix);
+    output.color = decodeOctahedral(input.normal);
+
+    return output;
+}
+
+// Instanced path : the instance index (which includes the first instance of the draw) indexes the instance transforms. Dequantization of
+// compact positions is folded into the instance transforms by the CPU.
+VsOutput VsMainInstanced(VertexInput input, uint instanceId : SV_InstanceID)
+{
+    VsOutput output;
+    output.position = mul(mul(float4(input.position, 1.0f), objectTransforms[instanceId].modelMatrix), sceneBuffer.viewProjectionMatrix);
+    output.color = input.color;
+
+    return output;
+}
+
+VsOutput VsMainCompactInstanced(CompactVertexInput input, uint instanceId : SV_InstanceID)
+{
+    VsOutput output;
+    output.position = mul(mul(float4(input.position.xyz, 1.0f), objectTransforms[instanceId].modelMatrix), sceneBuffer.viewProjectionMatrix);
+    output.color = decodeOctahedral(input.normal);
+
+    return output;
+}
+
 float4 PsMain(VsOutput input) : SV_Target { return float4(input.color, 1.0f); }
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "AllocationTracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace lunar
+{
+    namespace
+    {
+        struct CallSiteCounters
+        {
+            std::atomic<const char*> name{};
+            std::atomic<uint64_t> allocationCount{};
+            std::atomic<uint64_t> allocatedBytes{};
+        };
+
+        // Open addressing table of the call sites, keyed by the address of their name (scope names are string literals). Slots are claimed
+        // with a compare exchange and never released, so counting an allocation never allocates or locks. Allocations of call sites that do
+        // not fit are counted in the last slot.
+        constexpr size_t CALL_SITE_CAPACITY = 256u;
+        constexpr const char* OVERFLOW_CALL_SITE_NAME = "(other allocation scopes)";
+
+        std::array<CallSiteCounters, CALL_SITE_CAPACITY + 1u> callSites{};
+
+        std::atomic<uint64_t> allocationCount{};
+        std::atomic<uint64_t> allocatedBytes{};
+
+        thread_local bool currentThreadTracked{false};
+        thread_local const char* currentScope{};
+
+        void countCallSite(const char* name, const size_t size)
+        {
+            const size_t firstSlot = (std::bit_cast<uintptr_t>(name) >> 3u) % CALL_SITE_CAPACITY;
+
+            for (const size_t probe : std::views::iota(size_t{0u}, CALL_SITE_CAPACITY))
+            {
+                CallSiteCounters& callSite = callSites[(firstSlot + probe) % CALL_SITE_CAPACITY];
+
+                const char* slotName = callSite.name.load(std::memory_order_acquire);
+                if (slotName == nullptr && callSite.name.compare_exchange_strong(slotName, name, std::memory_order_acq_rel))
+                {
+                    slotName = name;
+                }
+
+                if (slotName == name)
+                {
+                    callSite.allocationCount.fetch_add(1u, std::memory_order_relaxed);
+                    callSite.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            CallSiteCounters& overflowCallSite = callSites[CALL_SITE_CAPACITY];
+            overflowCallSite.name.store(OVERFLOW_CALL_SITE_NAME, std::memory_order_relaxed);
+            overflowCallSite.allocationCount.fetch_add(1u, std::memory_order_relaxed);
+            overflowCallSite.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void countAllocation(const size_t size)
+        {
+            if (!currentThreadTracked)
+            {
+                return;
+            }
+
+            allocationCount.fetch_add(1u, std::memory_order_relaxed);
+            allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+            if constexpr (LUNAR_DEBUG)
+            {
+                countCallSite(currentScope ? currentScope : AllocationTracker::UNSCOPED_CALL_SITE_NAME, size);
+            }
+        }
+
+        [[nodiscard]] void* allocate(const size_t size) noexcept
+        {
+            countAllocation(size);
+
+            // malloc(0) may return null, but operator new must return a unique pointer.
+            return std::malloc(std::max(size, size_t{1u}));
+        }
+
+        [[nodiscard]] void* allocateAligned(const size_t size, const std::align_val_t alignment) noexcept
+        {
+            countAllocation(size);
+
+            const size_t alignmentValue = static_cast<size_t>(alignment);
+
+#ifdef _MSC_VER
+            return _aligned_malloc(std::max(size, size_t{1u}), alignmentValue);
+#else
+            // The size passed to aligned_alloc must be a multiple of the alignment.
+            return std::aligned_alloc(alignmentValue, (std::max(size, size_t{1u}) + alignmentValue - 1u) & ~(alignmentValue - 1u));
+#endif
+        }
+
+        void deallocateAligned(void* pointer) noexcept
+        {
+#ifdef _MSC_VER
+            _aligned_free(pointer);
+#else
+            std::free(pointer);
+#endif
+        }
+
+        [[nodiscard]] void* allocateOrThrow(const size_t size)
+        {
+            void* pointer = allocate(size);
+            if (!pointer)
+            {
+                throw std::bad_alloc{};
+            }
+
+            return pointer;
+        }
+
+        [[nodiscard]] void* allocateAlignedOrThrow(const size_t size, const std::align_val_t alignment)
+        {
+            void* pointer = allocateAligned(size, alignment);
+            if (!pointer)
+            {
+                throw std::bad_alloc{};
+            }
+
+            return pointer;
+        }
+    }
+
+    bool AllocationTracker::isCurrentThreadTracked()
+    {
+        return currentThreadTracked;
+    }
+
+    void AllocationTracker::setCurrentThreadTracked(const bool tracked)
+    {
+        currentThreadTracked = tracked;
+    }
+
+    AllocationCounters AllocationTracker::getCounters()
+    {
+        return AllocationCounters{
+            .allocationCount = allocationCount.load(std::memory_order_relaxed),
+            .allocatedBytes = allocatedBytes.load(std::memory_order_relaxed),
+        };
+    }
+
+    std::vector<AllocationCallSite> AllocationTracker::getCallSites()
+    {
+        std::vector<AllocationCallSite> result{};
+
+        for (const CallSiteCounters& callSite : callSites)
+        {
+            const char* name = callSite.name.load(std::memory_order_acquire);
+            const uint64_t callSiteAllocationCount = callSite.allocationCount.load(std::memory_order_relaxed);
+            if (!name || callSiteAllocationCount == 0u)
+            {
+                continue;
+            }
+
+            // The same literal can have a different address in each translation unit, so call sites are merged by name.
+            const auto existingCallSite = std::ranges::find(result, std::string_view(name), &AllocationCallSite::name);
+            if (existingCallSite != result.end())
+            {
+                existingCallSite->allocationCount += callSiteAllocationCount;
+                existingCallSite->allocatedBytes += callSite.allocatedBytes.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            result.push_back(AllocationCallSite{
+                .name = name,
+                .allocationCount = callSiteAllocationCount,
+                .allocatedBytes = callSite.allocatedBytes.load(std::memory_order_relaxed),
+            });
+        }
+
+        std::ranges::sort(result, std::ranges::greater{}, &AllocationCallSite::allocationCount);
+
+        return result;
+    }
+
+    void AllocationTracker::resetCallSites()
+    {
+        for (CallSiteCounters& callSite : callSites)
+        {
+            callSite.allocationCount.store(0u, std::memory_order_relaxed);
+            callSite.allocatedBytes.store(0u, std::memory_order_relaxed);
+        }
+    }
+
+    const char* AllocationTracker::getCurrentScope()
+    {
+        return currentScope;
+    }
+
+    void AllocationTracker::setCurrentScope(const char* name)
+    {
+        currentScope = name;
+    }
+}
+
+// Replacements of the global allocation functions. Every form of operator new is replaced (so that none is missed by the counts), and every
+// form of operator delete to match them.
+
+void* operator new(const size_t size)
+{
+    return lunar::allocateOrThrow(size);
+}
+
+void* operator new[](const size_t size)
+{
+    return lunar::allocateOrThrow(size);
+}
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept
+{
+    return lunar::allocate(size);
+}
+
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept
+{
+    return lunar::allocate(size);
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+    return lunar::allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment)
+{
+    return lunar::allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return lunar::allocateAligned(size, alignment);
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return lunar::allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::align_val_t) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
+
+void operator delete[](void* pointer, const std::align_val_t) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, const std::align_val_t) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, const std::align_val_t) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
+
+void operator delete(void* pointer, const std::align_val_t, const std::nothrow_t&) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
+
+void operator delete[](void* pointer, const std::align_val_t, const std::nothrow_t&) noexcept
+{
+    lunar::deallocateAligned(pointer);
+}
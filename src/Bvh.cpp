@@ -0,0 +1,800 @@
+#include "Bvh.hpp"
+
+namespace lunar
+{
+    // Number of bins (per axis) the centroids are sorted into when evaluating SAH splits during build.
+    static constexpr uint32_t SAH_BIN_COUNT = 16u;
+
+    static float getComponent(const math::XMFLOAT3& vector, const uint32_t axis)
+    {
+        return axis == 0u ? vector.x : (axis == 1u ? vector.y : vector.z);
+    }
+
+    Aabb Aabb::fromBoundingBox(const BoundingBox& boundingBox, const math::XMMATRIX& modelMatrix)
+    {
+        // With row vectors, the world space half extents are the sum of the absolute axes of the model matrix scaled by the object space half extents.
+        const math::XMVECTOR center = math::XMVector3Transform(math::XMLoadFloat3(&boundingBox.center), modelMatrix);
+        const math::XMVECTOR extents = math::XMVectorAdd(math::XMVectorAdd(math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[0]), boundingBox.extents.x),
+                                                                           math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[1]), boundingBox.extents.y)),
+                                                         math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[2]), boundingBox.extents.z));
+
+        Aabb aabb{};
+        math::XMStoreFloat3(&aabb.min, math::XMVectorSubtract(center, extents));
+        math::XMStoreFloat3(&aabb.max, math::XMVectorAdd(center, extents));
+
+        return aabb;
+    }
+
+    Aabb Aabb::merge(const Aabb& a, const Aabb& b)
+    {
+        return Aabb{
+            .min = {std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+            .max = {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)},
+        };
+    }
+
+    float Aabb::getSurfaceArea() const
+    {
+        const float x = max.x - min.x;
+        const float y = max.y - min.y;
+        const float z = max.z - min.z;
+
+        return 2.0f * (x * y + y * z + z * x);
+    }
+
+    bool Aabb::contains(const Aabb& other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    bool intersects(const Aabb& a, const Aabb& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    bool intersectsSphere(const Aabb& aabb, const math::XMFLOAT3& center, const float radius)
+    {
+        // Squared distance from the center to the closest point of the box.
+        float distanceSquared{};
+        for (const uint32_t axis : std::views::iota(0u, 3u))
+        {
+            const float value = getComponent(center, axis);
+            const float closest = std::clamp(value, getComponent(aabb.min, axis), getComponent(aabb.max, axis));
+
+            distanceSquared += (value - closest) * (value - closest);
+        }
+
+        return distanceSquared <= radius * radius;
+    }
+
+    bool intersectsFrustum(const Aabb& aabb, const Frustum& frustum)
+    {
+        for (const math::XMFLOAT4& plane : frustum.planes)
+        {
+            // The corner of the box furthest along the plane normal.
+            const float x = plane.x >= 0.0f ? aabb.max.x : aabb.min.x;
+            const float y = plane.y >= 0.0f ? aabb.max.y : aabb.min.y;
+            const float z = plane.z >= 0.0f ? aabb.max.z : aabb.min.z;
+
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::optional<float> intersectRay(const Aabb& aabb, const math::XMFLOAT3& origin, const math::XMFLOAT3& direction, const float maxDistance)
+    {
+        // Slab test. A zero direction component gives infinite slab distances, so the ray is only rejected on that axis if the origin is outside the slab.
+        float entryDistance = 0.0f;
+        float exitDistance = maxDistance;
+
+        for (const uint32_t axis : std::views::iota(0u, 3u))
+        {
+            const float inverseDirection = 1.0f / getComponent(direction, axis);
+
+            float nearDistance = (getComponent(aabb.min, axis) - getComponent(origin, axis)) * inverseDirection;
+            float farDistance = (getComponent(aabb.max, axis) - getComponent(origin, axis)) * inverseDirection;
+            if (nearDistance > farDistance)
+            {
+                std::swap(nearDistance, farDistance);
+            }
+
+            // Written so that NaNs (origin on a slab plane of a zero direction component) leave the range unchanged.
+            entryDistance = nearDistance > entryDistance ? nearDistance : entryDistance;
+            exitDistance = farDistance < exitDistance ? farDistance : exitDistance;
+
+            if (entryDistance > exitDistance)
+            {
+                return std::nullopt;
+            }
+        }
+
+        return entryDistance;
+    }
+
+    std::vector<uint32_t> DynamicBvh::build(std::span<const Aabb> bounds)
+    {
+        clear();
+
+        std::vector<uint32_t> leaves(bounds.size(), INVALID_U32);
+        if (bounds.empty())
+        {
+            return leaves;
+        }
+
+        std::vector<uint32_t> items(bounds.size());
+        std::iota(items.begin(), items.end(), 0u);
+
+        m_nodes.reserve(bounds.size() * 2u - 1u);
+        m_root = buildRecursive(bounds, items, leaves, INVALID_U32);
+        m_leafCount = static_cast<uint32_t>(bounds.size());
+
+        return leaves;
+    }
+
+    void DynamicBvh::clear()
+    {
+        m_nodes.clear();
+        m_freeNodes.clear();
+
+        m_root = INVALID_U32;
+        m_leafCount = 0u;
+    }
+
+    uint32_t DynamicBvh::insert(const Aabb& bounds, const uint32_t userData)
+    {
+        const uint32_t leaf = allocateNode();
+        m_nodes[leaf].bounds = bounds;
+        m_nodes[leaf].userData = userData;
+
+        m_leafCount++;
+
+        if (m_root == INVALID_U32)
+        {
+            m_root = leaf;
+            return leaf;
+        }
+
+        // The new leaf and its sibling become the children of a new internal node, which takes the place of the sibling.
+        const uint32_t sibling = findBestSibling(bounds);
+        const uint32_t oldParent = m_nodes[sibling].parent;
+
+        const uint32_t newParent = allocateNode();
+        m_nodes[newParent].parent = oldParent;
+        m_nodes[newParent].children = {sibling, leaf};
+        m_nodes[newParent].bounds = Aabb::merge(m_nodes[sibling].bounds, bounds);
+        m_nodes[newParent].needsRefit = m_nodes[sibling].needsRefit;
+
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent = newParent;
+
+        if (oldParent == INVALID_U32)
+        {
+            m_root = newParent;
+        }
+        else
+        {
+            std::array<uint32_t, 2>& children = m_nodes[oldParent].children;
+            children[children[0] == sibling ? 0u : 1u] = newParent;
+        }
+
+        refitAncestors(newParent);
+
+        return leaf;
+    }
+
+    void DynamicBvh::remove(const uint32_t leaf)
+    {
+        m_leafCount--;
+
+        if (leaf == m_root)
+        {
+            m_root = INVALID_U32;
+            freeNode(leaf);
+            return;
+        }
+
+        // The sibling of the leaf takes the place of their parent.
+        const uint32_t parent = m_nodes[leaf].parent;
+        const uint32_t grandparent = m_nodes[parent].parent;
+        const uint32_t sibling = m_nodes[parent].children[m_nodes[parent].children[0] == leaf ? 1u : 0u];
+
+        m_nodes[sibling].parent = grandparent;
+
+        if (grandparent == INVALID_U32)
+        {
+            m_root = sibling;
+        }
+        else
+        {
+            std::array<uint32_t, 2>& children = m_nodes[grandparent].children;
+            children[children[0] == parent ? 0u : 1u] = sibling;
+
+            refitAncestors(grandparent);
+        }
+
+        freeNode(parent);
+        freeNode(leaf);
+    }
+
+    void DynamicBvh::update(const uint32_t leaf, const Aabb& bounds)
+    {
+        m_nodes[leaf].bounds = bounds;
+
+        if (m_nodes[leaf].parent != INVALID_U32)
+        {
+            markForRefit(m_nodes[leaf].parent);
+        }
+    }
+
+    void DynamicBvh::refit()
+    {
+        if (m_root != INVALID_U32 && m_nodes[m_root].needsRefit)
+        {
+            refitMarked(m_root);
+        }
+    }
+
+    void DynamicBvh::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const
+    {
+        if (m_root == INVALID_U32)
+        {
+            return;
+        }
+
+        // Each node is only tested against the planes its parent was not entirely inside of. Once a node is inside all of them, all of its
+        // leaves are visible.
+        constexpr uint8_t allPlanesMask = (1u << std::tuple_size_v<decltype(Frustum::planes)>) - 1u;
+
+        // Frustum queries run every frame (from any thread), so the traversal stack keeps its memory from one query to the next.
+        thread_local std::vector<std::pair<uint32_t, uint8_t>> stack{};
+        stack.clear();
+        stack.emplace_back(m_root, allPlanesMask);
+
+        while (!stack.empty())
+        {
+            const auto [nodeIndex, parentPlaneMask] = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[nodeIndex];
+
+            uint8_t planeMask = parentPlaneMask;
+            bool outside = false;
+
+            for (const uint32_t planeIndex : std::views::iota(0u, static_cast<uint32_t>(frustum.planes.size())))
+            {
+                if ((planeMask & (1u << planeIndex)) == 0u)
+                {
+                    continue;
+                }
+
+                const math::XMFLOAT4& plane = frustum.planes[planeIndex];
+
+                // Distances of the corners of the box furthest along / against the plane normal.
+                const float maxDistance = plane.x * (plane.x >= 0.0f ? node.bounds.max.x : node.bounds.min.x) +
+                                          plane.y * (plane.y >= 0.0f ? node.bounds.max.y : node.bounds.min.y) +
+                                          plane.z * (plane.z >= 0.0f ? node.bounds.max.z : node.bounds.min.z) + plane.w;
+
+                if (maxDistance < 0.0f)
+                {
+                    outside = true;
+                    break;
+                }
+
+                const float minDistance = plane.x * (plane.x >= 0.0f ? node.bounds.min.x : node.bounds.max.x) +
+                                          plane.y * (plane.y >= 0.0f ? node.bounds.min.y : node.bounds.max.y) +
+                                          plane.z * (plane.z >= 0.0f ? node.bounds.min.z : node.bounds.max.z) + plane.w;
+
+                if (minDistance >= 0.0f)
+                {
+                    planeMask &= static_cast<uint8_t>(~(1u << planeIndex));
+                }
+            }
+
+            if (outside)
+            {
+                continue;
+            }
+
+            if (planeMask == 0u)
+            {
+                appendLeaves(nodeIndex, results);
+            }
+            else if (node.isLeaf())
+            {
+                results.push_back(node.userData);
+            }
+            else
+            {
+                stack.emplace_back(node.children[0], planeMask);
+                stack.emplace_back(node.children[1], planeMask);
+            }
+        }
+    }
+
+    void DynamicBvh::queryAabb(const Aabb& aabb, std::vector<uint32_t>& results) const
+    {
+        if (m_root == INVALID_U32)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> stack{m_root};
+        while (!stack.empty())
+        {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            if (!intersects(node.bounds, aabb))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                results.push_back(node.userData);
+            }
+            else
+            {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+        }
+    }
+
+    void DynamicBvh::querySphere(const math::XMFLOAT3& center, const float radius, std::vector<uint32_t>& results) const
+    {
+        if (m_root == INVALID_U32)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> stack{m_root};
+        while (!stack.empty())
+        {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            if (!intersectsSphere(node.bounds, center, radius))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                results.push_back(node.userData);
+            }
+            else
+            {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+        }
+    }
+
+    std::optional<BvhRayHit> DynamicBvh::raycast(const math::XMFLOAT3& origin, const math::XMFLOAT3& direction, const float maxDistance) const
+    {
+        if (m_root == INVALID_U32)
+        {
+            return std::nullopt;
+        }
+
+        const std::optional<float> rootDistance = intersectRay(m_nodes[m_root].bounds, origin, direction, maxDistance);
+        if (!rootDistance.has_value())
+        {
+            return std::nullopt;
+        }
+
+        std::optional<BvhRayHit> closestHit{};
+        float closestDistance = maxDistance;
+
+        // (node, entry distance) of nodes hit by the ray. The nearer child is visited first, so that further nodes can be skipped once a closer
+        // leaf has been hit.
+        std::vector<std::pair<uint32_t, float>> stack{{m_root, *rootDistance}};
+        while (!stack.empty())
+        {
+            const auto [nodeIndex, entryDistance] = stack.back();
+            stack.pop_back();
+
+            if (entryDistance > closestDistance)
+            {
+                continue;
+            }
+
+            const Node& node = m_nodes[nodeIndex];
+            if (node.isLeaf())
+            {
+                closestHit = BvhRayHit{.userData = node.userData, .distance = entryDistance};
+                closestDistance = entryDistance;
+                continue;
+            }
+
+            const std::optional<float> distance0 = intersectRay(m_nodes[node.children[0]].bounds, origin, direction, closestDistance);
+            const std::optional<float> distance1 = intersectRay(m_nodes[node.children[1]].bounds, origin, direction, closestDistance);
+
+            if (distance0.has_value() && distance1.has_value())
+            {
+                const bool firstIsNearer = *distance0 <= *distance1;
+
+                stack.emplace_back(node.children[firstIsNearer ? 1u : 0u], firstIsNearer ? *distance1 : *distance0);
+                stack.emplace_back(node.children[firstIsNearer ? 0u : 1u], firstIsNearer ? *distance0 : *distance1);
+            }
+            else if (distance0.has_value())
+            {
+                stack.emplace_back(node.children[0], *distance0);
+            }
+            else if (distance1.has_value())
+            {
+                stack.emplace_back(node.children[1], *distance1);
+            }
+        }
+
+        return closestHit;
+    }
+
+    BvhStatistics DynamicBvh::getStatistics() const
+    {
+        BvhStatistics statistics{.leafCount = m_leafCount};
+        if (m_root == INVALID_U32)
+        {
+            return statistics;
+        }
+
+        const float rootArea = m_nodes[m_root].bounds.getSurfaceArea();
+        float internalArea{};
+
+        // (node, depth).
+        std::vector<std::pair<uint32_t, uint32_t>> stack{{m_root, 1u}};
+        while (!stack.empty())
+        {
+            const auto [nodeIndex, depth] = stack.back();
+            stack.pop_back();
+
+            statistics.height = std::max(statistics.height, depth);
+
+            const Node& node = m_nodes[nodeIndex];
+            if (!node.isLeaf())
+            {
+                internalArea += node.bounds.getSurfaceArea();
+
+                stack.emplace_back(node.children[0], depth + 1u);
+                stack.emplace_back(node.children[1], depth + 1u);
+            }
+        }
+
+        statistics.sahCost = rootArea > 0.0f ? internalArea / rootArea : 0.0f;
+
+        return statistics;
+    }
+
+    uint32_t DynamicBvh::allocateNode()
+    {
+        if (!m_freeNodes.empty())
+        {
+            const uint32_t node = m_freeNodes.back();
+            m_freeNodes.pop_back();
+
+            return node;
+        }
+
+        m_nodes.emplace_back();
+        return static_cast<uint32_t>(m_nodes.size() - 1u);
+    }
+
+    void DynamicBvh::freeNode(const uint32_t node)
+    {
+        m_nodes[node] = Node{};
+        m_freeNodes.push_back(node);
+    }
+
+    uint32_t DynamicBvh::buildRecursive(std::span<const Aabb> bounds, std::span<uint32_t> items, std::span<uint32_t> leaves, const uint32_t parent)
+    {
+        // Node references are not held across the recursive calls, as they can grow m_nodes.
+        const uint32_t nodeIndex = allocateNode();
+        m_nodes[nodeIndex].parent = parent;
+
+        if (items.size() == 1u)
+        {
+            m_nodes[nodeIndex].bounds = bounds[items[0]];
+            m_nodes[nodeIndex].userData = items[0];
+            leaves[items[0]] = nodeIndex;
+
+            return nodeIndex;
+        }
+
+        const auto getCentroid = [&](const uint32_t item, const uint32_t axis) {
+            return (getComponent(bounds[item].min, axis) + getComponent(bounds[item].max, axis)) * 0.5f;
+        };
+
+        Aabb nodeBounds = bounds[items[0]];
+        math::XMFLOAT3 centroidMin = {getCentroid(items[0], 0u), getCentroid(items[0], 1u), getCentroid(items[0], 2u)};
+        math::XMFLOAT3 centroidMax = centroidMin;
+
+        for (const uint32_t item : items)
+        {
+            nodeBounds = Aabb::merge(nodeBounds, bounds[item]);
+
+            centroidMin = {std::min(centroidMin.x, getCentroid(item, 0u)), std::min(centroidMin.y, getCentroid(item, 1u)), std::min(centroidMin.z, getCentroid(item, 2u))};
+            centroidMax = {std::max(centroidMax.x, getCentroid(item, 0u)), std::max(centroidMax.y, getCentroid(item, 1u)), std::max(centroidMax.z, getCentroid(item, 2u))};
+        }
+
+        m_nodes[nodeIndex].bounds = nodeBounds;
+
+        // Find the split (a bin boundary along one of the axes) with the lowest SAH cost : the surface area of each side times its item count.
+        uint32_t bestAxis = INVALID_U32;
+        uint32_t bestSplit{};
+        float bestCost = std::numeric_limits<float>::max();
+
+        for (const uint32_t axis : std::views::iota(0u, 3u))
+        {
+            const float axisMin = getComponent(centroidMin, axis);
+            const float axisExtent = getComponent(centroidMax, axis) - axisMin;
+            if (axisExtent <= 0.0f)
+            {
+                continue;
+            }
+
+            const float binScale = static_cast<float>(SAH_BIN_COUNT) / axisExtent;
+
+            std::array<Aabb, SAH_BIN_COUNT> binBounds{};
+            std::array<uint32_t, SAH_BIN_COUNT> binCounts{};
+
+            for (const uint32_t item : items)
+            {
+                const uint32_t bin = std::min(static_cast<uint32_t>((getCentroid(item, axis) - axisMin) * binScale), SAH_BIN_COUNT - 1u);
+
+                binBounds[bin] = binCounts[bin] == 0u ? bounds[item] : Aabb::merge(binBounds[bin], bounds[item]);
+                binCounts[bin]++;
+            }
+
+            // Area and count of the bins to the right of each split, accumulated from the right.
+            std::array<float, SAH_BIN_COUNT> rightAreas{};
+            std::array<uint32_t, SAH_BIN_COUNT> rightCounts{};
+
+            Aabb rightBounds{};
+            uint32_t rightCount{};
+
+            for (uint32_t bin = SAH_BIN_COUNT - 1u; bin > 0u; bin--)
+            {
+                if (binCounts[bin] > 0u)
+                {
+                    rightBounds = rightCount == 0u ? binBounds[bin] : Aabb::merge(rightBounds, binBounds[bin]);
+                    rightCount += binCounts[bin];
+                }
+
+                rightAreas[bin] = rightBounds.getSurfaceArea();
+                rightCounts[bin] = rightCount;
+            }
+
+            Aabb leftBounds{};
+            uint32_t leftCount{};
+
+            // A split at bin s puts bins [0, s) on the left.
+            for (const uint32_t split : std::views::iota(1u, SAH_BIN_COUNT))
+            {
+                if (binCounts[split - 1u] > 0u)
+                {
+                    leftBounds = leftCount == 0u ? binBounds[split - 1u] : Aabb::merge(leftBounds, binBounds[split - 1u]);
+                    leftCount += binCounts[split - 1u];
+                }
+
+                if (leftCount == 0u || rightCounts[split] == 0u)
+                {
+                    continue;
+                }
+
+                const float cost = leftBounds.getSurfaceArea() * static_cast<float>(leftCount) + rightAreas[split] * static_cast<float>(rightCounts[split]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        size_t leftCount = items.size() / 2u;
+
+        if (bestAxis != INVALID_U32)
+        {
+            const float axisMin = getComponent(centroidMin, bestAxis);
+            const float binScale = static_cast<float>(SAH_BIN_COUNT) / (getComponent(centroidMax, bestAxis) - axisMin);
+
+            const auto rightBegin = std::partition(items.begin(), items.end(), [&](const uint32_t item) {
+                return std::min(static_cast<uint32_t>((getCentroid(item, bestAxis) - axisMin) * binScale), SAH_BIN_COUNT - 1u) < bestSplit;
+            });
+
+            leftCount = static_cast<size_t>(rightBegin - items.begin());
+        }
+
+        // All centroids coincide (or the split is degenerate) : split the items in half.
+        if (leftCount == 0u || leftCount == items.size())
+        {
+            leftCount = items.size() / 2u;
+        }
+
+        const uint32_t leftChild = buildRecursive(bounds, items.subspan(0u, leftCount), leaves, nodeIndex);
+        const uint32_t rightChild = buildRecursive(bounds, items.subspan(leftCount), leaves, nodeIndex);
+
+        m_nodes[nodeIndex].children = {leftChild, rightChild};
+
+        return nodeIndex;
+    }
+
+    uint32_t DynamicBvh::findBestSibling(const Aabb& bounds) const
+    {
+        // Branch and bound : the cost of making a node the sibling is the area of the new parent, plus the area its ancestors grow by (the
+        // inherited cost). The area of the new leaf plus the inherited cost of a subtree is a lower bound for the cost of any node in it.
+        const float leafArea = bounds.getSurfaceArea();
+
+        uint32_t bestSibling = m_root;
+        float bestCost = std::numeric_limits<float>::max();
+
+        // (node, inherited cost).
+        std::vector<std::pair<uint32_t, float>> stack{{m_root, 0.0f}};
+        while (!stack.empty())
+        {
+            const auto [nodeIndex, inheritedCost] = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[nodeIndex];
+
+            const float mergedArea = Aabb::merge(node.bounds, bounds).getSurfaceArea();
+            const float cost = mergedArea + inheritedCost;
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSibling = nodeIndex;
+            }
+
+            if (node.isLeaf())
+            {
+                continue;
+            }
+
+            const float childInheritedCost = inheritedCost + mergedArea - node.bounds.getSurfaceArea();
+            if (leafArea + childInheritedCost < bestCost)
+            {
+                stack.emplace_back(node.children[0], childInheritedCost);
+                stack.emplace_back(node.children[1], childInheritedCost);
+            }
+        }
+
+        return bestSibling;
+    }
+
+    void DynamicBvh::refitAncestors(uint32_t node)
+    {
+        while (node != INVALID_U32)
+        {
+            const std::array<uint32_t, 2>& children = m_nodes[node].children;
+            m_nodes[node].bounds = Aabb::merge(m_nodes[children[0]].bounds, m_nodes[children[1]].bounds);
+
+            rotate(node);
+
+            node = m_nodes[node].parent;
+        }
+    }
+
+    void DynamicBvh::refitMarked(const uint32_t node)
+    {
+        for (const uint32_t child : m_nodes[node].children)
+        {
+            if (m_nodes[child].needsRefit)
+            {
+                refitMarked(child);
+            }
+        }
+
+        const std::array<uint32_t, 2>& children = m_nodes[node].children;
+        m_nodes[node].bounds = Aabb::merge(m_nodes[children[0]].bounds, m_nodes[children[1]].bounds);
+        m_nodes[node].needsRefit = false;
+
+        rotate(node);
+    }
+
+    void DynamicBvh::markForRefit(uint32_t node)
+    {
+        while (node != INVALID_U32 && !m_nodes[node].needsRefit)
+        {
+            m_nodes[node].needsRefit = true;
+            node = m_nodes[node].parent;
+        }
+    }
+
+    void DynamicBvh::rotate(const uint32_t node)
+    {
+        // Node A has children B and C. Either child of C can be swapped with B (which changes the area of C), or either child of B with C (which
+        // changes the area of B). The bounds of A are the same in every case.
+        const std::array<uint32_t, 2> children = m_nodes[node].children;
+
+        uint32_t bestUncle = INVALID_U32;
+        uint32_t bestGrandchild = INVALID_U32;
+        float bestAreaChange{};
+
+        for (const uint32_t childSlot : {0u, 1u})
+        {
+            const uint32_t parent = children[childSlot];
+            const uint32_t uncle = children[1u - childSlot];
+
+            if (m_nodes[parent].isLeaf())
+            {
+                continue;
+            }
+
+            const float parentArea = m_nodes[parent].bounds.getSurfaceArea();
+
+            for (const uint32_t grandchildSlot : {0u, 1u})
+            {
+                // The grandchild moves up, so the parent's bounds become the uncle merged with the other grandchild.
+                const uint32_t grandchild = m_nodes[parent].children[grandchildSlot];
+                const uint32_t otherGrandchild = m_nodes[parent].children[1u - grandchildSlot];
+
+                const float areaChange = Aabb::merge(m_nodes[uncle].bounds, m_nodes[otherGrandchild].bounds).getSurfaceArea() - parentArea;
+                if (areaChange < bestAreaChange)
+                {
+                    bestAreaChange = areaChange;
+                    bestUncle = uncle;
+                    bestGrandchild = grandchild;
+                }
+            }
+        }
+
+        if (bestUncle == INVALID_U32)
+        {
+            return;
+        }
+
+        const uint32_t parent = m_nodes[bestGrandchild].parent;
+
+        std::array<uint32_t, 2>& nodeChildren = m_nodes[node].children;
+        nodeChildren[nodeChildren[0] == bestUncle ? 0u : 1u] = bestGrandchild;
+
+        std::array<uint32_t, 2>& parentChildren = m_nodes[parent].children;
+        parentChildren[parentChildren[0] == bestGrandchild ? 0u : 1u] = bestUncle;
+
+        m_nodes[bestGrandchild].parent = node;
+        m_nodes[bestUncle].parent = parent;
+
+        m_nodes[parent].bounds = Aabb::merge(m_nodes[parentChildren[0]].bounds, m_nodes[parentChildren[1]].bounds);
+
+        // A moved node that is waiting for a refit must stay reachable from the root through marked nodes.
+        if (m_nodes[bestUncle].needsRefit)
+        {
+            markForRefit(parent);
+        }
+
+        if (m_nodes[bestGrandchild].needsRefit)
+        {
+            markForRefit(node);
+        }
+    }
+
+    void DynamicBvh::appendLeaves(const uint32_t node, std::vector<uint32_t>& results) const
+    {
+        // Separate from the stack of queryFrustum(), which calls this during its traversal.
+        thread_local std::vector<uint32_t> stack{};
+        stack.clear();
+        stack.push_back(node);
+
+        while (!stack.empty())
+        {
+            const Node& current = m_nodes[stack.back()];
+            stack.pop_back();
+
+            if (current.isLeaf())
+            {
+                results.push_back(current.userData);
+            }
+            else
+            {
+                stack.push_back(current.children[0]);
+                stack.push_back(current.children[1]);
+            }
+        }
+    }
+}
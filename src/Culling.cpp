@@ -0,0 +1,189 @@
+#include "Culling.hpp"
+
+namespace lunar
+{
+    Frustum Frustum::fromViewProjection(const math::XMMATRIX& viewProjectionMatrix)
+    {
+        // With row vectors, clip = position * M, so each clip space component is the dot product of the position with a column of M.
+        const math::XMMATRIX columns = math::XMMatrixTranspose(viewProjectionMatrix);
+
+        const std::array<math::XMVECTOR, 6> planes = {
+            math::XMVectorAdd(columns.r[3], columns.r[0]),      // Left : -w <= x.
+            math::XMVectorSubtract(columns.r[3], columns.r[0]), // Right : x <= w.
+            math::XMVectorAdd(columns.r[3], columns.r[1]),      // Bottom : -w <= y.
+            math::XMVectorSubtract(columns.r[3], columns.r[1]), // Top : y <= w.
+            columns.r[2],                                       // Near : 0 <= z.
+            math::XMVectorSubtract(columns.r[3], columns.r[2]), // Far : z <= w.
+        };
+
+        Frustum frustum{};
+        for (const size_t planeIndex : std::views::iota(0u, planes.size()))
+        {
+            math::XMStoreFloat4(&frustum.planes[planeIndex], math::XMPlaneNormalize(planes[planeIndex]));
+        }
+
+        return frustum;
+    }
+
+    bool Frustum::intersectsSphere(const math::XMVECTOR center, const float radius) const
+    {
+        for (const math::XMFLOAT4& plane : planes)
+        {
+            if (math::XMVectorGetX(math::XMPlaneDotCoord(math::XMLoadFloat4(&plane), center)) < -radius)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void FrustumCuller::resize(const size_t objectCount)
+    {
+        m_objectCount = objectCount;
+
+        // Padding objects have empty bounds at the origin. They are tested along with the real objects, but their results are never read.
+        const size_t paddedObjectCount = (objectCount + CULLING_BATCH_SIZE - 1u) / CULLING_BATCH_SIZE * CULLING_BATCH_SIZE;
+
+        for (std::vector<float>* component : {&m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ})
+        {
+            component->resize(paddedObjectCount);
+        }
+
+        m_visibility.resize(paddedObjectCount);
+    }
+
+    void FrustumCuller::setBounds(const size_t objectIndex, const math::XMMATRIX& modelMatrix, const BoundingBox& boundingBox, const math::XMFLOAT4& boundingSphere)
+    {
+        math::XMFLOAT3 sphereCenter{};
+        math::XMStoreFloat3(&sphereCenter, math::XMVector3Transform(math::XMLoadFloat4(&boundingSphere), modelMatrix));
+
+        m_centerX[objectIndex] = sphereCenter.x;
+        m_centerY[objectIndex] = sphereCenter.y;
+        m_centerZ[objectIndex] = sphereCenter.z;
+        m_radius[objectIndex] = boundingSphere.w * getMaxScale(modelMatrix);
+
+        // With row vectors, the world space half extents are the sum of the absolute axes of the model matrix scaled by the object space half extents.
+        const math::XMVECTOR boxCenter = math::XMVector3Transform(math::XMLoadFloat3(&boundingBox.center), modelMatrix);
+        const math::XMVECTOR boxExtents = math::XMVectorAdd(math::XMVectorAdd(math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[0]), boundingBox.extents.x),
+                                                                              math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[1]), boundingBox.extents.y)),
+                                                            math::XMVectorScale(math::XMVectorAbs(modelMatrix.r[2]), boundingBox.extents.z));
+
+        // The box test is done around the sphere center (the box is grown by the offset between the two centers), so that only one center is stored.
+        const math::XMVECTOR grownBoxExtents = math::XMVectorAdd(boxExtents, math::XMVectorAbs(math::XMVectorSubtract(boxCenter, math::XMLoadFloat3(&sphereCenter))));
+
+        math::XMFLOAT3 extents{};
+        math::XMStoreFloat3(&extents, grownBoxExtents);
+
+        m_extentX[objectIndex] = extents.x;
+        m_extentY[objectIndex] = extents.y;
+        m_extentZ[objectIndex] = extents.z;
+    }
+
+    CullingStatistics FrustumCuller::cull(const Frustum& frustum, const size_t firstObject, const size_t objectCount)
+    {
+        // Splat the plane components (and the absolute normal, used to compute the projected radius of the boxes) once for all batches.
+        struct SplatPlane
+        {
+            math::XMVECTOR x;
+            math::XMVECTOR y;
+            math::XMVECTOR z;
+            math::XMVECTOR w;
+            math::XMVECTOR absX;
+            math::XMVECTOR absY;
+            math::XMVECTOR absZ;
+        };
+
+        std::array<SplatPlane, 6> planes{};
+        for (const size_t planeIndex : std::views::iota(0u, planes.size()))
+        {
+            const math::XMVECTOR plane = math::XMLoadFloat4(&frustum.planes[planeIndex]);
+
+            planes[planeIndex] = SplatPlane{
+                .x = math::XMVectorSplatX(plane),
+                .y = math::XMVectorSplatY(plane),
+                .z = math::XMVectorSplatZ(plane),
+                .w = math::XMVectorSplatW(plane),
+                .absX = math::XMVectorAbs(math::XMVectorSplatX(plane)),
+                .absY = math::XMVectorAbs(math::XMVectorSplatY(plane)),
+                .absZ = math::XMVectorAbs(math::XMVectorSplatZ(plane)),
+            };
+        }
+
+        const auto loadBatch = [](const std::vector<float>& component, const size_t firstObject) {
+            return math::XMLoadFloat4(reinterpret_cast<const math::XMFLOAT4*>(component.data() + firstObject));
+        };
+
+        CullingStatistics statistics{};
+
+        const size_t lastObject = std::min(firstObject + objectCount, m_objectCount);
+
+        for (size_t batchObject = firstObject; batchObject < lastObject; batchObject += CULLING_BATCH_SIZE)
+        {
+            const math::XMVECTOR centerX = loadBatch(m_centerX, batchObject);
+            const math::XMVECTOR centerY = loadBatch(m_centerY, batchObject);
+            const math::XMVECTOR centerZ = loadBatch(m_centerZ, batchObject);
+            const math::XMVECTOR radius = loadBatch(m_radius, batchObject);
+            const math::XMVECTOR extentX = loadBatch(m_extentX, batchObject);
+            const math::XMVECTOR extentY = loadBatch(m_extentY, batchObject);
+            const math::XMVECTOR extentZ = loadBatch(m_extentZ, batchObject);
+
+            math::XMVECTOR visible = math::XMVectorTrueInt();
+
+            for (const SplatPlane& plane : planes)
+            {
+                const math::XMVECTOR distance =
+                    math::XMVectorMultiplyAdd(centerX, plane.x, math::XMVectorMultiplyAdd(centerY, plane.y, math::XMVectorMultiplyAdd(centerZ, plane.z, plane.w)));
+
+                const math::XMVECTOR boxRadius =
+                    math::XMVectorMultiplyAdd(extentX, plane.absX, math::XMVectorMultiplyAdd(extentY, plane.absY, math::XMVectorMultiply(extentZ, plane.absZ)));
+
+                // Both volumes contain the object, so the tighter of the two decides.
+                visible = math::XMVectorAndInt(visible, math::XMVectorGreaterOrEqual(distance, math::XMVectorNegate(math::XMVectorMin(radius, boxRadius))));
+            }
+
+            std::array<uint32_t, CULLING_BATCH_SIZE> visibleLanes{};
+            math::XMStoreInt4(visibleLanes.data(), visible);
+
+            const size_t batchObjectCount = std::min(CULLING_BATCH_SIZE, lastObject - batchObject);
+            for (const size_t lane : std::views::iota(0u, batchObjectCount))
+            {
+                m_visibility[batchObject + lane] = visibleLanes[lane] != 0u ? 1u : 0u;
+                statistics.visibleCount += visibleLanes[lane] != 0u ? 1u : 0u;
+            }
+        }
+
+        statistics.culledCount = static_cast<uint32_t>(lastObject - std::min(firstObject, lastObject)) - statistics.visibleCount;
+
+        return statistics;
+    }
+
+    float getMaxScale(const math::XMMATRIX& modelMatrix)
+    {
+        const math::XMVECTOR scaleSquared = math::XMVectorMax(
+            math::XMVectorMax(math::XMVector3LengthSq(modelMatrix.r[0]), math::XMVector3LengthSq(modelMatrix.r[1])), math::XMVector3LengthSq(modelMatrix.r[2]));
+
+        return std::sqrt(math::XMVectorGetX(scaleSquared));
+    }
+
+    bool isMeshletCulled(const Meshlet& meshlet, const math::XMMATRIX& modelMatrix, const float maxScale, const MeshletCullingContext& context)
+    {
+        const math::XMVECTOR center = math::XMVector3Transform(math::XMLoadFloat4(&meshlet.boundingSphere), modelMatrix);
+        if (!context.frustum.intersectsSphere(center, meshlet.boundingSphere.w * maxScale))
+        {
+            return true;
+        }
+
+        if (meshlet.coneCutoff >= 1.0f)
+        {
+            return false;
+        }
+
+        const math::XMVECTOR apex = math::XMVector3Transform(math::XMLoadFloat3(&meshlet.coneApex), modelMatrix);
+        const math::XMVECTOR axis = math::XMVector3Normalize(math::XMVector3TransformNormal(math::XMLoadFloat3(&meshlet.coneAxis), modelMatrix));
+
+        const math::XMVECTOR viewDirection = math::XMVector3Normalize(math::XMVectorSubtract(apex, math::XMLoadFloat3(&context.cameraPosition)));
+
+        return math::XMVectorGetX(math::XMVector3Dot(viewDirection, axis)) >= meshlet.coneCutoff;
+    }
+}
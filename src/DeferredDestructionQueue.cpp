@@ -0,0 +1,64 @@
+#include "DeferredDestructionQueue.hpp"
+
+namespace lunar
+{
+    void DeferredDestructionQueue::init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker)
+    {
+        m_device = device;
+        m_allocator = allocator;
+        m_memoryTracker = &memoryTracker;
+    }
+
+    void DeferredDestructionQueue::collect(const uint64_t completedFrameNumber)
+    {
+        std::apply([&](auto&... objectArrays) { (collect(objectArrays, completedFrameNumber), ...); }, m_objectArrays);
+    }
+
+    void DeferredDestructionQueue::flush()
+    {
+        std::apply([&](auto&... objectArrays) { (flush(objectArrays), ...); }, m_objectArrays);
+    }
+
+    template <typename T> void DeferredDestructionQueue::collect(ObjectArrays<T>& objectArrays, const uint64_t completedFrameNumber)
+    {
+        std::vector<std::pair<uint64_t, T>>& retiredObjects = objectArrays.retiredObjects;
+
+        const auto firstPendingObject =
+            std::ranges::find_if(retiredObjects, [&](const std::pair<uint64_t, T>& retiredObject) { return retiredObject.first > completedFrameNumber; });
+
+        for (auto retiredObject = retiredObjects.begin(); retiredObject != firstPendingObject; ++retiredObject)
+        {
+            destroy(retiredObject->second);
+        }
+
+        // Erasing keeps the capacity of the array.
+        retiredObjects.erase(retiredObjects.begin(), firstPendingObject);
+    }
+
+    template <typename T> void DeferredDestructionQueue::flush(ObjectArrays<T>& objectArrays)
+    {
+        collect(objectArrays, INVALID_U64);
+
+        // Objects of the same type are destroyed in the reverse order of creation.
+        for (const T& object : objectArrays.shutdownObjects | std::views::reverse)
+        {
+            destroy(object);
+        }
+
+        objectArrays.shutdownObjects.clear();
+    }
+
+    template <typename T> void DeferredDestructionQueue::destroy(const T& object) { m_device.destroy(object); }
+
+    void DeferredDestructionQueue::destroy(const Buffer& buffer)
+    {
+        m_memoryTracker->untrack(buffer.allocation);
+        vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
+    }
+
+    void DeferredDestructionQueue::destroy(const Image& image)
+    {
+        m_memoryTracker->untrack(image.allocation);
+        vmaDestroyImage(m_allocator, image.image, image.allocation);
+    }
+}
@@ -1,5 +1,14 @@
 #include "Engine.hpp"
 
+#include "AllocationTracker.hpp"
+#include "Culling.hpp"
+#include "MeshCache.hpp"
+#include "MeshEncoder.hpp"
+#include "MeshImporter.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
 #include <SDL.h>
 #include <SDL_syswm.h>
 #include <SDL_vulkan.h>
@@ -9,14 +18,22 @@
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.hpp>
 
-#define TINYGLTF_IMPLEMENTATION
-#define TINYGLTF_NO_EXTERNAL_IMAGE
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <tiny_gltf.h>
-
 namespace lunar
 {
+    // Must match the numthreads attribute of CsMain in shaders/Culling.hlsl.
+    static constexpr uint32_t GPU_CULLING_GROUP_SIZE = 64u;
+
+    // Header written by the engine in front of the driver's pipeline cache data, used to detect truncated / corrupt cache files.
+    struct PipelineCacheFileHeader
+    {
+        static constexpr uint32_t MAGIC = 0x48435050u; // 'PPCH'.
+        static constexpr uint32_t VERSION = 1u;
+
+        uint32_t magic{MAGIC};
+        uint32_t version{VERSION};
+        uint64_t dataSize{};
+        uint64_t dataHash{};
+    };
 
     Engine::~Engine()
     {
@@ -28,37 +45,63 @@ namespace lunar
 
     void Engine::init()
     {
-        // Initialize SDL2 and create window.
-        if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        // Captures start before anything is initialized, so that the CPU scopes of init are part of the trace.
+        if constexpr (LUNAR_PROFILING)
         {
-            fatalError("Failed to initialize SDL2.");
+            if (m_config.profileFrameCount > 0u)
+            {
+                m_profiler.beginCapture(m_config.profileFrameCount, m_config.profileOutputPath);
+            }
         }
 
-        // Get monitor dimensions.
-        SDL_DisplayMode displayMode{};
-        if (SDL_GetCurrentDisplayMode(0, &displayMode) < 0)
+        LUNAR_PROFILE_SCOPE("init");
+
+        if (!m_config.telemetryOutputPath.empty())
         {
-            fatalError("Failed to get display mode");
+            m_telemetryWriter.open(m_config.telemetryOutputPath, m_config.telemetryFormat);
         }
 
-        const uint32_t monitorWidth = displayMode.w;
-        const uint32_t monitorHeight = displayMode.h;
+        const auto initStartTime = std::chrono::high_resolution_clock::now();
 
-        // Window must cover 85% of the screen.
-        m_windowExtent = vk::Extent2D{
-            .width = static_cast<uint32_t>(monitorWidth * 0.85f),
-            .height = static_cast<uint32_t>(monitorHeight * 0.85f),
-        };
-
-        m_window = SDL_CreateWindow("LunarEngine",
-                                    SDL_WINDOWPOS_CENTERED,
-                                    SDL_WINDOWPOS_CENTERED,
-                                    m_windowExtent.width,
-                                    m_windowExtent.height,
-                                    SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_VULKAN);
-        if (!m_window)
+        if (m_config.headless)
+        {
+            // No window is required in headless mode, the render targets are created by the engine itself.
+            m_windowExtent = m_config.headlessExtent;
+        }
+        else
         {
-            fatalError("Failed to create SDL2 window.");
+            // Initialize SDL2 and create window.
+            if (SDL_Init(SDL_INIT_VIDEO) < 0)
+            {
+                fatalError("Failed to initialize SDL2.");
+            }
+
+            // Get monitor dimensions.
+            SDL_DisplayMode displayMode{};
+            if (SDL_GetCurrentDisplayMode(0, &displayMode) < 0)
+            {
+                fatalError("Failed to get display mode");
+            }
+
+            const uint32_t monitorWidth = displayMode.w;
+            const uint32_t monitorHeight = displayMode.h;
+
+            // Window must cover 85% of the screen.
+            m_windowExtent = vk::Extent2D{
+                .width = static_cast<uint32_t>(monitorWidth * 0.85f),
+                .height = static_cast<uint32_t>(monitorHeight * 0.85f),
+            };
+
+            m_window = SDL_CreateWindow("LunarEngine",
+                                        SDL_WINDOWPOS_CENTERED,
+                                        SDL_WINDOWPOS_CENTERED,
+                                        m_windowExtent.width,
+                                        m_windowExtent.height,
+                                        SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_VULKAN);
+            if (!m_window)
+            {
+                fatalError("Failed to create SDL2 window.");
+            }
         }
 
         // Get root directory.
@@ -95,13 +138,38 @@ namespace lunar
         // Initialize scene (i.e all render objects).
         initScene();
 
-        // Upload buffers (all GPU only buffers will have data copied from a staging buffer and placed in their GPU
-        // only memory).
-        uploadBuffers();
+        // Upload buffers (all GPU only buffers will have data copied from the staging ring and placed in their GPU only memory). The first
+        // frame acquires them, so they must have completed before it is recorded.
+        m_uploadManager.wait(m_uploadManager.flush());
+
+        // Create the buffers of the GPU driven path (done even if the CPU path is used, so the paths can be switched at runtime). The first
+        // frame acquires them, so they must have completed before it is recorded.
+        buildGpuDrivenScene();
+        m_uploadManager.wait(m_pendingGpuDrivenScene.uploadTicket);
+        swapGpuDrivenScene();
+
+        const std::chrono::duration<double, std::milli> initTime = std::chrono::high_resolution_clock::now() - initStartTime;
+        m_initTimeMs = initTime.count();
+
+        const GeometryPoolStatistics geometryPoolStatistics = m_geometryPool.getStatistics();
+        std::cout << std::format("Geometry pool : {} allocations, vertex buffer {} / {} bytes, index buffer {} / {} bytes.\n",
+                                 geometryPoolStatistics.allocationCount,
+                                 geometryPoolStatistics.vertexBytesUsed,
+                                 geometryPoolStatistics.vertexCapacity,
+                                 geometryPoolStatistics.indexBytesUsed,
+                                 geometryPoolStatistics.indexCapacity);
+
+        std::cout << std::format("Engine initialized in {:.3f} ms. {} pipelines created in {:.3f} ms ({} pipeline cache).\n",
+                                 m_initTimeMs,
+                                 m_pipelineCount,
+                                 m_pipelineCreationTimeMs,
+                                 m_pipelineCacheWarm ? "warm" : "cold");
     }
 
     void Engine::initVulkan()
     {
+        LUNAR_PROFILE_SCOPE("initVulkan");
+
         // Initialize the core vulkan objects.
 
         // Get the instance and enable validation layers.
@@ -109,8 +177,12 @@ namespace lunar
         // (only applicable if a AAA Game Engine and such).
 
         vkb::InstanceBuilder instanceBuilder{};
-        const auto vkbInstanceResult =
-            instanceBuilder.set_app_name("Lunar Engine").request_validation_layers(LUNAR_DEBUG).use_default_debug_messenger().require_api_version(1, 3, 0).build();
+        const auto vkbInstanceResult = instanceBuilder.set_app_name("Lunar Engine")
+                                           .request_validation_layers(LUNAR_DEBUG)
+                                           .use_default_debug_messenger()
+                                           .require_api_version(1, 3, 0)
+                                           .set_headless(m_config.headless)
+                                           .build();
         if (!vkbInstanceResult)
         {
             fatalError("Failed to create vulkan instance.");
@@ -118,20 +190,18 @@ namespace lunar
 
         const vkb::Instance vkbInstance = vkbInstanceResult.value();
         m_instance = vkbInstance.instance;
-        m_deletionQueue.pushFunction([=]() { vkDestroyInstance(m_instance, nullptr); });
 
         // Get the debug messenger.
         m_debugMessenger = vkbInstance.debug_messenger;
 
-        m_deletionQueue.pushFunction([=]() { vkb::destroy_debug_utils_messenger(m_instance, m_debugMessenger, nullptr); });
-
         // Get the surface of the window opened by SDL (i.e get the underlying native platform surface). Required for
         // selection of physical device as the GPU must be able to render to the window.
-        VkSurfaceKHR surface{};
-        SDL_Vulkan_CreateSurface(m_window, m_instance, &surface);
-        m_surface = surface;
-
-        m_deletionQueue.pushFunction([=]() { m_instance.destroySurfaceKHR(m_surface); });
+        if (!m_config.headless)
+        {
+            VkSurfaceKHR surface{};
+            SDL_Vulkan_CreateSurface(m_window, m_instance, &surface);
+            m_surface = surface;
+        }
 
         // Specify that we require Vulkan 1.3's dynamic rendering feature.
         const vk::PhysicalDeviceVulkan13Features features{
@@ -139,15 +209,46 @@ namespace lunar
             .dynamicRendering = true,
         };
 
+        // The GPU driven path draws with drawIndexedIndirectCount, and uses the first instance of each draw command to index the draw item.
+        // Uploads are tracked with a timeline semaphore.
+        const vk::PhysicalDeviceVulkan12Features features12{
+            .drawIndirectCount = true,
+            .timelineSemaphore = true,
+        };
+
+        const vk::PhysicalDeviceFeatures features10{
+            .multiDrawIndirect = true,
+            .drawIndirectFirstInstance = true,
+        };
+
         // Get the physical adapter that can render to the surface. Prefer discrete GPU's.
         vkb::PhysicalDeviceSelector vkbPhysicalDeviceSelector{vkbInstance};
-        const auto vkbPhysicalDevice = vkbPhysicalDeviceSelector.set_minimum_version(1, 3)
-                                           .prefer_gpu_device_type(vkb::PreferredDeviceType::discrete)
-                                           .allow_any_gpu_device_type(false)
-                                           .set_required_features_13(features)
-                                           .set_surface(surface)
-                                           .select()
-                                           .value();
+        vkbPhysicalDeviceSelector.set_minimum_version(1, 3)
+            .prefer_gpu_device_type(vkb::PreferredDeviceType::discrete)
+            .set_required_features(features10)
+            .set_required_features_12(features12)
+            .set_required_features_13(features);
+
+        // VMA queries the memory usage and budget of the process from the driver when the memory budget extension is enabled (else it estimates them).
+        vkbPhysicalDeviceSelector.add_desired_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+        // The profiler converts GPU timestamps to CPU time with calibrated timestamps, when they are supported.
+        if constexpr (LUNAR_PROFILING)
+        {
+            vkbPhysicalDeviceSelector.add_desired_extension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+        }
+
+        if (m_config.headless)
+        {
+            // Allow software implementations (ex lavapipe), so that headless benchmarks can run on machines without a GPU.
+            vkbPhysicalDeviceSelector.allow_any_gpu_device_type(true);
+        }
+        else
+        {
+            vkbPhysicalDeviceSelector.allow_any_gpu_device_type(false).set_surface(m_surface);
+        }
+
+        const auto vkbPhysicalDevice = vkbPhysicalDeviceSelector.select().value();
 
         m_physicalDevice = vkbPhysicalDevice;
 
@@ -159,17 +260,34 @@ namespace lunar
         const vkb::Device vkbDevice = vkbDeviceBuilder.build().value();
 
         m_device = vkbDevice.device;
-        m_deletionQueue.pushFunction([=]() { m_device.destroy(); });
+
+        // Desired extensions are enabled if the device supports them.
+        const auto extensionProperties = m_physicalDevice.enumerateDeviceExtensionProperties();
+        const bool memoryBudgetExtensionEnabled = std::ranges::any_of(extensionProperties, [](const vk::ExtensionProperties& properties) {
+            return std::string_view(properties.extensionName.data()) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        });
 
         // Initialize the vulkan memory allocator.
         const VmaAllocatorCreateInfo vmaAllocatorCreateInfo = {
+            .flags = memoryBudgetExtensionEnabled ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : VmaAllocatorCreateFlags{0u},
             .physicalDevice = m_physicalDevice,
             .device = m_device,
             .instance = m_instance,
+            .vulkanApiVersion = VK_API_VERSION_1_3,
         };
 
         vkCheck(vmaCreateAllocator(&vmaAllocatorCreateInfo, &m_vmaAllocator));
-        m_deletionQueue.pushFunction([=]() { vmaDestroyAllocator(m_vmaAllocator); });
+
+        m_memoryTracker.init(m_vmaAllocator, memoryBudgetExtensionEnabled, m_config.memoryBudgetWarningThreshold);
+        m_deferredDestructionQueue.init(m_device, m_vmaAllocator, m_memoryTracker);
+
+        // All meshes are suballocated from the geometry pool.
+        m_geometryPool.init(m_device, m_vmaAllocator, m_memoryTracker, m_config.geometryPoolVertexCapacity, m_config.geometryPoolIndexCapacity);
+
+        // Transient images of the render graph are created by its first compile().
+        m_renderGraph.init(m_device, m_vmaAllocator, m_memoryTracker);
+
+        initPipelineCache();
 
         // Get the command queue and family (i.e type of queue).
         // The family indicates what is the capabilities supported by that family of queues (ex family at index 0 may
@@ -178,109 +296,138 @@ namespace lunar
         m_graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
         m_graphicsQueueIndex = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
-        m_transferQueue = vkbDevice.get_queue(vkb::QueueType::transfer).value();
-        m_transferQueueIndex = vkbDevice.get_queue_index(vkb::QueueType::transfer).value();
+        // Some implementations (ex lavapipe) expose a single queue family. In that case, transfer operations are done on the graphics queue.
+        const auto vkbTransferQueue = vkbDevice.get_queue(vkb::QueueType::transfer);
+        if (vkbTransferQueue)
+        {
+            m_transferQueue = vkbTransferQueue.value();
+            m_transferQueueIndex = vkbDevice.get_queue_index(vkb::QueueType::transfer).value();
+        }
+        else
+        {
+            m_transferQueue = m_graphicsQueue;
+            m_transferQueueIndex = m_graphicsQueueIndex;
+        }
+
+        m_uploadManager.init(m_device, m_vmaAllocator, m_memoryTracker, m_transferQueue, m_transferQueueIndex, m_graphicsQueueIndex, m_config.stagingRingSize);
 
         initSwapchain();
         initCommandObjects();
         initSyncPrimitives();
+        initQueryPools();
     }
 
     void Engine::initSwapchain()
     {
+        LUNAR_PROFILE_SCOPE("initSwapchain");
 
-        // Initialize the swapchain and get the swapchain images and image views.
-        // Swapchain provides ability to store and render the rendering results to a surface.
-        // Use FIFO_RELAXED_KHR, which caps the frame rate but if under performing (ex display is 60HZ but FPS is <60,
-        // allows tearing).
-        vkb::SwapchainBuilder vkbSwapchainBuilder{m_physicalDevice, m_device, m_surface};
-        vkb::Swapchain vkbSwapchain = vkbSwapchainBuilder.use_default_format_selection()
-                                          .set_desired_present_mode(VK_PRESENT_MODE_FIFO_RELAXED_KHR)
-                                          .set_desired_extent(m_windowExtent.width, m_windowExtent.height)
-                                          .build()
-                                          .value();
-
-        m_swapchain = vkbSwapchain.swapchain;
-        m_swapchainImageCount = vkbSwapchain.image_count;
-
-        m_swapchainImages.reserve(m_swapchainImageCount);
-        const auto vkbSwapchainImages = vkbSwapchain.get_images().value();
-        for (const auto swapchainImage : vkbSwapchainImages)
+        if (m_config.headless)
         {
-            m_swapchainImages.emplace_back(swapchainImage);
+            // There is no surface to present to, so render into offscreen targets instead.
+            initOffscreenTargets();
         }
-
-        m_swapchainImageViews.reserve(m_swapchainImageCount);
-        const auto vkbSwapchainImageViews = vkbSwapchain.get_image_views().value();
-        for (const auto swapchainImageView : vkbSwapchainImageViews)
+        else
         {
-            m_swapchainImageViews.emplace_back(swapchainImageView);
-        }
+            // Initialize the swapchain and get the swapchain images and image views.
+            // Swapchain provides ability to store and render the rendering results to a surface.
+            // Use FIFO_RELAXED_KHR, which caps the frame rate but if under performing (ex display is 60HZ but FPS is <60,
+            // allows tearing).
+            vkb::SwapchainBuilder vkbSwapchainBuilder{m_physicalDevice, m_device, m_surface};
+            vkb::Swapchain vkbSwapchain = vkbSwapchainBuilder.use_default_format_selection()
+                                              .set_desired_present_mode(VK_PRESENT_MODE_FIFO_RELAXED_KHR)
+                                              .set_desired_extent(m_windowExtent.width, m_windowExtent.height)
+                                              .build()
+                                              .value();
+
+            m_swapchain = vkbSwapchain.swapchain;
+            m_deferredDestructionQueue.destroyAtShutdown(m_swapchain);
+            m_swapchainImageCount = vkbSwapchain.image_count;
+
+            m_swapchainImages.reserve(m_swapchainImageCount);
+            const auto vkbSwapchainImages = vkbSwapchain.get_images().value();
+            for (const auto swapchainImage : vkbSwapchainImages)
+            {
+                m_swapchainImages.emplace_back(swapchainImage);
+            }
 
-        for (const auto& swapchainImageView : m_swapchainImageViews)
-        {
-            m_deletionQueue.pushFunction([=]() { m_device.destroyImageView(swapchainImageView); });
+            m_swapchainImageViews.reserve(m_swapchainImageCount);
+            const auto vkbSwapchainImageViews = vkbSwapchain.get_image_views().value();
+            for (const auto swapchainImageView : vkbSwapchainImageViews)
+            {
+                m_swapchainImageViews.emplace_back(swapchainImageView);
+            }
+
+            for (const auto& swapchainImageView : m_swapchainImageViews)
+            {
+                m_deferredDestructionQueue.destroyAtShutdown(swapchainImageView);
+            }
+
+            m_swapchainImageFormat = vk::Format(vkbSwapchain.image_format);
         }
+    }
 
-        m_swapchainImageFormat = vk::Format(vkbSwapchain.image_format);
+    void Engine::initOffscreenTargets()
+    {
+        LUNAR_PROFILE_SCOPE("initOffscreenTargets");
 
-        // Create the depth texture for use by the pipeline.
-        const vk::Extent3D depthImageExtent = {
-            .width = m_windowExtent.width,
-            .height = m_windowExtent.height,
-            .depth = 1,
-        };
+        m_swapchainImageFormat = vk::Format::eR8G8B8A8Unorm;
 
-        // We do not intend to read the image from the CPU, so we use tilingOptimal to let the GPU decide the optimal
-        // way to arrange the texture in the GPU.
-        const vk::ImageCreateInfo depthImageCreateInfo = {
+        const vk::ImageCreateInfo offscreenImageCreateInfo = {
             .imageType = vk::ImageType::e2D,
-            .format = m_depthImageFormat,
-            .extent = depthImageExtent,
+            .format = m_swapchainImageFormat,
+            .extent =
+                {
+                    .width = m_windowExtent.width,
+                    .height = m_windowExtent.height,
+                    .depth = 1u,
+                },
             .mipLevels = 1u,
             .arrayLayers = 1u,
             .tiling = vk::ImageTiling::eOptimal,
-            .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+            .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
         };
 
-        const VmaAllocationCreateInfo vmaDepthImageAllocationCreateInfo = {
+        const VkImageCreateInfo vkOffscreenImageCreateInfo = offscreenImageCreateInfo;
+
+        const VmaAllocationCreateInfo vmaOffscreenImageAllocationCreateInfo = {
             .usage = VMA_MEMORY_USAGE_GPU_ONLY,
         };
 
-        const VkImageCreateInfo vkDepthImageCreateInfo = depthImageCreateInfo;
-
-        VkImage vkDepthImage{};
-        vkCheck(vmaCreateImage(m_vmaAllocator, &vkDepthImageCreateInfo, &vmaDepthImageAllocationCreateInfo, &vkDepthImage, &m_depthImage.allocation, nullptr));
-        m_depthImage.image = vkDepthImage;
-
-        m_deletionQueue.pushFunction(
-            [=]()
-            {
-                const VkImage vkDepthImage = m_depthImage.image;
-                vmaDestroyImage(m_vmaAllocator, vkDepthImage, m_depthImage.allocation);
-            });
-
-        const vk::ImageViewCreateInfo depthImageViewCreateInfo = {
-            .image = m_depthImage.image,
-            .viewType = vk::ImageViewType::e2D,
-            .format = m_depthImageFormat,
-            .subresourceRange =
-                {
-                    .aspectMask = vk::ImageAspectFlagBits::eDepth,
-                    .baseMipLevel = 0u,
-                    .levelCount = 1u,
-                    .baseArrayLayer = 0u,
-                    .layerCount = 1u,
-                },
-        };
+        // Each frame in flight gets its own render target, so that frames can overlap just like they would with a swapchain.
+        for (const uint32_t frameIndex : std::views::iota(0u, FRAME_COUNT))
+        {
+            Image& offscreenImage = m_frameData[frameIndex].offscreenImage;
+
+            VkImage vkOffscreenImage{};
+            vkCheck(vmaCreateImage(m_vmaAllocator, &vkOffscreenImageCreateInfo, &vmaOffscreenImageAllocationCreateInfo, &vkOffscreenImage, &offscreenImage.allocation, nullptr));
+            offscreenImage.image = vkOffscreenImage;
+
+            m_memoryTracker.track(offscreenImage.allocation, MemoryCategory::eRenderTarget, std::format("Offscreen render target {}", frameIndex));
+            m_deferredDestructionQueue.destroyAtShutdown(offscreenImage);
+
+            const vk::ImageViewCreateInfo offscreenImageViewCreateInfo = {
+                .image = offscreenImage.image,
+                .viewType = vk::ImageViewType::e2D,
+                .format = m_swapchainImageFormat,
+                .subresourceRange =
+                    {
+                        .aspectMask = vk::ImageAspectFlagBits::eColor,
+                        .baseMipLevel = 0u,
+                        .levelCount = 1u,
+                        .baseArrayLayer = 0u,
+                        .layerCount = 1u,
+                    },
+            };
 
-        // Create depth texture image view.
-        m_depthImageView = m_device.createImageView(depthImageViewCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyImageView(m_depthImageView); });
+            m_frameData[frameIndex].offscreenImageView = m_device.createImageView(offscreenImageViewCreateInfo);
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].offscreenImageView);
+        }
     }
 
     void Engine::initCommandObjects()
     {
+        LUNAR_PROFILE_SCOPE("initCommandObjects");
+
         for (const uint32_t frameIndex : std::views::iota(0u, FRAME_COUNT))
         {
             // Create the command pools (i.e background allocators for command buffers).
@@ -292,7 +439,7 @@ namespace lunar
             };
 
             m_frameData[frameIndex].graphicsCommandPool = m_device.createCommandPool(commandPoolCreateInfo);
-            m_deletionQueue.pushFunction([=]() { m_device.destroyCommandPool(m_frameData[frameIndex].graphicsCommandPool); });
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].graphicsCommandPool);
 
             // Create the command buffer.
 
@@ -305,35 +452,35 @@ namespace lunar
             };
 
             m_frameData[frameIndex].graphicsCommandBuffer = m_device.allocateCommandBuffers(commandBufferAllocateInfo).at(0);
-        }
-
-        // Create command buffer and command pool but for transfer operations.
-        const vk::CommandPoolCreateInfo transferCommandPoolCreateInfo = {
-            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-            .queueFamilyIndex = m_transferQueueIndex,
-        };
-
-        m_transferCommandPool = m_device.createCommandPool(transferCommandPoolCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyCommandPool(m_transferCommandPool); });
 
-        const vk::CommandBufferAllocateInfo transferCommandPoolAllocateInfo = {
-            .commandPool = m_transferCommandPool,
-            .level = vk::CommandBufferLevel::ePrimary,
-            .commandBufferCount = 1u,
-        };
+            // One pool per thread that can record draws (the job system's workers and the main thread). These are reset as a whole every
+            // frame, so their command buffers do not need to be individually resettable.
+            const vk::CommandPoolCreateInfo secondaryCommandPoolCreateInfo = {
+                .flags = vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex = m_graphicsQueueIndex,
+            };
 
-        m_transferCommandBuffer = m_device.allocateCommandBuffers(transferCommandPoolAllocateInfo).at(0);
+            for (const uint32_t recordingJobIndex : std::views::iota(0u, m_jobSystem.getWorkerCount() + 1u))
+            {
+                const vk::CommandPool secondaryCommandPool = m_device.createCommandPool(secondaryCommandPoolCreateInfo);
+                m_deferredDestructionQueue.destroyAtShutdown(secondaryCommandPool);
 
-        // Reset the command buffer immediately, as it will be used to handle buffer copies.
-        const vk::CommandBufferBeginInfo transferCommandBufferBeginInfo = {
-            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
-        };
+                const vk::CommandBufferAllocateInfo secondaryCommandBufferAllocateInfo = {
+                    .commandPool = secondaryCommandPool,
+                    .level = vk::CommandBufferLevel::eSecondary,
+                    .commandBufferCount = 1u,
+                };
 
-        m_transferCommandBuffer.begin(transferCommandBufferBeginInfo);
+                m_frameData[frameIndex].secondaryCommandPools.push_back(secondaryCommandPool);
+                m_frameData[frameIndex].secondaryCommandBuffers.push_back(m_device.allocateCommandBuffers(secondaryCommandBufferAllocateInfo).at(0));
+            }
+        }
     }
 
     void Engine::initSyncPrimitives()
     {
+        LUNAR_PROFILE_SCOPE("initSyncPrimitives");
+
         // Create synchronization primitives.
 
         for (const uint32_t frameIndex : std::views::iota(0u, FRAME_COUNT))
@@ -343,29 +490,160 @@ namespace lunar
 
             const vk::FenceCreateInfo fenceCreateInfo = {.flags = vk::FenceCreateFlagBits::eSignaled};
             m_frameData[frameIndex].renderFence = m_device.createFence(fenceCreateInfo);
-            m_deletionQueue.pushFunction([=]() { m_device.destroyFence(m_frameData[frameIndex].renderFence); });
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].renderFence);
 
             // Create semaphores (GPU - GPU sync).
             const vk::SemaphoreCreateInfo semaphoreCreateInfo = {};
             m_frameData[frameIndex].renderSemaphore = m_device.createSemaphore(semaphoreCreateInfo);
             m_frameData[frameIndex].presentationSemaphore = m_device.createSemaphore(semaphoreCreateInfo);
 
-            m_deletionQueue.pushFunction(
-                [=]()
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].renderSemaphore);
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].presentationSemaphore);
+        }
+    }
+
+    void Engine::initQueryPools()
+    {
+        LUNAR_PROFILE_SCOPE("initQueryPools");
+
+        // Timestamps are only usable if the graphics queue supports them.
+        const vk::PhysicalDeviceProperties physicalDeviceProperties = m_physicalDevice.getProperties();
+        const auto queueFamilyProperties = m_physicalDevice.getQueueFamilyProperties();
+
+        // A queue family with no valid timestamp bits does not support timestamps.
+        m_timestampValidBits = queueFamilyProperties[m_graphicsQueueIndex].timestampValidBits;
+        m_gpuTimestampsSupported = physicalDeviceProperties.limits.timestampComputeAndGraphics && m_timestampValidBits > 0u;
+        m_timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+
+        if (!m_gpuTimestampsSupported)
+        {
+            std::cout << "GPU timestamps are not supported by the graphics queue, GPU frame times will not be reported.\n";
+            return;
+        }
+
+        for (const uint32_t frameIndex : std::views::iota(0u, FRAME_COUNT))
+        {
+            const vk::QueryPoolCreateInfo queryPoolCreateInfo = {
+                .queryType = vk::QueryType::eTimestamp,
+                .queryCount = 2u,
+            };
+
+            m_frameData[frameIndex].timestampQueryPool = m_device.createQueryPool(queryPoolCreateInfo);
+            m_deferredDestructionQueue.destroyAtShutdown(m_frameData[frameIndex].timestampQueryPool);
+        }
+
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.init(m_instance, m_physicalDevice, m_device, FRAME_COUNT, m_timestampValidBits);
+        }
+    }
+
+    void Engine::initPipelineCache()
+    {
+        LUNAR_PROFILE_SCOPE("initPipelineCache");
+
+        // The driver's pipeline cache data is only valid for the exact same device and driver, so they are part of the file name.
+        const vk::PhysicalDeviceProperties physicalDeviceProperties = m_physicalDevice.getProperties();
+
+        std::string pipelineCacheUuid{};
+        for (const uint8_t byte : physicalDeviceProperties.pipelineCacheUUID)
+        {
+            pipelineCacheUuid += std::format("{:02x}", byte);
+        }
+
+        m_pipelineCachePath = m_rootDirectory +
+                              std::format("cache/PipelineCache_{:04x}_{:04x}_{:08x}_{}.bin",
+                                          physicalDeviceProperties.vendorID,
+                                          physicalDeviceProperties.deviceID,
+                                          physicalDeviceProperties.driverVersion,
+                                          pipelineCacheUuid);
+
+        // Read the cache file (if present) and validate it. Any mismatch just means the cache is discarded and a cold (empty) cache is used.
+        std::vector<uint8_t> pipelineCacheData{};
+
+        std::ifstream pipelineCacheFile{m_pipelineCachePath, std::ios::ate | std::ios::binary};
+        if (pipelineCacheFile.is_open())
+        {
+            const size_t fileSize = static_cast<size_t>(pipelineCacheFile.tellg());
+            pipelineCacheFile.seekg(0);
+
+            PipelineCacheFileHeader fileHeader{};
+            if (fileSize >= sizeof(PipelineCacheFileHeader))
+            {
+                pipelineCacheFile.read(reinterpret_cast<char*>(&fileHeader), sizeof(PipelineCacheFileHeader));
+            }
+
+            if (fileHeader.magic == PipelineCacheFileHeader::MAGIC && fileHeader.version == PipelineCacheFileHeader::VERSION &&
+                fileHeader.dataSize == fileSize - sizeof(PipelineCacheFileHeader))
+            {
+                pipelineCacheData.resize(fileHeader.dataSize);
+                pipelineCacheFile.read(reinterpret_cast<char*>(pipelineCacheData.data()), fileHeader.dataSize);
+
+                if (!pipelineCacheFile || fnv1aHash(pipelineCacheData.data(), pipelineCacheData.size()) != fileHeader.dataHash)
                 {
-                    m_device.destroySemaphore(m_frameData[frameIndex].renderSemaphore);
-                    m_device.destroySemaphore(m_frameData[frameIndex].presentationSemaphore);
-                });
+                    pipelineCacheData.clear();
+                }
+            }
+        }
+
+        // Validate the header written by the driver (VkPipelineCacheHeaderVersionOne) against the current device.
+        constexpr size_t vulkanPipelineCacheHeaderSize = 16u + VK_UUID_SIZE;
+
+        if (pipelineCacheData.size() >= vulkanPipelineCacheHeaderSize)
+        {
+            uint32_t headerSize{};
+            uint32_t headerVersion{};
+            uint32_t vendorId{};
+            uint32_t deviceId{};
+            std::array<uint8_t, VK_UUID_SIZE> uuid{};
+
+            std::memcpy(&headerSize, pipelineCacheData.data(), sizeof(uint32_t));
+            std::memcpy(&headerVersion, pipelineCacheData.data() + 4u, sizeof(uint32_t));
+            std::memcpy(&vendorId, pipelineCacheData.data() + 8u, sizeof(uint32_t));
+            std::memcpy(&deviceId, pipelineCacheData.data() + 12u, sizeof(uint32_t));
+            std::memcpy(uuid.data(), pipelineCacheData.data() + 16u, VK_UUID_SIZE);
+
+            const bool headerValid = headerSize >= vulkanPipelineCacheHeaderSize && headerSize <= pipelineCacheData.size() &&
+                                     headerVersion == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne) && vendorId == physicalDeviceProperties.vendorID &&
+                                     deviceId == physicalDeviceProperties.deviceID && std::equal(uuid.begin(), uuid.end(), physicalDeviceProperties.pipelineCacheUUID.begin());
+
+            if (!headerValid)
+            {
+                pipelineCacheData.clear();
+            }
+        }
+        else
+        {
+            pipelineCacheData.clear();
         }
+
+        m_pipelineCacheWarm = !pipelineCacheData.empty();
+        if (pipelineCacheFile.is_open() && !m_pipelineCacheWarm)
+        {
+            std::cout << "Discarding stale or corrupt pipeline cache : " << m_pipelineCachePath << '\n';
+        }
+
+        const vk::PipelineCacheCreateInfo pipelineCacheCreateInfo = {
+            .initialDataSize = pipelineCacheData.size(),
+            .pInitialData = pipelineCacheData.data(),
+        };
+
+        m_pipelineCache = m_device.createPipelineCache(pipelineCacheCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(m_pipelineCache);
     }
 
     void Engine::initDescriptors()
     {
+        LUNAR_PROFILE_SCOPE("initDescriptors");
+
         // Create descriptor pool. Maintains a pool of descriptors, from which descriptor sets are allocated.
         // Reserve 10 uniform buffer pointers.
 
-        const std::array<vk::DescriptorPoolSize, 1u> descriptorPoolSizes = {
-            {vk::DescriptorType::eUniformBuffer, 10},
+        const std::array<vk::DescriptorPoolSize, 4u> descriptorPoolSizes = {
+            vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, 10},
+            vk::DescriptorPoolSize{vk::DescriptorType::eUniformBufferDynamic, 10},
+            vk::DescriptorPoolSize{vk::DescriptorType::eStorageBuffer, 16},
+            vk::DescriptorPoolSize{vk::DescriptorType::eStorageBufferDynamic, 10},
         };
 
         // 10 descriptor sets can be allocated from this pool.
@@ -376,18 +654,19 @@ namespace lunar
         };
 
         m_descriptorPool = m_device.createDescriptorPool(descriptorPoolCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyDescriptorPool(m_descriptorPool); });
+        m_deferredDestructionQueue.destroyAtShutdown(m_descriptorPool);
 
         // Descriptors are essentially pointers to a resource + some additional information about it. A descriptor set
         // is a set of descriptors. For performance, use set 0 as global, set 1 as per pass, set 2 as material and set 3
         // as per object (i.e inner loops will be binding only sets 2 and 3 will 0 and 1 will be less frequency unbound
         // and bound. Descriptor set layout gives the general shape / layout of the descriptor sets.
 
-        // Setup the descriptor set layout. At binding 0, there will be 1 uniform buffers for use by the vertex shader (SceneBuffer).
+        // Setup the descriptor set layout. At binding 0, there will be 1 uniform buffers for use by the vertex shader (SceneBuffer). It is in
+        // the frame's upload arena, at an offset that changes every frame, so it is a dynamic uniform buffer.
         const std::array<vk::DescriptorSetLayoutBinding, 1> descriptorSetLayoutBindings = {
             vk::DescriptorSetLayoutBinding{
                 .binding = 0u,
-                .descriptorType = vk::DescriptorType::eUniformBuffer,
+                .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
                 .descriptorCount = 1u,
                 .stageFlags = vk::ShaderStageFlagBits::eVertex,
             },
@@ -399,14 +678,57 @@ namespace lunar
         };
 
         m_globalDescriptorSetLayout = m_device.createDescriptorSetLayout(descriptorSetLayoutCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyDescriptorSetLayout(m_globalDescriptorSetLayout); });
+        m_deferredDestructionQueue.destroyAtShutdown(m_globalDescriptorSetLayout);
+
+        // Set 1 of the GPU driven path : object transforms, mesh data, draw items, draw commands and draw counts (see shaders/GpuDriven.hlsli).
+        // The object transforms are in the frame's upload arena, so they are a dynamic storage buffer.
+        std::array<vk::DescriptorSetLayoutBinding, 5> gpuDrivenDescriptorSetLayoutBindings{};
+        for (const uint32_t binding : std::views::iota(0u, static_cast<uint32_t>(gpuDrivenDescriptorSetLayoutBindings.size())))
+        {
+            gpuDrivenDescriptorSetLayoutBindings[binding] = vk::DescriptorSetLayoutBinding{
+                .binding = binding,
+                .descriptorType = binding == 0u ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1u,
+                .stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eCompute,
+            };
+        }
+
+        const vk::DescriptorSetLayoutCreateInfo gpuDrivenDescriptorSetLayoutCreateInfo = {
+            .bindingCount = static_cast<uint32_t>(gpuDrivenDescriptorSetLayoutBindings.size()),
+            .pBindings = gpuDrivenDescriptorSetLayoutBindings.data(),
+        };
+
+        m_gpuDrivenDescriptorSetLayout = m_device.createDescriptorSetLayout(gpuDrivenDescriptorSetLayoutCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(m_gpuDrivenDescriptorSetLayout);
+
+        // Set 1 of the instanced path : the instance buffer (at the binding of the object transforms in shaders/GpuDriven.hlsli).
+        const vk::DescriptorSetLayoutBinding instanceDescriptorSetLayoutBinding = {
+            .binding = 0u,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1u,
+            .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        };
+
+        const vk::DescriptorSetLayoutCreateInfo instanceDescriptorSetLayoutCreateInfo = {
+            .bindingCount = 1u,
+            .pBindings = &instanceDescriptorSetLayoutBinding,
+        };
+
+        m_instanceDescriptorSetLayout = m_device.createDescriptorSetLayout(instanceDescriptorSetLayoutCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(m_instanceDescriptorSetLayout);
+
+        // Dynamic offsets into the upload arenas must be multiples of these alignments.
+        const vk::PhysicalDeviceLimits physicalDeviceLimits = m_physicalDevice.getProperties().limits;
+        const uint32_t minDynamicOffsetAlignment = static_cast<uint32_t>(std::max(physicalDeviceLimits.minUniformBufferOffsetAlignment, physicalDeviceLimits.minStorageBufferOffsetAlignment));
 
         //  Setup descriptor sets.
         for (const uint32_t frameIndex : std::views::iota(0u, FRAME_COUNT))
         {
-            const vk::BufferCreateInfo sceneBufferCreateInfo = {.size = sizeof(SceneBufferData), .usage = vk::BufferUsageFlagBits::eUniformBuffer};
-
-            m_frameData[frameIndex].sceneBuffer = createGPUBuffer(sceneBufferCreateInfo);
+            m_frameData[frameIndex].uploadArena.init(m_vmaAllocator,
+                                                     m_memoryTracker,
+                                                     m_config.frameArenaSize,
+                                                     vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+                                                     minDynamicOffsetAlignment);
 
             // Allocate a descriptor set for the scene buffer for this frame.
             const vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo = {
@@ -417,9 +739,10 @@ namespace lunar
 
             m_frameData[frameIndex].globalDescriptorSet = m_device.allocateDescriptorSets(descriptorSetAllocateInfo).at(0);
 
-            // At this point, the descriptor set is allocated. Now, make the descriptor point to the camera buffer.
+            // At this point, the descriptor set is allocated. Now, make the descriptor point to the camera buffer (the offset of the frame's
+            // scene data in the upload arena is given when the descriptor set is bound).
             const vk::DescriptorBufferInfo cameraDescriptorBufferInfo = {
-                .buffer = m_frameData[frameIndex].sceneBuffer.buffer,
+                .buffer = m_frameData[frameIndex].uploadArena.getBuffer(),
                 .offset = 0u,
                 .range = sizeof(SceneBufferData),
             };
@@ -428,16 +751,53 @@ namespace lunar
                 .dstSet = m_frameData[frameIndex].globalDescriptorSet,
                 .dstBinding = 0u,
                 .descriptorCount = 1u,
-                .descriptorType = vk::DescriptorType::eUniformBuffer,
+                .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
                 .pBufferInfo = &cameraDescriptorBufferInfo,
             };
 
             m_device.updateDescriptorSets(1u, &descriptorSetWrite, 0u, nullptr);
+
+            // The GPU driven descriptor set is written when the GPU driven scene is built, as its buffers depend on the scene.
+            const vk::DescriptorSetAllocateInfo gpuDrivenDescriptorSetAllocateInfo = {
+                .descriptorPool = m_descriptorPool,
+                .descriptorSetCount = 1u,
+                .pSetLayouts = &m_gpuDrivenDescriptorSetLayout,
+            };
+
+            m_frameData[frameIndex].gpuDrivenDescriptorSet = m_device.allocateDescriptorSets(gpuDrivenDescriptorSetAllocateInfo).at(0);
+
+            // The instance descriptor set points to the whole upload arena : instance transforms are indexed with the first instance of each
+            // draw, which includes the offset of the frame's instance transforms.
+            const vk::DescriptorSetAllocateInfo instanceDescriptorSetAllocateInfo = {
+                .descriptorPool = m_descriptorPool,
+                .descriptorSetCount = 1u,
+                .pSetLayouts = &m_instanceDescriptorSetLayout,
+            };
+
+            m_frameData[frameIndex].instanceDescriptorSet = m_device.allocateDescriptorSets(instanceDescriptorSetAllocateInfo).at(0);
+
+            const vk::DescriptorBufferInfo instanceDescriptorBufferInfo = {
+                .buffer = m_frameData[frameIndex].uploadArena.getBuffer(),
+                .offset = 0u,
+                .range = VK_WHOLE_SIZE,
+            };
+
+            const vk::WriteDescriptorSet instanceDescriptorSetWrite = {
+                .dstSet = m_frameData[frameIndex].instanceDescriptorSet,
+                .dstBinding = 0u,
+                .descriptorCount = 1u,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &instanceDescriptorBufferInfo,
+            };
+
+            m_device.updateDescriptorSets(1u, &instanceDescriptorSetWrite, 0u, nullptr);
         }
     }
 
     void Engine::initPipelines()
     {
+        LUNAR_PROFILE_SCOPE("initPipelines");
+
         // Create a simple pipeline.
 
         // Create shader modules.
@@ -527,7 +887,7 @@ namespace lunar
 
         // Create base pipeline layout.
         m_materials["BaseMaterial"].pipelineLayout = m_device.createPipelineLayout(pipelineLayoutCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyPipelineLayout(m_materials["BaseMaterial"].pipelineLayout); });
+        m_deferredDestructionQueue.destroyAtShutdown(m_materials["BaseMaterial"].pipelineLayout);
 
         const vk::PipelineRenderingCreateInfo pipelineRenderingCreateInfo = {
             .colorAttachmentCount = 1u,
@@ -547,10 +907,145 @@ namespace lunar
         };
 
         m_materials["BaseMaterial"].pipeline = createPipeline(pipelineCreationDesc, m_materials["BaseMaterial"].pipelineLayout);
+
+        // Create the pipeline for meshes in the compact (quantized) vertex format. It shares the pipeline layout of the base material, as
+        // dequantization of positions is folded into the model matrix.
+        const vk::ShaderModule compactVertexShaderModule = createShaderModule("shaders/ShaderCompactVS.cso");
+
+        const vk::PipelineShaderStageCreateInfo compactVertexShaderStageCreateInfo = {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = compactVertexShaderModule,
+            .pName = "VsMainCompact",
+        };
+
+        PipelineCreationDesc compactPipelineCreationDesc = pipelineCreationDesc;
+        compactPipelineCreationDesc.shaderStages = {compactVertexShaderStageCreateInfo, pixelShaderStageCreateInfo};
+        compactPipelineCreationDesc.vertexInputState = CompactVertex::getVertexInputState();
+
+        m_materials["BaseMaterialCompact"].pipelineLayout = m_materials["BaseMaterial"].pipelineLayout;
+        m_materials["BaseMaterialCompact"].pipeline = createPipeline(compactPipelineCreationDesc, m_materials["BaseMaterialCompact"].pipelineLayout);
+
+        // Create the GPU driven variants of the materials. They have no push constants : the model matrix (and the position dequantization of
+        // compact meshes) is read from the GPU driven descriptor set, using the draw item index passed as the first instance of the draw command.
+        const std::array<vk::DescriptorSetLayout, 2> gpuDrivenDescriptorSetLayouts = {m_globalDescriptorSetLayout, m_gpuDrivenDescriptorSetLayout};
+
+        const vk::PipelineLayoutCreateInfo gpuDrivenPipelineLayoutCreateInfo = {
+            .setLayoutCount = static_cast<uint32_t>(gpuDrivenDescriptorSetLayouts.size()),
+            .pSetLayouts = gpuDrivenDescriptorSetLayouts.data(),
+        };
+
+        const vk::PipelineLayout gpuDrivenPipelineLayout = m_device.createPipelineLayout(gpuDrivenPipelineLayoutCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(gpuDrivenPipelineLayout);
+
+        const vk::PipelineShaderStageCreateInfo indirectVertexShaderStageCreateInfo = {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = createShaderModule("shaders/ShaderIndirectVS.cso"),
+            .pName = "VsMainIndirect",
+        };
+
+        const vk::PipelineShaderStageCreateInfo compactIndirectVertexShaderStageCreateInfo = {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = createShaderModule("shaders/ShaderCompactIndirectVS.cso"),
+            .pName = "VsMainCompactIndirect",
+        };
+
+        PipelineCreationDesc indirectPipelineCreationDesc = pipelineCreationDesc;
+        indirectPipelineCreationDesc.shaderStages = {indirectVertexShaderStageCreateInfo, pixelShaderStageCreateInfo};
+
+        PipelineCreationDesc compactIndirectPipelineCreationDesc = compactPipelineCreationDesc;
+        compactIndirectPipelineCreationDesc.shaderStages = {compactIndirectVertexShaderStageCreateInfo, pixelShaderStageCreateInfo};
+
+        m_materials["BaseMaterialIndirect"].pipelineLayout = gpuDrivenPipelineLayout;
+        m_materials["BaseMaterialIndirect"].pipeline = createPipeline(indirectPipelineCreationDesc, gpuDrivenPipelineLayout);
+
+        m_materials["BaseMaterialCompactIndirect"].pipelineLayout = gpuDrivenPipelineLayout;
+        m_materials["BaseMaterialCompactIndirect"].pipeline = createPipeline(compactIndirectPipelineCreationDesc, gpuDrivenPipelineLayout);
+
+        m_materials["BaseMaterial"].gpuDrivenVariant = &m_materials["BaseMaterialIndirect"];
+        m_materials["BaseMaterialCompact"].gpuDrivenVariant = &m_materials["BaseMaterialCompactIndirect"];
+
+        // Create the instanced variants of the materials. Like the GPU driven variants they have no push constants, but set 1 only holds the
+        // instance buffer, which is indexed by the instance index. Dequantization of compact positions is folded into the instance transforms.
+        const std::array<vk::DescriptorSetLayout, 2> instancedDescriptorSetLayouts = {m_globalDescriptorSetLayout, m_instanceDescriptorSetLayout};
+
+        const vk::PipelineLayoutCreateInfo instancedPipelineLayoutCreateInfo = {
+            .setLayoutCount = static_cast<uint32_t>(instancedDescriptorSetLayouts.size()),
+            .pSetLayouts = instancedDescriptorSetLayouts.data(),
+        };
+
+        const vk::PipelineLayout instancedPipelineLayout = m_device.createPipelineLayout(instancedPipelineLayoutCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(instancedPipelineLayout);
+
+        const vk::PipelineShaderStageCreateInfo instancedVertexShaderStageCreateInfo = {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = createShaderModule("shaders/ShaderInstancedVS.cso"),
+            .pName = "VsMainInstanced",
+        };
+
+        const vk::PipelineShaderStageCreateInfo compactInstancedVertexShaderStageCreateInfo = {
+            .stage = vk::ShaderStageFlagBits::eVertex,
+            .module = createShaderModule("shaders/ShaderCompactInstancedVS.cso"),
+            .pName = "VsMainCompactInstanced",
+        };
+
+        PipelineCreationDesc instancedPipelineCreationDesc = pipelineCreationDesc;
+        instancedPipelineCreationDesc.shaderStages = {instancedVertexShaderStageCreateInfo, pixelShaderStageCreateInfo};
+
+        PipelineCreationDesc compactInstancedPipelineCreationDesc = compactPipelineCreationDesc;
+        compactInstancedPipelineCreationDesc.shaderStages = {compactInstancedVertexShaderStageCreateInfo, pixelShaderStageCreateInfo};
+
+        m_materials["BaseMaterialInstanced"].pipelineLayout = instancedPipelineLayout;
+        m_materials["BaseMaterialInstanced"].pipeline = createPipeline(instancedPipelineCreationDesc, instancedPipelineLayout);
+
+        m_materials["BaseMaterialCompactInstanced"].pipelineLayout = instancedPipelineLayout;
+        m_materials["BaseMaterialCompactInstanced"].pipeline = createPipeline(compactInstancedPipelineCreationDesc, instancedPipelineLayout);
+
+        m_materials["BaseMaterial"].instancedVariant = &m_materials["BaseMaterialInstanced"];
+        m_materials["BaseMaterialCompact"].instancedVariant = &m_materials["BaseMaterialCompactInstanced"];
+
+        // Create the culling compute pipeline.
+        const vk::PushConstantRange cullingPushConstant = {
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .offset = 0u,
+            .size = sizeof(GpuCullingConstants),
+        };
+
+        const vk::PipelineLayoutCreateInfo cullingPipelineLayoutCreateInfo = {
+            .setLayoutCount = static_cast<uint32_t>(gpuDrivenDescriptorSetLayouts.size()),
+            .pSetLayouts = gpuDrivenDescriptorSetLayouts.data(),
+            .pushConstantRangeCount = 1u,
+            .pPushConstantRanges = &cullingPushConstant,
+        };
+
+        m_gpuCullingPipelineLayout = m_device.createPipelineLayout(cullingPipelineLayoutCreateInfo);
+        m_deferredDestructionQueue.destroyAtShutdown(m_gpuCullingPipelineLayout);
+
+        const vk::ComputePipelineCreateInfo cullingPipelineCreateInfo = {
+            .stage =
+                {
+                    .stage = vk::ShaderStageFlagBits::eCompute,
+                    .module = createShaderModule("shaders/CullingCS.cso"),
+                    .pName = "CsMain",
+                },
+            .layout = m_gpuCullingPipelineLayout,
+        };
+
+        const auto cullingPipelineCreationStartTime = std::chrono::high_resolution_clock::now();
+
+        const auto cullingPipelineResult = m_device.createComputePipeline(m_pipelineCache, cullingPipelineCreateInfo);
+        vkCheck(cullingPipelineResult.result);
+
+        const std::chrono::duration<double, std::milli> cullingPipelineCreationTime = std::chrono::high_resolution_clock::now() - cullingPipelineCreationStartTime;
+        m_pipelineCreationTimeMs += cullingPipelineCreationTime.count();
+        m_pipelineCount++;
+
+        m_gpuCullingPipeline = cullingPipelineResult.value;
+        m_deferredDestructionQueue.destroyAtShutdown(m_gpuCullingPipeline);
     }
 
     void Engine::initMeshes()
     {
+        LUNAR_PROFILE_SCOPE("initMeshes");
 
         std::vector<Vertex> triangleVertices(3);
 
@@ -558,86 +1053,1067 @@ namespace lunar
         triangleVertices[1] = Vertex{.position = {0.0f, 0.5f, 0.0f}, .color = {0.0f, 1.0f, 0.0f}};
         triangleVertices[2] = Vertex{.position = {0.5f, -0.5f, 0.0f}, .color = {0.0f, 0.0f, 1.0f}};
 
-        const vk::BufferCreateInfo vertexBufferCreateInfo = {
-            .size = triangleVertices.size() * sizeof(Vertex),
-            .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        };
-
-        m_meshes["Triangle"].vertexBuffer = createGPUBuffer(vertexBufferCreateInfo, triangleVertices.data());
-
         std::vector<uint32_t> triangleIndices{0u, 1u, 2u};
 
-        const vk::BufferCreateInfo indexBufferCreateInfo = {
-            .size = triangleIndices.size() * sizeof(uint32_t),
-            .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        };
+        const Submesh triangleSubmesh = {.vertexOffset = 0u, .vertexCount = 3u, .firstIndex = 0u, .indexCount = 3u};
 
-        m_meshes["Triangle"].indexBuffer = createGPUBuffer(indexBufferCreateInfo, triangleIndices.data());
-        m_meshes["Triangle"].indicesCount = triangleIndices.size();
+        m_meshes["Triangle"] = uploadMesh(MeshEncoding{}, std::as_bytes(std::span(triangleVertices)), std::as_bytes(std::span(triangleIndices)),
+                                          std::span(&triangleSubmesh, 1u));
+        m_meshes["Triangle"].boundingBox = BoundingBox{.center = {0.0f, 0.0f, 0.0f}, .extents = {0.5f, 0.5f, 0.0f}};
+        m_meshes["Triangle"].boundingSphere = math::XMFLOAT4{0.0f, 0.0f, 0.0f, std::sqrt(0.5f)};
 
-        m_meshes["Suzanne"] = createMesh("assets/Suzanne/glTF/Suzanne.gltf");
+        // Streamed, so that the first frame does not wait for it to be loaded.
+        requestMesh("Suzanne", "assets/Suzanne/glTF/Suzanne.gltf", VertexFormat::eCompact);
     }
 
     void Engine::initScene()
     {
-        const vk::BufferCreateInfo transformBufferCreateInfo = {
-            .size = sizeof(TransformBufferData),
-            .usage = vk::BufferUsageFlagBits::eUniformBuffer,
-        };
+        LUNAR_PROFILE_SCOPE("initScene");
 
         RenderObject triangle = {
             .mesh = &m_meshes["Triangle"],
             .material = &m_materials["BaseMaterial"],
-            .transformBuffer = {.buffer = createGPUBuffer(transformBufferCreateInfo)},
         };
 
         m_renderObjects.emplace_back(triangle);
 
         RenderObject suzanne = {
             .mesh = &m_meshes["Suzanne"],
-            .material = &m_materials["BaseMaterial"],
-            .transformBuffer = {.buffer = createGPUBuffer(transformBufferCreateInfo)},
+            .material = getMaterialForMesh(m_meshes["Suzanne"]),
         };
 
         m_renderObjects.emplace_back(suzanne);
-    }
 
-    void Engine::run()
-    {
-        // Initialize SDL and the graphics back end.
-        init();
+        // Static objects on a grid in front of the camera, alternating between the two meshes. Only a part of the grid is inside the frustum, so
+        // that there are objects to cull.
+        const std::array<Mesh*, 2> gridMeshes = {&m_meshes["Suzanne"], &m_meshes["Triangle"]};
 
-        // Main run loop.
-        bool quit{false};
-        SDL_Event event{};
+        const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(m_config.sceneObjectCount))));
+        const float gridOffset = (static_cast<float>(gridSize) - 1.0f) * 0.5f;
+        constexpr float gridSpacing = 3.0f;
+
+        m_renderObjects.reserve(m_renderObjects.size() + m_config.sceneObjectCount);
+        for (const uint32_t objectIndex : std::views::iota(0u, m_config.sceneObjectCount))
+        {
+            const float x = static_cast<float>(objectIndex % gridSize) - gridOffset;
+            const float y = static_cast<float>(objectIndex / gridSize % gridSize) - gridOffset;
+            const float z = static_cast<float>(objectIndex / (gridSize * gridSize));
+
+            Mesh* mesh = gridMeshes[objectIndex % 2u];
+
+            RenderObject renderObject = {
+                .mesh = mesh,
+                .material = getMaterialForMesh(*mesh),
+            };
+
+            renderObject.transformData.modelMatrix = math::XMMatrixTranslation(x * gridSpacing, y * gridSpacing, 5.0f + z * gridSpacing);
+
+            m_renderObjects.emplace_back(renderObject);
+        }
+
+        buildSceneBvh();
+
+        // Frames fill these from the render objects, so they are sized for all of them up front rather than grown by the first frames.
+        m_visibleObjectIndices.reserve(m_renderObjects.size());
+        m_instanceGroups.reserve(m_renderObjects.size());
+    }
+
+    void Engine::buildSceneBvh()
+    {
+        std::vector<Aabb> bounds{};
+        bounds.reserve(m_renderObjects.size());
+
+        for (const RenderObject& renderObject : m_renderObjects)
+        {
+            bounds.emplace_back(Aabb::fromBoundingBox(renderObject.mesh->boundingBox, renderObject.transformData.modelMatrix));
+        }
+
+        const std::vector<uint32_t> leaves = m_sceneBvh.build(bounds);
+        for (const size_t objectIndex : std::views::iota(0u, m_renderObjects.size()))
+        {
+            m_renderObjects[objectIndex].bvhLeaf = leaves[objectIndex];
+        }
+    }
+
+    void Engine::buildGpuDrivenScene()
+    {
+        LUNAR_PROFILE_SCOPE("buildGpuDrivenScene");
+
+        GpuDrivenScene& scene = m_pendingGpuDrivenScene;
+
+        // Every mesh gets an index into the mesh buffer.
+        std::unordered_map<const Mesh*, uint32_t> meshIndices{};
+        std::vector<GpuMeshData> gpuMeshes{};
+        gpuMeshes.reserve(m_meshes.size());
+
+        for (const auto& [meshName, mesh] : m_meshes)
+        {
+            meshIndices[&mesh] = static_cast<uint32_t>(gpuMeshes.size());
+
+            gpuMeshes.emplace_back(GpuMeshData{
+                .boundingSphere = mesh.boundingSphere,
+                .positionScale = mesh.encoding.positionScale,
+                .lodCount = mesh.lodChain.lodCount,
+                .positionOffset = mesh.encoding.positionOffset,
+                .lodErrors = {mesh.lodChain.lodErrors[0], mesh.lodChain.lodErrors[1], mesh.lodChain.lodErrors[2], mesh.lodChain.lodErrors[3]},
+            });
+        }
+
+        // One draw item per render object submesh. Draw items are grouped into batches by material and index type, and every batch has room in
+        // the draw command buffer for all of its draw items.
+        std::vector<GpuDrawItem> drawItems{};
+        scene.indirectDrawBatches.clear();
+
+        for (const uint32_t objectIndex : std::views::iota(0u, static_cast<uint32_t>(m_renderObjects.size())))
+        {
+            const RenderObject& renderObject = m_renderObjects[objectIndex];
+            const Mesh& mesh = *renderObject.mesh;
+
+            // Rebuilt once the mesh is resident.
+            if (mesh.residency != MeshResidency::eResident)
+            {
+                continue;
+            }
+
+            Material* material = renderObject.material->gpuDrivenVariant;
+            if (!material)
+            {
+                fatalError("Render object material has no GPU driven variant.");
+            }
+
+            const auto batch = std::find_if(scene.indirectDrawBatches.begin(), scene.indirectDrawBatches.end(), [&](const IndirectDrawBatch& indirectDrawBatch) {
+                return indirectDrawBatch.material == material && indirectDrawBatch.indexType == mesh.encoding.indexType;
+            });
+
+            const uint32_t batchIndex = static_cast<uint32_t>(std::distance(scene.indirectDrawBatches.begin(), batch));
+            if (batch == scene.indirectDrawBatches.end())
+            {
+                scene.indirectDrawBatches.emplace_back(IndirectDrawBatch{.material = material, .indexType = mesh.encoding.indexType});
+            }
+
+            const GeometryAllocation& geometryAllocation = m_geometryPool.getAllocation(mesh.geometryHandle);
+
+            for (const Submesh& submesh : mesh.submeshes)
+            {
+                GpuDrawItem drawItem = {
+                    .objectIndex = objectIndex,
+                    .meshIndex = meshIndices[&mesh],
+                    .batchIndex = batchIndex,
+                    .vertexOffset = static_cast<int32_t>(geometryAllocation.baseVertex + submesh.vertexOffset),
+                };
+
+                for (const uint32_t lodIndex : std::views::iota(0u, mesh.lodChain.lodCount))
+                {
+                    const IndexRange indexRange = submesh.getIndexRange(lodIndex);
+                    drawItem.lodIndexRanges[lodIndex] = IndexRange{
+                        .firstIndex = geometryAllocation.baseIndex + indexRange.firstIndex,
+                        .indexCount = indexRange.indexCount,
+                    };
+                }
+
+                drawItems.emplace_back(drawItem);
+                scene.indirectDrawBatches[batchIndex].maxDrawCount++;
+            }
+        }
+
+        uint32_t commandCount{};
+        for (IndirectDrawBatch& batch : scene.indirectDrawBatches)
+        {
+            batch.firstCommand = commandCount;
+            commandCount += batch.maxDrawCount;
+        }
+
+        for (GpuDrawItem& drawItem : drawItems)
+        {
+            drawItem.firstCommand = scene.indirectDrawBatches[drawItem.batchIndex].firstCommand;
+        }
+
+        scene.drawItemCount = static_cast<uint32_t>(drawItems.size());
+
+        // Mesh data and draw items only change when the scene does, so they are in GPU only memory.
+        scene.meshBuffer = createGpuDrivenSceneBuffer(gpuMeshes.size(), sizeof(GpuMeshData), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                                      "Meshes");
+        scene.drawItemBuffer = createGpuDrivenSceneBuffer(drawItems.size(), sizeof(GpuDrawItem),
+                                                          vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, "Draw items");
+
+        // Both copies are in the same batch (or the second in a later one), so the ticket of the second covers both.
+        copyToGPUBuffer(scene.meshBuffer.buffer, 0u, std::as_bytes(std::span(gpuMeshes)));
+        scene.uploadTicket = copyToGPUBuffer(scene.drawItemBuffer.buffer, 0u, std::as_bytes(std::span(drawItems)));
+
+        // Submitted right away, so that the uploads run on the transfer queue while the frame is recorded.
+        m_uploadManager.flush();
+
+        m_gpuDrivenScenePending = true;
+        m_gpuDrivenSceneDirty = false;
+    }
+
+    void Engine::swapGpuDrivenScene()
+    {
+        GpuDrivenScene scene = std::move(m_pendingGpuDrivenScene);
+        m_pendingGpuDrivenScene = {};
+        m_gpuDrivenScenePending = false;
+
+        destroyGpuDrivenScene();
+        m_gpuDrivenScene = std::move(scene);
+
+        uint32_t commandCount{};
+        for (const IndirectDrawBatch& batch : m_gpuDrivenScene.indirectDrawBatches)
+        {
+            commandCount += batch.maxDrawCount;
+        }
+
+        for (FrameData& frameData : m_frameData)
+        {
+            frameData.drawCommandBuffer = createGpuDrivenSceneBuffer(commandCount, sizeof(vk::DrawIndexedIndirectCommand),
+                                                                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, "Draw commands");
+
+            frameData.drawCountBuffer =
+                createGpuDrivenSceneBuffer(m_gpuDrivenScene.indirectDrawBatches.size(),
+                                           sizeof(uint32_t),
+                                           vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                           "Draw counts");
+
+            // Frames in flight may still use the descriptor set, so it is written once this frame data is next used.
+            frameData.gpuDrivenDescriptorSetDirty = true;
+        }
+    }
+
+    Buffer Engine::createGpuDrivenSceneBuffer(const size_t elementCount, const size_t elementSize, const vk::BufferUsageFlags usage, const std::string_view name)
+    {
+        // Buffers are never empty, so that the descriptors are always valid.
+        const vk::BufferCreateInfo bufferCreateInfo = {
+            .size = std::max<size_t>(elementCount, 1u) * elementSize,
+            .usage = usage,
+        };
+
+        const VmaAllocationCreateInfo vmaAllocationCreateInfo = {.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+
+        const VkBufferCreateInfo vkBufferCreateInfo = bufferCreateInfo;
+
+        Buffer buffer{};
+
+        VkBuffer vkBuffer{};
+        vkCheck(vmaCreateBuffer(m_vmaAllocator, &vkBufferCreateInfo, &vmaAllocationCreateInfo, &vkBuffer, &buffer.allocation, nullptr));
+        m_memoryTracker.track(buffer.allocation, MemoryCategory::eGpuDrivenScene, name);
+
+        buffer.buffer = vkBuffer;
+
+        return buffer;
+    }
+
+    void Engine::writeGpuDrivenDescriptorSet(FrameData& frameData)
+    {
+        // Bindings are in the order of shaders/GpuDriven.hlsli. The object transforms are written to the upload arena every frame, at the
+        // dynamic offset given when the descriptor set is bound.
+        const std::array<vk::DescriptorBufferInfo, 5> descriptorBufferInfos = {
+            vk::DescriptorBufferInfo{
+                .buffer = frameData.uploadArena.getBuffer(),
+                .offset = 0u,
+                .range = std::max<size_t>(m_renderObjects.size(), 1u) * sizeof(math::XMMATRIX),
+            },
+            vk::DescriptorBufferInfo{.buffer = m_gpuDrivenScene.meshBuffer.buffer, .offset = 0u, .range = VK_WHOLE_SIZE},
+            vk::DescriptorBufferInfo{.buffer = m_gpuDrivenScene.drawItemBuffer.buffer, .offset = 0u, .range = VK_WHOLE_SIZE},
+            vk::DescriptorBufferInfo{.buffer = frameData.drawCommandBuffer.buffer, .offset = 0u, .range = VK_WHOLE_SIZE},
+            vk::DescriptorBufferInfo{.buffer = frameData.drawCountBuffer.buffer, .offset = 0u, .range = VK_WHOLE_SIZE},
+        };
+
+        std::array<vk::WriteDescriptorSet, 5> descriptorSetWrites{};
+        for (const uint32_t binding : std::views::iota(0u, static_cast<uint32_t>(descriptorSetWrites.size())))
+        {
+            descriptorSetWrites[binding] = vk::WriteDescriptorSet{
+                .dstSet = frameData.gpuDrivenDescriptorSet,
+                .dstBinding = binding,
+                .descriptorCount = 1u,
+                .descriptorType = binding == 0u ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &descriptorBufferInfos[binding],
+            };
+        }
+
+        m_device.updateDescriptorSets(static_cast<uint32_t>(descriptorSetWrites.size()), descriptorSetWrites.data(), 0u, nullptr);
+
+        frameData.gpuDrivenDescriptorSetDirty = false;
+    }
+
+    void Engine::invalidateGpuDrivenScene()
+    {
+        // The current draw items refer to render objects by index and to the geometry of their meshes, so drawing them could read past the
+        // object transforms or draw freed geometry. Their buffers stay bound (and valid) until the rebuilt scene is swapped in.
+        m_gpuDrivenScene.drawItemCount = 0u;
+        m_gpuDrivenScene.indirectDrawBatches.clear();
+
+        // A rebuild that is still uploading is stale too. Its buffers must not be destroyed while they are being copied to.
+        if (m_gpuDrivenScenePending)
+        {
+            m_uploadManager.wait(m_pendingGpuDrivenScene.uploadTicket);
+
+            m_deferredDestructionQueue.retire(m_pendingGpuDrivenScene.meshBuffer, m_frameNumber);
+            m_deferredDestructionQueue.retire(m_pendingGpuDrivenScene.drawItemBuffer, m_frameNumber);
+
+            m_pendingGpuDrivenScene = {};
+            m_gpuDrivenScenePending = false;
+        }
+
+        m_gpuDrivenSceneDirty = true;
+    }
+
+    void Engine::destroyGpuDrivenScene()
+    {
+        // The frames in flight may still use the buffers, so they are retired by the frame being recorded.
+        const auto retireBuffer = [&](Buffer& buffer) {
+            if (buffer.buffer)
+            {
+                m_deferredDestructionQueue.retire(buffer, m_frameNumber);
+                buffer = {};
+            }
+        };
+
+        retireBuffer(m_gpuDrivenScene.meshBuffer);
+        retireBuffer(m_gpuDrivenScene.drawItemBuffer);
+        retireBuffer(m_pendingGpuDrivenScene.meshBuffer);
+        retireBuffer(m_pendingGpuDrivenScene.drawItemBuffer);
+
+        for (FrameData& frameData : m_frameData)
+        {
+            retireBuffer(frameData.drawCommandBuffer);
+            retireBuffer(frameData.drawCountBuffer);
+        }
+    }
+
+    uint32_t Engine::selectLod(const RenderObject& renderObject, const math::XMMATRIX& viewProjectionMatrix, const float projectionScale) const
+    {
+        const Mesh& mesh = *renderObject.mesh;
+        if (mesh.lodChain.lodCount <= 1u)
+        {
+            return 0u;
+        }
+
+        const math::XMMATRIX& modelMatrix = renderObject.transformData.modelMatrix;
+
+        // Errors are in object space, so they are scaled by the largest scale of the model matrix.
+        const float scale = getMaxScale(modelMatrix);
+
+        // The w component of the clip space position is the view space depth, so only the fourth column of the view projection matrix is needed.
+        const math::XMVECTOR center = math::XMVector3Transform(math::XMLoadFloat4(&mesh.boundingSphere), modelMatrix);
+        const math::XMVECTOR depthColumn = math::XMMatrixTranspose(viewProjectionMatrix).r[3];
+
+        const float depth = math::XMVectorGetX(math::XMVector4Dot(math::XMVectorSetW(center, 1.0f), depthColumn)) - mesh.boundingSphere.w * scale;
+        if (depth <= 0.0f)
+        {
+            return 0u;
+        }
+
+        for (uint32_t lodIndex = mesh.lodChain.lodCount - 1u; lodIndex > 0u; lodIndex--)
+        {
+            const float projectedError = mesh.lodChain.lodErrors[lodIndex] * scale / depth * projectionScale;
+            if (projectedError <= m_config.lodErrorThreshold)
+            {
+                return lodIndex;
+            }
+        }
+
+        return 0u;
+    }
+
+    void Engine::drawRenderObjects(const vk::CommandBuffer& cmd, std::span<const uint32_t> objectIndices, const MeshletCullingContext& meshletCullingContext,
+                                   RenderStatistics& statistics) const
+    {
+        // Meshes with 16 and 32 bit indices share the geometry pool's index buffer, which is rebound only when the index type changes.
+        constexpr vk::DeviceSize indexBufferOffset = 0;
+        std::optional<vk::IndexType> lastIndexType{};
+
+        // Update material and mesh only if the current render object's material / mesh is different from the one previously used.
+        // Useful as binding pipelines unnecessarily is not the most efficient.
+        Material* lastMaterial = nullptr;
+        Mesh* lastMesh = nullptr;
+
+        for (const uint32_t objectIndex : objectIndices)
+        {
+            const RenderObject& renderObject = m_renderObjects[objectIndex];
+            const math::XMMATRIX& modelMatrix = renderObject.transformData.modelMatrix;
+            const float maxScale = getMaxScale(modelMatrix);
+
+            if (renderObject.material != lastMaterial)
+            {
+                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, renderObject.material->pipeline);
+                cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                       renderObject.material->pipelineLayout,
+                                       0u,
+                                       1u,
+                                       &getCurrentFrameData().globalDescriptorSet,
+                                       1u,
+                                       &getCurrentFrameData().sceneBufferOffset);
+
+                lastMaterial = renderObject.material;
+
+                statistics.pipelineBindCount++;
+                statistics.descriptorSetBindCount++;
+            }
+            else
+            {
+                statistics.skippedPipelineBindCount++;
+            }
+
+            if (renderObject.mesh != lastMesh)
+            {
+                if (renderObject.mesh->encoding.indexType != lastIndexType)
+                {
+                    cmd.bindIndexBuffer(m_geometryPool.getIndexBuffer(), indexBufferOffset, renderObject.mesh->encoding.indexType);
+                    lastIndexType = renderObject.mesh->encoding.indexType;
+
+                    statistics.indexBufferBindCount++;
+                }
+                else
+                {
+                    statistics.skippedIndexBufferBindCount++;
+                }
+
+                lastMesh = renderObject.mesh;
+            }
+            else
+            {
+                statistics.skippedIndexBufferBindCount++;
+            }
+
+            const GeometryAllocation& geometryAllocation = m_geometryPool.getAllocation(lastMesh->geometryHandle);
+
+            // Quantized positions are dequantized by folding the mesh's scale / offset into the model matrix.
+            TransformBufferData transformBufferData = renderObject.transformData;
+            if (lastMesh->encoding.vertexFormat == VertexFormat::eCompact)
+            {
+                transformBufferData.modelMatrix = lastMesh->encoding.getPositionDequantizationMatrix() * transformBufferData.modelMatrix;
+            }
+
+            cmd.pushConstants(lastMaterial->pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0u, sizeof(TransformBufferData), &transformBufferData);
+            statistics.pushConstantBytes += sizeof(TransformBufferData);
+
+            // Submesh indices are relative to the submesh, so its vertex offset (plus the base vertex of the mesh in the geometry pool) is used as
+            // the base vertex. Meshlets only partition the full detail LOD.
+            for (const Submesh& submesh : lastMesh->submeshes)
+            {
+                // The object is visible, but with several submeshes some of them may not be.
+                if (lastMesh->submeshes.size() > 1u &&
+                    !meshletCullingContext.frustum.intersectsSphere(math::XMVector3Transform(math::XMLoadFloat4(&submesh.boundingSphere), modelMatrix),
+                                                                   submesh.boundingSphere.w * maxScale))
+                {
+                    continue;
+                }
+
+                if (m_config.meshletCulling && renderObject.lodIndex == 0u && submesh.meshletCount > 0u)
+                {
+                    drawVisibleMeshlets(cmd, submesh, *lastMesh, geometryAllocation, modelMatrix, meshletCullingContext, statistics);
+                    continue;
+                }
+
+                const IndexRange indexRange = submesh.getIndexRange(renderObject.lodIndex);
+                cmd.drawIndexed(indexRange.indexCount,
+                                1u,
+                                geometryAllocation.baseIndex + indexRange.firstIndex,
+                                static_cast<int32_t>(geometryAllocation.baseVertex + submesh.vertexOffset),
+                                0u);
+
+                statistics.drawCallCount++;
+                statistics.triangleCount += indexRange.indexCount / 3u;
+            }
+        }
+    }
+
+    void Engine::buildInstanceGroups()
+    {
+        if (m_visibleObjectIndices.empty())
+        {
+            return;
+        }
+
+        // Sort the visible render objects so that the members of each group are adjacent (and in render object order within the group).
+        std::sort(m_visibleObjectIndices.begin(), m_visibleObjectIndices.end(), [&](const uint32_t a, const uint32_t b) {
+            const RenderObject& renderObjectA = m_renderObjects[a];
+            const RenderObject& renderObjectB = m_renderObjects[b];
+
+            if (renderObjectA.material != renderObjectB.material)
+            {
+                return std::less<Material*>{}(renderObjectA.material, renderObjectB.material);
+            }
+
+            if (renderObjectA.mesh != renderObjectB.mesh)
+            {
+                return std::less<Mesh*>{}(renderObjectA.mesh, renderObjectB.mesh);
+            }
+
+            if (renderObjectA.lodIndex != renderObjectB.lodIndex)
+            {
+                return renderObjectA.lodIndex < renderObjectB.lodIndex;
+            }
+
+            return a < b;
+        });
+
+        const auto isSameGroup = [&](const uint32_t a, const uint32_t b) {
+            const RenderObject& renderObjectA = m_renderObjects[a];
+            const RenderObject& renderObjectB = m_renderObjects[b];
+
+            return renderObjectA.material == renderObjectB.material && renderObjectA.mesh == renderObjectB.mesh && renderObjectA.lodIndex == renderObjectB.lodIndex;
+        };
+
+        // Room is allocated for every visible render object, as it is not yet known how many of them are instanced. The allocation is aligned
+        // to the size of a transform, so that the instance index of the first transform is its offset divided by that size.
+        const FrameArenaAllocation instanceAllocation =
+            getCurrentFrameData().uploadArena.allocate(static_cast<uint32_t>(m_visibleObjectIndices.size() * sizeof(math::XMMATRIX)), sizeof(math::XMMATRIX));
+
+        math::XMMATRIX* instanceTransforms = reinterpret_cast<math::XMMATRIX*>(instanceAllocation.data);
+        const uint32_t firstArenaInstance = instanceAllocation.offset / static_cast<uint32_t>(sizeof(math::XMMATRIX));
+
+        uint32_t instanceCount{};
+
+        // Render objects that are not instanced are compacted to the start of the visible render object indices (the write position never
+        // passes the read position).
+        size_t singleObjectCount{};
+
+        for (size_t groupStart = 0u; groupStart < m_visibleObjectIndices.size();)
+        {
+            size_t groupEnd = groupStart + 1u;
+            while (groupEnd < m_visibleObjectIndices.size() && isSameGroup(m_visibleObjectIndices[groupStart], m_visibleObjectIndices[groupEnd]))
+            {
+                groupEnd++;
+            }
+
+            const RenderObject& firstRenderObject = m_renderObjects[m_visibleObjectIndices[groupStart]];
+
+            if (groupEnd - groupStart == 1u || !firstRenderObject.material->instancedVariant)
+            {
+                for (const size_t visibleIndex : std::views::iota(groupStart, groupEnd))
+                {
+                    m_visibleObjectIndices[singleObjectCount++] = m_visibleObjectIndices[visibleIndex];
+                }
+
+                groupStart = groupEnd;
+                continue;
+            }
+
+            m_instanceGroups.emplace_back(InstanceGroup{
+                .material = firstRenderObject.material->instancedVariant,
+                .mesh = firstRenderObject.mesh,
+                .lodIndex = firstRenderObject.lodIndex,
+                .firstInstance = firstArenaInstance + instanceCount,
+                .instanceCount = static_cast<uint32_t>(groupEnd - groupStart),
+            });
+
+            // Quantized positions are dequantized by folding the mesh's scale / offset into the instance transforms.
+            const bool compactVertexFormat = firstRenderObject.mesh->encoding.vertexFormat == VertexFormat::eCompact;
+            const math::XMMATRIX positionDequantizationMatrix = firstRenderObject.mesh->encoding.getPositionDequantizationMatrix();
+
+            for (const size_t visibleIndex : std::views::iota(groupStart, groupEnd))
+            {
+                const math::XMMATRIX& modelMatrix = m_renderObjects[m_visibleObjectIndices[visibleIndex]].transformData.modelMatrix;
+                instanceTransforms[instanceCount++] = compactVertexFormat ? positionDequantizationMatrix * modelMatrix : modelMatrix;
+            }
+
+            groupStart = groupEnd;
+        }
+
+        m_visibleObjectIndices.resize(singleObjectCount);
+    }
+
+    void Engine::drawInstanceGroups(const vk::CommandBuffer& cmd, std::span<const InstanceGroup> instanceGroups, RenderStatistics& statistics) const
+    {
+        constexpr vk::DeviceSize indexBufferOffset = 0;
+        std::optional<vk::IndexType> lastIndexType{};
+
+        Material* lastMaterial = nullptr;
+
+        const std::array<vk::DescriptorSet, 2> descriptorSets = {getCurrentFrameData().globalDescriptorSet, getCurrentFrameData().instanceDescriptorSet};
+
+        for (const InstanceGroup& instanceGroup : instanceGroups)
+        {
+            if (instanceGroup.material != lastMaterial)
+            {
+                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, instanceGroup.material->pipeline);
+                cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                       instanceGroup.material->pipelineLayout,
+                                       0u,
+                                       static_cast<uint32_t>(descriptorSets.size()),
+                                       descriptorSets.data(),
+                                       1u,
+                                       &getCurrentFrameData().sceneBufferOffset);
+
+                lastMaterial = instanceGroup.material;
+
+                statistics.pipelineBindCount++;
+                statistics.descriptorSetBindCount++;
+            }
+            else
+            {
+                statistics.skippedPipelineBindCount++;
+            }
+
+            if (instanceGroup.mesh->encoding.indexType != lastIndexType)
+            {
+                cmd.bindIndexBuffer(m_geometryPool.getIndexBuffer(), indexBufferOffset, instanceGroup.mesh->encoding.indexType);
+                lastIndexType = instanceGroup.mesh->encoding.indexType;
+
+                statistics.indexBufferBindCount++;
+            }
+            else
+            {
+                statistics.skippedIndexBufferBindCount++;
+            }
+
+            const GeometryAllocation& geometryAllocation = m_geometryPool.getAllocation(instanceGroup.mesh->geometryHandle);
+
+            // The first instance offsets the instance index, which the vertex shader uses to read the transform of each instance.
+            for (const Submesh& submesh : instanceGroup.mesh->submeshes)
+            {
+                const IndexRange indexRange = submesh.getIndexRange(instanceGroup.lodIndex);
+                cmd.drawIndexed(indexRange.indexCount,
+                                instanceGroup.instanceCount,
+                                geometryAllocation.baseIndex + indexRange.firstIndex,
+                                static_cast<int32_t>(geometryAllocation.baseVertex + submesh.vertexOffset),
+                                instanceGroup.firstInstance);
+
+                statistics.drawCallCount++;
+                statistics.triangleCount += static_cast<uint64_t>(indexRange.indexCount / 3u) * instanceGroup.instanceCount;
+            }
+        }
+    }
+
+    void Engine::recordDraws(const vk::CommandBuffer& cmd, const size_t firstDraw, const size_t lastDraw, const MeshletCullingContext& meshletCullingContext,
+                             RenderStatistics& statistics) const
+    {
+        // All meshes share the geometry pool's vertex buffer, so it is bound once.
+        constexpr vk::DeviceSize vertexBufferOffset = 0;
+
+        const vk::Buffer geometryVertexBuffer = m_geometryPool.getVertexBuffer();
+        cmd.bindVertexBuffers(0u, 1u, &geometryVertexBuffer, &vertexBufferOffset);
+        statistics.vertexBufferBindCount++;
+
+        // Instance groups come first in the draw list, then the visible render objects.
+        const size_t instanceGroupCount = m_instanceGroups.size();
+
+        const size_t firstInstanceGroup = std::min(firstDraw, instanceGroupCount);
+        const size_t lastInstanceGroup = std::min(lastDraw, instanceGroupCount);
+        drawInstanceGroups(cmd, std::span(m_instanceGroups).subspan(firstInstanceGroup, lastInstanceGroup - firstInstanceGroup), statistics);
+
+        const size_t firstObject = std::max(firstDraw, instanceGroupCount) - instanceGroupCount;
+        const size_t lastObject = std::max(lastDraw, instanceGroupCount) - instanceGroupCount;
+        drawRenderObjects(cmd, std::span(m_visibleObjectIndices).subspan(firstObject, lastObject - firstObject), meshletCullingContext, statistics);
+    }
+
+    void Engine::recordDrawsInParallel(const vk::CommandBuffer& cmd, const MeshletCullingContext& meshletCullingContext)
+    {
+        const FrameData& frameData = getCurrentFrameData();
+
+        const size_t drawCount = m_instanceGroups.size() + m_visibleObjectIndices.size();
+        const size_t recordingJobCount = std::min(frameData.secondaryCommandBuffers.size(), (drawCount + DRAWS_PER_RECORDING_JOB - 1u) / DRAWS_PER_RECORDING_JOB);
+        const size_t drawsPerJob = (drawCount + recordingJobCount - 1u) / recordingJobCount;
+
+        // Secondary command buffers executed inside a dynamic rendering instance must declare the formats of its attachments.
+        const vk::CommandBufferInheritanceRenderingInfo inheritanceRenderingInfo = {
+            .colorAttachmentCount = 1u,
+            .pColorAttachmentFormats = &m_swapchainImageFormat,
+            .depthAttachmentFormat = m_depthImageFormat,
+            .rasterizationSamples = vk::SampleCountFlagBits::e1,
+        };
+
+        const vk::CommandBufferInheritanceInfo inheritanceInfo = {
+            .pNext = &inheritanceRenderingInfo,
+        };
+
+        const vk::CommandBufferBeginInfo secondaryCommandBufferBeginInfo = {
+            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+            .pInheritanceInfo = &inheritanceInfo,
+        };
+
+        // Each job counts the commands it records separately, and the counts are summed once all jobs are done.
+        m_recordingJobStatistics.assign(recordingJobCount, RenderStatistics{});
+
+        // Each job records a contiguous chunk of the draw list into its own command buffer (from its own pool), so executing the command buffers
+        // in job order keeps the draw order. The previous use of the pools was by the frame whose fence has been waited on, so they can be reset.
+        m_jobSystem.parallelFor(recordingJobCount, [&](const size_t recordingJobIndex) {
+            const vk::CommandBuffer secondaryCommandBuffer = frameData.secondaryCommandBuffers[recordingJobIndex];
+
+            m_device.resetCommandPool(frameData.secondaryCommandPools[recordingJobIndex]);
+            secondaryCommandBuffer.begin(secondaryCommandBufferBeginInfo);
+
+            const size_t firstDraw = recordingJobIndex * drawsPerJob;
+            recordDraws(secondaryCommandBuffer,
+                        std::min(firstDraw, drawCount),
+                        std::min(firstDraw + drawsPerJob, drawCount),
+                        meshletCullingContext,
+                        m_recordingJobStatistics[recordingJobIndex]);
+
+            secondaryCommandBuffer.end();
+        });
+
+        for (const RenderStatistics& statistics : m_recordingJobStatistics)
+        {
+            m_renderStatistics += statistics;
+        }
+
+        cmd.executeCommands(static_cast<uint32_t>(recordingJobCount), frameData.secondaryCommandBuffers.data());
+    }
+
+    void Engine::dispatchGpuCulling(const vk::CommandBuffer& cmd, const Frustum& frustum, const math::XMMATRIX& viewProjectionMatrix, const float projectionScale)
+    {
+        FrameData& frameData = getCurrentFrameData();
+
+        // Model matrices are copied every frame, as any render object may have moved. Dequantization of compact positions is done by the vertex
+        // shader, so this is a plain copy.
+        const FrameArenaAllocation objectTransformAllocation =
+            frameData.uploadArena.allocate(static_cast<uint32_t>(m_renderObjects.size() * sizeof(math::XMMATRIX)), sizeof(math::XMMATRIX));
+
+        frameData.objectTransformOffset = objectTransformAllocation.offset;
+
+        math::XMMATRIX* objectTransforms = reinterpret_cast<math::XMMATRIX*>(objectTransformAllocation.data);
+        m_jobSystem.parallelForRange(m_renderObjects.size(), TRANSFORM_COPIES_PER_JOB, [&](const size_t firstObject, const size_t lastObject) {
+            for (const size_t objectIndex : std::views::iota(firstObject, lastObject))
+            {
+                objectTransforms[objectIndex] = m_renderObjects[objectIndex].transformData.modelMatrix;
+            }
+        });
+
+        GpuCullingConstants cullingConstants = {
+            .frustumPlanes = frustum.planes,
+            .projectionScale = projectionScale,
+            .lodErrorThreshold = m_config.lodErrorThreshold,
+            .drawItemCount = m_gpuDrivenScene.drawItemCount,
+        };
+
+        math::XMStoreFloat4(&cullingConstants.depthColumn, math::XMMatrixTranspose(viewProjectionMatrix).r[3]);
+
+        const std::array<vk::DescriptorSet, 2> descriptorSets = {frameData.globalDescriptorSet, frameData.gpuDrivenDescriptorSet};
+        const std::array<uint32_t, 2> dynamicOffsets = {frameData.sceneBufferOffset, frameData.objectTransformOffset};
+
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_gpuCullingPipeline);
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                               m_gpuCullingPipelineLayout,
+                               0u,
+                               static_cast<uint32_t>(descriptorSets.size()),
+                               descriptorSets.data(),
+                               static_cast<uint32_t>(dynamicOffsets.size()),
+                               dynamicOffsets.data());
+        cmd.pushConstants(m_gpuCullingPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0u, sizeof(GpuCullingConstants), &cullingConstants);
+        cmd.dispatch((m_gpuDrivenScene.drawItemCount + GPU_CULLING_GROUP_SIZE - 1u) / GPU_CULLING_GROUP_SIZE, 1u, 1u);
+
+        m_renderStatistics.pipelineBindCount++;
+        m_renderStatistics.descriptorSetBindCount++;
+        m_renderStatistics.pushConstantBytes += sizeof(GpuCullingConstants);
+        m_renderStatistics.dispatchCount++;
+    }
+
+    void Engine::drawIndirectBatches(const vk::CommandBuffer& cmd)
+    {
+        const FrameData& frameData = getCurrentFrameData();
+
+        const std::array<vk::DescriptorSet, 2> descriptorSets = {frameData.globalDescriptorSet, frameData.gpuDrivenDescriptorSet};
+        const std::array<uint32_t, 2> dynamicOffsets = {frameData.sceneBufferOffset, frameData.objectTransformOffset};
+
+        constexpr vk::DeviceSize indexBufferOffset = 0;
+        constexpr uint32_t drawCommandStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+        Material* lastMaterial = nullptr;
+
+        for (const uint32_t batchIndex : std::views::iota(0u, static_cast<uint32_t>(m_gpuDrivenScene.indirectDrawBatches.size())))
+        {
+            const IndirectDrawBatch& batch = m_gpuDrivenScene.indirectDrawBatches[batchIndex];
+
+            LUNAR_PROFILE_GPU_SCOPE(&m_profiler, cmd, "Indirect draw batch");
+
+            if (batch.material != lastMaterial)
+            {
+                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, batch.material->pipeline);
+                cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                       batch.material->pipelineLayout,
+                                       0u,
+                                       static_cast<uint32_t>(descriptorSets.size()),
+                                       descriptorSets.data(),
+                                       static_cast<uint32_t>(dynamicOffsets.size()),
+                                       dynamicOffsets.data());
+
+                lastMaterial = batch.material;
+
+                m_renderStatistics.pipelineBindCount++;
+                m_renderStatistics.descriptorSetBindCount++;
+            }
+            else
+            {
+                m_renderStatistics.skippedPipelineBindCount++;
+            }
+
+            cmd.bindIndexBuffer(m_geometryPool.getIndexBuffer(), indexBufferOffset, batch.indexType);
+            m_renderStatistics.indexBufferBindCount++;
+
+            cmd.drawIndexedIndirectCount(frameData.drawCommandBuffer.buffer,
+                                         static_cast<vk::DeviceSize>(batch.firstCommand) * drawCommandStride,
+                                         frameData.drawCountBuffer.buffer,
+                                         static_cast<vk::DeviceSize>(batchIndex) * sizeof(uint32_t),
+                                         batch.maxDrawCount,
+                                         drawCommandStride);
+
+            m_renderStatistics.drawCallCount++;
+            m_renderStatistics.indirectDrawCallCount++;
+        }
+    }
+
+    void Engine::drawVisibleMeshlets(const vk::CommandBuffer& cmd, const Submesh& submesh, const Mesh& mesh, const GeometryAllocation& geometryAllocation,
+                                     const math::XMMATRIX& modelMatrix, const MeshletCullingContext& meshletCullingContext, RenderStatistics& statistics) const
+    {
+        const float maxScale = getMaxScale(modelMatrix);
+
+        // Meshlets of a submesh are contiguous in the index buffer, so runs of visible meshlets are merged into a single draw.
+        IndexRange visibleRange{};
+
+        const auto flushVisibleRange = [&]() {
+            if (visibleRange.indexCount > 0u)
+            {
+                cmd.drawIndexed(visibleRange.indexCount,
+                                1u,
+                                geometryAllocation.baseIndex + visibleRange.firstIndex,
+                                static_cast<int32_t>(geometryAllocation.baseVertex + submesh.vertexOffset),
+                                0u);
+
+                statistics.drawCallCount++;
+                statistics.triangleCount += visibleRange.indexCount / 3u;
+            }
+
+            visibleRange = {};
+        };
+
+        for (const Meshlet& meshlet : std::span(mesh.meshlets).subspan(submesh.firstMeshlet, submesh.meshletCount))
+        {
+            if (isMeshletCulled(meshlet, modelMatrix, maxScale, meshletCullingContext))
+            {
+                flushVisibleRange();
+                continue;
+            }
+
+            if (visibleRange.indexCount == 0u)
+            {
+                visibleRange.firstIndex = meshlet.indexRange.firstIndex;
+            }
+
+            visibleRange.indexCount += meshlet.indexRange.indexCount;
+        }
+
+        flushVisibleRange();
+    }
+
+    Material* Engine::getMaterialForMesh(const Mesh& mesh)
+    {
+        return mesh.encoding.vertexFormat == VertexFormat::eCompact ? &m_materials["BaseMaterialCompact"] : &m_materials["BaseMaterial"];
+    }
+
+    void Engine::run()
+    {
+        // Initialize SDL and the graphics back end.
+        init();
+
+        // The heap allocations of every frame are counted (see RenderStatistics::heapAllocationCount).
+        AllocationTracker::setCurrentThreadTracked(true);
+
+        const bool benchmark = m_config.benchmarkFrameCount > 0u;
+        const uint64_t totalFrameCount = static_cast<uint64_t>(m_config.benchmarkWarmupFrameCount) + m_config.benchmarkFrameCount;
+
+        if (benchmark)
+        {
+            m_cpuFrameTimes.reserve(m_config.benchmarkFrameCount);
+            m_gpuFrameTimes.reserve(m_config.benchmarkFrameCount);
+
+            // Every frame draws the whole scene, so that results do not depend on how fast meshes are streamed in.
+            waitForStreamedMeshes();
+        }
+        else if (m_config.headless)
+        {
+            fatalError("Headless mode requires a non zero benchmark frame count.");
+        }
+
+        // Main run loop.
+        bool quit{false};
+        SDL_Event event{};
 
         while (!quit)
         {
-            while (SDL_PollEvent(&event))
+            // Job worker utilization is reported over the measured frames only.
+            if (benchmark && m_frameNumber == m_config.benchmarkWarmupFrameCount)
+            {
+                m_jobSystem.resetStatistics();
+            }
+
+            const auto frameStartTime = std::chrono::high_resolution_clock::now();
+
+            if (!m_config.headless)
             {
-                if (event.type == SDL_QUIT)
+                while (SDL_PollEvent(&event))
                 {
-                    quit = true;
+                    if (event.type == SDL_QUIT)
+                    {
+                        quit = true;
+                    }
+
+                    // Left click picks the render object under the cursor.
+                    if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT)
+                    {
+                        const std::optional<uint32_t> pickedObjectIndex =
+                            pickRenderObject(math::XMFLOAT2{static_cast<float>(event.button.x), static_cast<float>(event.button.y)});
+
+                        if (pickedObjectIndex.has_value())
+                        {
+                            std::cout << std::format("Picked render object {}.\n", *pickedObjectIndex);
+                        }
+                    }
+
+                    // G switches between the CPU and GPU driven draw paths.
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_g)
+                    {
+                        setGpuDrivenRendering(!m_config.gpuDrivenRendering);
+                        std::cout << (m_config.gpuDrivenRendering ? "GPU driven rendering enabled.\n" : "GPU driven rendering disabled.\n");
+
+                        // The passes of the frame change with the draw path.
+                        m_renderGraphDumpPending = true;
+                    }
+
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_m)
+                    {
+                        writeMemoryReport("memory_report.json");
+                    }
+
+                    const uint8_t* keyboardState = SDL_GetKeyboardState(nullptr);
+                    if (keyboardState[SDL_SCANCODE_ESCAPE])
+                    {
+                        quit = true;
+                    }
                 }
+            }
+
+            if constexpr (LUNAR_DEBUG)
+            {
+                AllocationTracker::resetCallSites();
+            }
+
+            const AllocationCounters allocationCountersBeforeFrame = AllocationTracker::getCounters();
+
+            render();
+
+            const AllocationCounters allocationCountersAfterFrame = AllocationTracker::getCounters();
+
+            const std::chrono::duration<double, std::milli> frameTime = std::chrono::high_resolution_clock::now() - frameStartTime;
+
+            m_renderStatistics.heapAllocationCount = allocationCountersAfterFrame.allocationCount - allocationCountersBeforeFrame.allocationCount;
+            m_renderStatistics.heapAllocatedBytes = allocationCountersAfterFrame.allocatedBytes - allocationCountersBeforeFrame.allocatedBytes;
 
-                const uint8_t* keyboardState = SDL_GetKeyboardState(nullptr);
-                if (keyboardState[SDL_SCANCODE_ESCAPE])
+            // Once warmed up, a frame only reuses memory (containers keep their capacity, jobs come from a pool...), so any allocation is a
+            // regression.
+            if (m_config.assertNoFrameAllocations && benchmark && m_frameNumber >= m_config.benchmarkWarmupFrameCount && m_renderStatistics.heapAllocationCount > 0u)
+            {
+                std::string message = std::format("Frame {} made {} heap allocations ({} bytes) after the warmup frames.",
+                                                  m_frameNumber,
+                                                  m_renderStatistics.heapAllocationCount,
+                                                  m_renderStatistics.heapAllocatedBytes);
+
+                if constexpr (LUNAR_DEBUG)
+                {
+                    for (const AllocationCallSite& callSite : AllocationTracker::getCallSites())
+                    {
+                        message += std::format("\n  {} : {} allocations, {} bytes", callSite.name, callSite.allocationCount, callSite.allocatedBytes);
+                    }
+                }
+                else
                 {
-                    quit = true;
+                    message += " Allocation call sites are only recorded in debug builds.";
                 }
+
+                fatalError(message);
             }
 
-            render();
+            m_telemetryWriter.push(TelemetryRecord{
+                .frameNumber = m_frameNumber,
+                .cpuFrameTimeMs = frameTime.count(),
+                .renderStatistics = m_renderStatistics,
+            });
+
+            if (benchmark && m_frameNumber >= m_config.benchmarkWarmupFrameCount)
+            {
+                m_cpuFrameTimes.push_back(frameTime.count());
+
+                m_visibleObjectCountSum += m_cullingStatistics.visibleCount;
+                m_culledObjectCountSum += m_cullingStatistics.culledCount;
+                m_renderStatisticsSum += m_renderStatistics;
+            }
 
             m_frameNumber++;
+
+            if (benchmark && m_frameNumber >= totalFrameCount)
+            {
+                quit = true;
+            }
+        }
+
+        if (benchmark)
+        {
+            reportBenchmarkResults();
         }
     }
 
     void Engine::render()
     {
+        LUNAR_PROFILE_SCOPE("render");
+        LUNAR_ALLOCATION_SCOPE("render");
+
         // Wait for the GPU to finish execution of commands previously submitted to the queue for this frame.
         vkCheck(m_device.waitForFences(1u, &getCurrentFrameData().renderFence, true, ONE_SECOND_IN_NANOSECOND));
 
+        // The timestamps written by the previous use of this frame data are now available.
+        readGpuFrameTime(getCurrentFrameData());
+
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.collectFrame(static_cast<uint32_t>(m_frameNumber % FRAME_COUNT));
+        }
+
+        // Frames do not allocate device memory, but other processes may, so the budgets are checked every frame.
+        m_memoryTracker.checkBudgets();
+
+        m_renderStatistics = {};
+        const uint64_t uploadedBytesBeforeFrame = m_uploadManager.getStatistics().uploadedBytes;
+
+        // The GPU is done with everything allocated from the upload arena by the previous use of this frame data.
+        getCurrentFrameData().uploadArena.reset();
+
+        // Upload the meshes loaded since the last frame, and submit the uploads recorded since then, so that they run on the transfer queue
+        // while this frame is recorded.
+        commitLoadedMeshes();
+        m_uploadManager.flush();
+
+        // Meshes whose upload has completed are acquired by this frame, and can be drawn from it on.
+        updateMeshResidency();
+
+        // Every frame up to the previous use of this frame data has completed, so geometry freed and objects retired during those frames can
+        // be released.
+        if (m_frameNumber >= FRAME_COUNT)
+        {
+            m_geometryPool.releaseCompletedFrees(m_frameNumber - FRAME_COUNT);
+            m_deferredDestructionQueue.collect(m_frameNumber - FRAME_COUNT);
+        }
+
+        // The GPU driven scene is only rebuilt while that path is used, and the frame never waits for a rebuild : the current buffers are drawn
+        // from until the uploads of the rebuilt ones have completed (they are then acquired by this frame, like meshes). A scene that changes
+        // again while a rebuild is uploading is rebuilt once that one has been swapped in.
+        if (m_config.gpuDrivenRendering)
+        {
+            if (m_gpuDrivenScenePending && m_uploadManager.isComplete(m_pendingGpuDrivenScene.uploadTicket))
+            {
+                swapGpuDrivenScene();
+            }
+
+            if (m_gpuDrivenSceneDirty && !m_gpuDrivenScenePending)
+            {
+                buildGpuDrivenScene();
+            }
+
+            if (getCurrentFrameData().gpuDrivenDescriptorSetDirty)
+            {
+                writeGpuDrivenDescriptorSet(getCurrentFrameData());
+            }
+        }
+
         // Reset fence.
         vkCheck(m_device.resetFences(1u, &getCurrentFrameData().renderFence));
 
@@ -645,201 +2121,514 @@ namespace lunar
         // Signal the presentation semaphore when image is acquired. Only after a image is acquired we can present the
         // rendered image. Block the main thread for the timeout duration if we cannot acquire swapchain image for
         // rendering.
+        // In headless mode, the offscreen target of the current frame is used instead.
         uint32_t swapchainImageIndex{};
-        vkCheck(m_device.acquireNextImageKHR(m_swapchain, ONE_SECOND_IN_NANOSECOND, getCurrentFrameData().presentationSemaphore, {}, &swapchainImageIndex));
+        if (!m_config.headless)
+        {
+            vkCheck(m_device.acquireNextImageKHR(m_swapchain, ONE_SECOND_IN_NANOSECOND, getCurrentFrameData().presentationSemaphore, {}, &swapchainImageIndex));
+        }
+
+        const vk::Image renderTargetImage = m_config.headless ? getCurrentFrameData().offscreenImage.image : m_swapchainImages[swapchainImageIndex];
+        const vk::ImageView renderTargetImageView = m_config.headless ? getCurrentFrameData().offscreenImageView : m_swapchainImageViews[swapchainImageIndex];
 
         getCurrentFrameData().graphicsCommandBuffer.reset();
 
         vk::CommandBuffer& cmd = getCurrentFrameData().graphicsCommandBuffer;
 
-        vk::CommandBufferBeginInfo commandBufferBeginInfo = {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
+        vk::CommandBufferBeginInfo commandBufferBeginInfo = {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
+
+        cmd.begin(commandBufferBeginInfo);
+
+        // Uploads that have completed since the last frame can be used from this frame on.
+        const uint64_t uploadTimelineValue = m_uploadManager.acquireCompletedUploads(cmd);
+
+        if (m_gpuTimestampsSupported)
+        {
+            cmd.resetQueryPool(getCurrentFrameData().timestampQueryPool, 0u, 2u);
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, getCurrentFrameData().timestampQueryPool, 0u);
+        }
+
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.beginFrame(cmd, static_cast<uint32_t>(m_frameNumber % FRAME_COUNT), m_frameNumber);
+        }
+
+        // Setup scene buffer data.
+        static const math::XMVECTOR eyePosition = math::XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f);
+        static const math::XMVECTOR targetPosition = math::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+        static const math::XMVECTOR upDirection = math::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+        const math::XMMATRIX projectionMatrix =
+            math::XMMatrixPerspectiveFovLH(math::XMConvertToRadians(45.0f), (float)m_windowExtent.width / (float)m_windowExtent.height, 0.1f, 100.0f);
+
+        const SceneBufferData sceneBufferData = {
+            .viewProjectionMatrix = math::XMMatrixLookAtLH(eyePosition, targetPosition, upDirection) * projectionMatrix,
+        };
+
+        // Update scene buffer.
+        getCurrentFrameData().sceneBufferOffset = getCurrentFrameData().uploadArena.push(sceneBufferData);
+
+        // Update transform buffers (WILL BE MOVED SOON).
+
+        // Triangle transform buffer.
+        setRenderObjectTransform(0u, math::XMMatrixRotationY(sin(m_frameNumber / 120.0f)) * math::XMMatrixTranslation(-2.0f, 0.0f, 0.0f));
+
+        // Suzanne transform buffer.
+        setRenderObjectTransform(1u, math::XMMatrixRotationY((m_frameNumber / 60.0f)) * math::XMMatrixTranslation(2.0f, 0.0f, 0.0f));
+
+        m_sceneBvh.refit();
+        m_viewProjectionMatrix = sceneBufferData.viewProjectionMatrix;
+
+        const float projectionScale = math::XMVectorGetY(projectionMatrix.r[1]) * static_cast<float>(m_windowExtent.height) * 0.5f;
+
+        // Render objects are culled against the frustum, and the meshlets of objects drawn at full detail by their normal cone too.
+        MeshletCullingContext meshletCullingContext = {
+            .frustum = Frustum::fromViewProjection(sceneBufferData.viewProjectionMatrix),
+        };
+
+        math::XMStoreFloat3(&meshletCullingContext.cameraPosition, eyePosition);
+
+        // In the GPU driven path, culling and LOD selection are done by a compute shader (a pass of the render graph). The number of culled
+        // objects is not read back, so no culling statistics are reported.
+        if (m_config.gpuDrivenRendering)
+        {
+            m_cullingStatistics = {};
+        }
+        else
+        {
+            LUNAR_PROFILE_SCOPE("Culling");
+            LUNAR_ALLOCATION_SCOPE("Culling");
+
+            m_visibleObjectIndices.clear();
+
+            if (m_config.bvhCulling)
+            {
+                // Only the subtrees that intersect the frustum are visited. The results are sorted so that draws are recorded in render object
+                // order, which keeps objects that share a material together.
+                m_sceneBvh.queryFrustum(meshletCullingContext.frustum, m_visibleObjectIndices);
+
+                std::sort(m_visibleObjectIndices.begin(), m_visibleObjectIndices.end());
+            }
+            else
+            {
+                // Frustum cull all render objects (a batch of objects at a time). Each job transforms the bounds of, and culls, its own range of
+                // culling batches.
+                m_frustumCuller.resize(m_renderObjects.size());
+
+                const size_t cullingBatchCount = (m_renderObjects.size() + FrustumCuller::CULLING_BATCH_SIZE - 1u) / FrustumCuller::CULLING_BATCH_SIZE;
+                m_jobSystem.parallelForRange(cullingBatchCount, CULLING_BATCHES_PER_JOB, [&](const size_t firstBatch, const size_t lastBatch) {
+                    const size_t firstObject = firstBatch * FrustumCuller::CULLING_BATCH_SIZE;
+                    const size_t lastObject = std::min(lastBatch * FrustumCuller::CULLING_BATCH_SIZE, m_renderObjects.size());
+
+                    for (const size_t objectIndex : std::views::iota(firstObject, lastObject))
+                    {
+                        const RenderObject& renderObject = m_renderObjects[objectIndex];
+                        m_frustumCuller.setBounds(objectIndex, renderObject.transformData.modelMatrix, renderObject.mesh->boundingBox, renderObject.mesh->boundingSphere);
+                    }
+
+                    m_frustumCuller.cull(meshletCullingContext.frustum, firstObject, lastObject - firstObject);
+                });
+
+                for (const uint32_t objectIndex : std::views::iota(0u, static_cast<uint32_t>(m_renderObjects.size())))
+                {
+                    if (m_frustumCuller.isVisible(objectIndex))
+                    {
+                        m_visibleObjectIndices.push_back(objectIndex);
+                    }
+                }
+            }
+
+            // Render objects whose mesh is not resident yet are not drawn (they are counted as culled).
+            std::erase_if(m_visibleObjectIndices, [&](const uint32_t objectIndex) { return m_renderObjects[objectIndex].mesh->residency != MeshResidency::eResident; });
+
+            m_cullingStatistics = CullingStatistics{
+                .visibleCount = static_cast<uint32_t>(m_visibleObjectIndices.size()),
+                .culledCount = static_cast<uint32_t>(m_renderObjects.size() - m_visibleObjectIndices.size()),
+            };
+
+            // Select the LOD of the visible render objects.
+            m_jobSystem.parallelForRange(m_visibleObjectIndices.size(), LOD_SELECTIONS_PER_JOB, [&](const size_t firstIndex, const size_t lastIndex) {
+                for (const uint32_t objectIndex : std::span(m_visibleObjectIndices).subspan(firstIndex, lastIndex - firstIndex))
+                {
+                    m_renderObjects[objectIndex].lodIndex = selectLod(m_renderObjects[objectIndex], sceneBufferData.viewProjectionMatrix, projectionScale);
+                }
+            });
+
+            m_instanceGroups.clear();
+            if (m_config.instancing)
+            {
+                buildInstanceGroups();
+            }
+        }
+
+        // When there are enough draws, they are recorded into secondary command buffers by several jobs, and the render pass instance only
+        // executes them (its contents must then come from secondary command buffers only).
+        const size_t drawCount = m_instanceGroups.size() + m_visibleObjectIndices.size();
+        const bool recordDrawsInSecondaryCommandBuffers = !m_config.gpuDrivenRendering && m_config.parallelCommandRecording && drawCount > DRAWS_PER_RECORDING_JOB;
+
+        // Build the render graph of the frame. The graph records the barriers (and layout transitions) between the passes, and the render
+        // target's transition to presentation (or to a copyable layout in headless mode, so that the results can be read back if required).
+        m_renderGraph.reset();
+
+        // The render target is waited on (presentation semaphore) at the color attachment output stage, and its previous contents are discarded.
+        const RenderGraphResource renderTarget = m_renderGraph.importImage("RenderTarget",
+                                                                           renderTargetImage,
+                                                                           renderTargetImageView,
+                                                                           m_swapchainImageFormat,
+                                                                           m_windowExtent,
+                                                                           RenderGraphResourceState{.stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput},
+                                                                           m_config.headless ? RenderGraphUsage::eTransferSrc : RenderGraphUsage::ePresent);
+
+        const RenderGraphResource depthImage = m_renderGraph.createImage("Depth", m_depthImageFormat, m_windowExtent);
+
+        // In the GPU driven path, culling and LOD selection are done by a compute shader, which writes the draw commands and counts consumed
+        // by the indirect draws.
+        RenderGraphResource drawCommands{INVALID_U32};
+        RenderGraphResource drawCounts{INVALID_U32};
+
+        if (m_config.gpuDrivenRendering)
+        {
+            drawCommands = m_renderGraph.importBuffer("DrawCommands", getCurrentFrameData().drawCommandBuffer.buffer);
+            drawCounts = m_renderGraph.importBuffer("DrawCounts", getCurrentFrameData().drawCountBuffer.buffer);
+
+            // Reset the draw counts before the culling shader increments them.
+            m_renderGraph
+                .addPass("ClearDrawCounts", [&](const vk::CommandBuffer& cmd) { cmd.fillBuffer(getCurrentFrameData().drawCountBuffer.buffer, 0u, VK_WHOLE_SIZE, 0u); })
+                .use(drawCounts, RenderGraphUsage::eTransferDst);
+
+            m_renderGraph
+                .addPass("GpuCulling",
+                         [&](const vk::CommandBuffer& cmd) { dispatchGpuCulling(cmd, meshletCullingContext.frustum, sceneBufferData.viewProjectionMatrix, projectionScale); })
+                .use(drawCommands, RenderGraphUsage::eComputeStorageWrite)
+                .use(drawCounts, RenderGraphUsage::eComputeStorageWrite);
+        }
+
+        const vk::ClearValue colorImageClearValue = {.color = {std::array{0.0f, 0.0f, 0.0f, 1.0f}}};
+        const vk::ClearValue depthImageClearValue = {.depthStencil{
+            .depth = 1.0f,
+            .stencil = 1u,
+        }};
+
+        RenderGraphPass& forwardPass = m_renderGraph.addPass("Forward", [&](const vk::CommandBuffer& cmd) {
+            if (m_config.gpuDrivenRendering)
+            {
+                // All meshes share the geometry pool's vertex buffer, so it is bound once.
+                constexpr vk::DeviceSize vertexBufferOffset = 0;
+
+                const vk::Buffer geometryVertexBuffer = m_geometryPool.getVertexBuffer();
+                cmd.bindVertexBuffers(0u, 1u, &geometryVertexBuffer, &vertexBufferOffset);
+                m_renderStatistics.vertexBufferBindCount++;
+
+                drawIndirectBatches(cmd);
+            }
+            else if (recordDrawsInSecondaryCommandBuffers)
+            {
+                recordDrawsInParallel(cmd, meshletCullingContext);
+            }
+            else
+            {
+                recordDraws(cmd, 0u, drawCount, meshletCullingContext, m_renderStatistics);
+            }
+        });
+
+        forwardPass.colorAttachment(renderTarget, vk::AttachmentLoadOp::eClear, colorImageClearValue)
+            .depthAttachment(depthImage, vk::AttachmentLoadOp::eClear, depthImageClearValue);
+
+        if (m_config.gpuDrivenRendering)
+        {
+            forwardPass.use(drawCommands, RenderGraphUsage::eIndirectArgument).use(drawCounts, RenderGraphUsage::eIndirectArgument);
+        }
+
+        if (recordDrawsInSecondaryCommandBuffers)
+        {
+            forwardPass.secondaryCommandBuffers();
+        }
+
+        {
+            LUNAR_PROFILE_SCOPE("Render graph compilation");
+            LUNAR_ALLOCATION_SCOPE("Render graph compilation");
+            m_renderGraph.compile();
+        }
+
+        if (m_config.dumpRenderGraph && m_renderGraphDumpPending)
+        {
+            std::cout << m_renderGraph.getDebugDump();
+            m_renderGraphDumpPending = false;
+        }
+
+        {
+            LUNAR_ALLOCATION_SCOPE("Render graph execution");
+            m_renderGraph.execute(cmd, &m_profiler);
+        }
+
+        // Culling statistics are only set by the CPU path.
+        m_renderStatistics.visibleObjectCount = m_cullingStatistics.visibleCount;
+        m_renderStatistics.culledObjectCount = m_cullingStatistics.culledCount;
+        m_renderStatistics.uploadedBytes = m_uploadManager.getStatistics().uploadedBytes - uploadedBytesBeforeFrame;
+        m_renderStatistics.frameArenaBytes = getCurrentFrameData().uploadArena.getUsedSize();
+
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.endFrame(cmd);
+        }
+
+        if (m_gpuTimestampsSupported)
+        {
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, getCurrentFrameData().timestampQueryPool, 1u);
+            getCurrentFrameData().timestampFrameNumber = m_frameNumber;
+        }
+
+        cmd.end();
+
+        // The acquired uploads have already completed, so waiting on them does not stall the queue.
+        // Presentation semaphore is ready when the swapchain image is ready.
+        // In headless mode there is no swapchain image to wait on or present, so no binary semaphores are required.
+        const std::array<vk::SemaphoreSubmitInfo, 2> waitSemaphoreInfos = {
+            vk::SemaphoreSubmitInfo{
+                .semaphore = m_uploadManager.getTimelineSemaphore(),
+                .value = uploadTimelineValue,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+            },
+            vk::SemaphoreSubmitInfo{
+                .semaphore = getCurrentFrameData().presentationSemaphore,
+                .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            },
+        };
+
+        const vk::SemaphoreSubmitInfo signalSemaphoreInfo = {
+            .semaphore = getCurrentFrameData().renderSemaphore,
+            .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        };
+
+        const vk::CommandBufferSubmitInfo commandBufferSubmitInfo = {.commandBuffer = cmd};
+
+        const vk::SubmitInfo2 submitInfo = {
+            .waitSemaphoreInfoCount = m_config.headless ? 1u : 2u,
+            .pWaitSemaphoreInfos = waitSemaphoreInfos.data(),
+            .commandBufferInfoCount = 1u,
+            .pCommandBufferInfos = &commandBufferSubmitInfo,
+            .signalSemaphoreInfoCount = m_config.headless ? 0u : 1u,
+            .pSignalSemaphoreInfos = &signalSemaphoreInfo,
+        };
+
+        vkCheck(m_graphicsQueue.submit2(1u, &submitInfo, getCurrentFrameData().renderFence));
+
+        if (m_config.headless)
+        {
+            return;
+        }
+
+        // Setup for presentation.
+
+        // Wait for the render semaphore to be signaled (will happen after commands submitted to the queue is
+        // completed).
+        const vk::PresentInfoKHR presentInfo = {
+            .waitSemaphoreCount = 1u,
+            .pWaitSemaphores = &getCurrentFrameData().renderSemaphore,
+            .swapchainCount = 1u,
+            .pSwapchains = &m_swapchain,
+            .pImageIndices = &swapchainImageIndex,
+        };
+
+        vkCheck(m_graphicsQueue.presentKHR(presentInfo));
+    }
+
+    void Engine::readGpuFrameTime(FrameData& frameData)
+    {
+        if (!m_gpuTimestampsSupported || frameData.timestampFrameNumber == INVALID_U64)
+        {
+            return;
+        }
 
-        cmd.begin(commandBufferBeginInfo);
+        const uint64_t frameNumber = frameData.timestampFrameNumber;
+        frameData.timestampFrameNumber = INVALID_U64;
 
-        // Set clear values for the color image and the depth image.
-        const vk::ClearValue colorImageClearValue = {.color = {std::array{0.0f, 0.0f, 0.0f, 1.0f}}};
-        const vk::ClearValue depthImageClearValue = {.depthStencil{
-            .depth = 1.0f,
-            .stencil = 1u,
-        }};
+        if (m_config.benchmarkFrameCount == 0u || frameNumber < m_config.benchmarkWarmupFrameCount)
+        {
+            return;
+        }
 
-        // Start rendering.
+        std::array<uint64_t, 2u> timestamps{};
+        vkCheck(m_device.getQueryPoolResults(frameData.timestampQueryPool,
+                                             0u,
+                                             2u,
+                                             sizeof(uint64_t) * timestamps.size(),
+                                             timestamps.data(),
+                                             sizeof(uint64_t),
+                                             vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait));
+
+        // Timestamp period is the number of nanoseconds per timestamp tick. Bits above the valid bits of the queue are undefined.
+        const double gpuFrameTime = static_cast<double>(getTimestampDelta(timestamps[0], timestamps[1], m_timestampValidBits)) * m_timestampPeriod / 1'000'000.0;
+        m_gpuFrameTimes.push_back(gpuFrameTime);
+    }
 
-        // Transition image into writable format before rendering.
-        const vk::ImageSubresourceRange subresourceRange = {
-            .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .baseMipLevel = 0,
-            .levelCount = 1u,
-            .baseArrayLayer = 0u,
-            .layerCount = 1u,
-        };
+    void Engine::reportBenchmarkResults()
+    {
+        // The last few frames are still in flight, wait for them to complete so their GPU timestamps can be read back.
+        m_device.waitIdle();
 
-        const vk::ImageMemoryBarrier imageToAttachmentBarrier = {
-            .oldLayout = vk::ImageLayout::eUndefined,
-            .newLayout = vk::ImageLayout::eColorAttachmentOptimal,
-            .image = m_swapchainImages[swapchainImageIndex],
-            .subresourceRange = subresourceRange,
-        };
+        for (FrameData& frameData : m_frameData)
+        {
+            readGpuFrameTime(frameData);
+        }
 
-        // Before the color attachment output is required by pipeline, the image must transition into the
-        // colorAttachmentOutput format. Else, the pipeline stage execution will be blocked.
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eNone,
-                            vk::PipelineStageFlagBits::eColorAttachmentOutput,
-                            vk::DependencyFlagBits::eByRegion,
-                            0u,
-                            nullptr,
-                            0u,
-                            nullptr,
-                            1u,
-                            &imageToAttachmentBarrier);
-
-        // Specify rendering attachments (color and depth images).
-        const vk::RenderingAttachmentInfo colorAttachmentInfo = {
-            .imageView = m_swapchainImageViews[swapchainImageIndex],
-            .imageLayout = vk::ImageLayout::eAttachmentOptimal,
-            .loadOp = vk::AttachmentLoadOp::eClear,
-            .storeOp = vk::AttachmentStoreOp::eStore,
-            .clearValue = colorImageClearValue,
+        const double measuredFrameCount = static_cast<double>(std::max<size_t>(m_cpuFrameTimes.size(), 1u));
+
+        m_benchmarkResults = BenchmarkResults{
+            .initTimeMs = m_initTimeMs,
+            .pipelineCreationTimeMs = m_pipelineCreationTimeMs,
+            .pipelineCacheWarm = m_pipelineCacheWarm,
+            .frameCount = static_cast<uint32_t>(m_cpuFrameTimes.size()),
+            .cpuFrameTime = FrameTimeStatistics::compute(m_cpuFrameTimes),
+            .gpuFrameTime = FrameTimeStatistics::compute(m_gpuFrameTimes),
+            .averageVisibleObjectCount = static_cast<double>(m_visibleObjectCountSum) / measuredFrameCount,
+            .averageCulledObjectCount = static_cast<double>(m_culledObjectCountSum) / measuredFrameCount,
+            .totalRenderStatistics = m_renderStatisticsSum,
+            .jobWorkerStatistics = m_jobSystem.getStatistics(),
+            .transientMemoryStatistics = m_renderGraph.getTransientMemoryStatistics(),
         };
 
-        const vk::RenderingAttachmentInfo depthAttachmentInfo = {
-            .imageView = m_depthImageView,
-            .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
-            .loadOp = vk::AttachmentLoadOp::eClear,
-            .storeOp = vk::AttachmentStoreOp::eStore,
-            .clearValue = depthImageClearValue,
+        const auto printStatistics = [](const std::string_view name, const FrameTimeStatistics& statistics)
+        {
+            std::cout << std::format("{} : min {:.3f} ms, avg {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms\n", name, statistics.minMs, statistics.avgMs, statistics.p99Ms, statistics.maxMs);
         };
 
-        const vk::RenderingInfo renderingInfo = {
-            .renderArea =
-                {
-                    .offset = {0, 0},
-                    .extent = m_windowExtent,
-                },
-            .layerCount = 1u,
-            .viewMask = 0u,
-            .colorAttachmentCount = 1u,
-            .pColorAttachments = &colorAttachmentInfo,
-            .pDepthAttachment = &depthAttachmentInfo,
-        };
+        std::cout << std::format("Benchmark results ({} frames, {}x{}{}) :\n", m_benchmarkResults.frameCount, m_windowExtent.width, m_windowExtent.height, m_config.headless ? ", headless" : "");
+        std::cout << std::format("Startup : init {:.3f} ms, pipeline creation {:.3f} ms ({} pipeline cache)\n",
+                                 m_benchmarkResults.initTimeMs,
+                                 m_benchmarkResults.pipelineCreationTimeMs,
+                                 m_benchmarkResults.pipelineCacheWarm ? "warm" : "cold");
+        printStatistics("CPU frame time", m_benchmarkResults.cpuFrameTime);
 
-        cmd.beginRendering(renderingInfo);
+        if (m_gpuTimestampsSupported)
+        {
+            printStatistics("GPU frame time", m_benchmarkResults.gpuFrameTime);
+        }
 
-        // Setup scene buffer data.
-        static const math::XMVECTOR eyePosition = math::XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f);
-        static const math::XMVECTOR targetPosition = math::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-        static const math::XMVECTOR upDirection = math::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+        if (!m_config.gpuDrivenRendering)
+        {
+            std::cout << std::format("Frustum culling : avg {:.1f} visible, {:.1f} culled render objects per frame\n",
+                                     m_benchmarkResults.averageVisibleObjectCount,
+                                     m_benchmarkResults.averageCulledObjectCount);
+        }
 
-        const SceneBufferData sceneBufferData = {
-            .viewProjectionMatrix = math::XMMatrixLookAtLH(eyePosition, targetPosition, upDirection) *
-                                    math::XMMatrixPerspectiveFovLH(math::XMConvertToRadians(45.0f), (float)m_windowExtent.width / (float)m_windowExtent.height, 0.1f, 100.0f),
-        };
+        const RenderStatistics& renderStatistics = m_benchmarkResults.totalRenderStatistics;
+        std::cout << std::format("Render statistics : avg {:.1f} draws ({:.1f} indirect), {:.1f} triangles, {:.1f} pipeline binds ({:.1f} skipped), {:.1f} index buffer "
+                                 "binds ({:.1f} skipped) per frame\n",
+                                 static_cast<double>(renderStatistics.drawCallCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.indirectDrawCallCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.triangleCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.pipelineBindCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.skippedPipelineBindCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.indexBufferBindCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.skippedIndexBufferBindCount) / measuredFrameCount);
+        std::cout << std::format("Heap allocations : avg {:.1f} allocations ({:.1f} bytes) per frame\n",
+                                 static_cast<double>(renderStatistics.heapAllocationCount) / measuredFrameCount,
+                                 static_cast<double>(renderStatistics.heapAllocatedBytes) / measuredFrameCount);
+
+        for (const size_t workerIndex : std::views::iota(0u, m_benchmarkResults.jobWorkerStatistics.size()))
+        {
+            const JobWorkerStatistics& statistics = m_benchmarkResults.jobWorkerStatistics[workerIndex];
+            std::cout << std::format("Job worker {} : {:.1f} % utilization, {} jobs ({} stolen)\n",
+                                     workerIndex,
+                                     statistics.utilization * 100.0,
+                                     statistics.executedJobCount,
+                                     statistics.stolenJobCount);
+        }
 
-        // Update scene buffer.
-        void* data{};
-        vkCheck(vmaMapMemory(m_vmaAllocator, getCurrentFrameData().sceneBuffer.allocation, &data));
-        std::memcpy(data, &sceneBufferData, sizeof(SceneBufferData));
-        vmaUnmapMemory(m_vmaAllocator, getCurrentFrameData().sceneBuffer.allocation);
+        constexpr double bytesPerMegabyte = 1024.0 * 1024.0;
 
-        // Update transform buffers (WILL BE MOVED SOON).
+        const TransientMemoryStatistics& transientMemoryStatistics = m_benchmarkResults.transientMemoryStatistics;
+        std::cout << std::format("Transient images : {} images in {} memory slots, {:.2f} MB allocated ({:.2f} MB lazily allocated), {:.2f} MB saved (peak {:.2f} MB)\n",
+                                 transientMemoryStatistics.imageCount,
+                                 transientMemoryStatistics.memorySlotCount,
+                                 static_cast<double>(transientMemoryStatistics.allocatedBytes) / bytesPerMegabyte,
+                                 static_cast<double>(transientMemoryStatistics.lazilyAllocatedBytes) / bytesPerMegabyte,
+                                 static_cast<double>(transientMemoryStatistics.savedBytes) / bytesPerMegabyte,
+                                 static_cast<double>(transientMemoryStatistics.peakSavedBytes) / bytesPerMegabyte);
+    }
 
-        // Triangle transform buffer.
-        m_renderObjects[0].transformBuffer.bufferData.modelMatrix = math::XMMatrixRotationY(sin(m_frameNumber / 120.0f)) * math::XMMatrixTranslation(-2.0f, 0.0f, 0.0f);
+    void Engine::savePipelineCache()
+    {
+        if (!m_pipelineCache)
+        {
+            return;
+        }
 
-        // Suzanne transform buffer.
-        m_renderObjects[1].transformBuffer.bufferData.modelMatrix = math::XMMatrixRotationY((m_frameNumber / 60.0f)) * math::XMMatrixTranslation(2.0f, 0.0f, 0.0f);
+        const std::vector<uint8_t> pipelineCacheData = m_device.getPipelineCacheData(m_pipelineCache);
 
-        // Update material and mesh only if the current render object's material / mesh is different from the one previously used.
-        // Useful as binding pipelines unnecessarily is not the most efficient.
-        Material* lastMaterial = nullptr;
-        Mesh* lastMesh = nullptr;
+        const PipelineCacheFileHeader fileHeader = {
+            .dataSize = pipelineCacheData.size(),
+            .dataHash = fnv1aHash(pipelineCacheData.data(), pipelineCacheData.size()),
+        };
 
-        for (const auto& renderObject : m_renderObjects)
-        {
-            if (renderObject.material != lastMaterial)
-            {
-                cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, renderObject.material->pipeline);
-                cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, renderObject.material->pipelineLayout, 0u, 1u, &getCurrentFrameData().globalDescriptorSet, 0u, nullptr);
+        // Write to a temporary file first and then rename, so that a crash while writing never leaves a partially written cache behind.
+        const std::filesystem::path pipelineCachePath = m_pipelineCachePath;
+        const std::filesystem::path temporaryPipelineCachePath = m_pipelineCachePath + ".tmp";
 
-                lastMaterial = renderObject.material;
-            }
+        std::error_code errorCode{};
+        std::filesystem::create_directories(pipelineCachePath.parent_path(), errorCode);
 
-            if (renderObject.mesh != lastMesh)
+        {
+            std::ofstream pipelineCacheFile{temporaryPipelineCachePath, std::ios::binary | std::ios::trunc};
+            if (!pipelineCacheFile.is_open())
             {
-                constexpr vk::DeviceSize vertexBufferOffset = 0;
-                constexpr vk::DeviceSize indexBufferOffset = 0;
-
-                cmd.bindVertexBuffers(0u, renderObject.mesh->vertexBuffer.buffer, vertexBufferOffset);
-                cmd.bindIndexBuffer(renderObject.mesh->indexBuffer.buffer, indexBufferOffset, vk::IndexType::eUint32);
-
-                lastMesh = renderObject.mesh;
+                std::cout << "Failed to write pipeline cache : " << m_pipelineCachePath << '\n';
+                return;
             }
 
-            cmd.pushConstants(lastMaterial->pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0u, sizeof(TransformBufferData), &renderObject.transformBuffer.bufferData);
-            cmd.drawIndexed(lastMesh->indicesCount, 1u, 0u, 0u, 0u);
+            pipelineCacheFile.write(reinterpret_cast<const char*>(&fileHeader), sizeof(PipelineCacheFileHeader));
+            pipelineCacheFile.write(reinterpret_cast<const char*>(pipelineCacheData.data()), pipelineCacheData.size());
         }
 
-        cmd.endRendering();
+        std::filesystem::rename(temporaryPipelineCachePath, pipelineCachePath, errorCode);
+    }
 
-        // Transition image to presentable format.
-        const vk::ImageMemoryBarrier attachmentToPresentationBarrier = {
-            .oldLayout = vk::ImageLayout::eColorAttachmentOptimal,
-            .newLayout = vk::ImageLayout::ePresentSrcKHR,
-            .image = m_swapchainImages[swapchainImageIndex],
-            .subresourceRange = subresourceRange,
-        };
+    void Engine::cleanup()
+    {
+        // Cleanup is done in the reverse order of creation.
+        m_device.waitIdle();
+        m_graphicsQueue.waitIdle();
+        m_transferQueue.waitIdle();
 
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
-                            vk::PipelineStageFlagBits::eNone,
-                            vk::DependencyFlagBits::eByRegion,
-                            0u,
-                            nullptr,
-                            0u,
-                            nullptr,
-                            1u,
-                            &attachmentToPresentationBarrier);
+        m_telemetryWriter.close();
 
-        cmd.end();
+        // Write the trace of a capture that has not recorded all of its frames yet.
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.endCapture();
+        }
 
-        // ???
-        const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        savePipelineCache();
 
-        // Presentation semaphore is ready when the swapchain image is ready.
-        const vk::SubmitInfo submitInfo = {
-            .waitSemaphoreCount = 1u,
-            .pWaitSemaphores = &getCurrentFrameData().presentationSemaphore,
-            .pWaitDstStageMask = &waitStage,
-            .commandBufferCount = 1u,
-            .pCommandBuffers = &cmd,
-            .signalSemaphoreCount = 1u,
-            .pSignalSemaphores = &getCurrentFrameData().renderSemaphore,
-        };
+        // The device is idle, so every object owned by the engine (and those retired by frames that were still in flight) can be destroyed.
+        destroyGpuDrivenScene();
+        m_deferredDestructionQueue.flush();
 
-        vkCheck(m_graphicsQueue.submit(1u, &submitInfo, getCurrentFrameData().renderFence));
+        if constexpr (LUNAR_PROFILING)
+        {
+            m_profiler.destroy();
+        }
 
-        // Setup for presentation.
+        for (FrameData& frameData : m_frameData)
+        {
+            frameData.uploadArena.destroy();
+        }
 
-        // Wait for the render semaphore to be signaled (will happen after commands submitted to the queue is
-        // completed).
-        const vk::PresentInfoKHR presentInfo = {
-            .waitSemaphoreCount = 1u,
-            .pWaitSemaphores = &getCurrentFrameData().renderSemaphore,
-            .swapchainCount = 1u,
-            .pSwapchains = &m_swapchain,
-            .pImageIndices = &swapchainImageIndex,
-        };
+        m_uploadManager.destroy();
+        m_renderGraph.destroy();
+        m_geometryPool.destroy();
 
-        vkCheck(m_graphicsQueue.presentKHR(presentInfo));
-    }
+        vmaDestroyAllocator(m_vmaAllocator);
+        m_device.destroy();
 
-    void Engine::cleanup()
-    {
-        // Cleanup is done in the reverse order of creation. Handled by deletion queue.
-        m_device.waitIdle();
-        m_graphicsQueue.waitIdle();
-        m_transferQueue.waitIdle();
+        if (!m_config.headless)
+        {
+            m_instance.destroySurfaceKHR(m_surface);
+        }
 
-        m_deletionQueue.flush();
+        vkb::destroy_debug_utils_messenger(m_instance, m_debugMessenger, nullptr);
+        m_instance.destroy();
     }
 
     vk::ShaderModule Engine::createShaderModule(const std::string_view shaderPath)
@@ -872,42 +2661,18 @@ namespace lunar
         };
 
         const vk::ShaderModule shaderModule = m_device.createShaderModule(shaderModuleCreateInfo);
-        m_deletionQueue.pushFunction([=]() { m_device.destroyShaderModule(shaderModule); });
+        m_deferredDestructionQueue.destroyAtShutdown(shaderModule);
 
         return shaderModule;
     }
 
-    Buffer Engine::createGPUBuffer(const vk::BufferCreateInfo bufferCreateInfo, const void* data)
+    Buffer Engine::createGPUBuffer(const vk::BufferCreateInfo bufferCreateInfo, const std::string_view name, const void* data)
     {
         Buffer buffer{};
 
-        // if data is != nullptr, create a staging buffer and upload the data to a GPU only buffer.
+        // if data is != nullptr, upload the data to a GPU only buffer through the staging ring.
         if (data)
         {
-            // Create staging buffer (i.e in GPU / CPU shared memory).
-            const vk::BufferCreateInfo stagingBufferCreateInfo = {
-                .size = bufferCreateInfo.size,
-                .usage = vk::BufferUsageFlagBits::eTransferSrc,
-            };
-
-            const VmaAllocationCreateInfo stagingBufferAllocationCreateInfo = {.usage = VMA_MEMORY_USAGE_CPU_TO_GPU};
-
-            Buffer stagingBuffer{};
-
-            VkBuffer vkStagingBuffer{};
-
-            const VkBufferCreateInfo vkStagingBufferCreateInfo = stagingBufferCreateInfo;
-
-            vkCheck(vmaCreateBuffer(m_vmaAllocator, &vkStagingBufferCreateInfo, &stagingBufferAllocationCreateInfo, &vkStagingBuffer, &stagingBuffer.allocation, nullptr));
-
-            stagingBuffer.buffer = vkStagingBuffer;
-
-            // Get a pointer to this memory allocation and copy the data passed into the function to this allocation.
-            void* dataPtr{};
-            vkCheck(vmaMapMemory(m_vmaAllocator, stagingBuffer.allocation, &dataPtr));
-            std::memcpy(dataPtr, data, stagingBufferCreateInfo.size);
-            vmaUnmapMemory(m_vmaAllocator, stagingBuffer.allocation);
-
             // Create buffer (GPU only memory), that will be returned by the function.
 
             const VmaAllocationCreateInfo vmaAllocationCreateInfo = {.usage = VMA_MEMORY_USAGE_GPU_ONLY};
@@ -920,20 +2685,7 @@ namespace lunar
             buffer.buffer = vkBuffer;
 
             // Issue a copy command to transfer data for CPU - GPU shared memory to GPU only memory.
-            const vk::BufferCopy copyRegions = {
-                .srcOffset = 0u,
-                .dstOffset = 0u,
-                .size = bufferCreateInfo.size,
-            };
-
-            m_transferCommandBuffer.copyBuffer(stagingBuffer.buffer, buffer.buffer, 1u, &copyRegions);
-
-            m_uploadBufferDeletionQueue.pushFunction(
-                [=]()
-                {
-                    VkBuffer buffer = stagingBuffer.buffer;
-                    vmaDestroyBuffer(m_vmaAllocator, buffer, stagingBuffer.allocation);
-                });
+            copyToGPUBuffer(buffer.buffer, 0u, std::span(static_cast<const std::byte*>(data), bufferCreateInfo.size));
         }
 
         // if data is a nullptr, create a buffer in CPU / GPU shared memory.
@@ -948,28 +2700,12 @@ namespace lunar
             buffer.buffer = vkBuffer;
         }
 
-        m_deletionQueue.pushFunction([=]() { vmaDestroyBuffer(m_vmaAllocator, buffer.buffer, buffer.allocation); });
+        m_memoryTracker.track(buffer.allocation, MemoryCategory::eBuffer, name);
+        m_deferredDestructionQueue.destroyAtShutdown(buffer);
 
         return buffer;
     }
 
-    void Engine::uploadBuffers()
-    {
-
-        // Prepare for submission of transfer command buffer to execute all buffer copy commands.
-        m_transferCommandBuffer.end();
-
-        const vk::SubmitInfo transferSubmitInfo = {
-            .commandBufferCount = 1u,
-            .pCommandBuffers = &m_transferCommandBuffer,
-        };
-
-        m_transferQueue.submit(transferSubmitInfo);
-        m_transferQueue.waitIdle();
-
-        m_uploadBufferDeletionQueue.flush();
-    }
-
     vk::Pipeline Engine::createPipeline(const PipelineCreationDesc& pipelineCreationDesc, const vk::PipelineLayout& pipelineLayout)
     {
         // Setup state that will not be used for now and are not part of the pipeline creation desc.
@@ -1002,144 +2738,388 @@ namespace lunar
             .layout = pipelineLayout,
         };
 
-        const auto result = m_device.createGraphicsPipeline({}, graphicsPipelineCreateInfo);
+        const auto pipelineCreationStartTime = std::chrono::high_resolution_clock::now();
+
+        const auto result = m_device.createGraphicsPipeline(m_pipelineCache, graphicsPipelineCreateInfo);
         vkCheck(result.result);
 
+        const std::chrono::duration<double, std::milli> pipelineCreationTime = std::chrono::high_resolution_clock::now() - pipelineCreationStartTime;
+        m_pipelineCreationTimeMs += pipelineCreationTime.count();
+        m_pipelineCount++;
+
         const vk::Pipeline pipeline = result.value;
-        m_deletionQueue.pushFunction([=]() { m_device.destroyPipeline(pipeline); });
+        m_deferredDestructionQueue.destroyAtShutdown(pipeline);
 
         return pipeline;
     }
 
-    Mesh Engine::createMesh(const std::string_view modelPath)
+    Mesh Engine::createMesh(const std::string_view modelPath, const VertexFormat vertexFormat)
     {
-        // Use tinygltf loader to load the model.
+        LUNAR_PROFILE_SCOPE("createMesh");
 
-        const std::string fullModelPath = m_rootDirectory + modelPath.data();
+        return uploadLoadedMesh(loadMesh(modelPath, vertexFormat));
+    }
 
-        std::string warning{};
-        std::string error{};
+    LoadedMesh Engine::loadMesh(const std::string_view modelPath, const VertexFormat vertexFormat)
+    {
+        LUNAR_PROFILE_SCOPE("loadMesh");
+
+        const auto loadStartTime = std::chrono::high_resolution_clock::now();
 
-        tinygltf::TinyGLTF context{};
+        const std::string fullModelPath = m_rootDirectory + modelPath.data();
 
-        tinygltf::Model model{};
+        // Warm path : the mesh cache is mapped and the vertex / index blobs are copied straight into the staging ring when uploaded.
+        const std::string meshCachePath = getMeshCachePath(m_rootDirectory, modelPath, vertexFormat);
+        const uint64_t sourcePathHash = fnv1aHash(modelPath.data(), modelPath.size());
+        const uint64_t contentHash = computeMeshSourceHash(fullModelPath);
 
-        if (!context.LoadASCIIFromFile(&model, &error, &warning, fullModelPath))
+        if (std::optional<MeshCacheView> meshCache = openMeshCache(meshCachePath, sourcePathHash, contentHash))
         {
-            if (!error.empty())
-            {
-                fatalError(error);
-            }
+            const std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - loadStartTime;
+            std::cout << std::format("Loaded mesh {} ({} submeshes) from the mesh cache in {:.3f} ms.\n", modelPath, meshCache->submeshes.size(), loadTime.count());
 
-            if (!warning.empty())
-            {
-                fatalError(warning);
-            }
+            return LoadedMesh{.meshCache = std::move(meshCache)};
+        }
+
+        // Cold path : import the whole glTF scene (primitives are decoded in parallel), optimize it and encode it in the requested vertex format.
+        MeshData meshData = importGltfMesh(fullModelPath, m_jobSystem);
+
+        // Optimize the mesh before encoding, so that the mesh cache stores the optimized result.
+        const MeshOptimizationStatistics optimizationStatistics = optimizeMeshData(meshData, m_jobSystem);
+        std::cout << std::format("Optimized mesh {} : vertices {} -> {}, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}.\n", modelPath,
+                                 optimizationStatistics.vertexCountBefore, optimizationStatistics.vertexCountAfter, optimizationStatistics.before.acmr,
+                                 optimizationStatistics.after.acmr, optimizationStatistics.before.atvr, optimizationStatistics.after.atvr);
+
+        // LODs are generated from the optimized mesh, and only append indices.
+        generateMeshLods(meshData, m_jobSystem);
+
+        // Meshlets reorder the full detail index range, so they are built last.
+        buildMeshlets(meshData, m_jobSystem);
+
+        PackedMeshData packedMeshData = encodeMeshData(meshData, vertexFormat);
+
+        if (!writeMeshCache(meshCachePath, sourcePathHash, contentHash, packedMeshData))
+        {
+            std::cout << "Failed to write mesh cache : " << meshCachePath << '\n';
         }
 
-        // Build meshes.
-        const tinygltf::Scene& scene = model.scenes[model.defaultScene];
+        const std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - loadStartTime;
+        std::cout << std::format("Imported mesh {} ({} submeshes, {} LODs) in {:.3f} ms.\n", modelPath, packedMeshData.submeshes.size(),
+                                 packedMeshData.lodChain.lodCount, loadTime.count());
 
-        tinygltf::Node& node = model.nodes[0u];
-        node.mesh = std::max<int32_t>(0u, node.mesh);
+        const size_t fullSize = meshData.vertices.size() * sizeof(Vertex) + meshData.indices.size() * sizeof(uint32_t);
+        const size_t packedSize = packedMeshData.vertexData.size() + packedMeshData.indexData.size();
+        std::cout << std::format("Mesh {} vertex + index data : {} bytes ({:.1f}% of the full format).\n", modelPath, packedSize,
+                                 100.0 * static_cast<double>(packedSize) / static_cast<double>(std::max<size_t>(fullSize, 1u)));
 
-        const tinygltf::Mesh& nodeMesh = model.meshes[node.mesh];
+        return LoadedMesh{.packedMeshData = std::move(packedMeshData)};
+    }
 
-        // note(rtarun9) : for now have all vertices in single vertex buffer. Same for index buffer.
-        std::vector<Vertex> vertices{};
-        std::vector<uint32_t> indices{};
+    Mesh Engine::uploadLoadedMesh(const LoadedMesh& loadedMesh)
+    {
+        LUNAR_PROFILE_SCOPE("uploadLoadedMesh");
 
-        for (size_t i = 0; i < nodeMesh.primitives.size(); ++i)
+        if (loadedMesh.meshCache.has_value())
         {
+            const MeshCacheView& meshCache = *loadedMesh.meshCache;
+
+            Mesh mesh = uploadMesh(meshCache.encoding, meshCache.vertexData, meshCache.indexData, meshCache.submeshes);
+            mesh.lodChain = meshCache.lodChain;
+            mesh.boundingBox = meshCache.boundingBox;
+            mesh.boundingSphere = meshCache.boundingSphere;
+            mesh.meshlets.assign(meshCache.meshlets.begin(), meshCache.meshlets.end());
+
+            return mesh;
+        }
 
-            // Reference used :
-            // https://github.com/mateeeeeee/Adria-DX12/blob/fc98468095bf5688a186ca84d94990ccd2f459b0/Adria/Rendering/EntityLoader.cpp.
+        const PackedMeshData& packedMeshData = loadedMesh.packedMeshData;
 
-            // Get Accessors, buffer view and buffer for each attribute (position, textureCoord, normal).
-            tinygltf::Primitive primitive = nodeMesh.primitives[i];
-            const tinygltf::Accessor& indexAccesor = model.accessors[primitive.indices];
+        Mesh mesh = uploadMesh(packedMeshData.encoding, packedMeshData.vertexData, packedMeshData.indexData, packedMeshData.submeshes);
+        mesh.lodChain = packedMeshData.lodChain;
+        mesh.boundingBox = packedMeshData.boundingBox;
+        mesh.boundingSphere = packedMeshData.boundingSphere;
+        mesh.meshlets = packedMeshData.meshlets;
 
-            // Position data.
-            const tinygltf::Accessor& positionAccesor = model.accessors[primitive.attributes["POSITION"]];
-            const tinygltf::BufferView& positionBufferView = model.bufferViews[positionAccesor.bufferView];
-            const tinygltf::Buffer& positionBuffer = model.buffers[positionBufferView.buffer];
+        return mesh;
+    }
+
+    Mesh* Engine::requestMesh(const std::string_view meshName, const std::string_view modelPath, const VertexFormat vertexFormat)
+    {
+        const auto [meshIterator, inserted] = m_meshes.try_emplace(std::string(meshName));
+        Mesh* mesh = &meshIterator->second;
 
-            const int positionByteStride = positionAccesor.ByteStride(positionBufferView);
-            uint8_t const* const positions = &positionBuffer.data[positionBufferView.byteOffset + positionAccesor.byteOffset];
+        if (!inserted)
+        {
+            return mesh;
+        }
 
-            // TextureCoord data.
-            const tinygltf::Accessor& textureCoordAccesor = model.accessors[primitive.attributes["TEXCOORD_0"]];
-            const tinygltf::BufferView& textureCoordBufferView = model.bufferViews[textureCoordAccesor.bufferView];
-            const tinygltf::Buffer& textureCoordBuffer = model.buffers[textureCoordBufferView.buffer];
-            const int textureCoordBufferStride = textureCoordAccesor.ByteStride(textureCoordBufferView);
-            uint8_t const* const texcoords = &textureCoordBuffer.data[textureCoordBufferView.byteOffset + textureCoordAccesor.byteOffset];
+        // The vertex format is known up front, so render objects can pick their material before the mesh is loaded.
+        mesh->residency = MeshResidency::eLoading;
+        mesh->encoding.vertexFormat = vertexFormat;
+        mesh->loadRequestId = m_nextMeshLoadRequestId++;
 
-            // Normal data.
-            const tinygltf::Accessor& normalAccesor = model.accessors[primitive.attributes["NORMAL"]];
-            const tinygltf::BufferView& normalBufferView = model.bufferViews[normalAccesor.bufferView];
-            const tinygltf::Buffer& normalBuffer = model.buffers[normalBufferView.buffer];
-            const int normalByteStride = normalAccesor.ByteStride(normalBufferView);
-            uint8_t const* const normals = &normalBuffer.data[normalBufferView.byteOffset + normalAccesor.byteOffset];
+        m_meshLoadsInFlight++;
 
-            // Fill in the vertices's array.
-            for (size_t i : std::views::iota(0u, positionAccesor.count))
+        m_assetLoaderThreadPool.submit(
+            [this, meshName = std::string(meshName), loadRequestId = mesh->loadRequestId, modelPath = std::string(modelPath), vertexFormat]()
             {
-                const math::XMFLOAT3 position{(reinterpret_cast<float const*>(positions + (i * positionByteStride)))[0],
-                                              (reinterpret_cast<float const*>(positions + (i * positionByteStride)))[1],
-                                              (reinterpret_cast<float const*>(positions + (i * positionByteStride)))[2]};
+                StreamedMeshLoad streamedMeshLoad = {.meshName = meshName, .loadRequestId = loadRequestId};
 
-                const math::XMFLOAT2 textureCoord{
-                    (reinterpret_cast<float const*>(texcoords + (i * textureCoordBufferStride)))[0],
-                    (reinterpret_cast<float const*>(texcoords + (i * textureCoordBufferStride)))[1],
-                };
+                try
+                {
+                    streamedMeshLoad.loadedMesh = loadMesh(modelPath, vertexFormat);
+                }
+                catch (...)
+                {
+                    streamedMeshLoad.exception = std::current_exception();
+                }
 
-                const math::XMFLOAT3 normal{
-                    (reinterpret_cast<float const*>(normals + (i * normalByteStride)))[0],
-                    (reinterpret_cast<float const*>(normals + (i * normalByteStride)))[1],
-                    (reinterpret_cast<float const*>(normals + (i * normalByteStride)))[2],
-                };
+                {
+                    std::scoped_lock lock{m_loadedMeshesMutex};
+                    m_loadedMeshes.emplace_back(std::move(streamedMeshLoad));
+                }
+
+                m_loadedMeshesCondition.notify_one();
+            });
 
-                // note(rtarun9) : using normals as colors for now, until texture loading is implemented.
-                vertices.emplace_back(Vertex{position, normal, normal});
+        return mesh;
+    }
+
+    void Engine::commitLoadedMeshes()
+    {
+        LUNAR_PROFILE_SCOPE("commitLoadedMeshes");
+        LUNAR_ALLOCATION_SCOPE("commitLoadedMeshes");
+
+        std::vector<StreamedMeshLoad> loadedMeshes{};
+
+        {
+            std::scoped_lock lock{m_loadedMeshesMutex};
+            loadedMeshes.swap(m_loadedMeshes);
+        }
+
+        for (StreamedMeshLoad& streamedMeshLoad : loadedMeshes)
+        {
+            m_meshLoadsInFlight--;
+
+            // The mesh may have been destroyed while it was loading (and requested again, in which case this is the result of the earlier load).
+            const auto meshIterator = m_meshes.find(streamedMeshLoad.meshName);
+            if (meshIterator == m_meshes.end() || meshIterator->second.residency != MeshResidency::eLoading ||
+                meshIterator->second.loadRequestId != streamedMeshLoad.loadRequestId)
+            {
+                continue;
             }
 
-            // Get the index buffer data.
-            const tinygltf::BufferView& indexBufferView = model.bufferViews[indexAccesor.bufferView];
-            const tinygltf::Buffer& indexBuffer = model.buffers[indexBufferView.buffer];
-            const int indexByteStride = indexAccesor.ByteStride(indexBufferView);
-            uint8_t const* const indexes = indexBuffer.data.data() + indexBufferView.byteOffset + indexAccesor.byteOffset;
+            Mesh& mesh = meshIterator->second;
 
-            // Fill indices array.
-            for (size_t i : std::views::iota(0u, indexAccesor.count))
+            if (streamedMeshLoad.exception)
             {
-                if (indexAccesor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+                try
+                {
+                    std::rethrow_exception(streamedMeshLoad.exception);
+                }
+                catch (const std::exception& exception)
+                {
+                    std::cout << std::format("Failed to load mesh {} : {}\n", streamedMeshLoad.meshName, exception.what());
+                }
+                catch (...)
                 {
-                    indices.push_back(static_cast<uint32_t>((reinterpret_cast<uint16_t const*>(indexes + (i * indexByteStride)))[0]));
+                    std::cout << std::format("Failed to load mesh {} : unknown exception\n", streamedMeshLoad.meshName);
                 }
-                else if (indexAccesor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+
+                mesh.residency = MeshResidency::eFailed;
+                continue;
+            }
+
+            mesh = uploadLoadedMesh(streamedMeshLoad.loadedMesh);
+        }
+    }
+
+    void Engine::updateMeshResidency()
+    {
+        for (auto& [meshName, mesh] : m_meshes)
+        {
+            if (mesh.residency != MeshResidency::eUploading || !m_uploadManager.isComplete(mesh.uploadTicket))
+            {
+                continue;
+            }
+
+            mesh.residency = MeshResidency::eResident;
+
+            // The bounds of the mesh's render objects were unknown while it was loading.
+            for (const RenderObject& renderObject : m_renderObjects)
+            {
+                if (renderObject.mesh == &mesh)
                 {
-                    indices.push_back(static_cast<uint32_t>((reinterpret_cast<uint32_t const*>(indexes + (i * indexByteStride)))[0]));
+                    m_sceneBvh.update(renderObject.bvhLeaf, Aabb::fromBoundingBox(mesh.boundingBox, renderObject.transformData.modelMatrix));
                 }
             }
+
+            // The GPU driven path only has draw items for render objects whose mesh is resident.
+            m_gpuDrivenSceneDirty = true;
+        }
+    }
+
+    void Engine::waitForStreamedMeshes()
+    {
+        while (m_meshLoadsInFlight > 0u)
+        {
+            {
+                std::unique_lock lock{m_loadedMeshesMutex};
+                m_loadedMeshesCondition.wait(lock, [&]() { return !m_loadedMeshes.empty(); });
+            }
+
+            commitLoadedMeshes();
         }
 
+        m_uploadManager.wait(m_uploadManager.flush());
+    }
+
+    Mesh Engine::uploadMesh(const MeshEncoding& encoding, std::span<const std::byte> vertexData, std::span<const std::byte> indexData,
+                            std::span<const Submesh> submeshes)
+    {
+        LUNAR_PROFILE_SCOPE("uploadMesh");
+
         Mesh mesh{};
-        mesh.indicesCount = indices.size();
+        mesh.indicesCount = static_cast<uint32_t>(indexData.size_bytes() / encoding.getIndexStride());
+        mesh.encoding = encoding;
+        mesh.submeshes.assign(submeshes.begin(), submeshes.end());
+
+        const std::optional<GeometryHandle> geometryHandle =
+            m_geometryPool.allocate(vertexData.size_bytes(), encoding.getVertexStride(), indexData.size_bytes(), encoding.getIndexStride());
+        if (!geometryHandle.has_value())
+        {
+            fatalError("The geometry pool is full. Increase the geometry pool capacity in the engine config.");
+        }
+
+        mesh.geometryHandle = *geometryHandle;
+
+        const GeometryAllocation& geometryAllocation = m_geometryPool.getAllocation(mesh.geometryHandle);
+        copyToGPUBuffer(m_geometryPool.getVertexBuffer(), static_cast<vk::DeviceSize>(geometryAllocation.baseVertex) * geometryAllocation.vertexStride, vertexData);
+
+        // The index data is recorded last, so its ticket covers the vertex data too.
+        mesh.uploadTicket =
+            copyToGPUBuffer(m_geometryPool.getIndexBuffer(), static_cast<vk::DeviceSize>(geometryAllocation.baseIndex) * geometryAllocation.indexStride, indexData);
+        mesh.residency = MeshResidency::eUploading;
+
+        return mesh;
+    }
+
+    UploadTicket Engine::copyToGPUBuffer(const vk::Buffer buffer, const vk::DeviceSize offset, std::span<const std::byte> data)
+    {
+        // The copy is submitted with the next flush of the upload manager (at the latest, at the start of the next frame).
+        return m_uploadManager.uploadBuffer(buffer, offset, data);
+    }
+
+    std::optional<uint32_t> Engine::pickRenderObject(const math::XMFLOAT2& pixelPosition) const
+    {
+        // The ray goes from the pixel on the near plane to the pixel on the far plane (Direct3D clip space, y up and depth in [0, 1]).
+        const float x = pixelPosition.x / static_cast<float>(m_windowExtent.width) * 2.0f - 1.0f;
+        const float y = 1.0f - pixelPosition.y / static_cast<float>(m_windowExtent.height) * 2.0f;
+
+        const math::XMMATRIX inverseViewProjectionMatrix = math::XMMatrixInverse(nullptr, m_viewProjectionMatrix);
+
+        const math::XMVECTOR nearPosition = math::XMVector3TransformCoord(math::XMVectorSet(x, y, 0.0f, 1.0f), inverseViewProjectionMatrix);
+        const math::XMVECTOR farPosition = math::XMVector3TransformCoord(math::XMVectorSet(x, y, 1.0f, 1.0f), inverseViewProjectionMatrix);
+
+        math::XMFLOAT3 origin{};
+        math::XMFLOAT3 direction{};
+        math::XMStoreFloat3(&origin, nearPosition);
+        math::XMStoreFloat3(&direction, math::XMVectorSubtract(farPosition, nearPosition));
+
+        const std::optional<BvhRayHit> hit = m_sceneBvh.raycast(origin, direction, 1.0f);
+        if (!hit.has_value())
+        {
+            return std::nullopt;
+        }
+
+        return hit->userData;
+    }
 
-        const vk::BufferCreateInfo vertexBufferCreateInfo = {
-            .size = sizeof(Vertex) * vertices.size(),
-            .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+    void Engine::setRenderObjectTransform(const uint32_t objectIndex, const math::XMMATRIX& modelMatrix)
+    {
+        RenderObject& renderObject = m_renderObjects[objectIndex];
+        renderObject.transformData.modelMatrix = modelMatrix;
+
+        m_sceneBvh.update(renderObject.bvhLeaf, Aabb::fromBoundingBox(renderObject.mesh->boundingBox, modelMatrix));
+    }
+
+    void Engine::destroyMesh(const std::string_view meshName)
+    {
+        const auto meshIterator = m_meshes.find(std::string(meshName));
+        if (meshIterator == m_meshes.end())
+        {
+            return;
+        }
+
+        Mesh* mesh = &meshIterator->second;
+        std::erase_if(m_renderObjects, [&](const RenderObject& renderObject) { return renderObject.mesh == mesh; });
+
+        // The geometry must not be reused while it is still being uploaded to.
+        if (mesh->residency == MeshResidency::eUploading)
+        {
+            m_uploadManager.wait(mesh->uploadTicket);
+        }
+
+        // The remaining render objects may have moved to a lower index, and the BVH refers to them by index.
+        buildSceneBvh();
+
+        // The current frame may still be recorded with this mesh, so the geometry is released once it has completed. Meshes that are still
+        // loading have no geometry yet (their load result is dropped when it arrives).
+        if (mesh->geometryHandle != INVALID_U32)
+        {
+            m_geometryPool.free(mesh->geometryHandle, m_frameNumber);
+        }
+
+        m_meshes.erase(meshIterator);
+
+        invalidateGpuDrivenScene();
+    }
+
+    void Engine::defragmentGeometryPool()
+    {
+        // Uploads into the old buffers must have completed (and be acquired below) before they are copied out of.
+        m_uploadManager.wait(m_uploadManager.flush());
+        m_device.waitIdle();
+
+        // The geometry pool buffers are owned by the graphics queue family, so the copies are recorded on the graphics queue (the frame's
+        // command buffer is idle, and is reset before the next frame is recorded).
+        const vk::CommandBuffer cmd = getCurrentFrameData().graphicsCommandBuffer;
+        cmd.reset();
+
+        const vk::CommandBufferBeginInfo commandBufferBeginInfo = {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
+        cmd.begin(commandBufferBeginInfo);
+
+        const uint64_t uploadTimelineValue = m_uploadManager.acquireCompletedUploads(cmd);
+        const RetiredGeometryBuffers retiredBuffers = m_geometryPool.defragment(cmd);
+
+        cmd.end();
+
+        const vk::SemaphoreSubmitInfo waitSemaphoreInfo = {
+            .semaphore = m_uploadManager.getTimelineSemaphore(),
+            .value = uploadTimelineValue,
+            .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
         };
 
-        mesh.vertexBuffer = createGPUBuffer(vertexBufferCreateInfo, vertices.data());
+        const vk::CommandBufferSubmitInfo commandBufferSubmitInfo = {.commandBuffer = cmd};
 
-        const vk::BufferCreateInfo indexBufferCreateInfo = {
-            .size = sizeof(uint32_t) * indices.size(),
-            .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        const vk::SubmitInfo2 submitInfo = {
+            .waitSemaphoreInfoCount = 1u,
+            .pWaitSemaphoreInfos = &waitSemaphoreInfo,
+            .commandBufferInfoCount = 1u,
+            .pCommandBufferInfos = &commandBufferSubmitInfo,
         };
 
-        mesh.indexBuffer = createGPUBuffer(indexBufferCreateInfo, indices.data());
+        vkCheck(m_graphicsQueue.submit2(1u, &submitInfo, {}));
+        m_graphicsQueue.waitIdle();
 
-        return mesh;
+        m_geometryPool.destroyRetiredBuffers(retiredBuffers);
+
+        // The draw items of the GPU driven path hold the base vertex / base index of each mesh, which have changed.
+        invalidateGpuDrivenScene();
+
+        const GeometryPoolStatistics geometryPoolStatistics = m_geometryPool.getStatistics();
+        std::cout << std::format("Defragmented geometry pool : vertex fragmentation {:.3f}, index fragmentation {:.3f}.\n",
+                                 geometryPoolStatistics.vertexFragmentation,
+                                 geometryPoolStatistics.indexFragmentation);
     }
 }
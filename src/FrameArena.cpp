@@ -0,0 +1,63 @@
+#include "FrameArena.hpp"
+
+namespace lunar
+{
+    void FrameArena::init(const VmaAllocator allocator, MemoryTracker& memoryTracker, const uint32_t size, const vk::BufferUsageFlags usage, const uint32_t minAlignment)
+    {
+        m_allocator = allocator;
+        m_memoryTracker = &memoryTracker;
+        m_size = size;
+        m_minAlignment = std::max(minAlignment, 1u);
+
+        const vk::BufferCreateInfo bufferCreateInfo = {
+            .size = size,
+            .usage = usage,
+        };
+
+        // The buffer stays mapped for its whole lifetime, so writing per frame data is a plain memcpy. The memory must be host coherent, as
+        // the allocations are written all over the frame and never flushed.
+        const VmaAllocationCreateInfo vmaAllocationCreateInfo = {
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+
+        const VkBufferCreateInfo vkBufferCreateInfo = bufferCreateInfo;
+
+        VkBuffer vkBuffer{};
+        VmaAllocationInfo allocationInfo{};
+        vkCheck(vmaCreateBuffer(m_allocator, &vkBufferCreateInfo, &vmaAllocationCreateInfo, &vkBuffer, &m_allocation, &allocationInfo));
+        m_memoryTracker->track(m_allocation, MemoryCategory::ePerFrame, "Upload arena");
+
+        m_buffer = vkBuffer;
+        m_mappedData = static_cast<std::byte*>(allocationInfo.pMappedData);
+    }
+
+    void FrameArena::destroy()
+    {
+        m_memoryTracker->untrack(m_allocation);
+        vmaDestroyBuffer(m_allocator, m_buffer, m_allocation);
+
+        m_buffer = vk::Buffer{};
+        m_mappedData = nullptr;
+    }
+
+    FrameArenaAllocation FrameArena::allocate(const uint32_t size, const uint32_t alignment)
+    {
+        // Both alignments are powers of two, so the larger one is a multiple of the other.
+        const uint32_t allocationAlignment = std::max(alignment, m_minAlignment);
+        const uint32_t offset = (m_offset + allocationAlignment - 1u) & ~(allocationAlignment - 1u);
+
+        if (offset + static_cast<uint64_t>(size) > m_size)
+        {
+            fatalError(std::format("Frame arena of {} bytes cannot fit an allocation of {} bytes ({} bytes are used).", m_size, size, m_offset));
+        }
+
+        m_offset = offset + size;
+
+        return FrameArenaAllocation{
+            .offset = offset,
+            .data = m_mappedData + offset,
+        };
+    }
+}
@@ -0,0 +1,256 @@
+#include "GeometryPool.hpp"
+
+namespace lunar
+{
+    static constexpr uint64_t INDEX_ALLOCATION_ALIGNMENT = 4u;
+
+    void GeometryPool::init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker, const uint64_t vertexCapacity, const uint64_t indexCapacity)
+    {
+        m_device = device;
+        m_allocator = allocator;
+        m_memoryTracker = &memoryTracker;
+
+        m_vertexCapacity = vertexCapacity;
+        m_indexCapacity = indexCapacity;
+
+        m_vertexBuffer = createBuffer(m_vertexCapacity, vk::BufferUsageFlagBits::eVertexBuffer, MemoryCategory::eMeshVertex, "Geometry pool vertex buffer");
+        m_indexBuffer = createBuffer(m_indexCapacity, vk::BufferUsageFlagBits::eIndexBuffer, MemoryCategory::eMeshIndex, "Geometry pool index buffer");
+
+        m_vertexBlock = createVirtualBlock(m_vertexCapacity);
+        m_indexBlock = createVirtualBlock(m_indexCapacity);
+    }
+
+    void GeometryPool::destroy()
+    {
+        // Virtual blocks must be empty before they are destroyed.
+        vmaClearVirtualBlock(m_vertexBlock);
+        vmaClearVirtualBlock(m_indexBlock);
+
+        vmaDestroyVirtualBlock(m_vertexBlock);
+        vmaDestroyVirtualBlock(m_indexBlock);
+
+        destroyRetiredBuffers({.vertexBuffer = m_vertexBuffer, .indexBuffer = m_indexBuffer});
+
+        m_allocations.clear();
+        m_freeHandles.clear();
+        m_pendingFrees.clear();
+    }
+
+    std::optional<GeometryHandle> GeometryPool::allocate(const uint64_t vertexDataSize, const uint32_t vertexStride, const uint64_t indexDataSize,
+                                                         const uint32_t indexStride)
+    {
+        GeometryAllocation allocation{
+            .vertexDataSize = vertexDataSize,
+            .indexDataSize = indexDataSize,
+            .vertexStride = vertexStride,
+            .indexStride = indexStride,
+            .isAllocated = true,
+        };
+
+        const std::optional<uint64_t> vertexOffset = allocateAligned(m_vertexBlock, vertexDataSize, vertexStride, allocation.vertexAllocation);
+        if (!vertexOffset.has_value())
+        {
+            return std::nullopt;
+        }
+
+        const std::optional<uint64_t> indexOffset = allocateAligned(m_indexBlock, indexDataSize, INDEX_ALLOCATION_ALIGNMENT, allocation.indexAllocation);
+        if (!indexOffset.has_value())
+        {
+            vmaVirtualFree(m_vertexBlock, allocation.vertexAllocation);
+            return std::nullopt;
+        }
+
+        allocation.baseVertex = static_cast<uint32_t>(*vertexOffset / vertexStride);
+        allocation.baseIndex = static_cast<uint32_t>(*indexOffset / indexStride);
+
+        if (!m_freeHandles.empty())
+        {
+            const GeometryHandle handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+
+            m_allocations[handle] = allocation;
+            return handle;
+        }
+
+        m_allocations.emplace_back(allocation);
+        return static_cast<GeometryHandle>(m_allocations.size() - 1u);
+    }
+
+    void GeometryPool::free(const GeometryHandle handle, const uint64_t frameNumber) { m_pendingFrees.emplace_back(frameNumber, handle); }
+
+    void GeometryPool::releaseCompletedFrees(const uint64_t completedFrameNumber)
+    {
+        while (!m_pendingFrees.empty() && m_pendingFrees.front().first <= completedFrameNumber)
+        {
+            GeometryAllocation& allocation = m_allocations[m_pendingFrees.front().second];
+
+            vmaVirtualFree(m_vertexBlock, allocation.vertexAllocation);
+            vmaVirtualFree(m_indexBlock, allocation.indexAllocation);
+            allocation = GeometryAllocation{};
+
+            m_freeHandles.push_back(m_pendingFrees.front().second);
+            m_pendingFrees.pop_front();
+        }
+    }
+
+    RetiredGeometryBuffers GeometryPool::defragment(const vk::CommandBuffer commandBuffer)
+    {
+        releaseCompletedFrees(INVALID_U64);
+
+        const RetiredGeometryBuffers retiredBuffers = {
+            .vertexBuffer = m_vertexBuffer,
+            .indexBuffer = m_indexBuffer,
+        };
+
+        vmaClearVirtualBlock(m_vertexBlock);
+        vmaClearVirtualBlock(m_indexBlock);
+
+        m_vertexBuffer = createBuffer(m_vertexCapacity, vk::BufferUsageFlagBits::eVertexBuffer, MemoryCategory::eMeshVertex, "Geometry pool vertex buffer");
+        m_indexBuffer = createBuffer(m_indexCapacity, vk::BufferUsageFlagBits::eIndexBuffer, MemoryCategory::eMeshIndex, "Geometry pool index buffer");
+
+        // Re-allocate in order of the current vertex offsets, so the allocations are packed from the start of the (now empty) blocks.
+        std::vector<GeometryHandle> liveHandles{};
+        for (const GeometryHandle handle : std::views::iota(0u, static_cast<GeometryHandle>(m_allocations.size())))
+        {
+            if (m_allocations[handle].isAllocated)
+            {
+                liveHandles.push_back(handle);
+            }
+        }
+
+        std::sort(liveHandles.begin(), liveHandles.end(), [&](const GeometryHandle a, const GeometryHandle b) {
+            return static_cast<uint64_t>(m_allocations[a].baseVertex) * m_allocations[a].vertexStride <
+                   static_cast<uint64_t>(m_allocations[b].baseVertex) * m_allocations[b].vertexStride;
+        });
+
+        std::vector<vk::BufferCopy> vertexCopyRegions{};
+        std::vector<vk::BufferCopy> indexCopyRegions{};
+
+        for (const GeometryHandle handle : liveHandles)
+        {
+            GeometryAllocation& allocation = m_allocations[handle];
+
+            // The new blocks are the same size as the old ones and hold the same data, so these cannot fail.
+            const std::optional<uint64_t> vertexOffset = allocateAligned(m_vertexBlock, allocation.vertexDataSize, allocation.vertexStride, allocation.vertexAllocation);
+            const std::optional<uint64_t> indexOffset = allocateAligned(m_indexBlock, allocation.indexDataSize, INDEX_ALLOCATION_ALIGNMENT, allocation.indexAllocation);
+
+            if (!vertexOffset.has_value() || !indexOffset.has_value())
+            {
+                fatalError("Failed to re-allocate geometry during defragmentation.");
+            }
+
+            vertexCopyRegions.emplace_back(vk::BufferCopy{
+                .srcOffset = static_cast<uint64_t>(allocation.baseVertex) * allocation.vertexStride,
+                .dstOffset = *vertexOffset,
+                .size = allocation.vertexDataSize,
+            });
+
+            indexCopyRegions.emplace_back(vk::BufferCopy{
+                .srcOffset = static_cast<uint64_t>(allocation.baseIndex) * allocation.indexStride,
+                .dstOffset = *indexOffset,
+                .size = allocation.indexDataSize,
+            });
+
+            allocation.baseVertex = static_cast<uint32_t>(*vertexOffset / allocation.vertexStride);
+            allocation.baseIndex = static_cast<uint32_t>(*indexOffset / allocation.indexStride);
+        }
+
+        if (!vertexCopyRegions.empty())
+        {
+            commandBuffer.copyBuffer(retiredBuffers.vertexBuffer.buffer, m_vertexBuffer.buffer, static_cast<uint32_t>(vertexCopyRegions.size()), vertexCopyRegions.data());
+            commandBuffer.copyBuffer(retiredBuffers.indexBuffer.buffer, m_indexBuffer.buffer, static_cast<uint32_t>(indexCopyRegions.size()), indexCopyRegions.data());
+        }
+
+        return retiredBuffers;
+    }
+
+    void GeometryPool::destroyRetiredBuffers(const RetiredGeometryBuffers& retiredBuffers)
+    {
+        m_memoryTracker->untrack(retiredBuffers.vertexBuffer.allocation);
+        m_memoryTracker->untrack(retiredBuffers.indexBuffer.allocation);
+
+        vmaDestroyBuffer(m_allocator, retiredBuffers.vertexBuffer.buffer, retiredBuffers.vertexBuffer.allocation);
+        vmaDestroyBuffer(m_allocator, retiredBuffers.indexBuffer.buffer, retiredBuffers.indexBuffer.allocation);
+    }
+
+    GeometryPoolStatistics GeometryPool::getStatistics() const
+    {
+        VmaDetailedStatistics vertexStatistics{};
+        VmaDetailedStatistics indexStatistics{};
+
+        vmaCalculateVirtualBlockStatistics(m_vertexBlock, &vertexStatistics);
+        vmaCalculateVirtualBlockStatistics(m_indexBlock, &indexStatistics);
+
+        const auto getFragmentation = [](const VmaDetailedStatistics& statistics) {
+            const uint64_t freeBytes = statistics.statistics.blockBytes - statistics.statistics.allocationBytes;
+            if (freeBytes == 0u || statistics.unusedRangeCount == 0u)
+            {
+                return 0.0f;
+            }
+
+            return 1.0f - static_cast<float>(statistics.unusedRangeSizeMax) / static_cast<float>(freeBytes);
+        };
+
+        return GeometryPoolStatistics{
+            .allocationCount = vertexStatistics.statistics.allocationCount,
+            .vertexCapacity = m_vertexCapacity,
+            .vertexBytesUsed = vertexStatistics.statistics.allocationBytes,
+            .indexCapacity = m_indexCapacity,
+            .indexBytesUsed = indexStatistics.statistics.allocationBytes,
+            .vertexFragmentation = getFragmentation(vertexStatistics),
+            .indexFragmentation = getFragmentation(indexStatistics),
+        };
+    }
+
+    Buffer GeometryPool::createBuffer(const uint64_t size, const vk::BufferUsageFlags usage, const MemoryCategory category, const std::string_view name) const
+    {
+        // Transfer source, so that defragmentation can copy out of the buffers.
+        const vk::BufferCreateInfo bufferCreateInfo = {
+            .size = size,
+            .usage = usage | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+        };
+
+        const VmaAllocationCreateInfo vmaAllocationCreateInfo = {.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+
+        const VkBufferCreateInfo vkBufferCreateInfo = bufferCreateInfo;
+
+        Buffer buffer{};
+
+        VkBuffer vkBuffer{};
+        vkCheck(vmaCreateBuffer(m_allocator, &vkBufferCreateInfo, &vmaAllocationCreateInfo, &vkBuffer, &buffer.allocation, nullptr));
+        m_memoryTracker->track(buffer.allocation, category, name);
+
+        buffer.buffer = vkBuffer;
+
+        return buffer;
+    }
+
+    VmaVirtualBlock GeometryPool::createVirtualBlock(const uint64_t size) const
+    {
+        const VmaVirtualBlockCreateInfo virtualBlockCreateInfo = {.size = size};
+
+        VmaVirtualBlock virtualBlock{};
+        vkCheck(vmaCreateVirtualBlock(&virtualBlockCreateInfo, &virtualBlock));
+
+        return virtualBlock;
+    }
+
+    std::optional<uint64_t> GeometryPool::allocateAligned(const VmaVirtualBlock block, const uint64_t size, const uint64_t alignment, VmaVirtualAllocation& allocation)
+    {
+        // VMA only supports power of two alignments, so vertex strides like 36 bytes are handled by over allocating and rounding the offset up.
+        const bool powerOfTwoAlignment = (alignment & (alignment - 1u)) == 0u;
+
+        const VmaVirtualAllocationCreateInfo virtualAllocationCreateInfo = {
+            .size = powerOfTwoAlignment ? size : size + alignment - 1u,
+            .alignment = powerOfTwoAlignment ? alignment : 1u,
+        };
+
+        uint64_t offset{};
+        if (vmaVirtualAllocate(block, &virtualAllocationCreateInfo, &allocation, &offset) != VK_SUCCESS)
+        {
+            return std::nullopt;
+        }
+
+        return (offset + alignment - 1u) / alignment * alignment;
+    }
+}
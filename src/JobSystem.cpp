@@ -0,0 +1,613 @@
+#include "JobSystem.hpp"
+
+#include "AllocationTracker.hpp"
+
+namespace lunar
+{
+    struct Job
+    {
+        std::function<void()> function{};
+
+        // Dependencies that have not completed yet, plus one while the job is being scheduled (so that it is not queued before all its
+        // dependencies have been registered).
+        std::atomic<uint32_t> remainingDependencyCount{};
+
+        // Set by the thread that runs the job. A parallelFor helper can also be claimed by the thread that called parallelFor, which cancels
+        // it (the job is then skipped when it is dequeued, and never completes).
+        std::atomic<bool> started{false};
+        std::atomic<bool> completed{false};
+
+        // Set by threads that sleep in wait() until the job completes, so that completion only notifies when someone is waiting.
+        std::atomic<bool> hasWaiters{false};
+
+        std::exception_ptr exception{};
+
+        // Jobs that depend on this one, guarded by mutex (which also orders their registration against completion).
+        std::vector<JobHandle> continuations{};
+        std::mutex mutex{};
+    };
+
+    // Free list of the fixed size blocks that jobs (and their shared_ptr control blocks) are allocated from. Blocks are only returned to the
+    // heap when the pool is destroyed, so once the pool has as many blocks as there are jobs alive at once, scheduling a job does not allocate.
+    class JobPool
+    {
+      public:
+        static constexpr size_t BLOCK_SIZE = 256u;
+
+      public:
+        JobPool() = default;
+
+        ~JobPool()
+        {
+            while (m_freeBlocks)
+            {
+                FreeBlock* nextFreeBlock = m_freeBlocks->next;
+                ::operator delete(m_freeBlocks);
+                m_freeBlocks = nextFreeBlock;
+            }
+        }
+
+        JobPool(const JobPool&) = delete;
+        JobPool& operator=(const JobPool&) = delete;
+
+        void reserve(const size_t blockCount)
+        {
+            for (size_t i = 0; i < blockCount; ++i)
+            {
+                deallocate(::operator new(BLOCK_SIZE));
+            }
+        }
+
+        [[nodiscard]] void* allocate()
+        {
+            {
+                std::scoped_lock lock{m_mutex};
+                if (m_freeBlocks)
+                {
+                    FreeBlock* block = m_freeBlocks;
+                    m_freeBlocks = block->next;
+
+                    return block;
+                }
+            }
+
+            return ::operator new(BLOCK_SIZE);
+        }
+
+        void deallocate(void* block)
+        {
+            std::scoped_lock lock{m_mutex};
+            m_freeBlocks = ::new (block) FreeBlock{.next = m_freeBlocks};
+        }
+
+      private:
+        struct FreeBlock
+        {
+            FreeBlock* next{};
+        };
+
+        FreeBlock* m_freeBlocks{};
+        std::mutex m_mutex{};
+    };
+
+    namespace
+    {
+        // Allocator that std::allocate_shared uses for jobs. It is rebound to the type of the control block (which holds the job), and a copy
+        // of it is stored in the control block, which keeps the pool alive until the last handle to a job is released.
+        template <typename T> class JobAllocator
+        {
+          public:
+            using value_type = T;
+
+          public:
+            explicit JobAllocator(std::shared_ptr<JobPool> pool) : m_pool(std::move(pool)) {}
+            template <typename U> JobAllocator(const JobAllocator<U>& other) : m_pool(other.m_pool) {}
+
+            [[nodiscard]] T* allocate([[maybe_unused]] const size_t count)
+            {
+                static_assert(sizeof(T) <= JobPool::BLOCK_SIZE && alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Jobs do not fit in the blocks of the job pool.");
+
+                return static_cast<T*>(m_pool->allocate());
+            }
+
+            void deallocate(T* pointer, [[maybe_unused]] const size_t count) { m_pool->deallocate(pointer); }
+
+            template <typename U> [[nodiscard]] bool operator==(const JobAllocator<U>& other) const { return m_pool == other.m_pool; }
+
+          private:
+            template <typename U> friend class JobAllocator;
+
+            std::shared_ptr<JobPool> m_pool{};
+        };
+
+        // parallelFor schedules at most this many helper jobs (one per worker), so that their handles fit in an array.
+        constexpr size_t MAX_PARALLEL_FOR_HELPERS = 64u;
+
+        // Jobs preallocated per thread, enough for a few nested parallelFor calls to run at once without growing the pool mid frame.
+        constexpr size_t RESERVED_JOBS_PER_THREAD = 16u;
+
+        // Worker that the calling thread belongs to (a thread can only be a worker of one job system).
+        thread_local const JobSystem* currentJobSystem{};
+        thread_local uint32_t currentWorkerIndex{INVALID_U32};
+
+        [[nodiscard]] int64_t getTimeNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    JobSystem::JobSystem(const uint32_t workerCount)
+    {
+        m_statisticsResetTimeNs = getTimeNs();
+
+        m_jobPool = std::make_shared<JobPool>();
+        m_jobPool->reserve((workerCount + 1u) * RESERVED_JOBS_PER_THREAD);
+
+        // All workers are created before any thread starts, as workers steal from each other.
+        m_workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            m_workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            m_workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::scoped_lock lock{m_sleepMutex};
+            m_stopping = true;
+        }
+
+        m_sleepCondition.notify_all();
+
+        for (const std::unique_ptr<Worker>& worker : m_workers)
+        {
+            worker->thread.join();
+        }
+    }
+
+    JobHandle JobSystem::schedule(std::function<void()>&& function, std::span<const JobHandle> dependencies)
+    {
+        const JobHandle job = std::allocate_shared<Job>(JobAllocator<Job>{m_jobPool});
+        job->function = std::move(function);
+        job->remainingDependencyCount = static_cast<uint32_t>(dependencies.size()) + 1u;
+
+        for (const JobHandle& dependency : dependencies)
+        {
+            if (dependency)
+            {
+                std::scoped_lock lock{dependency->mutex};
+                if (!dependency->completed)
+                {
+                    dependency->continuations.push_back(job);
+                    continue;
+                }
+            }
+
+            --job->remainingDependencyCount;
+        }
+
+        if (--job->remainingDependencyCount == 0u)
+        {
+            enqueue(job);
+        }
+
+        return job;
+    }
+
+    void JobSystem::wait(const JobHandle& job)
+    {
+        if (!job)
+        {
+            return;
+        }
+
+        const uint32_t workerIndex = getCurrentWorkerIndex();
+
+        while (!job->completed)
+        {
+            if (const JobHandle otherJob = dequeue(workerIndex))
+            {
+                execute(otherJob);
+                continue;
+            }
+
+            // Nothing to help with : the job is running on another thread, or waiting for dependencies that are. Sleep until it completes or
+            // until more work is queued.
+            job->hasWaiters = true;
+
+            std::unique_lock lock{m_sleepMutex};
+            m_sleepCondition.wait(lock, [&]() { return job->completed || m_queuedJobCount > 0u; });
+        }
+
+        if (job->exception)
+        {
+            std::rethrow_exception(job->exception);
+        }
+    }
+
+    void JobSystem::parallelFor(const size_t count, const FunctionRef<void(size_t)> function)
+    {
+        if (count == 0u)
+        {
+            return;
+        }
+
+        // The calling thread waits for every helper job before returning, so the state can live on its stack. Helpers only capture its
+        // address, which fits in the inline storage of std::function, so scheduling them does not allocate.
+        struct ParallelForState
+        {
+            std::atomic<size_t> nextIndex{0u};
+            size_t count{};
+            FunctionRef<void(size_t)> function;
+
+            // Helpers count (and attribute) their allocations like the calling thread does.
+            bool allocationsTracked{};
+            const char* allocationScope{};
+
+            std::mutex exceptionMutex{};
+            std::exception_ptr exception{};
+        };
+
+        ParallelForState state{
+            .count = count,
+            .function = function,
+            .allocationsTracked = AllocationTracker::isCurrentThreadTracked(),
+            .allocationScope = AllocationTracker::getCurrentScope(),
+        };
+
+        const auto processIndices = [&state]() {
+            const bool allocationsTracked = AllocationTracker::isCurrentThreadTracked();
+            AllocationTracker::setCurrentThreadTracked(state.allocationsTracked);
+
+            const AllocationScope allocationScope{state.allocationScope};
+
+            for (size_t index = state.nextIndex++; index < state.count; index = state.nextIndex++)
+            {
+                try
+                {
+                    state.function(index);
+                }
+                catch (...)
+                {
+                    std::scoped_lock lock{state.exceptionMutex};
+                    if (!state.exception)
+                    {
+                        state.exception = std::current_exception();
+                    }
+                }
+            }
+
+            AllocationTracker::setCurrentThreadTracked(allocationsTracked);
+        };
+
+        const size_t helperCount = std::min({m_workers.size(), count - 1u, MAX_PARALLEL_FOR_HELPERS});
+
+        std::array<JobHandle, MAX_PARALLEL_FOR_HELPERS> helpers{};
+        for (size_t i = 0; i < helperCount; ++i)
+        {
+            helpers[i] = schedule(processIndices);
+        }
+
+        processIndices();
+
+        // Every index has been claimed, so helpers that have not started have nothing left to do and are cancelled. The calling thread only
+        // sleeps until the helpers that did start have completed (they are running on other threads), instead of executing other queued jobs
+        // like wait() does : those may be unrelated and long (ex the mesh processing of the asset loader threads), which would stall a frame.
+        bool helpersCancelled{false};
+
+        for (const JobHandle& helper : std::span(helpers).first(helperCount))
+        {
+            if (!helper->started.exchange(true))
+            {
+                helpersCancelled = true;
+                continue;
+            }
+
+            helper->hasWaiters = true;
+
+            std::unique_lock lock{m_sleepMutex};
+            m_completionCondition.wait(lock, [&]() { return helper->completed.load(); });
+        }
+
+        if (helpersCancelled)
+        {
+            removeCancelledJobs();
+        }
+
+        if (state.exception)
+        {
+            std::rethrow_exception(state.exception);
+        }
+    }
+
+    void JobSystem::parallelForRange(const size_t count, const size_t minRangeSize, const FunctionRef<void(size_t, size_t)> function)
+    {
+        if (count == 0u)
+        {
+            return;
+        }
+
+        // A few ranges per thread, so that threads that finish early can pick up the remaining ranges of slower ones.
+        constexpr size_t RANGES_PER_THREAD = 4u;
+
+        const size_t targetRangeCount = (m_workers.size() + 1u) * RANGES_PER_THREAD;
+        const size_t rangeSize = std::max({minRangeSize, (count + targetRangeCount - 1u) / targetRangeCount, size_t{1u}});
+
+        if (count <= rangeSize)
+        {
+            function(0u, count);
+            return;
+        }
+
+        const size_t rangeCount = (count + rangeSize - 1u) / rangeSize;
+
+        parallelFor(rangeCount, [&](const size_t rangeIndex) {
+            const size_t begin = rangeIndex * rangeSize;
+            function(begin, std::min(begin + rangeSize, count));
+        });
+    }
+
+    std::vector<JobWorkerStatistics> JobSystem::getStatistics() const
+    {
+        const double elapsedTimeNs = static_cast<double>(std::max<int64_t>(getTimeNs() - m_statisticsResetTimeNs, 1));
+
+        std::vector<JobWorkerStatistics> statistics{};
+        statistics.reserve(m_workers.size());
+
+        for (const std::unique_ptr<Worker>& worker : m_workers)
+        {
+            const double busyTimeNs = static_cast<double>(worker->busyTimeNs.load());
+
+            statistics.push_back(JobWorkerStatistics{
+                .executedJobCount = worker->executedJobCount,
+                .stolenJobCount = worker->stolenJobCount,
+                .busyTimeMs = busyTimeNs / 1'000'000.0,
+                .utilization = std::min(busyTimeNs / elapsedTimeNs, 1.0),
+            });
+        }
+
+        return statistics;
+    }
+
+    void JobSystem::resetStatistics()
+    {
+        for (const std::unique_ptr<Worker>& worker : m_workers)
+        {
+            worker->executedJobCount = 0u;
+            worker->stolenJobCount = 0u;
+            worker->busyTimeNs = 0u;
+        }
+
+        m_statisticsResetTimeNs = getTimeNs();
+    }
+
+    void JobSystem::workerLoop(const uint32_t workerIndex)
+    {
+        currentJobSystem = this;
+        currentWorkerIndex = workerIndex;
+
+        Worker& worker = *m_workers[workerIndex];
+
+        while (true)
+        {
+            if (const JobHandle job = dequeue(workerIndex))
+            {
+                const int64_t startTimeNs = getTimeNs();
+                execute(job);
+
+                worker.busyTimeNs += static_cast<uint64_t>(getTimeNs() - startTimeNs);
+                ++worker.executedJobCount;
+
+                continue;
+            }
+
+            std::unique_lock lock{m_sleepMutex};
+            m_sleepCondition.wait(lock, [this]() { return m_stopping || m_queuedJobCount > 0u; });
+
+            // Queued jobs are drained before stopping, as someone may be waiting for them.
+            if (m_stopping && m_queuedJobCount == 0u)
+            {
+                return;
+            }
+        }
+    }
+
+    void JobSystem::enqueue(JobHandle job)
+    {
+        const uint32_t workerIndex = getCurrentWorkerIndex();
+
+        if (workerIndex != INVALID_U32)
+        {
+            Worker& worker = *m_workers[workerIndex];
+
+            std::scoped_lock lock{worker.mutex};
+            worker.jobs.pushBack(std::move(job));
+        }
+        else
+        {
+            std::scoped_lock lock{m_injectedJobsMutex};
+            m_injectedJobs.pushBack(std::move(job));
+        }
+
+        ++m_queuedJobCount;
+
+        // Taking the lock orders the increment against sleeping threads checking their predicate, so that the wake up cannot be missed.
+        {
+            std::scoped_lock lock{m_sleepMutex};
+        }
+
+        m_sleepCondition.notify_one();
+    }
+
+    void JobSystem::removeCancelledJobs()
+    {
+        const uint32_t workerIndex = getCurrentWorkerIndex();
+
+        JobQueue& jobs = workerIndex != INVALID_U32 ? m_workers[workerIndex]->jobs : m_injectedJobs;
+        std::mutex& mutex = workerIndex != INVALID_U32 ? m_workers[workerIndex]->mutex : m_injectedJobsMutex;
+
+        // Jobs are only marked as started once they have left the queues, so a started job in a queue has been cancelled.
+        std::scoped_lock lock{mutex};
+        while (!jobs.empty() && jobs.back()->started)
+        {
+            const JobHandle job = jobs.popBack();
+            --m_queuedJobCount;
+        }
+    }
+
+    JobHandle JobSystem::dequeue(const uint32_t workerIndex)
+    {
+        if (m_queuedJobCount == 0u)
+        {
+            return nullptr;
+        }
+
+        JobHandle job{};
+
+        if (workerIndex != INVALID_U32)
+        {
+            Worker& worker = *m_workers[workerIndex];
+
+            std::scoped_lock lock{worker.mutex};
+            if (!worker.jobs.empty())
+            {
+                job = worker.jobs.popBack();
+            }
+        }
+
+        if (!job)
+        {
+            std::scoped_lock lock{m_injectedJobsMutex};
+            if (!m_injectedJobs.empty())
+            {
+                job = m_injectedJobs.popFront();
+            }
+        }
+
+        // Steal from the other workers, starting after the calling worker so that thieves spread out over the victims.
+        const size_t workerCount = m_workers.size();
+        const size_t firstVictim = workerIndex != INVALID_U32 ? workerIndex + 1u : 0u;
+
+        for (size_t i = 0; i < workerCount && !job; ++i)
+        {
+            const size_t victimIndex = (firstVictim + i) % workerCount;
+            if (victimIndex == workerIndex)
+            {
+                continue;
+            }
+
+            Worker& victim = *m_workers[victimIndex];
+
+            std::scoped_lock lock{victim.mutex};
+            if (!victim.jobs.empty())
+            {
+                job = victim.jobs.popFront();
+
+                if (workerIndex != INVALID_U32)
+                {
+                    ++m_workers[workerIndex]->stolenJobCount;
+                }
+            }
+        }
+
+        if (job)
+        {
+            --m_queuedJobCount;
+        }
+
+        return job;
+    }
+
+    void JobSystem::execute(const JobHandle& job)
+    {
+        // Cancelled parallelFor helper.
+        if (job->started.exchange(true))
+        {
+            return;
+        }
+
+        try
+        {
+            job->function();
+        }
+        catch (...)
+        {
+            job->exception = std::current_exception();
+        }
+
+        // The function may hold captures whose lifetime should not be extended by handles to the job.
+        job->function = nullptr;
+
+        std::vector<JobHandle> continuations{};
+        {
+            std::scoped_lock lock{job->mutex};
+            job->completed = true;
+            continuations.swap(job->continuations);
+        }
+
+        if (job->hasWaiters)
+        {
+            {
+                std::scoped_lock lock{m_sleepMutex};
+            }
+
+            m_sleepCondition.notify_all();
+            m_completionCondition.notify_all();
+        }
+
+        for (JobHandle& continuation : continuations)
+        {
+            if (--continuation->remainingDependencyCount == 0u)
+            {
+                enqueue(std::move(continuation));
+            }
+        }
+    }
+
+    void JobSystem::JobQueue::pushBack(JobHandle&& job)
+    {
+        if (m_size == m_jobs.size())
+        {
+            // Unrolls the ring into a buffer twice as large.
+            std::vector<JobHandle> jobs(std::max<size_t>(m_jobs.size() * 2u, 16u));
+            for (size_t i = 0; i < m_size; ++i)
+            {
+                jobs[i] = std::move(m_jobs[(m_front + i) % m_jobs.size()]);
+            }
+
+            m_jobs.swap(jobs);
+            m_front = 0u;
+        }
+
+        m_jobs[(m_front + m_size) % m_jobs.size()] = std::move(job);
+        ++m_size;
+    }
+
+    JobHandle JobSystem::JobQueue::popBack()
+    {
+        --m_size;
+
+        return std::move(m_jobs[(m_front + m_size) % m_jobs.size()]);
+    }
+
+    JobHandle JobSystem::JobQueue::popFront()
+    {
+        JobHandle job = std::move(m_jobs[m_front]);
+
+        m_front = (m_front + 1u) % m_jobs.size();
+        --m_size;
+
+        return job;
+    }
+
+    uint32_t JobSystem::getCurrentWorkerIndex() const
+    {
+        return currentJobSystem == this ? currentWorkerIndex : INVALID_U32;
+    }
+}
@@ -0,0 +1,139 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lunar
+{
+    MappedFile::MappedFile(const std::string_view filePath)
+    {
+        const std::string path{filePath};
+
+#ifdef _WIN32
+        const HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        m_fileHandle = fileHandle;
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            release();
+            return;
+        }
+
+        m_fileMappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+        if (!m_fileMappingHandle)
+        {
+            release();
+            return;
+        }
+
+        m_data = static_cast<const std::byte*>(MapViewOfFile(m_fileMappingHandle, FILE_MAP_READ, 0u, 0u, 0u));
+        if (!m_data)
+        {
+            release();
+            return;
+        }
+
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        m_fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (m_fileDescriptor < 0)
+        {
+            return;
+        }
+
+        struct stat fileStatus{};
+
+        if (fstat(m_fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+        {
+            release();
+            return;
+        }
+
+        void* mappedData = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+        if (mappedData == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+
+        m_data = static_cast<const std::byte*>(mappedData);
+        m_size = static_cast<size_t>(fileStatus.st_size);
+#endif
+    }
+
+    MappedFile::~MappedFile() { release(); }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0u);
+
+#ifdef _WIN32
+            m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+            m_fileMappingHandle = std::exchange(other.m_fileMappingHandle, nullptr);
+#else
+            m_fileDescriptor = std::exchange(other.m_fileDescriptor, -1);
+#endif
+        }
+
+        return *this;
+    }
+
+    void MappedFile::release()
+    {
+#ifdef _WIN32
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+        }
+
+        if (m_fileMappingHandle)
+        {
+            CloseHandle(m_fileMappingHandle);
+        }
+
+        if (m_fileHandle)
+        {
+            CloseHandle(m_fileHandle);
+        }
+
+        m_fileHandle = nullptr;
+        m_fileMappingHandle = nullptr;
+#else
+        if (m_data)
+        {
+            munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+
+        if (m_fileDescriptor >= 0)
+        {
+            close(m_fileDescriptor);
+        }
+
+        m_fileDescriptor = -1;
+#endif
+
+        m_data = nullptr;
+        m_size = 0u;
+    }
+}
@@ -0,0 +1,277 @@
+#include "MemoryTracker.hpp"
+
+namespace lunar
+{
+    namespace
+    {
+        // Escapes the characters that cannot appear as is in a JSON string (quotes, backslashes and control characters), ex in asset paths.
+        [[nodiscard]] std::string escapeJsonString(const std::string_view string)
+        {
+            std::string escapedString{};
+            escapedString.reserve(string.size());
+
+            for (const char character : string)
+            {
+                switch (character)
+                {
+                case '"':
+                    escapedString += "\\\"";
+                    break;
+                case '\\':
+                    escapedString += "\\\\";
+                    break;
+                case '\n':
+                    escapedString += "\\n";
+                    break;
+                case '\r':
+                    escapedString += "\\r";
+                    break;
+                case '\t':
+                    escapedString += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(character) < 0x20u)
+                    {
+                        escapedString += std::format("\\u{:04x}", static_cast<uint32_t>(character));
+                    }
+                    else
+                    {
+                        escapedString += character;
+                    }
+                    break;
+                }
+            }
+
+            return escapedString;
+        }
+    }
+
+    std::string_view getMemoryCategoryName(const MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::eMeshVertex:
+            return "Mesh vertex";
+        case MemoryCategory::eMeshIndex:
+            return "Mesh index";
+        case MemoryCategory::eStaging:
+            return "Staging";
+        case MemoryCategory::ePerFrame:
+            return "Per frame";
+        case MemoryCategory::eRenderTarget:
+            return "Render target";
+        case MemoryCategory::eTransientImage:
+            return "Transient image";
+        case MemoryCategory::eGpuDrivenScene:
+            return "GPU driven scene";
+        case MemoryCategory::eBuffer:
+            return "Buffer";
+        default:
+            break;
+        }
+
+        fatalError("Invalid memory category.");
+        return {};
+    }
+
+    void MemoryTracker::init(const VmaAllocator allocator, const bool memoryBudgetExtensionEnabled, const float budgetWarningThreshold)
+    {
+        m_allocator = allocator;
+        m_memoryBudgetExtensionEnabled = memoryBudgetExtensionEnabled;
+        m_budgetWarningThreshold = budgetWarningThreshold;
+    }
+
+    void MemoryTracker::track(const VmaAllocation allocation, const MemoryCategory category, const std::string_view name)
+    {
+        VmaAllocationInfo allocationInfo{};
+        vmaGetAllocationInfo(m_allocator, allocation, &allocationInfo);
+
+        vmaSetAllocationName(m_allocator, allocation, std::format("{} : {}", getMemoryCategoryName(category), name).c_str());
+
+        {
+            std::scoped_lock lock{m_mutex};
+
+            m_allocations.insert_or_assign(allocation,
+                                           TrackedAllocation{
+                                               .category = category,
+                                               .name = std::string(name),
+                                               .size = allocationInfo.size,
+                                           });
+
+            MemoryCategoryStatistics& statistics = m_categoryStatistics[static_cast<size_t>(category)];
+            statistics.allocationCount++;
+            statistics.bytes += allocationInfo.size;
+            statistics.peakBytes = std::max(statistics.peakBytes, statistics.bytes);
+        }
+
+        // New allocations are the only thing that moves usage closer to the budgets (apart from other processes).
+        checkBudgets();
+    }
+
+    void MemoryTracker::untrack(const VmaAllocation allocation)
+    {
+        std::scoped_lock lock{m_mutex};
+
+        const auto trackedAllocation = m_allocations.find(allocation);
+        if (trackedAllocation == m_allocations.end())
+        {
+            fatalError("Untracked allocation cannot be untracked.");
+            return;
+        }
+
+        MemoryCategoryStatistics& statistics = m_categoryStatistics[static_cast<size_t>(trackedAllocation->second.category)];
+        statistics.allocationCount--;
+        statistics.bytes -= trackedAllocation->second.size;
+
+        m_allocations.erase(trackedAllocation);
+    }
+
+    void MemoryTracker::checkBudgets()
+    {
+        const VkPhysicalDeviceMemoryProperties* memoryProperties{};
+        vmaGetMemoryProperties(m_allocator, &memoryProperties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetHeapBudgets(m_allocator, budgets.data());
+
+        std::scoped_lock lock{m_mutex};
+
+        for (const uint32_t heapIndex : std::views::iota(0u, memoryProperties->memoryHeapCount))
+        {
+            const VmaBudget& budget = budgets[heapIndex];
+            if (budget.budget == 0u)
+            {
+                continue;
+            }
+
+            const float usageRatio = static_cast<float>(budget.usage) / static_cast<float>(budget.budget);
+
+            if (usageRatio < m_budgetWarningThreshold - BUDGET_WARNING_HYSTERESIS)
+            {
+                m_budgetWarned[heapIndex] = false;
+            }
+            else if (usageRatio > m_budgetWarningThreshold && !m_budgetWarned[heapIndex])
+            {
+                m_budgetWarned[heapIndex] = true;
+
+                constexpr double bytesPerMegabyte = 1024.0 * 1024.0;
+                std::cout << std::format("Warning : memory heap {} is at {:.1f} % of its budget ({:.2f} MB used, {:.2f} MB budget, {:.2f} MB allocated by this "
+                                         "engine).\n",
+                                         heapIndex,
+                                         usageRatio * 100.0f,
+                                         static_cast<double>(budget.usage) / bytesPerMegabyte,
+                                         static_cast<double>(budget.budget) / bytesPerMegabyte,
+                                         static_cast<double>(budget.statistics.blockBytes) / bytesPerMegabyte);
+            }
+        }
+    }
+
+    MemoryCategoryStatistics MemoryTracker::getCategoryStatistics(const MemoryCategory category) const
+    {
+        std::scoped_lock lock{m_mutex};
+        return m_categoryStatistics[static_cast<size_t>(category)];
+    }
+
+    std::string MemoryTracker::buildReport() const
+    {
+        const VkPhysicalDeviceMemoryProperties* memoryProperties{};
+        vmaGetMemoryProperties(m_allocator, &memoryProperties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetHeapBudgets(m_allocator, budgets.data());
+
+        VmaTotalStatistics totalStatistics{};
+        vmaCalculateStatistics(m_allocator, &totalStatistics);
+
+        // Fragmentation of the free space of VMA's memory blocks : 0 if it is a single range, close to 1 if it is split in many small ranges.
+        const auto getFragmentation = [](const VmaDetailedStatistics& statistics) {
+            const uint64_t freeBytes = statistics.statistics.blockBytes - statistics.statistics.allocationBytes;
+            if (freeBytes == 0u || statistics.unusedRangeCount == 0u)
+            {
+                return 0.0f;
+            }
+
+            return 1.0f - static_cast<float>(statistics.unusedRangeSizeMax) / static_cast<float>(freeBytes);
+        };
+
+        std::string report = std::format(R"({{"memory_budget_extension": {}, "heaps": [)", m_memoryBudgetExtensionEnabled);
+
+        for (const uint32_t heapIndex : std::views::iota(0u, memoryProperties->memoryHeapCount))
+        {
+            const VmaBudget& budget = budgets[heapIndex];
+            const VmaDetailedStatistics& statistics = totalStatistics.memoryHeap[heapIndex];
+
+            report += std::format(R"({}{{"index": {}, "device_local": {}, "size": {}, "budget": {}, "usage": {}, "block_count": {}, "block_bytes": {}, )"
+                                  R"("allocation_count": {}, "allocation_bytes": {}, "unused_range_count": {}, "largest_unused_range": {}, "fragmentation": {:.4f}}})",
+                                  heapIndex == 0u ? "" : ", ",
+                                  heapIndex,
+                                  (memoryProperties->memoryHeaps[heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0u,
+                                  memoryProperties->memoryHeaps[heapIndex].size,
+                                  budget.budget,
+                                  budget.usage,
+                                  statistics.statistics.blockCount,
+                                  statistics.statistics.blockBytes,
+                                  statistics.statistics.allocationCount,
+                                  statistics.statistics.allocationBytes,
+                                  statistics.unusedRangeCount,
+                                  statistics.unusedRangeCount == 0u ? 0u : statistics.unusedRangeSizeMax,
+                                  getFragmentation(statistics));
+        }
+
+        report += R"(], "categories": [)";
+
+        {
+            std::scoped_lock lock{m_mutex};
+
+            for (const size_t categoryIndex : std::views::iota(size_t{0u}, m_categoryStatistics.size()))
+            {
+                const MemoryCategoryStatistics& statistics = m_categoryStatistics[categoryIndex];
+
+                report += std::format(R"({}{{"name": "{}", "allocation_count": {}, "bytes": {}, "peak_bytes": {}}})",
+                                      categoryIndex == 0u ? "" : ", ",
+                                      escapeJsonString(getMemoryCategoryName(static_cast<MemoryCategory>(categoryIndex))),
+                                      statistics.allocationCount,
+                                      statistics.bytes,
+                                      statistics.peakBytes);
+            }
+
+            report += R"(], "allocations": [)";
+
+            bool firstAllocation{true};
+            for (const TrackedAllocation& allocation : m_allocations | std::views::values)
+            {
+                report += std::format(R"({}{{"category": "{}", "name": "{}", "size": {}}})",
+                                      firstAllocation ? "" : ", ",
+                                      escapeJsonString(getMemoryCategoryName(allocation.category)),
+                                      escapeJsonString(allocation.name),
+                                      allocation.size);
+
+                firstAllocation = false;
+            }
+        }
+
+        // VMA's stats string is a JSON document of its own (with the names of the allocations in the detailed map).
+        char* vmaStatsString{};
+        vmaBuildStatsString(m_allocator, &vmaStatsString, VK_TRUE);
+
+        report += std::format(R"(], "vma": {}}})", vmaStatsString);
+        report += '\n';
+
+        vmaFreeStatsString(m_allocator, vmaStatsString);
+
+        return report;
+    }
+
+    void MemoryTracker::writeReport(const std::string_view path) const
+    {
+        std::ofstream reportFile{std::string(path)};
+        if (!reportFile.is_open())
+        {
+            fatalError(std::string("Failed to open memory report file : ") + std::string(path));
+        }
+
+        reportFile << buildReport();
+
+        std::cout << std::format("Memory report written to {}.\n", path);
+    }
+}
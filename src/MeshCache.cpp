@@ -0,0 +1,194 @@
+#include "MeshCache.hpp"
+
+namespace lunar
+{
+    static constexpr uint64_t MESH_CACHE_SECTION_ALIGNMENT = 16u;
+
+    static uint64_t alignUp(const uint64_t value, const uint64_t alignment) { return (value + alignment - 1u) & ~(alignment - 1u); }
+
+    std::string getMeshCachePath(const std::string_view rootDirectory, const std::string_view modelPath, const VertexFormat vertexFormat)
+    {
+        return std::format("{}cache/meshes/{:016x}_{}.lmesh", rootDirectory, fnv1aHash(modelPath.data(), modelPath.size()), vertexFormat == VertexFormat::eCompact ? "compact" : "full");
+    }
+
+    uint64_t computeMeshSourceHash(const std::string_view fullModelPath)
+    {
+        const std::filesystem::path modelPath{fullModelPath};
+
+        std::ifstream modelFile{modelPath, std::ios::ate | std::ios::binary};
+        if (!modelFile.is_open())
+        {
+            fatalError(std::string("Failed to open model file : ") + modelPath.string());
+        }
+
+        const size_t fileSize = static_cast<size_t>(modelFile.tellg());
+        modelFile.seekg(0);
+
+        std::vector<char> fileContents(fileSize);
+        modelFile.read(fileContents.data(), fileSize);
+
+        uint64_t hash = fnv1aHash(fileContents.data(), fileContents.size());
+
+        // The binary buffers are sorted by name so that the hash does not depend on directory iteration order.
+        std::vector<std::filesystem::path> bufferPaths{};
+        for (const auto& entry : std::filesystem::directory_iterator(modelPath.parent_path()))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".bin")
+            {
+                bufferPaths.emplace_back(entry.path());
+            }
+        }
+
+        std::sort(bufferPaths.begin(), bufferPaths.end());
+
+        for (const auto& bufferPath : bufferPaths)
+        {
+            const uint64_t bufferSize = std::filesystem::file_size(bufferPath);
+            const int64_t lastWriteTime = std::filesystem::last_write_time(bufferPath).time_since_epoch().count();
+
+            hash = fnv1aHash(&bufferSize, sizeof(uint64_t), hash);
+            hash = fnv1aHash(&lastWriteTime, sizeof(int64_t), hash);
+        }
+
+        return hash;
+    }
+
+    std::optional<MeshCacheView> openMeshCache(const std::string_view cachePath, const uint64_t sourcePathHash, const uint64_t contentHash)
+    {
+        MappedFile file{cachePath};
+        if (!file.isValid() || file.size() < sizeof(MeshCacheHeader))
+        {
+            return std::nullopt;
+        }
+
+        MeshCacheHeader header{};
+        std::memcpy(&header, file.data(), sizeof(MeshCacheHeader));
+
+        const MeshEncoding encoding = {
+            .vertexFormat = header.vertexFormat,
+            .indexType = header.indexType,
+            .positionScale = header.positionScale,
+            .positionOffset = header.positionOffset,
+        };
+
+        if (header.magic != MeshCacheHeader::MAGIC || header.version != MeshCacheHeader::VERSION || header.sourcePathHash != sourcePathHash || header.contentHash != contentHash)
+        {
+            return std::nullopt;
+        }
+
+        if (header.lodChain.lodCount == 0u || header.lodChain.lodCount > MAX_MESH_LOD_COUNT)
+        {
+            return std::nullopt;
+        }
+
+        if ((header.vertexFormat != VertexFormat::eFull && header.vertexFormat != VertexFormat::eCompact) ||
+            (header.indexType != vk::IndexType::eUint16 && header.indexType != vk::IndexType::eUint32) || header.vertexStride != encoding.getVertexStride() ||
+            header.indexStride != encoding.getIndexStride())
+        {
+            return std::nullopt;
+        }
+
+        // Reject truncated (or corrupt) files : every section must be inside the file, and sections that are read in place as structs must be
+        // aligned for them (the mapping itself is page aligned). The checks are written so that corrupt offsets and counts cannot overflow.
+        const auto isSectionValid = [&](const uint64_t offset, const uint64_t count, const uint64_t stride, const uint64_t alignment) {
+            return offset <= file.size() && count <= (file.size() - offset) / stride && offset % alignment == 0u;
+        };
+
+        if (!isSectionValid(header.submeshDataOffset, header.submeshCount, sizeof(Submesh), alignof(Submesh)) ||
+            !isSectionValid(header.meshletDataOffset, header.meshletCount, sizeof(Meshlet), alignof(Meshlet)) ||
+            !isSectionValid(header.vertexDataOffset, header.vertexCount, header.vertexStride, 1u) ||
+            !isSectionValid(header.indexDataOffset, header.indexCount, header.indexStride, 1u))
+        {
+            return std::nullopt;
+        }
+
+        MeshCacheView view{
+            .header = header,
+            .encoding = encoding,
+            .lodChain = header.lodChain,
+            .boundingBox = header.boundingBox,
+            .boundingSphere = header.boundingSphere,
+            .vertexData = std::span(file.data() + header.vertexDataOffset, header.vertexCount * header.vertexStride),
+            .indexData = std::span(file.data() + header.indexDataOffset, header.indexCount * header.indexStride),
+            .submeshes = std::span(reinterpret_cast<const Submesh*>(file.data() + header.submeshDataOffset), header.submeshCount),
+            .meshlets = std::span(reinterpret_cast<const Meshlet*>(file.data() + header.meshletDataOffset), header.meshletCount),
+        };
+
+        view.file = std::move(file);
+
+        return view;
+    }
+
+    bool writeMeshCache(const std::string_view cachePath, const uint64_t sourcePathHash, const uint64_t contentHash, const PackedMeshData& packedMeshData)
+    {
+        const MeshEncoding& encoding = packedMeshData.encoding;
+
+        const std::span<const Submesh> submeshes = packedMeshData.submeshes;
+        const std::span<const Meshlet> meshlets = packedMeshData.meshlets;
+        const std::span<const std::byte> vertexData = packedMeshData.vertexData;
+        const std::span<const std::byte> indexData = packedMeshData.indexData;
+
+        MeshCacheHeader header{
+            .vertexFormat = encoding.vertexFormat,
+            .indexType = encoding.indexType,
+            .positionScale = encoding.positionScale,
+            .positionOffset = encoding.positionOffset,
+            .lodChain = packedMeshData.lodChain,
+            .boundingBox = packedMeshData.boundingBox,
+            .boundingSphere = packedMeshData.boundingSphere,
+            .vertexStride = encoding.getVertexStride(),
+            .indexStride = encoding.getIndexStride(),
+            .sourcePathHash = sourcePathHash,
+            .contentHash = contentHash,
+            .vertexCount = vertexData.size() / encoding.getVertexStride(),
+            .indexCount = indexData.size() / encoding.getIndexStride(),
+            .submeshCount = submeshes.size(),
+            .meshletCount = meshlets.size(),
+        };
+
+        header.submeshDataOffset = alignUp(sizeof(MeshCacheHeader), MESH_CACHE_SECTION_ALIGNMENT);
+        header.meshletDataOffset = alignUp(header.submeshDataOffset + submeshes.size_bytes(), MESH_CACHE_SECTION_ALIGNMENT);
+        header.vertexDataOffset = alignUp(header.meshletDataOffset + meshlets.size_bytes(), MESH_CACHE_SECTION_ALIGNMENT);
+        header.indexDataOffset = alignUp(header.vertexDataOffset + vertexData.size_bytes(), MESH_CACHE_SECTION_ALIGNMENT);
+
+        const std::filesystem::path path{cachePath};
+        const std::filesystem::path temporaryPath = path.string() + ".tmp";
+
+        std::error_code errorCode{};
+        std::filesystem::create_directories(path.parent_path(), errorCode);
+
+        {
+            std::ofstream cacheFile{temporaryPath, std::ios::binary | std::ios::trunc};
+            if (!cacheFile.is_open())
+            {
+                return false;
+            }
+
+            // Writes a section, padding the file up to the section's offset first.
+            const auto writeSection = [&](const uint64_t offset, std::span<const std::byte> data)
+            {
+                static constexpr std::array<char, MESH_CACHE_SECTION_ALIGNMENT> padding{};
+
+                const uint64_t paddingSize = offset - static_cast<uint64_t>(cacheFile.tellp());
+                cacheFile.write(padding.data(), paddingSize);
+                cacheFile.write(reinterpret_cast<const char*>(data.data()), data.size_bytes());
+            };
+
+            writeSection(0u, std::as_bytes(std::span(&header, 1u)));
+            writeSection(header.submeshDataOffset, std::as_bytes(submeshes));
+            writeSection(header.meshletDataOffset, std::as_bytes(meshlets));
+            writeSection(header.vertexDataOffset, vertexData);
+            writeSection(header.indexDataOffset, indexData);
+
+            if (!cacheFile)
+            {
+                return false;
+            }
+        }
+
+        // Rename once fully written, so a partially written file is never picked up.
+        std::filesystem::rename(temporaryPath, path, errorCode);
+
+        return !errorCode;
+    }
+}
@@ -0,0 +1,136 @@
+#include "MeshEncoder.hpp"
+
+#include <DirectXPackedVector.h>
+
+namespace lunar
+{
+    static int16_t floatToSnorm16(const float value) { return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f)); }
+
+    std::array<int16_t, 2> encodeOctahedralNormal(const math::XMFLOAT3& normal)
+    {
+        const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (length == 0.0f)
+        {
+            return {0, 0};
+        }
+
+        // Project onto the octahedron, and fold the lower hemisphere over the diagonals.
+        float x = normal.x / length;
+        float y = normal.y / length;
+
+        if (normal.z < 0.0f)
+        {
+            const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+            x = foldedX;
+            y = foldedY;
+        }
+
+        return {floatToSnorm16(x), floatToSnorm16(y)};
+    }
+
+    static void encodeCompactVertices(const MeshData& meshData, PackedMeshData& packedMeshData)
+    {
+        // Quantization range is the bounding box of the mesh.
+        constexpr float floatMax = std::numeric_limits<float>::max();
+
+        math::XMFLOAT3 minPosition{floatMax, floatMax, floatMax};
+        math::XMFLOAT3 maxPosition{-floatMax, -floatMax, -floatMax};
+
+        for (const Vertex& vertex : meshData.vertices)
+        {
+            minPosition = {std::min(minPosition.x, vertex.position.x), std::min(minPosition.y, vertex.position.y), std::min(minPosition.z, vertex.position.z)};
+            maxPosition = {std::max(maxPosition.x, vertex.position.x), std::max(maxPosition.y, vertex.position.y), std::max(maxPosition.z, vertex.position.z)};
+        }
+
+        if (meshData.vertices.empty())
+        {
+            minPosition = {};
+            maxPosition = {};
+        }
+
+        // Avoid division by zero for flat meshes.
+        const auto getExtent = [](const float minValue, const float maxValue) { return maxValue > minValue ? maxValue - minValue : 1.0f; };
+        const math::XMFLOAT3 extent = {getExtent(minPosition.x, maxPosition.x), getExtent(minPosition.y, maxPosition.y), getExtent(minPosition.z, maxPosition.z)};
+
+        packedMeshData.encoding.positionScale = extent;
+        packedMeshData.encoding.positionOffset = minPosition;
+
+        const auto quantize = [](const float value, const float minValue, const float extentValue)
+        { return static_cast<uint16_t>(std::round(std::clamp((value - minValue) / extentValue, 0.0f, 1.0f) * 65535.0f)); };
+
+        std::vector<CompactVertex> compactVertices(meshData.vertices.size());
+        for (const size_t i : std::views::iota(0u, meshData.vertices.size()))
+        {
+            const Vertex& vertex = meshData.vertices[i];
+            const math::XMFLOAT2 textureCoord = i < meshData.textureCoords.size() ? meshData.textureCoords[i] : math::XMFLOAT2{};
+
+            compactVertices[i] = CompactVertex{
+                .position =
+                    {
+                        quantize(vertex.position.x, minPosition.x, extent.x),
+                        quantize(vertex.position.y, minPosition.y, extent.y),
+                        quantize(vertex.position.z, minPosition.z, extent.z),
+                        0u,
+                    },
+                .normal = encodeOctahedralNormal(vertex.normal),
+                .textureCoord =
+                    {
+                        math::PackedVector::XMConvertFloatToHalf(textureCoord.x),
+                        math::PackedVector::XMConvertFloatToHalf(textureCoord.y),
+                    },
+            };
+        }
+
+        const std::span<const std::byte> compactVertexBytes = std::as_bytes(std::span(compactVertices));
+        packedMeshData.vertexData.assign(compactVertexBytes.begin(), compactVertexBytes.end());
+    }
+
+    PackedMeshData encodeMeshData(const MeshData& meshData, const VertexFormat vertexFormat)
+    {
+        PackedMeshData packedMeshData{
+            .encoding = {.vertexFormat = vertexFormat},
+            .submeshes = meshData.submeshes,
+            .meshlets = meshData.meshlets,
+            .lodChain = meshData.lodChain,
+            .boundingBox = meshData.boundingBox,
+            .boundingSphere = meshData.boundingSphere,
+        };
+
+        if (vertexFormat == VertexFormat::eCompact)
+        {
+            encodeCompactVertices(meshData, packedMeshData);
+        }
+        else
+        {
+            const std::span<const std::byte> vertexBytes = std::as_bytes(std::span(meshData.vertices));
+            packedMeshData.vertexData.assign(vertexBytes.begin(), vertexBytes.end());
+        }
+
+        // Submesh indices are relative to the submesh, so it is the largest submesh that decides if 16 bit indices can be used.
+        const bool use16BitIndices = std::all_of(meshData.submeshes.begin(),
+                                                 meshData.submeshes.end(),
+                                                 [](const Submesh& submesh) { return submesh.vertexCount <= std::numeric_limits<uint16_t>::max() + 1u; });
+
+        if (use16BitIndices)
+        {
+            packedMeshData.encoding.indexType = vk::IndexType::eUint16;
+
+            std::vector<uint16_t> indices(meshData.indices.size());
+            std::transform(meshData.indices.begin(), meshData.indices.end(), indices.begin(), [](const uint32_t index) { return static_cast<uint16_t>(index); });
+
+            const std::span<const std::byte> indexBytes = std::as_bytes(std::span(indices));
+            packedMeshData.indexData.assign(indexBytes.begin(), indexBytes.end());
+        }
+        else
+        {
+            packedMeshData.encoding.indexType = vk::IndexType::eUint32;
+
+            const std::span<const std::byte> indexBytes = std::as_bytes(std::span(meshData.indices));
+            packedMeshData.indexData.assign(indexBytes.begin(), indexBytes.end());
+        }
+
+        return packedMeshData;
+    }
+}
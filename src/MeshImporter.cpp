@@ -0,0 +1,455 @@
+#include "MeshImporter.hpp"
+
+#include "JobSystem.hpp"
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+namespace lunar
+{
+    // Strided view into the data of a glTF accessor.
+    struct AccessorView
+    {
+        const uint8_t* data{};
+        size_t stride{};
+        size_t count{};
+        int componentType{};
+    };
+
+    // A primitive of a node, along with the ranges it will occupy in the mesh's vertex / index arrays.
+    struct PrimitiveImportJob
+    {
+        const tinygltf::Primitive* primitive{};
+        math::XMFLOAT4X4 worldMatrix{};
+        bool identityTransform{};
+        bool flipWinding{};
+        Submesh submesh{};
+    };
+
+    static size_t getComponentSize(const int componentType)
+    {
+        switch (componentType)
+        {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                return 1u;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                return 2u;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                return 4u;
+            default:
+                fatalError(std::format("Unsupported glTF accessor component type : {}", componentType));
+        }
+
+        return 0u;
+    }
+
+    static AccessorView getAccessorView(const tinygltf::Model& model, const int accessorIndex, const size_t elementSize)
+    {
+        const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+        if (accessor.bufferView < 0 || accessor.sparse.isSparse)
+        {
+            fatalError("glTF accessors that are sparse or without a buffer view are not supported.");
+        }
+
+        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+        const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+        const int byteStride = accessor.ByteStride(bufferView);
+        if (byteStride <= 0)
+        {
+            fatalError("Invalid glTF accessor byte stride.");
+        }
+
+        const AccessorView accessorView = {
+            .data = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset,
+            .stride = static_cast<size_t>(byteStride),
+            .count = accessor.count,
+            .componentType = accessor.componentType,
+        };
+
+        // Validate that the last element lies within the buffer, so that decoding never reads out of bounds.
+        const size_t accessorEnd = bufferView.byteOffset + accessor.byteOffset + (accessorView.count ? (accessorView.count - 1u) * accessorView.stride + elementSize : 0u);
+        if (accessorEnd > buffer.data.size())
+        {
+            fatalError("glTF accessor data lies outside of its buffer.");
+        }
+
+        return accessorView;
+    }
+
+    static math::XMMATRIX getLocalTransform(const tinygltf::Node& node)
+    {
+        // glTF matrices are column major (for column vectors). Reading them as row major gives the transpose, which is what the engine's row
+        // vector convention requires.
+        if (node.matrix.size() == 16u)
+        {
+            math::XMFLOAT4X4 matrix{};
+            for (const uint32_t i : std::views::iota(0u, 16u))
+            {
+                matrix.m[i / 4u][i % 4u] = static_cast<float>(node.matrix[i]);
+            }
+
+            return math::XMLoadFloat4x4(&matrix);
+        }
+
+        const math::XMVECTOR scale = node.scale.size() == 3u ? math::XMVectorSet(static_cast<float>(node.scale[0]), static_cast<float>(node.scale[1]), static_cast<float>(node.scale[2]), 0.0f)
+                                                              : math::XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f);
+
+        const math::XMVECTOR rotation = node.rotation.size() == 4u ? math::XMVectorSet(static_cast<float>(node.rotation[0]),
+                                                                                       static_cast<float>(node.rotation[1]),
+                                                                                       static_cast<float>(node.rotation[2]),
+                                                                                       static_cast<float>(node.rotation[3]))
+                                                                   : math::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+        const math::XMVECTOR translation = node.translation.size() == 3u ? math::XMVectorSet(static_cast<float>(node.translation[0]),
+                                                                                             static_cast<float>(node.translation[1]),
+                                                                                             static_cast<float>(node.translation[2]),
+                                                                                             0.0f)
+                                                                         : math::XMVectorZero();
+
+        return math::XMMatrixScalingFromVector(scale) * math::XMMatrixRotationQuaternion(rotation) * math::XMMatrixTranslationFromVector(translation);
+    }
+
+    static bool isIdentity(const math::XMFLOAT4X4& matrix)
+    {
+        for (const uint32_t row : std::views::iota(0u, 4u))
+        {
+            for (const uint32_t column : std::views::iota(0u, 4u))
+            {
+                if (matrix.m[row][column] != (row == column ? 1.0f : 0.0f))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Deinterleaves the attributes of a primitive into its range of the vertex array, and widens its indices into its range of the index array.
+    static void decodePrimitive(const tinygltf::Model& model, const PrimitiveImportJob& job, MeshData& meshData)
+    {
+        const tinygltf::Primitive& primitive = *job.primitive;
+        const Submesh& submesh = job.submesh;
+
+        Vertex* const vertices = meshData.vertices.data() + submesh.vertexOffset;
+        uint32_t* const indices = meshData.indices.data() + submesh.firstIndex;
+
+        const math::XMMATRIX worldMatrix = math::XMLoadFloat4x4(&job.worldMatrix);
+
+        // Normals are transformed by the inverse transpose, so that non uniform scaling is handled correctly.
+        const math::XMMATRIX normalMatrix = math::XMMatrixTranspose(math::XMMatrixInverse(nullptr, worldMatrix));
+
+        // Position data.
+        const AccessorView positions = getAccessorView(model, primitive.attributes.at("POSITION"), sizeof(math::XMFLOAT3));
+        for (const size_t i : std::views::iota(0u, positions.count))
+        {
+            math::XMFLOAT3& position = vertices[i].position;
+            std::memcpy(&position, positions.data + i * positions.stride, sizeof(math::XMFLOAT3));
+
+            if (!job.identityTransform)
+            {
+                math::XMStoreFloat3(&position, math::XMVector3TransformCoord(math::XMLoadFloat3(&position), worldMatrix));
+            }
+        }
+
+        // Normal data (optional). Primitives without normals are left with zero normals.
+        // note(rtarun9) : using normals as colors for now, until texture loading is implemented.
+        if (const auto normalAttribute = primitive.attributes.find("NORMAL"); normalAttribute != primitive.attributes.end())
+        {
+            const AccessorView normals = getAccessorView(model, normalAttribute->second, sizeof(math::XMFLOAT3));
+            const size_t normalCount = std::min(normals.count, positions.count);
+
+            for (const size_t i : std::views::iota(0u, normalCount))
+            {
+                math::XMFLOAT3& normal = vertices[i].normal;
+                std::memcpy(&normal, normals.data + i * normals.stride, sizeof(math::XMFLOAT3));
+
+                if (!job.identityTransform)
+                {
+                    math::XMStoreFloat3(&normal, math::XMVector3Normalize(math::XMVector3TransformNormal(math::XMLoadFloat3(&normal), normalMatrix)));
+                }
+
+                vertices[i].color = normal;
+            }
+        }
+
+        // Texture coordinate data (optional). May be stored as floats, or as normalized unsigned bytes / shorts.
+        if (const auto textureCoordAttribute = primitive.attributes.find("TEXCOORD_0"); textureCoordAttribute != primitive.attributes.end())
+        {
+            const tinygltf::Accessor& textureCoordAccessor = model.accessors[textureCoordAttribute->second];
+            const size_t componentSize = getComponentSize(textureCoordAccessor.componentType);
+
+            const AccessorView textureCoords = getAccessorView(model, textureCoordAttribute->second, componentSize * 2u);
+            const size_t textureCoordCount = std::min(textureCoords.count, positions.count);
+
+            math::XMFLOAT2* const outputTextureCoords = meshData.textureCoords.data() + submesh.vertexOffset;
+
+            for (const size_t i : std::views::iota(0u, textureCoordCount))
+            {
+                const uint8_t* const textureCoord = textureCoords.data + i * textureCoords.stride;
+
+                if (textureCoords.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+                {
+                    std::memcpy(&outputTextureCoords[i], textureCoord, sizeof(math::XMFLOAT2));
+                }
+                else if (textureCoords.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+                {
+                    std::array<uint16_t, 2> normalizedTextureCoord{};
+                    std::memcpy(normalizedTextureCoord.data(), textureCoord, sizeof(uint16_t) * 2u);
+
+                    outputTextureCoords[i] = {normalizedTextureCoord[0] / 65535.0f, normalizedTextureCoord[1] / 65535.0f};
+                }
+                else
+                {
+                    outputTextureCoords[i] = {textureCoord[0] / 255.0f, textureCoord[1] / 255.0f};
+                }
+            }
+        }
+
+        // Index data. Non indexed primitives get a sequential index list.
+        if (primitive.indices < 0)
+        {
+            std::iota(indices, indices + submesh.indexCount, 0u);
+        }
+        else
+        {
+            const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+            const AccessorView indexView = getAccessorView(model, primitive.indices, getComponentSize(indexAccessor.componentType));
+
+            if (indexView.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT && indexView.stride == sizeof(uint32_t))
+            {
+                // Tightly packed 32 bit indices can be copied in bulk.
+                std::memcpy(indices, indexView.data, submesh.indexCount * sizeof(uint32_t));
+            }
+            else if (indexView.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+            {
+                for (const size_t i : std::views::iota(0u, indexView.count))
+                {
+                    std::memcpy(&indices[i], indexView.data + i * indexView.stride, sizeof(uint32_t));
+                }
+            }
+            else if (indexView.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+            {
+                for (const size_t i : std::views::iota(0u, indexView.count))
+                {
+                    uint16_t index{};
+                    std::memcpy(&index, indexView.data + i * indexView.stride, sizeof(uint16_t));
+                    indices[i] = index;
+                }
+            }
+            else if (indexView.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+            {
+                for (const size_t i : std::views::iota(0u, indexView.count))
+                {
+                    indices[i] = indexView.data[i * indexView.stride];
+                }
+            }
+            else
+            {
+                fatalError("Unsupported glTF index component type.");
+            }
+
+            // Out of range indices would result in out of bounds vertex fetches on the GPU.
+            if (std::any_of(indices, indices + submesh.indexCount, [&](const uint32_t index) { return index >= submesh.vertexCount; }))
+            {
+                fatalError("glTF primitive has out of range indices.");
+            }
+        }
+
+        // Mirroring transforms flip the triangle winding, so flip it back to keep back face culling correct.
+        if (job.flipWinding)
+        {
+            for (uint32_t i = 0; i + 2u < submesh.indexCount; i += 3u)
+            {
+                std::swap(indices[i + 1u], indices[i + 2u]);
+            }
+        }
+    }
+
+    // The sphere is centered on the bounding box, which is not minimal but good enough for culling / LOD selection.
+    static void computeBounds(std::span<const Vertex> vertices, BoundingBox& boundingBox, math::XMFLOAT4& boundingSphere)
+    {
+        if (vertices.empty())
+        {
+            boundingBox = BoundingBox{};
+            boundingSphere = math::XMFLOAT4{};
+            return;
+        }
+
+        math::XMVECTOR minPosition = math::XMLoadFloat3(&vertices.front().position);
+        math::XMVECTOR maxPosition = minPosition;
+
+        for (const Vertex& vertex : vertices)
+        {
+            const math::XMVECTOR position = math::XMLoadFloat3(&vertex.position);
+
+            minPosition = math::XMVectorMin(minPosition, position);
+            maxPosition = math::XMVectorMax(maxPosition, position);
+        }
+
+        const math::XMVECTOR center = math::XMVectorScale(math::XMVectorAdd(minPosition, maxPosition), 0.5f);
+
+        math::XMStoreFloat3(&boundingBox.center, center);
+        math::XMStoreFloat3(&boundingBox.extents, math::XMVectorScale(math::XMVectorSubtract(maxPosition, minPosition), 0.5f));
+
+        float radiusSquared{};
+        for (const Vertex& vertex : vertices)
+        {
+            radiusSquared = std::max(radiusSquared, math::XMVectorGetX(math::XMVector3LengthSq(math::XMVectorSubtract(math::XMLoadFloat3(&vertex.position), center))));
+        }
+
+        math::XMStoreFloat4(&boundingSphere, center);
+        boundingSphere.w = std::sqrt(radiusSquared);
+    }
+
+    MeshData importGltfMesh(const std::string_view fullModelPath, JobSystem& jobSystem)
+    {
+        // Use tinygltf loader to load the model.
+        std::string warning{};
+        std::string error{};
+
+        tinygltf::TinyGLTF context{};
+
+        tinygltf::Model model{};
+
+        // tinygltf may fail without an error (or warning) message, in which case the model is empty.
+        if (!context.LoadASCIIFromFile(&model, &error, &warning, std::string(fullModelPath)))
+        {
+            fatalError(std::format("Failed to load glTF file {} : {}", fullModelPath, !error.empty() ? error : !warning.empty() ? warning : "unknown error"));
+        }
+
+        // Find the root nodes : the nodes of the default scene, or (if the file has no scenes) every node that is not a child of another node.
+        std::vector<int> rootNodes{};
+        if (!model.scenes.empty())
+        {
+            const size_t sceneIndex = model.defaultScene >= 0 ? static_cast<size_t>(model.defaultScene) : 0u;
+            rootNodes = model.scenes[sceneIndex].nodes;
+        }
+        else
+        {
+            std::vector<bool> isChild(model.nodes.size(), false);
+            for (const tinygltf::Node& node : model.nodes)
+            {
+                for (const int child : node.children)
+                {
+                    isChild[child] = true;
+                }
+            }
+
+            for (const size_t nodeIndex : std::views::iota(0u, model.nodes.size()))
+            {
+                if (!isChild[nodeIndex])
+                {
+                    rootNodes.push_back(static_cast<int>(nodeIndex));
+                }
+            }
+        }
+
+        // Walk the node hierarchy, computing world transforms and collecting every triangle primitive along with the vertex / index ranges it will
+        // occupy. Counts come from the accessors, so the output arrays can be sized before any decoding happens.
+        std::vector<PrimitiveImportJob> jobs{};
+
+        struct NodeStackEntry
+        {
+            int nodeIndex{};
+            math::XMFLOAT4X4 parentWorldMatrix{};
+        };
+
+        std::vector<NodeStackEntry> nodeStack{};
+        for (const int rootNode : rootNodes)
+        {
+            NodeStackEntry& entry = nodeStack.emplace_back(NodeStackEntry{.nodeIndex = rootNode});
+            math::XMStoreFloat4x4(&entry.parentWorldMatrix, math::XMMatrixIdentity());
+        }
+
+        uint32_t vertexCount{};
+        uint32_t indexCount{};
+
+        while (!nodeStack.empty())
+        {
+            const NodeStackEntry entry = nodeStack.back();
+            nodeStack.pop_back();
+
+            const tinygltf::Node& node = model.nodes[entry.nodeIndex];
+            const math::XMMATRIX worldMatrix = getLocalTransform(node) * math::XMLoadFloat4x4(&entry.parentWorldMatrix);
+
+            math::XMFLOAT4X4 worldMatrixData{};
+            math::XMStoreFloat4x4(&worldMatrixData, worldMatrix);
+
+            for (const int child : node.children)
+            {
+                nodeStack.emplace_back(NodeStackEntry{.nodeIndex = child, .parentWorldMatrix = worldMatrixData});
+            }
+
+            if (node.mesh < 0)
+            {
+                continue;
+            }
+
+            const bool flipWinding = math::XMVectorGetX(math::XMMatrixDeterminant(worldMatrix)) < 0.0f;
+
+            for (const tinygltf::Primitive& primitive : model.meshes[node.mesh].primitives)
+            {
+                // Only triangle lists are supported by the pipelines.
+                if (primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != -1)
+                {
+                    continue;
+                }
+
+                const auto positionAttribute = primitive.attributes.find("POSITION");
+                if (positionAttribute == primitive.attributes.end())
+                {
+                    continue;
+                }
+
+                const uint32_t primitiveVertexCount = static_cast<uint32_t>(model.accessors[positionAttribute->second].count);
+                const uint32_t primitiveIndexCount = primitive.indices >= 0 ? static_cast<uint32_t>(model.accessors[primitive.indices].count) : primitiveVertexCount;
+
+                jobs.emplace_back(PrimitiveImportJob{
+                    .primitive = &primitive,
+                    .worldMatrix = worldMatrixData,
+                    .identityTransform = isIdentity(worldMatrixData),
+                    .flipWinding = flipWinding,
+                    .submesh =
+                        {
+                            .vertexOffset = vertexCount,
+                            .vertexCount = primitiveVertexCount,
+                            .firstIndex = indexCount,
+                            .indexCount = primitiveIndexCount,
+                        },
+                });
+
+                vertexCount += primitiveVertexCount;
+                indexCount += primitiveIndexCount;
+            }
+        }
+
+        MeshData meshData{};
+        meshData.vertices.resize(vertexCount);
+        meshData.textureCoords.resize(vertexCount);
+        meshData.indices.resize(indexCount);
+
+        meshData.submeshes.reserve(jobs.size());
+        for (const PrimitiveImportJob& job : jobs)
+        {
+            meshData.submeshes.emplace_back(job.submesh);
+        }
+
+        // Each primitive writes to its own disjoint range, so they can be decoded (and their bounds computed) in parallel.
+        jobSystem.parallelFor(jobs.size(), [&](const size_t jobIndex) {
+            decodePrimitive(model, jobs[jobIndex], meshData);
+
+            Submesh& submesh = meshData.submeshes[jobIndex];
+            computeBounds(std::span(meshData.vertices).subspan(submesh.vertexOffset, submesh.vertexCount), submesh.boundingBox, submesh.boundingSphere);
+        });
+
+        computeBounds(meshData.vertices, meshData.boundingBox, meshData.boundingSphere);
+
+        return meshData;
+    }
+}
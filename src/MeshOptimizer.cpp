@@ -0,0 +1,481 @@
+#include "MeshOptimizer.hpp"
+
+#include "JobSystem.hpp"
+
+namespace lunar
+{
+    // Optimized vertex / index data of a single submesh. Indices are relative to the submesh.
+    struct SubmeshOptimizationResult
+    {
+        std::vector<Vertex> vertices{};
+        std::vector<math::XMFLOAT2> textureCoords{};
+        std::vector<uint32_t> indices{};
+
+        uint64_t cacheMissesBefore{};
+        uint64_t cacheMissesAfter{};
+    };
+
+    uint64_t simulateVertexCacheMisses(std::span<const uint32_t> indices, const uint32_t vertexCount)
+    {
+        // A vertex is in the cache if fewer than VERTEX_CACHE_SIZE vertices were inserted since it was inserted itself.
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0u);
+        uint32_t timestamp = VERTEX_CACHE_SIZE + 1u;
+
+        uint64_t cacheMisses{};
+        for (const uint32_t index : indices)
+        {
+            if (timestamp - cacheTimestamps[index] > VERTEX_CACHE_SIZE)
+            {
+                cacheTimestamps[index] = timestamp++;
+                cacheMisses++;
+            }
+        }
+
+        return cacheMisses;
+    }
+
+    // Welds bitwise identical vertices. Returns the remap table (old vertex index -> unique vertex index) and the number of unique vertices.
+    // Uses an open addressing hash table of unique vertex indices.
+    static uint32_t generateWeldRemap(std::span<const Vertex> vertices, std::span<const math::XMFLOAT2> textureCoords, std::vector<uint32_t>& remap)
+    {
+        const auto hashVertex = [&](const uint32_t vertexIndex) {
+            const uint64_t hash = fnv1aHash(&vertices[vertexIndex], sizeof(Vertex));
+            return fnv1aHash(&textureCoords[vertexIndex], sizeof(math::XMFLOAT2), hash);
+        };
+
+        const auto equalVertices = [&](const uint32_t a, const uint32_t b) {
+            return std::memcmp(&vertices[a], &vertices[b], sizeof(Vertex)) == 0 && std::memcmp(&textureCoords[a], &textureCoords[b], sizeof(math::XMFLOAT2)) == 0;
+        };
+
+        size_t tableSize = 1u;
+        while (tableSize < vertices.size() * 2u)
+        {
+            tableSize *= 2u;
+        }
+
+        std::vector<uint32_t> table(tableSize, INVALID_U32);
+        remap.resize(vertices.size());
+
+        uint32_t uniqueVertexCount{};
+        for (const uint32_t vertexIndex : std::views::iota(0u, static_cast<uint32_t>(vertices.size())))
+        {
+            size_t slot = hashVertex(vertexIndex) & (tableSize - 1u);
+            while (table[slot] != INVALID_U32 && !equalVertices(table[slot], vertexIndex))
+            {
+                slot = (slot + 1u) & (tableSize - 1u);
+            }
+
+            if (table[slot] == INVALID_U32)
+            {
+                table[slot] = vertexIndex;
+                remap[vertexIndex] = uniqueVertexCount++;
+            }
+            else
+            {
+                remap[vertexIndex] = remap[table[slot]];
+            }
+        }
+
+        return uniqueVertexCount;
+    }
+
+    // Tipsify : greedily fans around the current vertex, emitting all of its remaining triangles, then moves to the vertex (among those just
+    // emitted) that is most likely to still be in the cache once its remaining triangles are emitted. Returns the reordered indices, and fills
+    // hardBoundaries with the first triangle of each cluster that starts after a dead end (i.e a cache flush).
+    static std::vector<uint32_t> tipsify(std::span<const uint32_t> indices, const uint32_t vertexCount, std::vector<uint32_t>& hardBoundaries)
+    {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+
+        // Vertex -> triangle adjacency (compressed row storage).
+        std::vector<uint32_t> liveTriangles(vertexCount, 0u);
+        for (const uint32_t index : indices)
+        {
+            liveTriangles[index]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1u, 0u);
+        std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1u);
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1u);
+            for (const uint32_t triangleIndex : std::views::iota(0u, triangleCount))
+            {
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    adjacency[adjacencyCursors[indices[triangleIndex * 3u + corner]]++] = triangleIndex;
+                }
+            }
+        }
+
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0u);
+        uint32_t timestamp = VERTEX_CACHE_SIZE + 1u;
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEndStack{};
+        std::vector<uint32_t> candidates{};
+        uint32_t cursor{};
+
+        std::vector<uint32_t> output{};
+        output.reserve(indices.size());
+
+        const auto skipDeadEnd = [&]() -> uint32_t {
+            while (!deadEndStack.empty())
+            {
+                const uint32_t vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+
+                if (liveTriangles[vertex] > 0u)
+                {
+                    return vertex;
+                }
+            }
+
+            while (cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0u)
+                {
+                    return cursor;
+                }
+
+                cursor++;
+            }
+
+            return INVALID_U32;
+        };
+
+        uint32_t fanningVertex = skipDeadEnd();
+        while (fanningVertex != INVALID_U32)
+        {
+            candidates.clear();
+
+            for (const uint32_t adjacencyIndex : std::views::iota(adjacencyOffsets[fanningVertex], adjacencyOffsets[fanningVertex + 1u]))
+            {
+                const uint32_t triangleIndex = adjacency[adjacencyIndex];
+                if (emitted[triangleIndex])
+                {
+                    continue;
+                }
+
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    const uint32_t vertex = indices[triangleIndex * 3u + corner];
+
+                    output.push_back(vertex);
+                    deadEndStack.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+
+                    if (timestamp - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE)
+                    {
+                        cacheTimestamps[vertex] = timestamp++;
+                    }
+                }
+
+                emitted[triangleIndex] = true;
+            }
+
+            // Pick the candidate that will still be in the cache after its remaining triangles are emitted, preferring the oldest one.
+            uint32_t nextVertex = INVALID_U32;
+            int64_t bestPriority = -1;
+
+            for (const uint32_t vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0u)
+                {
+                    continue;
+                }
+
+                int64_t priority{};
+                const int64_t age = static_cast<int64_t>(timestamp - cacheTimestamps[vertex]);
+                if (age + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= static_cast<int64_t>(VERTEX_CACHE_SIZE))
+                {
+                    priority = age;
+                }
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    nextVertex = vertex;
+                }
+            }
+
+            if (nextVertex == INVALID_U32)
+            {
+                nextVertex = skipDeadEnd();
+                if (nextVertex != INVALID_U32)
+                {
+                    hardBoundaries.push_back(static_cast<uint32_t>(output.size() / 3u));
+                }
+            }
+
+            fanningVertex = nextVertex;
+        }
+
+        return output;
+    }
+
+    // Splits the hard clusters produced by tipsify into smaller clusters wherever restarting with an empty cache keeps the cluster's ACMR within
+    // threshold of the mesh's ACMR, then sorts the clusters so that those facing away from the mesh's center are drawn first.
+    static std::vector<uint32_t> optimizeOverdraw(std::span<const uint32_t> indices, std::span<const Vertex> vertices, std::span<const uint32_t> hardBoundaries,
+                                                  const float threshold)
+    {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+        const double meshAcmr = static_cast<double>(simulateVertexCacheMisses(indices, vertexCount)) / triangleCount;
+
+        // Cluster boundaries (first triangle of each cluster, terminated by triangleCount).
+        std::vector<uint32_t> clusters{0u};
+        {
+            std::vector<uint32_t> cacheTimestamps(vertexCount, 0u);
+            uint32_t timestamp = VERTEX_CACHE_SIZE + 1u;
+
+            uint32_t clusterMisses{};
+            uint32_t clusterTriangles{};
+            size_t hardBoundaryIndex{};
+
+            for (const uint32_t triangleIndex : std::views::iota(0u, triangleCount))
+            {
+                const bool hardBoundary = hardBoundaryIndex < hardBoundaries.size() && hardBoundaries[hardBoundaryIndex] == triangleIndex;
+                if (hardBoundary)
+                {
+                    hardBoundaryIndex++;
+                }
+
+                const bool softBoundary = clusterTriangles > 0u && static_cast<double>(clusterMisses) / clusterTriangles <= meshAcmr * threshold;
+
+                if (triangleIndex != 0u && (hardBoundary || softBoundary))
+                {
+                    clusters.push_back(triangleIndex);
+
+                    // Simulate a cache flush at the start of each cluster, as the previous cluster may be drawn at any point after sorting.
+                    timestamp += VERTEX_CACHE_SIZE + 1u;
+                    clusterMisses = 0u;
+                    clusterTriangles = 0u;
+                }
+
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    const uint32_t vertex = indices[triangleIndex * 3u + corner];
+                    if (timestamp - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE)
+                    {
+                        cacheTimestamps[vertex] = timestamp++;
+                        clusterMisses++;
+                    }
+                }
+
+                clusterTriangles++;
+            }
+
+            clusters.push_back(triangleCount);
+        }
+
+        const size_t clusterCount = clusters.size() - 1u;
+
+        // Compute the area weighted centroid and normal of each cluster, and the centroid of the mesh.
+        std::vector<math::XMFLOAT3> clusterCentroids(clusterCount);
+        std::vector<math::XMFLOAT3> clusterNormals(clusterCount);
+
+        math::XMVECTOR meshCentroid = math::XMVectorZero();
+        float meshArea{};
+
+        for (const size_t clusterIndex : std::views::iota(0u, clusterCount))
+        {
+            math::XMVECTOR centroid = math::XMVectorZero();
+            math::XMVECTOR normal = math::XMVectorZero();
+            float clusterArea{};
+
+            for (const uint32_t triangleIndex : std::views::iota(clusters[clusterIndex], clusters[clusterIndex + 1u]))
+            {
+                const math::XMVECTOR a = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 0u]].position);
+                const math::XMVECTOR b = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 1u]].position);
+                const math::XMVECTOR c = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 2u]].position);
+
+                const math::XMVECTOR triangleNormal = math::XMVector3Cross(math::XMVectorSubtract(b, a), math::XMVectorSubtract(c, a));
+                const float triangleArea = math::XMVectorGetX(math::XMVector3Length(triangleNormal));
+
+                const math::XMVECTOR triangleCentroid = math::XMVectorScale(math::XMVectorAdd(math::XMVectorAdd(a, b), c), 1.0f / 3.0f);
+
+                centroid = math::XMVectorAdd(centroid, math::XMVectorScale(triangleCentroid, triangleArea));
+                normal = math::XMVectorAdd(normal, triangleNormal);
+                clusterArea += triangleArea;
+            }
+
+            meshCentroid = math::XMVectorAdd(meshCentroid, centroid);
+            meshArea += clusterArea;
+
+            if (clusterArea > 0.0f)
+            {
+                centroid = math::XMVectorScale(centroid, 1.0f / clusterArea);
+            }
+
+            math::XMStoreFloat3(&clusterCentroids[clusterIndex], centroid);
+            math::XMStoreFloat3(&clusterNormals[clusterIndex], math::XMVector3Normalize(normal));
+        }
+
+        if (meshArea > 0.0f)
+        {
+            meshCentroid = math::XMVectorScale(meshCentroid, 1.0f / meshArea);
+        }
+
+        // Clusters that are far out along their own normal are likely to occlude the rest of the mesh, so they are drawn first.
+        std::vector<float> sortKeys(clusterCount);
+        for (const size_t clusterIndex : std::views::iota(0u, clusterCount))
+        {
+            const math::XMVECTOR offset = math::XMVectorSubtract(math::XMLoadFloat3(&clusterCentroids[clusterIndex]), meshCentroid);
+            sortKeys[clusterIndex] = math::XMVectorGetX(math::XMVector3Dot(offset, math::XMLoadFloat3(&clusterNormals[clusterIndex])));
+        }
+
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        std::iota(clusterOrder.begin(), clusterOrder.end(), 0u);
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](const uint32_t a, const uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> output{};
+        output.reserve(indices.size());
+
+        for (const uint32_t clusterIndex : clusterOrder)
+        {
+            output.insert(output.end(), indices.begin() + clusters[clusterIndex] * 3u, indices.begin() + clusters[clusterIndex + 1u] * 3u);
+        }
+
+        return output;
+    }
+
+    static SubmeshOptimizationResult optimizeSubmesh(const MeshData& meshData, const Submesh& submesh, const float overdrawThreshold)
+    {
+        const std::span<const Vertex> vertices = std::span(meshData.vertices).subspan(submesh.vertexOffset, submesh.vertexCount);
+        const std::span<const math::XMFLOAT2> textureCoords = std::span(meshData.textureCoords).subspan(submesh.vertexOffset, submesh.vertexCount);
+        const std::span<const uint32_t> indices = std::span(meshData.indices).subspan(submesh.firstIndex, submesh.indexCount);
+
+        SubmeshOptimizationResult result{};
+        result.cacheMissesBefore = simulateVertexCacheMisses(indices, submesh.vertexCount);
+
+        // Weld duplicate vertices.
+        std::vector<uint32_t> weldRemap{};
+        const uint32_t uniqueVertexCount = generateWeldRemap(vertices, textureCoords, weldRemap);
+
+        std::vector<Vertex> uniqueVertices(uniqueVertexCount);
+        std::vector<math::XMFLOAT2> uniqueTextureCoords(uniqueVertexCount);
+
+        for (const uint32_t vertexIndex : std::views::iota(0u, submesh.vertexCount))
+        {
+            uniqueVertices[weldRemap[vertexIndex]] = vertices[vertexIndex];
+            uniqueTextureCoords[weldRemap[vertexIndex]] = textureCoords[vertexIndex];
+        }
+
+        std::vector<uint32_t> weldedIndices(indices.size());
+        std::transform(indices.begin(), indices.end(), weldedIndices.begin(), [&](const uint32_t index) { return weldRemap[index]; });
+
+        // Reorder triangles for vertex cache locality, then for overdraw.
+        std::vector<uint32_t> hardBoundaries{};
+        const std::vector<uint32_t> cacheOptimizedIndices = tipsify(weldedIndices, uniqueVertexCount, hardBoundaries);
+        result.indices = optimizeOverdraw(cacheOptimizedIndices, uniqueVertices, hardBoundaries, overdrawThreshold);
+
+        // Reorder vertices in the order of first use. Vertices not referenced by any triangle are dropped.
+        std::vector<uint32_t> fetchRemap(uniqueVertexCount, INVALID_U32);
+        uint32_t fetchVertexCount{};
+
+        for (uint32_t& index : result.indices)
+        {
+            if (fetchRemap[index] == INVALID_U32)
+            {
+                fetchRemap[index] = fetchVertexCount++;
+            }
+
+            index = fetchRemap[index];
+        }
+
+        result.vertices.resize(fetchVertexCount);
+        result.textureCoords.resize(fetchVertexCount);
+
+        for (const uint32_t vertexIndex : std::views::iota(0u, uniqueVertexCount))
+        {
+            if (fetchRemap[vertexIndex] != INVALID_U32)
+            {
+                result.vertices[fetchRemap[vertexIndex]] = uniqueVertices[vertexIndex];
+                result.textureCoords[fetchRemap[vertexIndex]] = uniqueTextureCoords[vertexIndex];
+            }
+        }
+
+        result.cacheMissesAfter = simulateVertexCacheMisses(result.indices, fetchVertexCount);
+
+        return result;
+    }
+
+    MeshOptimizationStatistics optimizeMeshData(MeshData& meshData, JobSystem& jobSystem, const float overdrawThreshold)
+    {
+        std::vector<SubmeshOptimizationResult> results(meshData.submeshes.size());
+
+        jobSystem.parallelFor(meshData.submeshes.size(), [&](const size_t submeshIndex) {
+            const Submesh& submesh = meshData.submeshes[submeshIndex];
+            SubmeshOptimizationResult& result = results[submeshIndex];
+
+            // Submeshes that are not triangle lists are kept as is.
+            if (submesh.indexCount == 0u || submesh.indexCount % 3u != 0u)
+            {
+                result.vertices.assign(meshData.vertices.begin() + submesh.vertexOffset, meshData.vertices.begin() + submesh.vertexOffset + submesh.vertexCount);
+                result.textureCoords.assign(meshData.textureCoords.begin() + submesh.vertexOffset,
+                                            meshData.textureCoords.begin() + submesh.vertexOffset + submesh.vertexCount);
+                result.indices.assign(meshData.indices.begin() + submesh.firstIndex, meshData.indices.begin() + submesh.firstIndex + submesh.indexCount);
+
+                result.cacheMissesBefore = simulateVertexCacheMisses(result.indices, submesh.vertexCount);
+                result.cacheMissesAfter = result.cacheMissesBefore;
+
+                return;
+            }
+
+            result = optimizeSubmesh(meshData, submesh, overdrawThreshold);
+        });
+
+        // Rebuild the mesh data from the optimized submeshes.
+        MeshOptimizationStatistics statistics{
+            .vertexCountBefore = static_cast<uint32_t>(meshData.vertices.size()),
+        };
+
+        uint64_t triangleCount{};
+        uint64_t cacheMissesBefore{};
+        uint64_t cacheMissesAfter{};
+
+        meshData.vertices.clear();
+        meshData.textureCoords.clear();
+        meshData.indices.clear();
+
+        for (const size_t submeshIndex : std::views::iota(0u, meshData.submeshes.size()))
+        {
+            SubmeshOptimizationResult& result = results[submeshIndex];
+
+            // Welding and reordering keep the set of vertex positions, so the submesh's bounds are still valid.
+            Submesh& submesh = meshData.submeshes[submeshIndex];
+            submesh.vertexOffset = static_cast<uint32_t>(meshData.vertices.size());
+            submesh.vertexCount = static_cast<uint32_t>(result.vertices.size());
+            submesh.firstIndex = static_cast<uint32_t>(meshData.indices.size());
+            submesh.indexCount = static_cast<uint32_t>(result.indices.size());
+
+            meshData.vertices.insert(meshData.vertices.end(), result.vertices.begin(), result.vertices.end());
+            meshData.textureCoords.insert(meshData.textureCoords.end(), result.textureCoords.begin(), result.textureCoords.end());
+            meshData.indices.insert(meshData.indices.end(), result.indices.begin(), result.indices.end());
+
+            triangleCount += result.indices.size() / 3u;
+            cacheMissesBefore += result.cacheMissesBefore;
+            cacheMissesAfter += result.cacheMissesAfter;
+        }
+
+        statistics.vertexCountAfter = static_cast<uint32_t>(meshData.vertices.size());
+
+        if (triangleCount > 0u)
+        {
+            statistics.before = {
+                .acmr = static_cast<double>(cacheMissesBefore) / triangleCount,
+                .atvr = static_cast<double>(cacheMissesBefore) / std::max(statistics.vertexCountBefore, 1u),
+            };
+
+            statistics.after = {
+                .acmr = static_cast<double>(cacheMissesAfter) / triangleCount,
+                .atvr = static_cast<double>(cacheMissesAfter) / std::max(statistics.vertexCountAfter, 1u),
+            };
+        }
+
+        return statistics;
+    }
+}
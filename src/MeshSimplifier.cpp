@@ -0,0 +1,407 @@
+#include "MeshSimplifier.hpp"
+
+#include "JobSystem.hpp"
+
+namespace lunar
+{
+    // Symmetric 4x4 matrix Q, such that the sum of squared distances of a point p to a set of planes is [p 1] Q [p 1]^T.
+    struct Quadric
+    {
+        double a2{}, ab{}, ac{}, ad{};
+        double b2{}, bc{}, bd{};
+        double c2{}, cd{};
+        double d2{};
+
+        static Quadric fromPlane(const double a, const double b, const double c, const double d)
+        {
+            return Quadric{
+                .a2 = a * a, .ab = a * b, .ac = a * c, .ad = a * d,
+                .b2 = b * b, .bc = b * c, .bd = b * d,
+                .c2 = c * c, .cd = c * d,
+                .d2 = d * d,
+            };
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad;
+            b2 += other.b2, bc += other.bc, bd += other.bd;
+            c2 += other.c2, cd += other.cd;
+            d2 += other.d2;
+
+            return *this;
+        }
+
+        [[nodiscard]] double evaluate(const math::XMFLOAT3& p) const
+        {
+            const double x = p.x;
+            const double y = p.y;
+            const double z = p.z;
+
+            return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y + c2 * z * z + 2.0 * cd * z + d2;
+        }
+    };
+
+    struct EdgeCollapse
+    {
+        double cost{};
+        uint32_t from{};
+        uint32_t to{};
+    };
+
+    // LOD chain of a single submesh. Indices are relative to the submesh.
+    struct SubmeshLodChain
+    {
+        std::vector<std::vector<uint32_t>> lodIndices{};
+        std::vector<float> lodErrors{};
+    };
+
+    static math::XMVECTOR computeTriangleNormal(const math::XMFLOAT3& a, const math::XMFLOAT3& b, const math::XMFLOAT3& c)
+    {
+        const math::XMVECTOR positionA = math::XMLoadFloat3(&a);
+
+        return math::XMVector3Cross(math::XMVectorSubtract(math::XMLoadFloat3(&b), positionA), math::XMVectorSubtract(math::XMLoadFloat3(&c), positionA));
+    }
+
+    // Vertices that share their position with another vertex (attribute seams), or lie on an edge used by a single triangle (borders).
+    static std::vector<bool> findLockedVertices(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+    {
+        // Map each vertex to the first vertex with the same position.
+        std::vector<uint32_t> positionIds(vertices.size());
+        std::vector<uint32_t> positionUseCounts(vertices.size(), 0u);
+        {
+            std::unordered_map<uint64_t, std::vector<uint32_t>> positionBuckets{};
+            positionBuckets.reserve(vertices.size());
+
+            for (const uint32_t vertexIndex : std::views::iota(0u, static_cast<uint32_t>(vertices.size())))
+            {
+                std::vector<uint32_t>& bucket = positionBuckets[fnv1aHash(&vertices[vertexIndex].position, sizeof(math::XMFLOAT3))];
+
+                const auto samePosition = std::find_if(bucket.begin(), bucket.end(), [&](const uint32_t other) {
+                    return std::memcmp(&vertices[other].position, &vertices[vertexIndex].position, sizeof(math::XMFLOAT3)) == 0;
+                });
+
+                if (samePosition == bucket.end())
+                {
+                    bucket.push_back(vertexIndex);
+                    positionIds[vertexIndex] = vertexIndex;
+                }
+                else
+                {
+                    positionIds[vertexIndex] = *samePosition;
+                }
+
+                positionUseCounts[positionIds[vertexIndex]]++;
+            }
+        }
+
+        std::vector<bool> locked(vertices.size(), false);
+        for (const uint32_t vertexIndex : std::views::iota(0u, static_cast<uint32_t>(vertices.size())))
+        {
+            locked[vertexIndex] = positionUseCounts[positionIds[vertexIndex]] > 1u;
+        }
+
+        // Count the triangles using each (undirected, position based) edge.
+        std::unordered_map<uint64_t, uint32_t> edgeUseCounts{};
+        edgeUseCounts.reserve(indices.size());
+
+        const auto getEdgeKey = [&](const uint32_t a, const uint32_t b) {
+            const uint64_t positionA = positionIds[a];
+            const uint64_t positionB = positionIds[b];
+
+            return positionA < positionB ? (positionA << 32u) | positionB : (positionB << 32u) | positionA;
+        };
+
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            for (const uint32_t corner : std::views::iota(0u, 3u))
+            {
+                edgeUseCounts[getEdgeKey(indices[i + corner], indices[i + (corner + 1u) % 3u])]++;
+            }
+        }
+
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            for (const uint32_t corner : std::views::iota(0u, 3u))
+            {
+                const uint32_t a = indices[i + corner];
+                const uint32_t b = indices[i + (corner + 1u) % 3u];
+
+                if (edgeUseCounts[getEdgeKey(a, b)] == 1u)
+                {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+
+        return locked;
+    }
+
+    // Collapses edges in order of increasing cost until the triangle count reaches targetTriangleCount or no edge can be collapsed. Several
+    // independent collapses are done per pass, a collapse being independent if none of the triangles it modifies were modified in the pass.
+    // Returns the simplified indices, and raises maxError to the largest error of the collapses done.
+    static std::vector<uint32_t> simplify(std::span<const uint32_t> sourceIndices, std::span<const Vertex> vertices, const std::vector<bool>& locked,
+                                          std::vector<Quadric>& quadrics, const uint32_t targetTriangleCount, double& maxError)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+        std::vector<uint32_t> indices(sourceIndices.begin(), sourceIndices.end());
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1u);
+        std::vector<uint32_t> adjacency{};
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<bool> touched(vertexCount);
+        std::vector<EdgeCollapse> collapses{};
+
+        while (indices.size() / 3u > targetTriangleCount)
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+
+            // Vertex -> triangle adjacency of the current indices.
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+            for (const uint32_t index : indices)
+            {
+                adjacencyOffsets[index + 1u]++;
+            }
+
+            std::inclusive_scan(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+            adjacency.resize(indices.size());
+            {
+                std::vector<uint32_t> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1u);
+                for (const uint32_t triangleIndex : std::views::iota(0u, triangleCount))
+                {
+                    for (const uint32_t corner : std::views::iota(0u, 3u))
+                    {
+                        adjacency[adjacencyCursors[indices[triangleIndex * 3u + corner]]++] = triangleIndex;
+                    }
+                }
+            }
+
+            // Cost of moving a vertex onto the other end of an edge.
+            collapses.clear();
+            for (const uint32_t triangleIndex : std::views::iota(0u, triangleCount))
+            {
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    const uint32_t a = indices[triangleIndex * 3u + corner];
+                    const uint32_t b = indices[triangleIndex * 3u + (corner + 1u) % 3u];
+
+                    const auto addCollapse = [&](const uint32_t from, const uint32_t to) {
+                        if (locked[from])
+                        {
+                            return;
+                        }
+
+                        Quadric quadric = quadrics[from];
+                        quadric += quadrics[to];
+
+                        collapses.emplace_back(EdgeCollapse{.cost = std::max(quadric.evaluate(vertices[to].position), 0.0), .from = from, .to = to});
+                    };
+
+                    addCollapse(a, b);
+                    addCollapse(b, a);
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost < b.cost; });
+
+            std::iota(remap.begin(), remap.end(), 0u);
+            std::fill(touched.begin(), touched.end(), false);
+
+            uint32_t removedTriangleCount{};
+            uint32_t collapseCount{};
+
+            for (const EdgeCollapse& collapse : collapses)
+            {
+                if (triangleCount - removedTriangleCount <= targetTriangleCount)
+                {
+                    break;
+                }
+
+                if (touched[collapse.from] || touched[collapse.to])
+                {
+                    continue;
+                }
+
+                // Reject collapses that would flip a triangle, and count the triangles that become degenerate.
+                bool flips = false;
+                uint32_t degenerateTriangleCount{};
+
+                for (const uint32_t adjacencyIndex : std::views::iota(adjacencyOffsets[collapse.from], adjacencyOffsets[collapse.from + 1u]))
+                {
+                    const uint32_t* triangle = &indices[adjacency[adjacencyIndex] * 3u];
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    {
+                        degenerateTriangleCount++;
+                        continue;
+                    }
+
+                    const auto getCollapsedPosition = [&](const uint32_t index) -> const math::XMFLOAT3& {
+                        return vertices[index == collapse.from ? collapse.to : index].position;
+                    };
+
+                    const math::XMVECTOR normal = computeTriangleNormal(vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position);
+                    const math::XMVECTOR collapsedNormal = computeTriangleNormal(getCollapsedPosition(triangle[0]), getCollapsedPosition(triangle[1]), getCollapsedPosition(triangle[2]));
+
+                    if (math::XMVectorGetX(math::XMVector3Dot(normal, collapsedNormal)) <= 0.0f)
+                    {
+                        flips = true;
+                        break;
+                    }
+                }
+
+                if (flips)
+                {
+                    continue;
+                }
+
+                // Every vertex of the modified triangles is marked, so that the flip test of later collapses in this pass remains valid.
+                for (const uint32_t adjacencyIndex : std::views::iota(adjacencyOffsets[collapse.from], adjacencyOffsets[collapse.from + 1u]))
+                {
+                    for (const uint32_t corner : std::views::iota(0u, 3u))
+                    {
+                        touched[indices[adjacency[adjacencyIndex] * 3u + corner]] = true;
+                    }
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                maxError = std::max(maxError, collapse.cost);
+
+                removedTriangleCount += degenerateTriangleCount;
+                collapseCount++;
+            }
+
+            if (collapseCount == 0u)
+            {
+                break;
+            }
+
+            // Apply the collapses, and remove the triangles that became degenerate.
+            size_t writeIndex{};
+            for (size_t i = 0u; i < indices.size(); i += 3u)
+            {
+                const uint32_t a = remap[indices[i + 0u]];
+                const uint32_t b = remap[indices[i + 1u]];
+                const uint32_t c = remap[indices[i + 2u]];
+
+                if (a != b && b != c && a != c)
+                {
+                    indices[writeIndex++] = a;
+                    indices[writeIndex++] = b;
+                    indices[writeIndex++] = c;
+                }
+            }
+
+            indices.resize(writeIndex);
+        }
+
+        return indices;
+    }
+
+    static SubmeshLodChain generateSubmeshLods(const MeshData& meshData, const Submesh& submesh, std::span<const float> lodTriangleRatios)
+    {
+        const std::span<const Vertex> vertices = std::span(meshData.vertices).subspan(submesh.vertexOffset, submesh.vertexCount);
+        const std::span<const uint32_t> indices = std::span(meshData.indices).subspan(submesh.firstIndex, submesh.indexCount);
+
+        SubmeshLodChain lodChain{};
+
+        if (indices.empty() || indices.size() % 3u != 0u)
+        {
+            return lodChain;
+        }
+
+        const std::vector<bool> locked = findLockedVertices(vertices, indices);
+
+        // Quadric of each vertex is the sum of the planes of the triangles around it.
+        std::vector<Quadric> quadrics(vertices.size());
+        for (size_t i = 0u; i < indices.size(); i += 3u)
+        {
+            const math::XMVECTOR normal = math::XMVector3Normalize(
+                computeTriangleNormal(vertices[indices[i + 0u]].position, vertices[indices[i + 1u]].position, vertices[indices[i + 2u]].position));
+
+            math::XMFLOAT3 planeNormal{};
+            math::XMStoreFloat3(&planeNormal, normal);
+
+            const float planeDistance = -math::XMVectorGetX(math::XMVector3Dot(normal, math::XMLoadFloat3(&vertices[indices[i]].position)));
+            const Quadric planeQuadric = Quadric::fromPlane(planeNormal.x, planeNormal.y, planeNormal.z, planeDistance);
+
+            for (const uint32_t corner : std::views::iota(0u, 3u))
+            {
+                quadrics[indices[i + corner]] += planeQuadric;
+            }
+        }
+
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+
+        std::span<const uint32_t> previousLodIndices = indices;
+        double maxError{};
+
+        for (const float lodTriangleRatio : lodTriangleRatios)
+        {
+            const uint32_t targetTriangleCount = static_cast<uint32_t>(static_cast<float>(triangleCount) * lodTriangleRatio);
+
+            std::vector<uint32_t> lodIndices = simplify(previousLodIndices, vertices, locked, quadrics, targetTriangleCount, maxError);
+
+            // Stop when simplification no longer removes a meaningful amount of triangles (i.e the mesh is mostly locked).
+            if (lodIndices.empty() || lodIndices.size() * 10u > previousLodIndices.size() * 9u)
+            {
+                break;
+            }
+
+            lodChain.lodIndices.emplace_back(std::move(lodIndices));
+            lodChain.lodErrors.emplace_back(static_cast<float>(std::sqrt(maxError)));
+
+            previousLodIndices = lodChain.lodIndices.back();
+        }
+
+        return lodChain;
+    }
+
+    void generateMeshLods(MeshData& meshData, JobSystem& jobSystem, std::span<const float> lodTriangleRatios)
+    {
+        lodTriangleRatios = lodTriangleRatios.first(std::min<size_t>(lodTriangleRatios.size(), MAX_MESH_LOD_COUNT - 1u));
+
+        std::vector<SubmeshLodChain> submeshLodChains(meshData.submeshes.size());
+        jobSystem.parallelFor(meshData.submeshes.size(), [&](const size_t submeshIndex) {
+            submeshLodChains[submeshIndex] = generateSubmeshLods(meshData, meshData.submeshes[submeshIndex], lodTriangleRatios);
+        });
+
+        // The mesh has as many LODs as its most simplified submesh, other submeshes reuse their last LOD.
+        meshData.lodChain = MeshLodChain{};
+        for (const SubmeshLodChain& submeshLodChain : submeshLodChains)
+        {
+            meshData.lodChain.lodCount = std::max(meshData.lodChain.lodCount, static_cast<uint32_t>(submeshLodChain.lodIndices.size()) + 1u);
+        }
+
+        for (const uint32_t lodIndex : std::views::iota(1u, meshData.lodChain.lodCount))
+        {
+            for (const size_t submeshIndex : std::views::iota(0u, meshData.submeshes.size()))
+            {
+                const SubmeshLodChain& submeshLodChain = submeshLodChains[submeshIndex];
+                Submesh& submesh = meshData.submeshes[submeshIndex];
+
+                if (lodIndex > submeshLodChain.lodIndices.size())
+                {
+                    submesh.lodIndexRanges[lodIndex - 1u] = submesh.getIndexRange(lodIndex - 1u);
+                    continue;
+                }
+
+                const std::vector<uint32_t>& lodIndices = submeshLodChain.lodIndices[lodIndex - 1u];
+
+                submesh.lodIndexRanges[lodIndex - 1u] = IndexRange{
+                    .firstIndex = static_cast<uint32_t>(meshData.indices.size()),
+                    .indexCount = static_cast<uint32_t>(lodIndices.size()),
+                };
+
+                meshData.indices.insert(meshData.indices.end(), lodIndices.begin(), lodIndices.end());
+
+                meshData.lodChain.lodErrors[lodIndex] = std::max(meshData.lodChain.lodErrors[lodIndex], submeshLodChain.lodErrors[lodIndex - 1u]);
+            }
+
+            meshData.lodChain.lodErrors[lodIndex] = std::max(meshData.lodChain.lodErrors[lodIndex], meshData.lodChain.lodErrors[lodIndex - 1u]);
+        }
+    }
+}
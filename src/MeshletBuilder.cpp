@@ -0,0 +1,273 @@
+#include "MeshletBuilder.hpp"
+
+#include "JobSystem.hpp"
+
+namespace lunar
+{
+    // Computes the bounding sphere and normal cone of the triangles of a meshlet (indices are relative to the submesh's vertices).
+    static void computeMeshletBounds(std::span<const Vertex> vertices, std::span<const uint32_t> indices, Meshlet& meshlet)
+    {
+        // Bounding sphere centered on the bounding box of the meshlet.
+        math::XMVECTOR minPosition = math::XMLoadFloat3(&vertices[indices.front()].position);
+        math::XMVECTOR maxPosition = minPosition;
+
+        for (const uint32_t index : indices)
+        {
+            const math::XMVECTOR position = math::XMLoadFloat3(&vertices[index].position);
+
+            minPosition = math::XMVectorMin(minPosition, position);
+            maxPosition = math::XMVectorMax(maxPosition, position);
+        }
+
+        const math::XMVECTOR center = math::XMVectorScale(math::XMVectorAdd(minPosition, maxPosition), 0.5f);
+
+        float radiusSquared{};
+        for (const uint32_t index : indices)
+        {
+            radiusSquared = std::max(radiusSquared, math::XMVectorGetX(math::XMVector3LengthSq(math::XMVectorSubtract(math::XMLoadFloat3(&vertices[index].position), center))));
+        }
+
+        math::XMStoreFloat4(&meshlet.boundingSphere, center);
+        meshlet.boundingSphere.w = std::sqrt(radiusSquared);
+
+        // The cone axis is the average of the (unit) triangle normals, and the cone's spread is given by the normal furthest away from it.
+        const size_t triangleCount = indices.size() / 3u;
+
+        std::vector<math::XMVECTOR> triangleNormals(triangleCount);
+        math::XMVECTOR axis = math::XMVectorZero();
+
+        for (const size_t triangleIndex : std::views::iota(0u, triangleCount))
+        {
+            const math::XMVECTOR a = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 0u]].position);
+            const math::XMVECTOR b = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 1u]].position);
+            const math::XMVECTOR c = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + 2u]].position);
+
+            const math::XMVECTOR normal = math::XMVector3Cross(math::XMVectorSubtract(b, a), math::XMVectorSubtract(c, a));
+
+            // Degenerate triangles do not contribute to the cone.
+            triangleNormals[triangleIndex] = math::XMVectorGetX(math::XMVector3LengthSq(normal)) > 0.0f ? math::XMVector3Normalize(normal) : math::XMVectorZero();
+            axis = math::XMVectorAdd(axis, triangleNormals[triangleIndex]);
+        }
+
+        meshlet.coneCutoff = 1.0f;
+
+        if (math::XMVectorGetX(math::XMVector3LengthSq(axis)) == 0.0f)
+        {
+            return;
+        }
+
+        axis = math::XMVector3Normalize(axis);
+
+        float minAxisDot = 1.0f;
+        for (const math::XMVECTOR& normal : triangleNormals)
+        {
+            if (math::XMVectorGetX(math::XMVector3LengthSq(normal)) > 0.0f)
+            {
+                minAxisDot = std::min(minAxisDot, math::XMVectorGetX(math::XMVector3Dot(normal, axis)));
+            }
+        }
+
+        // The cone spans more than a hemisphere, so there is no view direction from which every triangle is backfacing.
+        if (minAxisDot <= 0.0f)
+        {
+            return;
+        }
+
+        // The apex is placed behind every triangle's plane along the axis, so that the view direction test is conservative for perspective.
+        float maxApexDistance{};
+        for (const size_t triangleIndex : std::views::iota(0u, triangleCount))
+        {
+            const math::XMVECTOR& normal = triangleNormals[triangleIndex];
+            const float axisDot = math::XMVectorGetX(math::XMVector3Dot(normal, axis));
+
+            if (axisDot <= 0.0f)
+            {
+                continue;
+            }
+
+            const math::XMVECTOR a = math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u]].position);
+            const float distance = math::XMVectorGetX(math::XMVector3Dot(math::XMVectorSubtract(center, a), normal)) / axisDot;
+
+            maxApexDistance = std::max(maxApexDistance, distance);
+        }
+
+        math::XMStoreFloat3(&meshlet.coneApex, math::XMVectorSubtract(center, math::XMVectorScale(axis, maxApexDistance)));
+        math::XMStoreFloat3(&meshlet.coneAxis, axis);
+
+        // sin of the cone's half angle : the meshlet is backfacing when the angle between the view direction and the axis is smaller than
+        // 90 degrees minus the half angle.
+        meshlet.coneCutoff = std::sqrt(1.0f - minAxisDot * minAxisDot);
+    }
+
+    // Grows meshlets greedily over the triangle adjacency : the next triangle is the one adjacent to the meshlet that adds the fewest new vertices
+    // (ties go to the triangle closest to the meshlet's center), so that meshlets are spatially compact and their normal cones tight. When no
+    // adjacent triangle fits, the meshlet is finished and the next one starts from the first remaining triangle in index order. The submesh's
+    // full detail indices are rewritten in meshlet order.
+    static std::vector<Meshlet> buildSubmeshMeshlets(MeshData& meshData, const Submesh& submesh)
+    {
+        const std::span<const Vertex> vertices = std::span(meshData.vertices).subspan(submesh.vertexOffset, submesh.vertexCount);
+        const std::span<uint32_t> outputIndices = std::span(meshData.indices).subspan(submesh.firstIndex, submesh.indexCount);
+
+        std::vector<Meshlet> meshlets{};
+        if (outputIndices.empty() || outputIndices.size() % 3u != 0u)
+        {
+            return meshlets;
+        }
+
+        const std::vector<uint32_t> indices(outputIndices.begin(), outputIndices.end());
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+
+        // Vertex -> triangle adjacency (compressed row storage).
+        std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1u, 0u);
+        for (const uint32_t index : indices)
+        {
+            adjacencyOffsets[index + 1u]++;
+        }
+
+        std::inclusive_scan(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1u);
+            for (const uint32_t triangleIndex : std::views::iota(0u, triangleCount))
+            {
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    adjacency[adjacencyCursors[indices[triangleIndex * 3u + corner]]++] = triangleIndex;
+                }
+            }
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+
+        // Tag of the meshlet that last used each vertex, so that unique vertices can be counted without clearing a set per meshlet.
+        std::vector<uint32_t> vertexMeshletTags(vertices.size(), INVALID_U32);
+        std::vector<uint32_t> meshletVertices{};
+
+        uint32_t outputIndex{};
+        uint32_t seedTriangle{};
+
+        const auto countNewVertices = [&](const uint32_t triangleIndex, const uint32_t meshletTag) {
+            uint32_t newVertexCount{};
+            for (const uint32_t corner : std::views::iota(0u, 3u))
+            {
+                newVertexCount += vertexMeshletTags[indices[triangleIndex * 3u + corner]] != meshletTag ? 1u : 0u;
+            }
+
+            return newVertexCount;
+        };
+
+        while (outputIndex < indices.size())
+        {
+            const uint32_t meshletTag = static_cast<uint32_t>(meshlets.size());
+            const uint32_t meshletFirstIndex = outputIndex;
+
+            meshletVertices.clear();
+            math::XMVECTOR positionSum = math::XMVectorZero();
+
+            while (emitted[seedTriangle])
+            {
+                seedTriangle++;
+            }
+
+            uint32_t nextTriangle = seedTriangle;
+            uint32_t meshletTriangleCount{};
+
+            while (nextTriangle != INVALID_U32)
+            {
+                // Emit the triangle.
+                for (const uint32_t corner : std::views::iota(0u, 3u))
+                {
+                    const uint32_t vertex = indices[nextTriangle * 3u + corner];
+                    outputIndices[outputIndex++] = vertex;
+
+                    if (vertexMeshletTags[vertex] != meshletTag)
+                    {
+                        vertexMeshletTags[vertex] = meshletTag;
+                        meshletVertices.push_back(vertex);
+                        positionSum = math::XMVectorAdd(positionSum, math::XMLoadFloat3(&vertices[vertex].position));
+                    }
+                }
+
+                emitted[nextTriangle] = true;
+                meshletTriangleCount++;
+
+                if (meshletTriangleCount == MAX_MESHLET_TRIANGLE_COUNT)
+                {
+                    break;
+                }
+
+                // Pick the best adjacent triangle that still fits.
+                const math::XMVECTOR center = math::XMVectorScale(positionSum, 1.0f / static_cast<float>(meshletVertices.size()));
+
+                nextTriangle = INVALID_U32;
+                uint32_t bestNewVertexCount = 4u;
+                float bestDistance = std::numeric_limits<float>::max();
+
+                for (const uint32_t vertex : meshletVertices)
+                {
+                    for (const uint32_t adjacencyIndex : std::views::iota(adjacencyOffsets[vertex], adjacencyOffsets[vertex + 1u]))
+                    {
+                        const uint32_t triangleIndex = adjacency[adjacencyIndex];
+                        if (emitted[triangleIndex])
+                        {
+                            continue;
+                        }
+
+                        const uint32_t newVertexCount = countNewVertices(triangleIndex, meshletTag);
+                        if (meshletVertices.size() + newVertexCount > MAX_MESHLET_VERTEX_COUNT || newVertexCount > bestNewVertexCount)
+                        {
+                            continue;
+                        }
+
+                        math::XMVECTOR triangleCenter = math::XMVectorZero();
+                        for (const uint32_t corner : std::views::iota(0u, 3u))
+                        {
+                            triangleCenter = math::XMVectorAdd(triangleCenter, math::XMLoadFloat3(&vertices[indices[triangleIndex * 3u + corner]].position));
+                        }
+
+                        const float distance = math::XMVectorGetX(math::XMVector3LengthSq(math::XMVectorSubtract(math::XMVectorScale(triangleCenter, 1.0f / 3.0f), center)));
+
+                        if (newVertexCount < bestNewVertexCount || distance < bestDistance)
+                        {
+                            nextTriangle = triangleIndex;
+                            bestNewVertexCount = newVertexCount;
+                            bestDistance = distance;
+                        }
+                    }
+                }
+            }
+
+            Meshlet& meshlet = meshlets.emplace_back(Meshlet{
+                .indexRange =
+                    {
+                        .firstIndex = submesh.firstIndex + meshletFirstIndex,
+                        .indexCount = outputIndex - meshletFirstIndex,
+                    },
+            });
+
+            computeMeshletBounds(vertices, outputIndices.subspan(meshletFirstIndex, outputIndex - meshletFirstIndex), meshlet);
+        }
+
+        return meshlets;
+    }
+
+    void buildMeshlets(MeshData& meshData, JobSystem& jobSystem)
+    {
+        std::vector<std::vector<Meshlet>> submeshMeshlets(meshData.submeshes.size());
+        jobSystem.parallelFor(meshData.submeshes.size(), [&](const size_t submeshIndex) {
+            submeshMeshlets[submeshIndex] = buildSubmeshMeshlets(meshData, meshData.submeshes[submeshIndex]);
+        });
+
+        meshData.meshlets.clear();
+        for (const size_t submeshIndex : std::views::iota(0u, meshData.submeshes.size()))
+        {
+            Submesh& submesh = meshData.submeshes[submeshIndex];
+
+            submesh.firstMeshlet = static_cast<uint32_t>(meshData.meshlets.size());
+            submesh.meshletCount = static_cast<uint32_t>(submeshMeshlets[submeshIndex].size());
+
+            meshData.meshlets.insert(meshData.meshlets.end(), submeshMeshlets[submeshIndex].begin(), submeshMeshlets[submeshIndex].end());
+        }
+    }
+}
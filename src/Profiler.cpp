@@ -0,0 +1,382 @@
+#include "Profiler.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+namespace lunar
+{
+    namespace
+    {
+        // Host clock domain that the steady clock is based on (the performance counter on Windows, CLOCK_MONOTONIC elsewhere).
+#ifdef _WIN32
+        constexpr vk::TimeDomainEXT HOST_TIME_DOMAIN = vk::TimeDomainEXT::eQueryPerformanceCounter;
+#else
+        constexpr vk::TimeDomainEXT HOST_TIME_DOMAIN = vk::TimeDomainEXT::eClockMonotonic;
+#endif
+
+        [[nodiscard]] int64_t hostTimestampToNs(const uint64_t hostTimestamp)
+        {
+#ifdef _WIN32
+            LARGE_INTEGER frequency{};
+            QueryPerformanceFrequency(&frequency);
+
+            return static_cast<int64_t>(static_cast<double>(hostTimestamp) * 1'000'000'000.0 / static_cast<double>(frequency.QuadPart));
+#else
+            return static_cast<int64_t>(hostTimestamp);
+#endif
+        }
+    }
+
+    void Profiler::init(const vk::Instance instance, const vk::PhysicalDevice physicalDevice, const vk::Device device, const uint32_t frameCount,
+                        const uint32_t timestampValidBits)
+    {
+        m_device = device;
+        m_timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+        m_timestampValidBits = timestampValidBits;
+
+        // Calibrated timestamps need the extension (requested by the engine when profiling is compiled in), and both the device and host
+        // clocks to be calibrateable.
+        const auto extensionProperties = physicalDevice.enumerateDeviceExtensionProperties();
+        const bool calibratedTimestampsSupported = std::ranges::any_of(extensionProperties, [](const vk::ExtensionProperties& properties) {
+            return std::string_view(properties.extensionName.data()) == VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+        });
+
+        if (calibratedTimestampsSupported)
+        {
+            const auto getCalibrateableTimeDomains =
+                reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(instance.getProcAddr("vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+
+            uint32_t timeDomainCount{};
+            vkCheck(getCalibrateableTimeDomains(static_cast<VkPhysicalDevice>(physicalDevice), &timeDomainCount, nullptr));
+
+            std::vector<VkTimeDomainEXT> timeDomains(timeDomainCount);
+            vkCheck(getCalibrateableTimeDomains(static_cast<VkPhysicalDevice>(physicalDevice), &timeDomainCount, timeDomains.data()));
+
+            const auto hasTimeDomain = [&](const vk::TimeDomainEXT timeDomain) { return std::ranges::find(timeDomains, static_cast<VkTimeDomainEXT>(timeDomain)) != timeDomains.end(); };
+
+            if (hasTimeDomain(vk::TimeDomainEXT::eDevice) && hasTimeDomain(HOST_TIME_DOMAIN))
+            {
+                m_getCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(device.getProcAddr("vkGetCalibratedTimestampsEXT"));
+            }
+        }
+
+        if (!m_getCalibratedTimestamps)
+        {
+            std::cout << "Calibrated timestamps are not supported, GPU scopes of profiler captures will be aligned to the submission of their frame.\n";
+        }
+
+        const vk::QueryPoolCreateInfo queryPoolCreateInfo = {
+            .queryType = vk::QueryType::eTimestamp,
+            .queryCount = MAX_GPU_SCOPES_PER_FRAME * 2u,
+        };
+
+        m_frames.resize(frameCount);
+        for (Frame& frame : m_frames)
+        {
+            frame.queryPool = m_device.createQueryPool(queryPoolCreateInfo);
+        }
+    }
+
+    void Profiler::destroy()
+    {
+        for (const Frame& frame : m_frames)
+        {
+            m_device.destroyQueryPool(frame.queryPool);
+        }
+
+        m_frames.clear();
+    }
+
+    void Profiler::beginCapture(const uint32_t frameCount, const std::string_view outputPath)
+    {
+        {
+            std::scoped_lock lock{m_eventsMutex};
+
+            m_capturing = true;
+            m_events.clear();
+            m_threadIndices.clear();
+            m_threadIndices.emplace(std::this_thread::get_id(), 0u);
+        }
+
+        m_outputPath = outputPath;
+        m_captureStartTimeNs = getTimeNs();
+        m_remainingFrameCount = frameCount;
+        m_gpuTimestampsCalibrated = m_getCalibratedTimestamps != nullptr;
+
+        s_capturingProfiler = this;
+    }
+
+    void Profiler::endCapture()
+    {
+        if (s_capturingProfiler != this)
+        {
+            return;
+        }
+
+        for (const uint32_t frameIndex : std::views::iota(0u, static_cast<uint32_t>(m_frames.size())))
+        {
+            collectFrame(frameIndex);
+        }
+
+        // collectFrame() writes the trace once the last requested frame is collected.
+        if (s_capturingProfiler == this)
+        {
+            writeTrace();
+        }
+    }
+
+    void Profiler::collectFrame(const uint32_t frameIndex)
+    {
+        if (m_frames.empty() || !m_frames[frameIndex].recorded)
+        {
+            return;
+        }
+
+        Frame& frame = m_frames[frameIndex];
+        frame.recorded = false;
+
+        std::vector<uint64_t> timestamps(frame.queryCount);
+        vkCheck(m_device.getQueryPoolResults(frame.queryPool,
+                                             0u,
+                                             frame.queryCount,
+                                             sizeof(uint64_t) * timestamps.size(),
+                                             timestamps.data(),
+                                             sizeof(uint64_t),
+                                             vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait));
+
+        // Without calibration, the start of the frame (its first scope) is aligned with its submission.
+        const uint64_t referenceTimestamp = frame.calibrated ? frame.calibrationGpuTimestamp : timestamps[frame.scopes.front().beginQuery];
+
+        // Timestamps are unsigned tick counts of m_timestampValidBits bits (the other bits are undefined), but may be before the reference : their
+        // difference modulo 2^validBits is sign extended from its top valid bit.
+        const uint32_t invalidBitCount = 64u - m_timestampValidBits;
+        const auto getTimeNs = [&](const uint64_t timestamp) {
+            const int64_t ticks = static_cast<int64_t>(getTimestampDelta(referenceTimestamp, timestamp, m_timestampValidBits) << invalidBitCount) >> invalidBitCount;
+            return frame.calibrationTimeNs + static_cast<int64_t>(static_cast<double>(ticks) * m_timestampPeriod);
+        };
+
+        {
+            std::scoped_lock lock{m_eventsMutex};
+
+            for (const size_t scopeIndex : std::views::iota(size_t{0u}, frame.scopes.size()))
+            {
+                const GpuScope& scope = frame.scopes[scopeIndex];
+
+                m_events.push_back(TraceEvent{
+                    .name = scope.name,
+                    .beginTimeNs = getTimeNs(timestamps[scope.beginQuery]),
+                    .endTimeNs = getTimeNs(timestamps[scope.beginQuery + 1u]),
+                    .threadIndex = INVALID_U32,
+                    .frameNumber = scopeIndex == 0u ? frame.frameNumber : INVALID_U64,
+                });
+            }
+        }
+
+        const bool framesPending = std::ranges::any_of(m_frames, std::identity{}, &Frame::recorded);
+        if (m_remainingFrameCount == 0u && !framesPending && s_capturingProfiler == this)
+        {
+            writeTrace();
+        }
+    }
+
+    void Profiler::beginFrame(const vk::CommandBuffer& cmd, const uint32_t frameIndex, const uint64_t frameNumber)
+    {
+        if (m_frames.empty() || m_remainingFrameCount == 0u)
+        {
+            return;
+        }
+
+        Frame& frame = m_frames[frameIndex];
+
+        frame.recorded = true;
+        frame.frameNumber = frameNumber;
+        frame.queryCount = 0u;
+        frame.scopes.clear();
+        frame.openScopes.clear();
+
+        cmd.resetQueryPool(frame.queryPool, 0u, MAX_GPU_SCOPES_PER_FRAME * 2u);
+
+        frame.calibrated = calibrate(frame);
+
+        m_recordingFrame = &frame;
+        beginGpuScope(cmd, "Frame");
+    }
+
+    void Profiler::endFrame(const vk::CommandBuffer& cmd)
+    {
+        if (!m_recordingFrame)
+        {
+            return;
+        }
+
+        endGpuScope(cmd);
+
+        if (!m_recordingFrame->calibrated)
+        {
+            m_recordingFrame->calibrationTimeNs = getTimeNs();
+        }
+
+        m_recordingFrame = nullptr;
+        --m_remainingFrameCount;
+    }
+
+    void Profiler::beginGpuScope(const vk::CommandBuffer& cmd, const std::string_view name)
+    {
+        if (!m_recordingFrame)
+        {
+            return;
+        }
+
+        Frame& frame = *m_recordingFrame;
+        if (frame.queryCount + 2u > MAX_GPU_SCOPES_PER_FRAME * 2u)
+        {
+            frame.openScopes.push_back(INVALID_U32);
+            return;
+        }
+
+        frame.openScopes.push_back(static_cast<uint32_t>(frame.scopes.size()));
+        frame.scopes.push_back(GpuScope{
+            .name = name,
+            .beginQuery = frame.queryCount,
+        });
+
+        cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eNone, frame.queryPool, frame.queryCount);
+        frame.queryCount += 2u;
+    }
+
+    void Profiler::endGpuScope(const vk::CommandBuffer& cmd)
+    {
+        if (!m_recordingFrame || m_recordingFrame->openScopes.empty())
+        {
+            return;
+        }
+
+        Frame& frame = *m_recordingFrame;
+
+        const uint32_t scopeIndex = frame.openScopes.back();
+        frame.openScopes.pop_back();
+
+        if (scopeIndex != INVALID_U32)
+        {
+            cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, frame.queryPool, frame.scopes[scopeIndex].beginQuery + 1u);
+        }
+    }
+
+    void Profiler::recordCpuScope(const std::string_view name, const int64_t beginTimeNs, const int64_t endTimeNs)
+    {
+        std::scoped_lock lock{m_eventsMutex};
+        if (!m_capturing)
+        {
+            return;
+        }
+
+        const auto [threadIndex, inserted] = m_threadIndices.try_emplace(std::this_thread::get_id(), static_cast<uint32_t>(m_threadIndices.size()));
+
+        m_events.push_back(TraceEvent{
+            .name = name,
+            .beginTimeNs = beginTimeNs,
+            .endTimeNs = endTimeNs,
+            .threadIndex = threadIndex->second,
+        });
+    }
+
+    int64_t Profiler::getTimeNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool Profiler::calibrate(Frame& frame) const
+    {
+        if (!m_getCalibratedTimestamps)
+        {
+            return false;
+        }
+
+        const std::array<vk::CalibratedTimestampInfoEXT, 2> timestampInfos = {
+            vk::CalibratedTimestampInfoEXT{.timeDomain = vk::TimeDomainEXT::eDevice},
+            vk::CalibratedTimestampInfoEXT{.timeDomain = HOST_TIME_DOMAIN},
+        };
+
+        std::array<uint64_t, 2> timestamps{};
+        uint64_t maxDeviation{};
+
+        const VkResult result = m_getCalibratedTimestamps(static_cast<VkDevice>(m_device),
+                                                          static_cast<uint32_t>(timestampInfos.size()),
+                                                          reinterpret_cast<const VkCalibratedTimestampInfoEXT*>(timestampInfos.data()),
+                                                          timestamps.data(),
+                                                          &maxDeviation);
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        frame.calibrationGpuTimestamp = timestamps[0];
+        frame.calibrationTimeNs = hostTimestampToNs(timestamps[1]);
+
+        return true;
+    }
+
+    void Profiler::writeTrace()
+    {
+        s_capturingProfiler = nullptr;
+
+        std::scoped_lock lock{m_eventsMutex};
+        m_capturing = false;
+
+        std::ofstream traceFile{m_outputPath};
+        if (!traceFile.is_open())
+        {
+            fatalError(std::string("Failed to open profiler trace file : ") + m_outputPath);
+        }
+
+        // CPU threads are in process 0, the graphics queue in process 1. Times are in microseconds, from the start of the capture.
+        constexpr uint32_t cpuProcessId = 0u;
+        constexpr uint32_t gpuProcessId = 1u;
+
+        traceFile << std::format(R"({{"displayTimeUnit": "ms", "otherData": {{"gpu_timestamps_calibrated": {}}}, "traceEvents": [)", m_gpuTimestampsCalibrated) << '\n';
+
+        traceFile << std::format(R"({{"name": "process_name", "ph": "M", "pid": {}, "args": {{"name": "CPU"}}}},)", cpuProcessId) << '\n';
+        traceFile << std::format(R"({{"name": "process_name", "ph": "M", "pid": {}, "args": {{"name": "GPU"}}}},)", gpuProcessId) << '\n';
+        traceFile << std::format(R"({{"name": "thread_name", "ph": "M", "pid": {}, "tid": 0, "args": {{"name": "Graphics queue"}}}})", gpuProcessId);
+
+        for (const uint32_t threadIndex : m_threadIndices | std::views::values)
+        {
+            traceFile << std::format(",\n" R"({{"name": "thread_name", "ph": "M", "pid": {}, "tid": {}, "args": {{"name": "{}"}}}})",
+                                     cpuProcessId,
+                                     threadIndex,
+                                     threadIndex == 0u ? std::string("Main thread") : std::format("Thread {}", threadIndex));
+        }
+
+        const auto toMicroseconds = [&](const int64_t timeNs) { return static_cast<double>(timeNs - m_captureStartTimeNs) / 1'000.0; };
+
+        for (const TraceEvent& event : m_events)
+        {
+            const bool gpuEvent = event.threadIndex == INVALID_U32;
+
+            traceFile << std::format(",\n" R"({{"name": "{}", "cat": "{}", "ph": "X", "pid": {}, "tid": {}, "ts": {:.3f}, "dur": {:.3f})",
+                                     event.name,
+                                     gpuEvent ? "gpu" : "cpu",
+                                     gpuEvent ? gpuProcessId : cpuProcessId,
+                                     gpuEvent ? 0u : event.threadIndex,
+                                     toMicroseconds(event.beginTimeNs),
+                                     static_cast<double>(event.endTimeNs - event.beginTimeNs) / 1'000.0);
+
+            if (event.frameNumber != INVALID_U64)
+            {
+                traceFile << std::format(R"(, "args": {{"frame": {}}})", event.frameNumber);
+            }
+
+            traceFile << '}';
+        }
+
+        traceFile << "\n]}\n";
+
+        std::cout << std::format("Profiler trace ({} events) written to {}.\n", m_events.size(), m_outputPath);
+
+        m_events.clear();
+        m_threadIndices.clear();
+    }
+}
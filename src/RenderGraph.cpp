@@ -0,0 +1,773 @@
+#include "RenderGraph.hpp"
+
+namespace lunar
+{
+    namespace
+    {
+        // Only writes have to be made available, so the read bits of source access masks are dropped.
+        constexpr vk::AccessFlags2 WRITE_ACCESS_FLAGS = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eShaderStorageWrite |
+                                                        vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+                                                        vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+    }
+
+    RenderGraphPass& RenderGraphPass::use(const RenderGraphResource resource, const RenderGraphUsage usage)
+    {
+        if (usage == RenderGraphUsage::ePresent)
+        {
+            fatalError(std::format("Render graph pass {} : present is only valid as the final usage of an imported image.", m_name));
+        }
+
+        m_accesses.push_back(Access{
+            .resource = resource,
+            .usage = usage,
+        });
+
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::colorAttachment(const RenderGraphResource resource, const vk::AttachmentLoadOp loadOp, const vk::ClearValue clearValue)
+    {
+        m_colorAttachments.push_back(RenderGraphAttachment{
+            .resource = resource,
+            .loadOp = loadOp,
+            .clearValue = clearValue,
+        });
+
+        return use(resource, RenderGraphUsage::eColorAttachment);
+    }
+
+    RenderGraphPass& RenderGraphPass::depthAttachment(const RenderGraphResource resource, const vk::AttachmentLoadOp loadOp, const vk::ClearValue clearValue)
+    {
+        m_depthAttachment = RenderGraphAttachment{
+            .resource = resource,
+            .loadOp = loadOp,
+            .clearValue = clearValue,
+        };
+
+        return use(resource, RenderGraphUsage::eDepthAttachment);
+    }
+
+    RenderGraphPass& RenderGraphPass::secondaryCommandBuffers()
+    {
+        m_secondaryCommandBuffers = true;
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::sideEffects()
+    {
+        m_sideEffects = true;
+        return *this;
+    }
+
+    bool RenderGraphPass::discardsContents(const RenderGraphResource resource) const
+    {
+        const auto isClearedAttachment = [&](const RenderGraphAttachment& attachment) {
+            return attachment.resource == resource && attachment.loadOp != vk::AttachmentLoadOp::eLoad;
+        };
+
+        return std::ranges::any_of(m_colorAttachments, isClearedAttachment) || (m_depthAttachment.has_value() && isClearedAttachment(*m_depthAttachment));
+    }
+
+    void RenderGraphPass::reset(const std::string_view name, RenderGraphRecordFunction&& record)
+    {
+        m_name = name;
+        m_record = std::move(record);
+
+        m_accesses.clear();
+        m_colorAttachments.clear();
+        m_depthAttachment.reset();
+        m_secondaryCommandBuffers = false;
+        m_sideEffects = false;
+
+        m_culled = false;
+        m_imageBarriers.clear();
+        m_bufferBarriers.clear();
+    }
+
+    RenderGraph::UsageInfo RenderGraph::getUsageInfo(const RenderGraphUsage usage)
+    {
+        using Stage = vk::PipelineStageFlagBits2;
+        using Access = vk::AccessFlagBits2;
+        using Layout = vk::ImageLayout;
+        using ImageUsage = vk::ImageUsageFlagBits;
+
+        switch (usage)
+        {
+        case RenderGraphUsage::eColorAttachment:
+            return {Stage::eColorAttachmentOutput, Access::eColorAttachmentRead | Access::eColorAttachmentWrite, Layout::eColorAttachmentOptimal, ImageUsage::eColorAttachment, true};
+        case RenderGraphUsage::eDepthAttachment:
+            return {Stage::eEarlyFragmentTests | Stage::eLateFragmentTests,
+                    Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite,
+                    Layout::eDepthAttachmentOptimal,
+                    ImageUsage::eDepthStencilAttachment,
+                    true};
+        case RenderGraphUsage::eDepthAttachmentRead:
+            return {Stage::eEarlyFragmentTests | Stage::eLateFragmentTests, Access::eDepthStencilAttachmentRead, Layout::eDepthReadOnlyOptimal, ImageUsage::eDepthStencilAttachment, false};
+        case RenderGraphUsage::eFragmentSampled:
+            return {Stage::eFragmentShader, Access::eShaderSampledRead, Layout::eShaderReadOnlyOptimal, ImageUsage::eSampled, false};
+        case RenderGraphUsage::eComputeSampled:
+            return {Stage::eComputeShader, Access::eShaderSampledRead, Layout::eShaderReadOnlyOptimal, ImageUsage::eSampled, false};
+        case RenderGraphUsage::eComputeStorageRead:
+            return {Stage::eComputeShader, Access::eShaderStorageRead, Layout::eGeneral, ImageUsage::eStorage, false};
+        case RenderGraphUsage::eComputeStorageWrite:
+            return {Stage::eComputeShader, Access::eShaderStorageRead | Access::eShaderStorageWrite, Layout::eGeneral, ImageUsage::eStorage, true};
+        case RenderGraphUsage::eGraphicsStorageRead:
+            return {Stage::eVertexShader | Stage::eFragmentShader, Access::eShaderStorageRead, Layout::eGeneral, ImageUsage::eStorage, false};
+        case RenderGraphUsage::eIndirectArgument:
+            return {Stage::eDrawIndirect, Access::eIndirectCommandRead, Layout::eUndefined, ImageUsage{}, false};
+        case RenderGraphUsage::eTransferSrc:
+            return {Stage::eAllTransfer, Access::eTransferRead, Layout::eTransferSrcOptimal, ImageUsage::eTransferSrc, false};
+        case RenderGraphUsage::eTransferDst:
+            return {Stage::eAllTransfer, Access::eTransferWrite, Layout::eTransferDstOptimal, ImageUsage::eTransferDst, true};
+        case RenderGraphUsage::ePresent:
+            return {Stage::eNone, Access::eNone, Layout::ePresentSrcKHR, ImageUsage{}, false};
+        }
+
+        fatalError("Unknown render graph usage.");
+        return {};
+    }
+
+    void RenderGraph::init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker)
+    {
+        m_transientAllocator.init(device, allocator, memoryTracker);
+    }
+
+    void RenderGraph::destroy()
+    {
+        m_transientAllocator.destroy();
+        reset();
+
+        m_freePasses.clear();
+    }
+
+    void RenderGraph::reset()
+    {
+        m_resources.clear();
+
+        // In reverse, so that addPass() reuses the pass that was at the same index (whose vectors have the right capacity).
+        for (RenderGraphPass& pass : m_passes | std::views::reverse)
+        {
+            m_freePasses.push_back(std::move(pass));
+        }
+
+        m_passes.clear();
+        m_finalImageBarriers.clear();
+    }
+
+    RenderGraphResource RenderGraph::importImage(const std::string_view name, const vk::Image image, const vk::ImageView imageView, const vk::Format format,
+                                                 const vk::Extent2D extent, const RenderGraphResourceState& initialState, const std::optional<RenderGraphUsage> finalUsage)
+    {
+        m_resources.push_back(Resource{
+            .name = name,
+            .isImage = true,
+            .imported = true,
+            .image = image,
+            .imageView = imageView,
+            .format = format,
+            .extent = extent,
+            .aspect = getImageAspect(format),
+            .initialState = initialState,
+            .finalUsage = finalUsage,
+        });
+
+        return static_cast<RenderGraphResource>(m_resources.size() - 1u);
+    }
+
+    RenderGraphResource RenderGraph::importBuffer(const std::string_view name, const vk::Buffer buffer, const vk::DeviceSize offset, const vk::DeviceSize size)
+    {
+        m_resources.push_back(Resource{
+            .name = name,
+            .isImage = false,
+            .imported = true,
+            .buffer = buffer,
+            .offset = offset,
+            .size = size,
+        });
+
+        return static_cast<RenderGraphResource>(m_resources.size() - 1u);
+    }
+
+    RenderGraphResource RenderGraph::createImage(const std::string_view name, const vk::Format format, const vk::Extent2D extent)
+    {
+        m_resources.push_back(Resource{
+            .name = name,
+            .isImage = true,
+            .imported = false,
+            .format = format,
+            .extent = extent,
+            .aspect = getImageAspect(format),
+        });
+
+        return static_cast<RenderGraphResource>(m_resources.size() - 1u);
+    }
+
+    RenderGraphPass& RenderGraph::addPass(const std::string_view name, RenderGraphRecordFunction&& record)
+    {
+        if (m_freePasses.empty())
+        {
+            m_passes.emplace_back();
+        }
+        else
+        {
+            m_passes.push_back(std::move(m_freePasses.back()));
+            m_freePasses.pop_back();
+        }
+
+        RenderGraphPass& pass = m_passes.back();
+        pass.reset(name, std::move(record));
+
+        return pass;
+    }
+
+    void RenderGraph::compile()
+    {
+        cullPasses();
+
+        // Lifetime and usage flags of each resource, over the passes that are not culled.
+        for (const uint32_t passIndex : std::views::iota(0u, static_cast<uint32_t>(m_passes.size())))
+        {
+            const RenderGraphPass& pass = m_passes[passIndex];
+            if (pass.m_culled)
+            {
+                continue;
+            }
+
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                Resource& resource = m_resources[access.resource];
+
+                resource.firstPass = std::min(resource.firstPass, passIndex);
+                resource.lastPass = std::max(resource.lastPass, passIndex);
+                resource.imageUsage |= getUsageInfo(access.usage).imageUsage;
+            }
+        }
+
+        allocateTransientImages();
+        computeStoreOps();
+        computeBarriers();
+    }
+
+    void RenderGraph::execute(const vk::CommandBuffer& cmd, [[maybe_unused]] Profiler* profiler)
+    {
+        constexpr size_t MAX_COLOR_ATTACHMENT_COUNT = 8u;
+
+        for (const RenderGraphPass& pass : m_passes)
+        {
+            if (pass.m_culled)
+            {
+                continue;
+            }
+
+            LUNAR_PROFILE_GPU_SCOPE(profiler, cmd, pass.m_name);
+
+            if (!pass.m_imageBarriers.empty() || !pass.m_bufferBarriers.empty())
+            {
+                const vk::DependencyInfo dependencyInfo = {
+                    .bufferMemoryBarrierCount = static_cast<uint32_t>(pass.m_bufferBarriers.size()),
+                    .pBufferMemoryBarriers = pass.m_bufferBarriers.data(),
+                    .imageMemoryBarrierCount = static_cast<uint32_t>(pass.m_imageBarriers.size()),
+                    .pImageMemoryBarriers = pass.m_imageBarriers.data(),
+                };
+
+                cmd.pipelineBarrier2(dependencyInfo);
+            }
+
+            if (pass.m_colorAttachments.empty() && !pass.m_depthAttachment.has_value())
+            {
+                pass.m_record(cmd);
+                continue;
+            }
+
+            if (pass.m_colorAttachments.size() > MAX_COLOR_ATTACHMENT_COUNT)
+            {
+                fatalError(std::format("Render graph pass {} has more than {} color attachments.", pass.m_name, MAX_COLOR_ATTACHMENT_COUNT));
+            }
+
+            const auto getAttachmentInfo = [&](const RenderGraphAttachment& attachment, const vk::ImageLayout layout) {
+                return vk::RenderingAttachmentInfo{
+                    .imageView = m_resources[attachment.resource].imageView,
+                    .imageLayout = layout,
+                    .loadOp = attachment.loadOp,
+                    .storeOp = attachment.storeOp,
+                    .clearValue = attachment.clearValue,
+                };
+            };
+
+            std::array<vk::RenderingAttachmentInfo, MAX_COLOR_ATTACHMENT_COUNT> colorAttachmentInfos{};
+            for (const size_t attachmentIndex : std::views::iota(0u, pass.m_colorAttachments.size()))
+            {
+                colorAttachmentInfos[attachmentIndex] = getAttachmentInfo(pass.m_colorAttachments[attachmentIndex], vk::ImageLayout::eColorAttachmentOptimal);
+            }
+
+            const vk::RenderingAttachmentInfo depthAttachmentInfo =
+                pass.m_depthAttachment.has_value() ? getAttachmentInfo(*pass.m_depthAttachment, vk::ImageLayout::eDepthAttachmentOptimal) : vk::RenderingAttachmentInfo{};
+
+            // All attachments of a pass have the same extent.
+            const RenderGraphResource firstAttachment = pass.m_colorAttachments.empty() ? pass.m_depthAttachment->resource : pass.m_colorAttachments.front().resource;
+
+            const vk::RenderingInfo renderingInfo = {
+                .flags = pass.m_secondaryCommandBuffers ? vk::RenderingFlagBits::eContentsSecondaryCommandBuffers : vk::RenderingFlags{},
+                .renderArea =
+                    {
+                        .offset = {0, 0},
+                        .extent = m_resources[firstAttachment].extent,
+                    },
+                .layerCount = 1u,
+                .viewMask = 0u,
+                .colorAttachmentCount = static_cast<uint32_t>(pass.m_colorAttachments.size()),
+                .pColorAttachments = colorAttachmentInfos.data(),
+                .pDepthAttachment = pass.m_depthAttachment.has_value() ? &depthAttachmentInfo : nullptr,
+            };
+
+            cmd.beginRendering(renderingInfo);
+            pass.m_record(cmd);
+            cmd.endRendering();
+        }
+
+        if (!m_finalImageBarriers.empty())
+        {
+            const vk::DependencyInfo dependencyInfo = {
+                .imageMemoryBarrierCount = static_cast<uint32_t>(m_finalImageBarriers.size()),
+                .pImageMemoryBarriers = m_finalImageBarriers.data(),
+            };
+
+            cmd.pipelineBarrier2(dependencyInfo);
+        }
+    }
+
+    std::string RenderGraph::getDebugDump() const
+    {
+        const size_t culledPassCount = std::ranges::count_if(m_passes, [](const RenderGraphPass& pass) { return pass.m_culled; });
+
+        std::string dump = std::format("Render graph : {} passes ({} culled), {} resources\n", m_passes.size(), culledPassCount, m_resources.size());
+
+        const auto getResourceName = [&](const vk::Image image, const vk::Buffer buffer) -> std::string_view {
+            for (const Resource& resource : m_resources)
+            {
+                if ((image && resource.image == image) || (buffer && resource.buffer == buffer))
+                {
+                    return resource.name;
+                }
+            }
+
+            return "?";
+        };
+
+        const auto dumpImageBarrier = [&](const vk::ImageMemoryBarrier2& barrier) {
+            dump += std::format("    barrier {} : {} / {} -> {} / {}, {} -> {}\n",
+                                getResourceName(barrier.image, {}),
+                                vk::to_string(barrier.srcStageMask),
+                                vk::to_string(barrier.srcAccessMask),
+                                vk::to_string(barrier.dstStageMask),
+                                vk::to_string(barrier.dstAccessMask),
+                                vk::to_string(barrier.oldLayout),
+                                vk::to_string(barrier.newLayout));
+        };
+
+        for (const uint32_t passIndex : std::views::iota(0u, static_cast<uint32_t>(m_passes.size())))
+        {
+            const RenderGraphPass& pass = m_passes[passIndex];
+            dump += std::format("  [{}] {}{}{}\n", passIndex, pass.m_name, pass.m_culled ? " (culled)" : "", pass.m_secondaryCommandBuffers ? " (secondary command buffers)" : "");
+
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                const UsageInfo usageInfo = getUsageInfo(access.usage);
+                dump += std::format("    {} {} : {} / {}\n",
+                                    usageInfo.write ? "writes" : "reads",
+                                    m_resources[access.resource].name,
+                                    vk::to_string(usageInfo.stages),
+                                    vk::to_string(usageInfo.access));
+            }
+
+            const auto dumpAttachment = [&](const RenderGraphAttachment& attachment) {
+                dump += std::format("    attachment {} : load {}, store {}\n", m_resources[attachment.resource].name, vk::to_string(attachment.loadOp), vk::to_string(attachment.storeOp));
+            };
+
+            std::ranges::for_each(pass.m_colorAttachments, dumpAttachment);
+            if (pass.m_depthAttachment.has_value())
+            {
+                dumpAttachment(*pass.m_depthAttachment);
+            }
+
+            for (const vk::ImageMemoryBarrier2& barrier : pass.m_imageBarriers)
+            {
+                dumpImageBarrier(barrier);
+            }
+
+            for (const vk::BufferMemoryBarrier2& barrier : pass.m_bufferBarriers)
+            {
+                dump += std::format("    barrier {} : {} / {} -> {} / {}\n",
+                                    getResourceName({}, barrier.buffer),
+                                    vk::to_string(barrier.srcStageMask),
+                                    vk::to_string(barrier.srcAccessMask),
+                                    vk::to_string(barrier.dstStageMask),
+                                    vk::to_string(barrier.dstAccessMask));
+            }
+        }
+
+        dump += "  Final transitions :\n";
+        for (const vk::ImageMemoryBarrier2& barrier : m_finalImageBarriers)
+        {
+            dumpImageBarrier(barrier);
+        }
+
+        constexpr double bytesPerMegabyte = 1024.0 * 1024.0;
+
+        const TransientMemoryStatistics& memoryStatistics = m_transientAllocator.getStatistics();
+        dump += std::format("  Transient images ({} memory slots, {:.2f} MB allocated, {:.2f} MB lazily allocated, {:.2f} MB saved) :\n",
+                            memoryStatistics.memorySlotCount,
+                            static_cast<double>(memoryStatistics.allocatedBytes) / bytesPerMegabyte,
+                            static_cast<double>(memoryStatistics.lazilyAllocatedBytes) / bytesPerMegabyte,
+                            static_cast<double>(memoryStatistics.savedBytes) / bytesPerMegabyte);
+
+        const std::vector<TransientImage>& transientImages = m_transientAllocator.getImages();
+        for (const Resource& resource : m_resources)
+        {
+            if (resource.transientIndex == INVALID_U32)
+            {
+                continue;
+            }
+
+            const TransientImage& transientImage = transientImages[resource.transientIndex];
+            dump += std::format("    {} : {} {}x{}, passes [{}, {}], memory slot {} ({:.2f} MB{})\n",
+                                resource.name,
+                                vk::to_string(transientImage.desc.format),
+                                transientImage.desc.extent.width,
+                                transientImage.desc.extent.height,
+                                transientImage.desc.firstPass,
+                                transientImage.desc.lastPass,
+                                transientImage.memorySlot,
+                                static_cast<double>(m_transientAllocator.getMemorySlotSize(transientImage.memorySlot)) / bytesPerMegabyte,
+                                m_transientAllocator.isMemorySlotLazilyAllocated(transientImage.memorySlot) ? ", lazily allocated" : "");
+        }
+
+        return dump;
+    }
+
+    void RenderGraph::cullPasses()
+    {
+        // Walk the passes backwards from the outputs : a pass is needed if it writes a resource that is needed after it, and then the resources
+        // it uses are needed before it (except attachments it clears, whose previous contents are discarded).
+        std::vector<bool>& neededResources = m_neededResources;
+        neededResources.assign(m_resources.size(), false);
+        for (const size_t resourceIndex : std::views::iota(0u, m_resources.size()))
+        {
+            neededResources[resourceIndex] = m_resources[resourceIndex].finalUsage.has_value();
+        }
+
+        for (RenderGraphPass& pass : m_passes | std::views::reverse)
+        {
+            bool needed = pass.m_sideEffects;
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                needed = needed || (getUsageInfo(access.usage).write && neededResources[access.resource]);
+            }
+
+            pass.m_culled = !needed;
+            if (!needed)
+            {
+                continue;
+            }
+
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                neededResources[access.resource] = !pass.discardsContents(access.resource);
+            }
+        }
+    }
+
+    void RenderGraph::allocateTransientImages()
+    {
+        constexpr vk::ImageUsageFlags attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+
+        std::vector<TransientImageDesc>& imageDescs = m_transientImageDescs;
+        imageDescs.clear();
+        for (Resource& resource : m_resources)
+        {
+            if (resource.imported || resource.firstPass == INVALID_U32)
+            {
+                continue;
+            }
+
+            resource.transientIndex = static_cast<uint32_t>(imageDescs.size());
+            imageDescs.push_back(TransientImageDesc{
+                .format = resource.format,
+                .extent = resource.extent,
+                .usage = resource.imageUsage,
+                .firstPass = resource.firstPass,
+                .lastPass = resource.lastPass,
+                .transientAttachment = resource.firstPass == resource.lastPass && (resource.imageUsage & ~attachmentUsage) == vk::ImageUsageFlags{},
+            });
+        }
+
+        m_transientAllocator.allocate(imageDescs);
+
+        const std::vector<TransientImage>& transientImages = m_transientAllocator.getImages();
+        for (Resource& resource : m_resources)
+        {
+            if (resource.transientIndex != INVALID_U32)
+            {
+                resource.image = transientImages[resource.transientIndex].image;
+                resource.imageView = transientImages[resource.transientIndex].imageView;
+            }
+        }
+    }
+
+    void RenderGraph::computeStoreOps()
+    {
+        // The contents of an attachment are stored if a later pass uses them (i.e does not clear them), or if the image is imported (its
+        // contents may be used after the graph).
+        for (const uint32_t passIndex : std::views::iota(0u, static_cast<uint32_t>(m_passes.size())))
+        {
+            RenderGraphPass& pass = m_passes[passIndex];
+            if (pass.m_culled)
+            {
+                continue;
+            }
+
+            const auto getStoreOp = [&](const RenderGraphResource resource) {
+                for (const RenderGraphPass& laterPass : m_passes | std::views::drop(passIndex + 1u))
+                {
+                    const bool usesResource = std::ranges::any_of(laterPass.m_accesses, [&](const RenderGraphPass::Access& access) { return access.resource == resource; });
+                    if (!laterPass.m_culled && usesResource)
+                    {
+                        return laterPass.discardsContents(resource) ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
+                    }
+                }
+
+                return m_resources[resource].imported ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+            };
+
+            for (RenderGraphAttachment& attachment : pass.m_colorAttachments)
+            {
+                attachment.storeOp = getStoreOp(attachment.resource);
+            }
+
+            if (pass.m_depthAttachment.has_value())
+            {
+                pass.m_depthAttachment->storeOp = getStoreOp(pass.m_depthAttachment->resource);
+            }
+        }
+    }
+
+    void RenderGraph::computeBarriers()
+    {
+        // Synchronization state of each resource, as the passes are walked in order.
+        std::vector<SyncState>& syncStates = m_syncStates;
+        syncStates.resize(m_resources.size());
+        for (const size_t resourceIndex : std::views::iota(0u, m_resources.size()))
+        {
+            const RenderGraphResourceState& initialState = m_resources[resourceIndex].initialState;
+
+            syncStates[resourceIndex] = SyncState{
+                .writeStages = initialState.stages,
+                .writeAccess = initialState.access & WRITE_ACCESS_FLAGS,
+                .layout = initialState.layout,
+            };
+        }
+
+        // The memory of a transient image was last used by the previous image of its memory slot. For the first image of a slot, that is the
+        // last image of the slot in the previous frame (whose uses over the whole graph are waited on).
+        const std::vector<TransientImage>& transientImages = m_transientAllocator.getImages();
+        const uint32_t memorySlotCount = m_transientAllocator.getMemorySlotCount();
+
+        std::vector<uint32_t>& slotLastImages = m_slotLastImages;
+        slotLastImages.assign(memorySlotCount, INVALID_U32);
+        for (const uint32_t imageIndex : std::views::iota(0u, static_cast<uint32_t>(transientImages.size())))
+        {
+            uint32_t& slotLastImage = slotLastImages[transientImages[imageIndex].memorySlot];
+            if (slotLastImage == INVALID_U32 || transientImages[imageIndex].desc.firstPass > transientImages[slotLastImage].desc.firstPass)
+            {
+                slotLastImage = imageIndex;
+            }
+        }
+
+        std::vector<SyncState>& slotPreviousFrameStates = m_slotPreviousFrameStates;
+        slotPreviousFrameStates.assign(memorySlotCount, SyncState{});
+        for (const RenderGraphPass& pass : m_passes)
+        {
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                const uint32_t transientIndex = m_resources[access.resource].transientIndex;
+                if (pass.m_culled || transientIndex == INVALID_U32 || slotLastImages[transientImages[transientIndex].memorySlot] != transientIndex)
+                {
+                    continue;
+                }
+
+                const UsageInfo usageInfo = getUsageInfo(access.usage);
+
+                SyncState& slotState = slotPreviousFrameStates[transientImages[transientIndex].memorySlot];
+                slotState.writeStages |= usageInfo.stages;
+                slotState.writeAccess |= usageInfo.access & WRITE_ACCESS_FLAGS;
+            }
+        }
+
+        // Last resource of each memory slot used so far in this frame.
+        std::vector<RenderGraphResource>& slotLastResources = m_slotLastResources;
+        slotLastResources.assign(memorySlotCount, INVALID_U32);
+
+        for (const uint32_t passIndex : std::views::iota(0u, static_cast<uint32_t>(m_passes.size())))
+        {
+            RenderGraphPass& pass = m_passes[passIndex];
+
+            pass.m_imageBarriers.clear();
+            pass.m_bufferBarriers.clear();
+
+            if (pass.m_culled)
+            {
+                continue;
+            }
+
+            // Uses of the same resource within a pass are merged into a single access.
+            std::vector<MergedAccess>& mergedAccesses = m_mergedAccesses;
+            mergedAccesses.clear();
+            for (const RenderGraphPass::Access& access : pass.m_accesses)
+            {
+                const UsageInfo usageInfo = getUsageInfo(access.usage);
+
+                const auto mergedAccess = std::ranges::find(mergedAccesses, access.resource, &MergedAccess::resource);
+                if (mergedAccess == mergedAccesses.end())
+                {
+                    mergedAccesses.push_back(MergedAccess{
+                        .resource = access.resource,
+                        .usageInfo = usageInfo,
+                    });
+
+                    continue;
+                }
+
+                if (m_resources[access.resource].isImage && mergedAccess->usageInfo.layout != usageInfo.layout)
+                {
+                    fatalError(std::format("Render graph pass {} uses image {} in two different layouts.", pass.m_name, m_resources[access.resource].name));
+                }
+
+                mergedAccess->usageInfo.stages |= usageInfo.stages;
+                mergedAccess->usageInfo.access |= usageInfo.access;
+                mergedAccess->usageInfo.write = mergedAccess->usageInfo.write || usageInfo.write;
+            }
+
+            for (const MergedAccess& mergedAccess : mergedAccesses)
+            {
+                const Resource& resource = m_resources[mergedAccess.resource];
+                const UsageInfo& usageInfo = mergedAccess.usageInfo;
+
+                SyncState& syncState = syncStates[mergedAccess.resource];
+
+                // First use of a transient image : its previous contents are discarded, but the previous uses of its memory must complete.
+                if (resource.transientIndex != INVALID_U32 && resource.firstPass == passIndex)
+                {
+                    const uint32_t memorySlot = transientImages[resource.transientIndex].memorySlot;
+                    const RenderGraphResource previousResource = slotLastResources[memorySlot];
+
+                    const SyncState& previousState = previousResource != INVALID_U32 ? syncStates[previousResource] : slotPreviousFrameStates[memorySlot];
+
+                    syncState.writeStages = previousState.writeStages | previousState.readStages;
+                    syncState.writeAccess = previousState.writeAccess;
+                    slotLastResources[memorySlot] = mergedAccess.resource;
+                }
+
+                const bool layoutTransition = resource.isImage && usageInfo.layout != syncState.layout;
+
+                const auto addBarrier = [&](const vk::PipelineStageFlags2 srcStages, const vk::AccessFlags2 srcAccess) {
+                    if (resource.isImage)
+                    {
+                        pass.m_imageBarriers.push_back(vk::ImageMemoryBarrier2{
+                            .srcStageMask = srcStages,
+                            .srcAccessMask = srcAccess,
+                            .dstStageMask = usageInfo.stages,
+                            .dstAccessMask = usageInfo.access,
+                            .oldLayout = syncState.layout,
+                            .newLayout = usageInfo.layout,
+                            .image = resource.image,
+                            .subresourceRange =
+                                {
+                                    .aspectMask = resource.aspect,
+                                    .baseMipLevel = 0u,
+                                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                                    .baseArrayLayer = 0u,
+                                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                                },
+                        });
+                    }
+                    else
+                    {
+                        pass.m_bufferBarriers.push_back(vk::BufferMemoryBarrier2{
+                            .srcStageMask = srcStages,
+                            .srcAccessMask = srcAccess,
+                            .dstStageMask = usageInfo.stages,
+                            .dstAccessMask = usageInfo.access,
+                            .buffer = resource.buffer,
+                            .offset = resource.offset,
+                            .size = resource.size,
+                        });
+                    }
+                };
+
+                if (usageInfo.write || layoutTransition)
+                {
+                    // Write after write / read (or a layout transition, which is a write) : wait for the last write and the reads since.
+                    const vk::PipelineStageFlags2 srcStages = syncState.writeStages | syncState.readStages;
+                    if (layoutTransition || srcStages != vk::PipelineStageFlags2{})
+                    {
+                        addBarrier(srcStages, syncState.writeAccess);
+                    }
+
+                    syncState = SyncState{
+                        .writeStages = usageInfo.stages,
+                        .writeAccess = usageInfo.access & WRITE_ACCESS_FLAGS,
+                        .visibleStages = usageInfo.stages,
+                        .visibleAccess = usageInfo.access,
+                        .layout = usageInfo.layout,
+                    };
+                }
+                else
+                {
+                    // Read after write : only if this stage / access does not already wait for the last write (reads after reads need nothing).
+                    const bool alreadyVisible = (usageInfo.stages & ~syncState.visibleStages) == vk::PipelineStageFlags2{} &&
+                                                (usageInfo.access & ~syncState.visibleAccess) == vk::AccessFlags2{};
+
+                    if (syncState.writeStages != vk::PipelineStageFlags2{} && !alreadyVisible)
+                    {
+                        addBarrier(syncState.writeStages, syncState.writeAccess);
+
+                        syncState.visibleStages |= usageInfo.stages;
+                        syncState.visibleAccess |= usageInfo.access;
+                    }
+
+                    syncState.readStages |= usageInfo.stages;
+                }
+            }
+        }
+
+        // Transition the outputs to their final usage.
+        for (const size_t resourceIndex : std::views::iota(0u, m_resources.size()))
+        {
+            const Resource& resource = m_resources[resourceIndex];
+            if (!resource.finalUsage.has_value())
+            {
+                continue;
+            }
+
+            const UsageInfo usageInfo = getUsageInfo(*resource.finalUsage);
+            const SyncState& syncState = syncStates[resourceIndex];
+
+            m_finalImageBarriers.push_back(vk::ImageMemoryBarrier2{
+                .srcStageMask = syncState.writeStages | syncState.readStages,
+                .srcAccessMask = syncState.writeAccess,
+                .dstStageMask = usageInfo.stages,
+                .dstAccessMask = usageInfo.access,
+                .oldLayout = syncState.layout,
+                .newLayout = usageInfo.layout,
+                .image = resource.image,
+                .subresourceRange =
+                    {
+                        .aspectMask = resource.aspect,
+                        .baseMipLevel = 0u,
+                        .levelCount = VK_REMAINING_MIP_LEVELS,
+                        .baseArrayLayer = 0u,
+                        .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                    },
+            });
+        }
+    }
+}
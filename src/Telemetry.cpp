@@ -0,0 +1,148 @@
+#include "Telemetry.hpp"
+
+namespace lunar
+{
+    TelemetryWriter::~TelemetryWriter()
+    {
+        close();
+    }
+
+    void TelemetryWriter::open(const std::string_view path, const TelemetryFormat format)
+    {
+        close();
+
+        m_file.open(std::string(path), format == TelemetryFormat::eBinary ? std::ios::out | std::ios::binary : std::ios::out);
+        if (!m_file.is_open())
+        {
+            fatalError(std::string("Failed to open telemetry file : ") + std::string(path));
+        }
+
+        m_format = format;
+
+        if (m_format == TelemetryFormat::eBinary)
+        {
+            const std::array<uint32_t, 3> header = {TELEMETRY_BINARY_MAGIC, TELEMETRY_BINARY_VERSION, static_cast<uint32_t>(sizeof(TelemetryRecord))};
+            m_file.write(reinterpret_cast<const char*>(header.data()), sizeof(header));
+        }
+        else
+        {
+            m_file << "frame,cpu_frame_time_ms,draw_calls,indirect_draw_calls,dispatches,triangles,pipeline_binds,descriptor_set_binds,vertex_buffer_binds,"
+                      "index_buffer_binds,push_constant_bytes,skipped_pipeline_binds,skipped_index_buffer_binds,visible_objects,culled_objects,uploaded_bytes,"
+                      "frame_arena_bytes,heap_allocations,heap_allocated_bytes\n";
+        }
+
+        m_ring.resize(RING_CAPACITY);
+        m_head = 0u;
+        m_tail = 0u;
+        m_droppedRecordCount = 0u;
+        m_stopping = false;
+
+        m_writerThread = std::thread([this]() { writerLoop(); });
+    }
+
+    void TelemetryWriter::close()
+    {
+        if (!m_writerThread.joinable())
+        {
+            return;
+        }
+
+        {
+            std::scoped_lock lock{m_mutex};
+            m_stopping = true;
+        }
+
+        m_condition.notify_one();
+        m_writerThread.join();
+
+        m_file.close();
+
+        if (m_droppedRecordCount > 0u)
+        {
+            std::cout << std::format("Telemetry writer dropped {} records, as its ring buffer was full.\n", m_droppedRecordCount);
+        }
+    }
+
+    void TelemetryWriter::push(const TelemetryRecord& record)
+    {
+        if (!m_writerThread.joinable())
+        {
+            return;
+        }
+
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == RING_CAPACITY)
+        {
+            ++m_droppedRecordCount;
+            return;
+        }
+
+        m_ring[head % RING_CAPACITY] = record;
+        m_head.store(head + 1u, std::memory_order_release);
+
+        // The writer thread is not waited on. It may miss this notification if it is just about to wait, in which case the record is written
+        // by its next periodic wake up.
+        m_condition.notify_one();
+    }
+
+    void TelemetryWriter::writerLoop()
+    {
+        constexpr std::chrono::milliseconds maxWaitTime{100};
+
+        while (true)
+        {
+            bool stopping{};
+            {
+                std::unique_lock lock{m_mutex};
+                m_condition.wait_for(lock, maxWaitTime, [&]() { return m_stopping || m_tail.load(std::memory_order_relaxed) != m_head.load(std::memory_order_acquire); });
+
+                stopping = m_stopping;
+            }
+
+            // Records pushed before close() are all visible once m_stopping is, so the ring is fully drained before the thread exits.
+            const uint64_t head = m_head.load(std::memory_order_acquire);
+            for (uint64_t tail = m_tail.load(std::memory_order_relaxed); tail != head; ++tail)
+            {
+                writeRecord(m_ring[tail % RING_CAPACITY]);
+                m_tail.store(tail + 1u, std::memory_order_release);
+            }
+
+            if (stopping)
+            {
+                m_file.flush();
+                return;
+            }
+        }
+    }
+
+    void TelemetryWriter::writeRecord(const TelemetryRecord& record)
+    {
+        if (m_format == TelemetryFormat::eBinary)
+        {
+            m_file.write(reinterpret_cast<const char*>(&record), sizeof(TelemetryRecord));
+            return;
+        }
+
+        const RenderStatistics& statistics = record.renderStatistics;
+        m_file << std::format("{},{:.4f},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                              record.frameNumber,
+                              record.cpuFrameTimeMs,
+                              statistics.drawCallCount,
+                              statistics.indirectDrawCallCount,
+                              statistics.dispatchCount,
+                              statistics.triangleCount,
+                              statistics.pipelineBindCount,
+                              statistics.descriptorSetBindCount,
+                              statistics.vertexBufferBindCount,
+                              statistics.indexBufferBindCount,
+                              statistics.pushConstantBytes,
+                              statistics.skippedPipelineBindCount,
+                              statistics.skippedIndexBufferBindCount,
+                              statistics.visibleObjectCount,
+                              statistics.culledObjectCount,
+                              statistics.uploadedBytes,
+                              statistics.frameArenaBytes,
+                              statistics.heapAllocationCount,
+                              statistics.heapAllocatedBytes);
+    }
+}
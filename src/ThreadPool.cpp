@@ -0,0 +1,61 @@
+#include "ThreadPool.hpp"
+
+namespace lunar
+{
+    ThreadPool::ThreadPool(const uint32_t threadCount)
+    {
+        m_threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            m_threads.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_stopping = true;
+        }
+
+        m_condition.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()>&& task)
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_tasks.emplace_back(std::move(task));
+        }
+
+        m_condition.notify_one();
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task{};
+
+            {
+                std::unique_lock lock{m_mutex};
+                m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+                if (m_stopping && m_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+}
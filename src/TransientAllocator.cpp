@@ -0,0 +1,198 @@
+#include "TransientAllocator.hpp"
+
+namespace lunar
+{
+    void TransientAllocator::init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker)
+    {
+        m_device = device;
+        m_allocator = allocator;
+        m_memoryTracker = &memoryTracker;
+    }
+
+    void TransientAllocator::destroy()
+    {
+        destroyImages();
+    }
+
+    bool TransientAllocator::allocate(std::span<const TransientImageDesc> imageDescs)
+    {
+        const auto isSameDesc = [](const TransientImageDesc& desc, const TransientImage& image) {
+            return desc.format == image.desc.format && desc.extent == image.desc.extent && desc.usage == image.desc.usage &&
+                   desc.firstPass == image.desc.firstPass && desc.lastPass == image.desc.lastPass && desc.transientAttachment == image.desc.transientAttachment;
+        };
+
+        if (std::ranges::equal(imageDescs, m_images, isSameDesc))
+        {
+            return false;
+        }
+
+        if (!m_images.empty())
+        {
+            m_device.waitIdle();
+            destroyImages();
+        }
+
+        // Create the images first, as their memory requirements are needed to assign them to memory slots.
+        std::vector<vk::MemoryRequirements> memoryRequirements{};
+        memoryRequirements.reserve(imageDescs.size());
+
+        m_images.reserve(imageDescs.size());
+        for (const TransientImageDesc& imageDesc : imageDescs)
+        {
+            const vk::ImageCreateInfo imageCreateInfo = {
+                .imageType = vk::ImageType::e2D,
+                .format = imageDesc.format,
+                .extent =
+                    {
+                        .width = imageDesc.extent.width,
+                        .height = imageDesc.extent.height,
+                        .depth = 1u,
+                    },
+                .mipLevels = 1u,
+                .arrayLayers = 1u,
+                .tiling = vk::ImageTiling::eOptimal,
+                .usage = imageDesc.transientAttachment ? imageDesc.usage | vk::ImageUsageFlagBits::eTransientAttachment : imageDesc.usage,
+            };
+
+            m_images.push_back(TransientImage{
+                .desc = imageDesc,
+                .image = m_device.createImage(imageCreateInfo),
+            });
+
+            memoryRequirements.push_back(m_device.getImageMemoryRequirements(m_images.back().image));
+        }
+
+        const VmaAllocationCreateInfo lazilyAllocatedCreateInfo = {
+            .usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+        };
+
+        const VmaAllocationCreateInfo deviceLocalCreateInfo = {
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        };
+
+        struct SlotRequirements
+        {
+            vk::MemoryRequirements memoryRequirements{};
+            uint32_t lastPass{};
+            bool lazilyAllocated{};
+        };
+
+        std::vector<uint32_t> imageOrder(m_images.size());
+        std::iota(imageOrder.begin(), imageOrder.end(), 0u);
+        std::ranges::stable_sort(imageOrder, {}, [&](const uint32_t imageIndex) { return m_images[imageIndex].desc.firstPass; });
+
+        std::vector<SlotRequirements> slotRequirements{};
+        for (const uint32_t imageIndex : imageOrder)
+        {
+            TransientImage& image = m_images[imageIndex];
+            const vk::MemoryRequirements& imageMemoryRequirements = memoryRequirements[imageIndex];
+
+            // Devices without lazily allocated memory (most desktop GPUs) have no memory type for it, in which case transient attachments
+            // alias regular device local memory like the other images.
+            uint32_t lazilyAllocatedMemoryTypeIndex{};
+            const bool lazilyAllocated = image.desc.transientAttachment &&
+                                         vmaFindMemoryTypeIndex(m_allocator, imageMemoryRequirements.memoryTypeBits, &lazilyAllocatedCreateInfo, &lazilyAllocatedMemoryTypeIndex) ==
+                                             VK_SUCCESS;
+
+            const auto slot = std::ranges::find_if(slotRequirements, [&](const SlotRequirements& slot) {
+                return slot.lazilyAllocated == lazilyAllocated && slot.lastPass < image.desc.firstPass &&
+                       (slot.memoryRequirements.memoryTypeBits & imageMemoryRequirements.memoryTypeBits) != 0u;
+            });
+
+            if (slot == slotRequirements.end())
+            {
+                image.memorySlot = static_cast<uint32_t>(slotRequirements.size());
+                slotRequirements.push_back(SlotRequirements{
+                    .memoryRequirements = imageMemoryRequirements,
+                    .lastPass = image.desc.lastPass,
+                    .lazilyAllocated = lazilyAllocated,
+                });
+
+                continue;
+            }
+
+            image.memorySlot = static_cast<uint32_t>(std::distance(slotRequirements.begin(), slot));
+
+            slot->memoryRequirements.size = std::max(slot->memoryRequirements.size, imageMemoryRequirements.size);
+            slot->memoryRequirements.alignment = std::max(slot->memoryRequirements.alignment, imageMemoryRequirements.alignment);
+            slot->memoryRequirements.memoryTypeBits &= imageMemoryRequirements.memoryTypeBits;
+            slot->lastPass = image.desc.lastPass;
+        }
+
+        for (const SlotRequirements& slot : slotRequirements)
+        {
+            const VkMemoryRequirements vkMemoryRequirements = slot.memoryRequirements;
+
+            MemorySlot& memorySlot = m_memorySlots.emplace_back();
+            memorySlot.size = slot.memoryRequirements.size;
+            memorySlot.lazilyAllocated = slot.lazilyAllocated;
+
+            vkCheck(vmaAllocateMemory(m_allocator,
+                                      &vkMemoryRequirements,
+                                      slot.lazilyAllocated ? &lazilyAllocatedCreateInfo : &deviceLocalCreateInfo,
+                                      &memorySlot.allocation,
+                                      nullptr));
+
+            m_memoryTracker->track(memorySlot.allocation,
+                                   MemoryCategory::eTransientImage,
+                                   std::format("Memory slot {}{}", m_memorySlots.size() - 1u, slot.lazilyAllocated ? " (lazily allocated)" : ""));
+        }
+
+        for (TransientImage& image : m_images)
+        {
+            vkCheck(vmaBindImageMemory(m_allocator, m_memorySlots[image.memorySlot].allocation, image.image));
+
+            const vk::ImageViewCreateInfo imageViewCreateInfo = {
+                .image = image.image,
+                .viewType = vk::ImageViewType::e2D,
+                .format = image.desc.format,
+                .subresourceRange =
+                    {
+                        .aspectMask = getImageAspect(image.desc.format),
+                        .baseMipLevel = 0u,
+                        .levelCount = 1u,
+                        .baseArrayLayer = 0u,
+                        .layerCount = 1u,
+                    },
+            };
+
+            image.imageView = m_device.createImageView(imageViewCreateInfo);
+        }
+
+        m_statistics.imageCount = static_cast<uint32_t>(m_images.size());
+        m_statistics.memorySlotCount = static_cast<uint32_t>(m_memorySlots.size());
+        m_statistics.requiredBytes = std::accumulate(memoryRequirements.begin(), memoryRequirements.end(), uint64_t{0u}, [](const uint64_t sum, const vk::MemoryRequirements& requirements) {
+            return sum + requirements.size;
+        });
+
+        m_statistics.allocatedBytes = 0u;
+        m_statistics.lazilyAllocatedBytes = 0u;
+        for (const MemorySlot& memorySlot : m_memorySlots)
+        {
+            (memorySlot.lazilyAllocated ? m_statistics.lazilyAllocatedBytes : m_statistics.allocatedBytes) += memorySlot.size;
+        }
+
+        m_statistics.savedBytes = m_statistics.requiredBytes - m_statistics.allocatedBytes;
+        m_statistics.peakSavedBytes = std::max(m_statistics.peakSavedBytes, m_statistics.savedBytes);
+
+        return true;
+    }
+
+    void TransientAllocator::destroyImages()
+    {
+        for (const TransientImage& image : m_images)
+        {
+            m_device.destroyImageView(image.imageView);
+            m_device.destroyImage(image.image);
+        }
+
+        for (const MemorySlot& memorySlot : m_memorySlots)
+        {
+            m_memoryTracker->untrack(memorySlot.allocation);
+            vmaFreeMemory(m_allocator, memorySlot.allocation);
+        }
+
+        m_images.clear();
+        m_memorySlots.clear();
+    }
+}
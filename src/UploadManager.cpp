@@ -0,0 +1,323 @@
+#include "UploadManager.hpp"
+
+namespace lunar
+{
+    // Uploads are split into copies of at most this fraction of the ring, so that a large upload can make progress while earlier batches are
+    // still in flight.
+    static constexpr uint64_t MAX_COPY_SIZE_DIVISOR = 4u;
+    static constexpr uint64_t STAGING_ALIGNMENT = 16u;
+
+    void UploadManager::init(const vk::Device device, const VmaAllocator allocator, MemoryTracker& memoryTracker, const vk::Queue transferQueue,
+                             const uint32_t transferQueueIndex, const uint32_t graphicsQueueIndex, const uint32_t stagingRingSize)
+    {
+        m_device = device;
+        m_allocator = allocator;
+        m_memoryTracker = &memoryTracker;
+
+        m_transferQueue = transferQueue;
+        m_transferQueueIndex = transferQueueIndex;
+        m_graphicsQueueIndex = graphicsQueueIndex;
+
+        const vk::CommandPoolCreateInfo commandPoolCreateInfo = {
+            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .queueFamilyIndex = m_transferQueueIndex,
+        };
+
+        m_commandPool = m_device.createCommandPool(commandPoolCreateInfo);
+
+        // Batch i signals value i, so the semaphore starts at 0 (no batch has completed).
+        const vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {
+            .semaphoreType = vk::SemaphoreType::eTimeline,
+            .initialValue = 0u,
+        };
+
+        const vk::SemaphoreCreateInfo semaphoreCreateInfo = {.pNext = &semaphoreTypeCreateInfo};
+        m_timelineSemaphore = m_device.createSemaphore(semaphoreCreateInfo);
+
+        m_stagingSize = stagingRingSize;
+
+        const vk::BufferCreateInfo stagingBufferCreateInfo = {
+            .size = m_stagingSize,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+        };
+
+        // Uploads are copied into the ring through its persistent mapping without being flushed, so the memory must be host coherent.
+        const VmaAllocationCreateInfo vmaAllocationCreateInfo = {
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+
+        const VkBufferCreateInfo vkBufferCreateInfo = stagingBufferCreateInfo;
+
+        VkBuffer vkBuffer{};
+        VmaAllocationInfo allocationInfo{};
+        vkCheck(vmaCreateBuffer(m_allocator, &vkBufferCreateInfo, &vmaAllocationCreateInfo, &vkBuffer, &m_stagingBuffer.allocation, &allocationInfo));
+        m_memoryTracker->track(m_stagingBuffer.allocation, MemoryCategory::eStaging, "Staging ring");
+
+        m_stagingBuffer.buffer = vkBuffer;
+        m_stagingData = static_cast<std::byte*>(allocationInfo.pMappedData);
+
+        m_recordingBatch.timelineValue = 1u;
+    }
+
+    void UploadManager::destroy()
+    {
+        // Copies that were recorded but never used are still submitted, so the command buffer is not destroyed while recording.
+        wait(flush());
+
+        m_device.destroyCommandPool(m_commandPool);
+        m_device.destroySemaphore(m_timelineSemaphore);
+
+        m_memoryTracker->untrack(m_stagingBuffer.allocation);
+        vmaDestroyBuffer(m_allocator, m_stagingBuffer.buffer, m_stagingBuffer.allocation);
+
+        m_freeCommandBuffers.clear();
+        m_submittedBatches.clear();
+        m_pendingAcquires.clear();
+    }
+
+    UploadTicket UploadManager::uploadBuffer(const vk::Buffer buffer, const vk::DeviceSize offset, std::span<const std::byte> data)
+    {
+        const uint64_t maxCopySize = m_stagingSize / MAX_COPY_SIZE_DIVISOR;
+
+        uint64_t copiedSize = 0u;
+        while (copiedSize < data.size_bytes())
+        {
+            const uint64_t copySize = std::min<uint64_t>(data.size_bytes() - copiedSize, maxCopySize);
+
+            // Allocating may flush the current batch, so the batch is begun afterwards.
+            const uint64_t stagingOffset = allocateStaging(copySize);
+            beginBatch();
+
+            std::memcpy(m_stagingData + stagingOffset, data.data() + copiedSize, copySize);
+
+            const vk::BufferCopy copyRegion = {
+                .srcOffset = stagingOffset,
+                .dstOffset = offset + copiedSize,
+                .size = copySize,
+            };
+
+            m_recordingBatch.commandBuffer.copyBuffer(m_stagingBuffer.buffer, buffer, 1u, &copyRegion);
+
+            if (m_transferQueueIndex != m_graphicsQueueIndex)
+            {
+                m_recordingBatch.ownershipTransfers.push_back(OwnershipTransfer{
+                    .buffer = buffer,
+                    .offset = offset + copiedSize,
+                    .size = copySize,
+                });
+            }
+
+            copiedSize += copySize;
+        }
+
+        m_statistics.uploadedBytes += data.size_bytes();
+
+        return UploadTicket{.timelineValue = m_recording ? m_recordingBatch.timelineValue : m_lastSubmittedValue};
+    }
+
+    UploadTicket UploadManager::flush()
+    {
+        if (!m_recording)
+        {
+            return UploadTicket{.timelineValue = m_lastSubmittedValue};
+        }
+
+        // Release the written ranges to the graphics queue family. The matching acquire is recorded once the batch has completed.
+        if (!m_recordingBatch.ownershipTransfers.empty())
+        {
+            m_ownershipBarriers.clear();
+            for (const OwnershipTransfer& ownershipTransfer : m_recordingBatch.ownershipTransfers)
+            {
+                m_ownershipBarriers.push_back(createOwnershipBarrier(ownershipTransfer, true));
+            }
+
+            const vk::DependencyInfo dependencyInfo = {
+                .bufferMemoryBarrierCount = static_cast<uint32_t>(m_ownershipBarriers.size()),
+                .pBufferMemoryBarriers = m_ownershipBarriers.data(),
+            };
+
+            m_recordingBatch.commandBuffer.pipelineBarrier2(dependencyInfo);
+        }
+
+        m_recordingBatch.commandBuffer.end();
+        m_recordingBatch.stagingEnd = m_stagingHead;
+
+        const vk::CommandBufferSubmitInfo commandBufferSubmitInfo = {.commandBuffer = m_recordingBatch.commandBuffer};
+
+        const vk::SemaphoreSubmitInfo signalSemaphoreInfo = {
+            .semaphore = m_timelineSemaphore,
+            .value = m_recordingBatch.timelineValue,
+            .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        };
+
+        const vk::SubmitInfo2 submitInfo = {
+            .commandBufferInfoCount = 1u,
+            .pCommandBufferInfos = &commandBufferSubmitInfo,
+            .signalSemaphoreInfoCount = 1u,
+            .pSignalSemaphoreInfos = &signalSemaphoreInfo,
+        };
+
+        vkCheck(m_transferQueue.submit2(1u, &submitInfo, {}));
+
+        m_lastSubmittedValue = m_recordingBatch.timelineValue;
+        m_submittedBatches.push_back(std::move(m_recordingBatch));
+        m_statistics.submittedBatchCount++;
+
+        m_recordingBatch = Batch{.timelineValue = m_lastSubmittedValue + 1u};
+        m_recording = false;
+
+        return UploadTicket{.timelineValue = m_lastSubmittedValue};
+    }
+
+    bool UploadManager::isComplete(const UploadTicket ticket) const
+    {
+        return m_device.getSemaphoreCounterValue(m_timelineSemaphore) >= ticket.timelineValue;
+    }
+
+    void UploadManager::wait(const UploadTicket ticket)
+    {
+        if (ticket.timelineValue > m_lastSubmittedValue)
+        {
+            flush();
+        }
+
+        const vk::SemaphoreWaitInfo semaphoreWaitInfo = {
+            .semaphoreCount = 1u,
+            .pSemaphores = &m_timelineSemaphore,
+            .pValues = &ticket.timelineValue,
+        };
+
+        vkCheck(m_device.waitSemaphores(semaphoreWaitInfo, UINT64_MAX));
+    }
+
+    uint64_t UploadManager::acquireCompletedUploads(const vk::CommandBuffer commandBuffer)
+    {
+        retireCompletedBatches();
+
+        if (!m_pendingAcquires.empty())
+        {
+            m_ownershipBarriers.clear();
+            for (const OwnershipTransfer& ownershipTransfer : m_pendingAcquires)
+            {
+                m_ownershipBarriers.push_back(createOwnershipBarrier(ownershipTransfer, false));
+            }
+
+            const vk::DependencyInfo dependencyInfo = {
+                .bufferMemoryBarrierCount = static_cast<uint32_t>(m_ownershipBarriers.size()),
+                .pBufferMemoryBarriers = m_ownershipBarriers.data(),
+            };
+
+            commandBuffer.pipelineBarrier2(dependencyInfo);
+
+            m_pendingAcquires.clear();
+        }
+
+        // Waiting on a value that has already been reached does not stall the graphics queue, but orders the copies (and releases) before the
+        // acquires.
+        return m_completedValue;
+    }
+
+    uint64_t UploadManager::allocateStaging(const uint64_t size)
+    {
+        const uint64_t alignedSize = (size + STAGING_ALIGNMENT - 1u) & ~(STAGING_ALIGNMENT - 1u);
+
+        while (true)
+        {
+            retireCompletedBatches();
+
+            // Once every allocation has been released, start again from the beginning of the ring.
+            if (m_stagingHead == m_stagingTail)
+            {
+                m_stagingHead = 0u;
+                m_stagingTail = 0u;
+            }
+
+            // Allocations are contiguous, so if the allocation does not fit before the end of the ring, it is placed at its start.
+            const uint64_t ringOffset = m_stagingHead % m_stagingSize;
+            const uint64_t padding = ringOffset + alignedSize > m_stagingSize ? m_stagingSize - ringOffset : 0u;
+
+            if (m_stagingHead + padding + alignedSize - m_stagingTail <= m_stagingSize)
+            {
+                m_stagingHead += padding + alignedSize;
+                return padding == 0u ? ringOffset : 0u;
+            }
+
+            // The ring is full : submit the copies recorded so far (they may be what fills it), and wait for the oldest batch.
+            flush();
+
+            m_statistics.stallCount++;
+            wait(UploadTicket{.timelineValue = m_submittedBatches.front().timelineValue});
+        }
+    }
+
+    void UploadManager::beginBatch()
+    {
+        if (m_recording)
+        {
+            return;
+        }
+
+        if (m_freeCommandBuffers.empty())
+        {
+            const vk::CommandBufferAllocateInfo commandBufferAllocateInfo = {
+                .commandPool = m_commandPool,
+                .level = vk::CommandBufferLevel::ePrimary,
+                .commandBufferCount = 1u,
+            };
+
+            m_freeCommandBuffers.push_back(m_device.allocateCommandBuffers(commandBufferAllocateInfo).at(0));
+        }
+
+        m_recordingBatch.commandBuffer = m_freeCommandBuffers.back();
+        m_freeCommandBuffers.pop_back();
+
+        m_recordingBatch.commandBuffer.reset();
+
+        const vk::CommandBufferBeginInfo commandBufferBeginInfo = {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
+        m_recordingBatch.commandBuffer.begin(commandBufferBeginInfo);
+
+        m_recording = true;
+    }
+
+    void UploadManager::retireCompletedBatches()
+    {
+        if (m_submittedBatches.empty())
+        {
+            return;
+        }
+
+        const uint64_t completedValue = m_device.getSemaphoreCounterValue(m_timelineSemaphore);
+
+        while (!m_submittedBatches.empty() && m_submittedBatches.front().timelineValue <= completedValue)
+        {
+            Batch& batch = m_submittedBatches.front();
+
+            m_stagingTail = batch.stagingEnd;
+            m_freeCommandBuffers.push_back(batch.commandBuffer);
+
+            m_pendingAcquires.insert(m_pendingAcquires.end(), batch.ownershipTransfers.begin(), batch.ownershipTransfers.end());
+            m_completedValue = batch.timelineValue;
+
+            m_submittedBatches.pop_front();
+        }
+    }
+
+    vk::BufferMemoryBarrier2 UploadManager::createOwnershipBarrier(const OwnershipTransfer& ownershipTransfer, const bool release) const
+    {
+        // The release only makes the copies available, and the acquire makes them visible to whatever reads the buffer next (vertex / index
+        // fetch, indirect arguments or shader reads).
+        return vk::BufferMemoryBarrier2{
+            .srcStageMask = release ? vk::PipelineStageFlagBits2::eCopy : vk::PipelineStageFlagBits2::eNone,
+            .srcAccessMask = release ? vk::AccessFlagBits2::eTransferWrite : vk::AccessFlagBits2::eNone,
+            .dstStageMask = release ? vk::PipelineStageFlagBits2::eNone : vk::PipelineStageFlagBits2::eAllCommands,
+            .dstAccessMask = release ? vk::AccessFlagBits2::eNone : vk::AccessFlagBits2::eMemoryRead,
+            .srcQueueFamilyIndex = m_transferQueueIndex,
+            .dstQueueFamilyIndex = m_graphicsQueueIndex,
+            .buffer = ownershipTransfer.buffer,
+            .offset = ownershipTransfer.offset,
+            .size = ownershipTransfer.size,
+        };
+    }
+}